@@ -0,0 +1,71 @@
+/*
+ * FIR filter engine with length chosen at runtime.
+ *
+ * Delay line is mirrored: it has 2 * taps samples and every input sample is
+ * written twice, at pos and pos + taps. The last taps samples are then
+ * always contiguous (newest first) at state[ pos ], so the convolution is one
+ * straight dot product, there is no modulo or wrap check in the inner loop.
+ *
+ * Dot product kernels:
+ *     float - FPU multiply accumulate with 4 partial sums on target,
+ *             SSE (AVX with -mavx) on host
+ *     Q15   - SMLALD, two 16 bit products per instruction into 64 bit
+ *             accumulator, on target, SSE2 pmaddwd on host
+ * Both host kernels give the same result as the target ones (Q15 exactly, the
+ * float ones up to summation order).
+ *
+ * Block API filters n samples per call, eg. all encoder samples that came in
+ * since the last control tick.
+ *
+ * The engine doesn't allocate, the caller provides coefficients and a delay
+ * line of FIR_ENGINE_STATE_LEN( taps ) samples, eg.
+ *      float coeffs[ 64 ];
+ *      float state[ FIR_ENGINE_STATE_LEN( 64 ) ];
+ *      FIR_engine fir;
+ *      FIR_design_lowpass( coeffs, 64, 0.05f );        // cutoff 0.05 * fs
+ *      FIR_engine_init( &fir, coeffs, state, 64 );
+ *      y = FIR_engine_update( &fir, x );
+ */
+
+#ifndef FIR_ENGINE_H
+#define FIR_ENGINE_H
+
+#include <stdint.h>
+
+/* Delay line length for taps coefficients. */
+#define FIR_ENGINE_STATE_LEN( taps ) ( 2 * ( taps ) )
+
+typedef struct
+{
+    uint32_t taps;
+    const float *coeffs;    /* coeffs[ 0 ] multiplies the newest sample */
+    float *state;           /* FIR_ENGINE_STATE_LEN( taps ) samples */
+    uint32_t pos;           /* newest sample is state[ pos ] and state[ pos + taps ] */
+} FIR_engine;
+
+typedef struct
+{
+    uint32_t taps;
+    const int16_t *coeffs;  /* Q15 */
+    int16_t *state;         /* FIR_ENGINE_STATE_LEN( taps ) samples */
+    uint32_t pos;
+} FIR_engine_q15;
+
+/* Zero delay line. */
+void FIR_engine_init( FIR_engine *fir, const float *coeffs, float *state, uint32_t taps );
+float FIR_engine_update( FIR_engine *fir, float in );
+void FIR_engine_block( FIR_engine *fir, const float *in, float *out, uint32_t n );
+
+/* Q15 samples and coefficients, output is rounded and saturated to Q15. */
+void FIR_engine_q15_init( FIR_engine_q15 *fir, const int16_t *coeffs, int16_t *state, uint32_t taps );
+int16_t FIR_engine_q15_update( FIR_engine_q15 *fir, int16_t in );
+void FIR_engine_q15_block( FIR_engine_q15 *fir, const int16_t *in, int16_t *out, uint32_t n );
+
+/* Linear phase low-pass, windowed sinc (Hamming), unity DC gain.
+cutoff is -6dB frequency as a fraction of sampling frequency, (0, 0.5). */
+void FIR_design_lowpass( float *coeffs, uint32_t taps, float cutoff );
+
+/* Round and saturate float coefficients to Q15. */
+void FIR_coeffs_to_q15( const float *in, int16_t *out, uint32_t taps );
+
+#endif // FIR_ENGINE_H
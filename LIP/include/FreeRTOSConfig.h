@@ -122,4 +122,29 @@ standard names. */
 
 #define xPortSysTickHandler SysTick_Handler
 
+/* Task profiler (task_prof.c, "task-stats" cli command). Profiled tasks have
+application task tag set to their slot number + 1. Task switched out is still
+in its ready list when it was preempted, otherwise it blocked or was suspended. */
+#define configUSE_APPLICATION_TASK_TAG           1
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+  void task_prof_switched_in( uint32_t id );
+  void task_prof_switched_out( uint32_t id, long still_ready );
+#endif
+#define traceTASK_SWITCHED_IN()     task_prof_switched_in( ( uint32_t ) ( uintptr_t ) pxCurrentTCB->pxTaskTag )
+#define traceTASK_SWITCHED_OUT()    task_prof_switched_out( ( uint32_t ) ( uintptr_t ) pxCurrentTCB->pxTaskTag, \
+                                        ( long ) listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ), &( pxCurrentTCB->xStateListItem ) ) )
+
+/* Host software-in-the-loop build (sim/), see sim/README.md. There is no newlib
+on the host, simulated time is advanced from the idle hook and asserts have to
+stop the run instead of hanging it. */
+#ifdef LIP_SIM
+  #undef configUSE_NEWLIB_REENTRANT
+  #define configUSE_NEWLIB_REENTRANT 0
+  #undef configUSE_IDLE_HOOK
+  #define configUSE_IDLE_HOOK 1
+  #undef configASSERT
+  void vAssertCalled( const char *pcFile, unsigned long ulLine );
+  #define configASSERT( x ) if ((x) == 0) { vAssertCalled( __FILE__, __LINE__ ); }
+#endif /* LIP_SIM */
+
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,105 @@
+/*
+ * Cascade of second order IIR sections (biquads), direct form II transposed.
+ *
+ * Each section:
+ *      y  = b0 * x + s1
+ *      s1 = b1 * x - a1 * y + s2
+ *      s2 = b2 * x - a2 * y
+ * Two state variables per section, 5 multiplies and 4 additions per sample.
+ * DF2T keeps the state small in float, it is the usual form for single
+ * precision.
+ *
+ * Design helpers (bilinear transform, cutoff prewarped):
+ *     IIR_biquad_design_butterworth_lp() - Butterworth low pass of order 1 to
+ *         2 * IIR_BIQUAD_MAX_SECTIONS, odd order adds one first order section
+ *     IIR_biquad_design_notch() - notch at f0 with quality factor q (f0 / -3dB
+ *         bandwidth), unity gain far from f0, almost no phase lag below f0 / 2
+ *
+ * Coefficients known at compile time (fixed frequency and CTRL_TICK_HZ) can
+ * be written with the IIR_BIQUAD_LP / IIR_BIQUAD_NOTCH macros, they only use
+ * arithmetic so the compiler folds them into constants and the table can live
+ * in flash, eg. 4th order Butterworth at 10Hz and a notch at 25Hz:
+ *      static const IIR_biquad_coeffs cart_coeffs[ 3 ] =
+ *      {
+ *          IIR_BIQUAD_LP( 10.0f, IIR_BIQUAD_BUTTER4_Q1, dt_ctrl ),
+ *          IIR_BIQUAD_LP( 10.0f, IIR_BIQUAD_BUTTER4_Q2, dt_ctrl ),
+ *          IIR_BIQUAD_NOTCH( 25.0f, 2.0f, dt_ctrl ),
+ *      };
+ *      IIR_biquad cart_filter;
+ *      IIR_biquad_init( &cart_filter, cart_coeffs, 3 );
+ *      y = IIR_biquad_update( &cart_filter, x );
+ */
+
+#ifndef IIR_BIQUAD_H
+#define IIR_BIQUAD_H
+
+#include <stdint.h>
+
+#define IIR_BIQUAD_MAX_SECTIONS 4
+
+typedef struct
+{
+    float b0, b1, b2;
+    float a1, a2;       /* a0 normalized to 1 */
+} IIR_biquad_coeffs;
+
+typedef struct
+{
+    uint32_t sections;
+    const IIR_biquad_coeffs *coeffs;
+    float s1[ IIR_BIQUAD_MAX_SECTIONS ];
+    float s2[ IIR_BIQUAD_MAX_SECTIONS ];
+} IIR_biquad;
+
+/* Quality factors of Butterworth sections. */
+#define IIR_BIQUAD_BUTTER2_Q    0.70710678f
+#define IIR_BIQUAD_BUTTER4_Q1   0.54119610f
+#define IIR_BIQUAD_BUTTER4_Q2   1.30656296f
+
+/* tan( pi * f * dt ), Pade approximation, relative error below 1e-7 up to
+f = fs / 4 and below 1e-4 up to 0.45 * fs. */
+#define IIR_BIQUAD_K( f, dt )   ( 3.14159265f * ( f ) * ( dt ) )
+#define IIR_BIQUAD_TAN( x ) \
+    ( ( x ) * ( 945.0f - 105.0f * ( x ) * ( x ) + ( x ) * ( x ) * ( x ) * ( x ) ) \
+      / ( 945.0f - 420.0f * ( x ) * ( x ) + 15.0f * ( x ) * ( x ) * ( x ) * ( x ) ) )
+
+/* Second order low pass section with cutoff fc (Hz) and quality factor q. */
+#define IIR_BIQUAD_LP_K( K, q ) \
+    { \
+        .b0 = ( K ) * ( K ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .b1 = 2.0f * ( K ) * ( K ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .b2 = ( K ) * ( K ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .a1 = 2.0f * ( ( K ) * ( K ) - 1.0f ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .a2 = ( 1.0f - ( K ) / ( q ) + ( K ) * ( K ) ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+    }
+#define IIR_BIQUAD_LP( fc, q, dt ) \
+    IIR_BIQUAD_LP_K( IIR_BIQUAD_TAN( IIR_BIQUAD_K( fc, dt ) ), q )
+
+/* Notch section at f0 (Hz) with quality factor q. */
+#define IIR_BIQUAD_NOTCH_K( K, q ) \
+    { \
+        .b0 = ( 1.0f + ( K ) * ( K ) ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .b1 = 2.0f * ( ( K ) * ( K ) - 1.0f ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .b2 = ( 1.0f + ( K ) * ( K ) ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .a1 = 2.0f * ( ( K ) * ( K ) - 1.0f ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+        .a2 = ( 1.0f - ( K ) / ( q ) + ( K ) * ( K ) ) / ( 1.0f + ( K ) / ( q ) + ( K ) * ( K ) ), \
+    }
+#define IIR_BIQUAD_NOTCH( f0, q, dt ) \
+    IIR_BIQUAD_NOTCH_K( IIR_BIQUAD_TAN( IIR_BIQUAD_K( f0, dt ) ), q )
+
+/* Assign coefficients of sections (at most IIR_BIQUAD_MAX_SECTIONS) and zero state. */
+void IIR_biquad_init( IIR_biquad *iir, const IIR_biquad_coeffs *coeffs, uint32_t sections );
+
+/* Set state to the steady state of a constant input. */
+void IIR_biquad_reset( IIR_biquad *iir, float in );
+
+float IIR_biquad_update( IIR_biquad *iir, float in );
+
+/* Butterworth low pass, cutoff fc (Hz) below 0.5 / dt. Writes ( order + 1 ) / 2
+sections to coeffs and returns their number, 0 if order is out of range. */
+uint32_t IIR_biquad_design_butterworth_lp( IIR_biquad_coeffs *coeffs, uint32_t order, float fc, float dt );
+
+/* One notch section at f0 (Hz) below 0.5 / dt, q > 0. */
+void IIR_biquad_design_notch( IIR_biquad_coeffs *coeffs, float f0, float q, float dt );
+
+#endif // IIR_BIQUAD_H
@@ -46,6 +46,115 @@ enum cart_position_zones
 };
 #endif // CART_POSITION_ZONE_FLAGS
 
+/* Cart position zone limits, cm, set by watchdog task. Note: max cart run is 40.7cm */
+#define FREEZING_ZONE_L_LOWER_LIMIT     0.0f
+#define OK_ZONE_LOWER_LIMIT             3.0f
+#define FREEZING_ZONE_R_LOWER_LIMIT     (40.07f - OK_ZONE_LOWER_LIMIT)
+
+/* Enum for control law run by util task (control pipeline) every control tick. */
+#ifndef CTRL_LAWS_ENUM
+#define CTRL_LAWS_ENUM
+enum ctrl_laws
+{
+    /* No control law, pipeline doesn't write to the motor driver. */
+    CTRL_LAW_NONE,
+    /* Down position controller, ctrl_3_FSF_downpos_law(). */
+    CTRL_LAW_DPC,
+    /* Up position controller, ctrl_5_FSF_uppos_law(). */
+    CTRL_LAW_UPC,
+    /* Energy shaping swingup, ctrl_7_energy_swingup_law(). */
+    CTRL_LAW_SWINGUP,
+    /* TVLQR tracking of the optimized swingup trajectory, ctrl_8_tvlqr_swingup_law(). */
+    CTRL_LAW_SWINGUP_TVLQR
+};
+#endif // CTRL_LAWS_ENUM
+
+/* Cart speed estimate used by util task (cart_speed[ 0 ]). */
+#ifndef CART_SPEED_SOURCES_ENUM
+#define CART_SPEED_SOURCES_ENUM
+enum cart_speed_sources
+{
+    /* Tustin derivative of cart position, low-pass filtered (LP_CH_CART_SPEED, "tcc"). */
+    CART_SPEED_LP,
+    /* M/T estimate from encoder edge timestamps, cart_vel.h. */
+    CART_SPEED_MT
+};
+#endif // CART_SPEED_SOURCES_ENUM
+
+/* Channels of util task low pass filter bank (LP_filters). */
+#ifndef LP_CHANNELS_ENUM
+#define LP_CHANNELS_ENUM
+enum lp_channels
+{
+    LP_CH_PEND_SPEED,   /* pendulum angle derivative, "tcp" */
+    LP_CH_CART_SPEED,   /* cart position derivative, "tcc" */
+    LP_CH_SP_POT,       /* cart position setpoint from potentiometer */
+    LP_CH_SP_CLI,       /* cart position setpoint from cli */
+    LP_CH_COUNT
+};
+#endif // LP_CHANNELS_ENUM
+
+/* Estimator of cart and pendulum speed used by util task. */
+#ifndef STATE_ESTIMATORS_ENUM
+#define STATE_ESTIMATORS_ENUM
+enum state_estimators
+{
+    /* Tustin derivatives, low-pass filtered (cart speed source from cart_speed_select()). */
+    STATE_EST_LP,
+    /* Kalman filter driven by motor voltage and both encoders, kalman.h. */
+    STATE_EST_KF,
+    /* Polynomial fit derivatives over a sliding window, poly_diff.h, no dead zone. */
+    STATE_EST_PD
+};
+#endif // STATE_ESTIMATORS_ENUM
+
+/* Control law behind CTRL_LAW_UPC. */
+#ifndef UPC_LAWS_ENUM
+#define UPC_LAWS_ENUM
+enum upc_laws
+{
+    /* Full state feedback, ctrl_5_FSF_uppos_law(). */
+    UPC_LAW_FSF,
+    /* Constrained MPC around the same feedback, ctrl_6_MPC_uppos_law(), mpc.h. */
+    UPC_LAW_MPC
+};
+#endif // UPC_LAWS_ENUM
+
+/* Swingup procedure run by swingup task. */
+#ifndef SWINGUP_MODES_ENUM
+#define SWINGUP_MODES_ENUM
+enum swingup_modes
+{
+    /* Open loop voltage lookup table from SWINGUP_START_POSITION, DPC moves the cart there first. */
+    SWINGUP_MODE_TABLE,
+    /* Closed loop energy shaping around the cart setpoint, swingup_energy.h. */
+    SWINGUP_MODE_ENERGY,
+    /* Optimized trajectory from SWINGUP_TVLQR_START_CM tracked with time-varying LQR, swingup_tvlqr.h. */
+    SWINGUP_MODE_TVLQR
+};
+#endif // SWINGUP_MODES_ENUM
+
+/* Polynomial fit differentiators of "estimator pd" (poly_diff.h): window
+(samples), polynomial order, delay of the evaluation point (samples). */
+#define PD_WINDOW   4
+#define PD_ORDER    1
+#define PD_DELAY    0.0f
+
+/* Pendulum angle in util task is an integer, sum of the last PEND_ENC_AVG_LEN
+encoder counts relative to the down position at startup (pend_init_count_sum),
+so one revolution is PEND_ANGLE_SUM_PER_REV. Revolutions and base range angles
+of DPC and UPC are split from it with integer arithmetic, exact after any
+number of revolutions, float is used only for the base range fraction. */
+#define PEND_ANGLE_SUM_PER_REV  ( PEND_ENC_COUNTS_PER_REV * PEND_ENC_AVG_LEN )
+#define PEND_ANGLE_SUM_TO_RAD   ( PI2 / ( float ) PEND_ANGLE_SUM_PER_REV )
+
+/* Pendulum angle setpoints in base range, DPC [0, 2PI], UPC [-PI, PI]. Down
+position corresponds to PI radians, up position to 0 radians. */
+#define PENDULUM_ANGLE_DOWN_SETPOINT_BASE PI
+// non zero value because of pendulum encoder error
+// #define PENDULUM_ANGLE_UP_SETPOINT_BASE 0.0f
+#define PENDULUM_ANGLE_UP_SETPOINT_BASE -0.070563f // ??? probably not needed
+
 /* These values are used as task notification value for
 worker task. */
 #define GO_RIGHT    0x01    /* Move cart to the right. */
@@ -62,6 +171,10 @@ test task. */
 void watchdog_task( void *pvParameters );
 #define WATCHDOG_STACK_DEPTH 2000
 
+/* Limit switch task - handles limit switch interrupts (limit_switch.c), state change after motor cutoff. */
+void limit_switch_task( void *pvParameters );
+#define LIMITSW_STACK_DEPTH 500
+
 /* console task. */
 void console_task( void *pvParameters );
 #define MAX_INPUT_LENGTH    50
@@ -69,10 +182,49 @@ void console_task( void *pvParameters );
 // #define CONSOLE_STACKDEPTH  4000
 #define CONSOLE_STACKDEPTH  6000
 
-/* util task (State estimation & setpoint calc. task). */
+/* util task (control pipeline: state estimation & setpoint calc., control law, motor output). */
 void util_task( void *pvParameters );
 #define UTIL_STACK_DEPTH 1000
 
+/* Select control law run by util task. CTRL_LAW_NONE stops writing to the motor
+driver from the next tick on, caller sets the output voltage itself. */
+void ctrl_select_law( enum ctrl_laws law );
+
+/* ctrl_select_law() for interrupts with priority not above configMAX_SYSCALL_INTERRUPT_PRIORITY. */
+void ctrl_select_law_from_isr( enum ctrl_laws law );
+
+/* Select cart speed estimate used by util task from the next tick on. */
+void cart_speed_select( enum cart_speed_sources source );
+enum cart_speed_sources cart_speed_selected( void );
+
+/* Select speed estimator used by util task from the next tick on. */
+void state_est_select( enum state_estimators estimator );
+enum state_estimators state_est_selected( void );
+
+/* Select law run for CTRL_LAW_UPC from the next tick on. */
+void upc_law_select( enum upc_laws upc_law );
+enum upc_laws upc_law_selected( void );
+
+/* Control pipeline latency, DWT cycles, only ticks with active control law are counted.
+    sense to actuate : start of sensor reads to motor driver write
+    tick to actuate  : control tick ISR to motor driver write */
+typedef struct
+{
+    uint32_t count;
+    uint32_t sense_to_actuate_min;
+    uint32_t sense_to_actuate_max;
+    uint64_t sense_to_actuate_sum;
+    uint32_t tick_to_actuate_min;
+    uint32_t tick_to_actuate_max;
+    uint64_t tick_to_actuate_sum;
+} ctrl_pipeline_stats;
+
+/* Copy of current pipeline latency statistics. */
+void ctrl_pipeline_get_stats( ctrl_pipeline_stats *out );
+
+/* Clear pipeline latency statistics. */
+void ctrl_pipeline_reset_stats( void );
+
 /* Communication task - for serialOscilloscope. */
 void com_task( void *pvParameters );
 #define COM_STACK_DEPTH 500
@@ -86,21 +238,81 @@ Its purpose is to move the cart without any controller. */
 void cart_worker_task( void *pvParameters );
 #define CARTWORKER_STACK_DEPTH 500
 
-/* Controller 3 task
+/* Controller 3 control law
 Full state feedback Full state feedback with deadzone compensation,
-pendulum down position. */
-void ctrl_3_FSF_downpos_task( void *pvParameters );
-#define CTRL_3_FSF_DOWNPOS_STACK_DEPTH 500
+pendulum down position. Returns dc motor voltage. */
+float ctrl_3_FSF_downpos_law( void );
+
+/* Controller 5 control law
+Full state feedback up position with deadzone compensation.
+Returns dc motor voltage. */
+float ctrl_5_FSF_uppos_law( void );
 
-/* Controller 5 task
-Full state feedback up position with deadzone compensation. */
-void ctrl_5_FSF_uppos_task( void *pvParameters );
-#define CTRL_5_FSF_UPPOS_STACK_DEPTH 500
+/* Controller 6 control law
+MPC up position, controller 5 feedback corrected to keep the cart out of the
+freezing zones and the voltage in range. Returns dc motor voltage. */
+float ctrl_6_MPC_uppos_law( void );
+
+/* Distance controller 6 keeps from the freezing zones, cm. Stiction and
+deadzone are not in the prediction model, cart limit cycles of a few cm
+around the setpoint have to fit in. */
+#define MPC_ZONE_MARGIN_CM      3.0f
+
+/* Controller 6 model (lqr_get_plant()) and its LQR feedback, taken at the next
+call, warm start is dropped. Runs in the caller's task, returns 1 if the LQR
+of the model has no solution. */
+uint8_t ctrl_6_MPC_uppos_reset( void );
+
+/* Controller 6 solver statistics, cycles are DWT cycles of mpc_solve(). */
+typedef struct
+{
+    uint32_t solves;
+    uint32_t cycles_max;
+    uint64_t cycles_sum;
+    uint32_t sweeps_max;
+    uint32_t constrained;       /* solves with an active constraint */
+    uint32_t not_converged;     /* solves that used all MPC_MAX_SWEEPS */
+} mpc_law_stats;
+
+void ctrl_6_MPC_uppos_get_stats( mpc_law_stats *out );
+void ctrl_6_MPC_uppos_reset_stats( void );
+
+/* Controller 7 control law
+Energy shaping swingup around the cart position setpoint, brakes the cart to
+stop SWINGUP_ENERGY_ZONE_MARGIN_CM before the freezing zones. Returns dc motor voltage. */
+float ctrl_7_energy_swingup_law( void );
+
+/* Watchdog hand-off test of controller 7: 1 if UPC with the gain set in use,
+started from this state, stops the cart SWINGUP_ENERGY_CATCH_MARGIN_CM inside
+the freezing zones on the lqr model (swingup_energy_catch_ok()). */
+uint8_t ctrl_7_energy_swingup_catch_ok( void );
+
+/* Distance from the freezing zones where controller 7 plans to stop the cart, cm. */
+#define SWINGUP_ENERGY_ZONE_MARGIN_CM   4.0f
+
+/* Distance from the freezing zones UPC has to keep on the model after the
+hand-off, cm, covers the model error. */
+#define SWINGUP_ENERGY_CATCH_MARGIN_CM  2.0f
+
+/* Controller 8 control law
+TVLQR tracking of the optimized swingup trajectory, one table sample per
+10 ms, CTRL_TICK_HZ / 100 control ticks. Returns dc motor voltage. */
+float ctrl_8_tvlqr_swingup_law( void );
+
+/* Start controller 8 from the first sample, call before selecting the law. */
+void ctrl_8_tvlqr_swingup_reset( void );
+
+/* Controller 8 used all samples. */
+uint8_t ctrl_8_tvlqr_swingup_done( void );
 
 /* Swingup. */
 void swingup_task( void *pvParameters );
 #define SWINGUP_STACK_DEPTH 1000
 
+/* Select swingup procedure of the next "swingup" command. */
+void swingup_mode_select( enum swingup_modes mode );
+enum swingup_modes swingup_mode_selected( void );
+
 /* Swingdown */
 void swingdown_task( void *pvParameters );
 #define SWINGDOWN_STACK_DEPTH 1000
@@ -113,6 +325,10 @@ void bounceoff_task( void *pvParameters );
 void test_task( void *pvParameters );
 #define TEST_STACK_DEPTH 500
 
+/* LQR task - solves UPC / DPC gains in the background (lqr.h). */
+void lqr_task( void *pvParameters );
+#define LQR_STACK_DEPTH 500
+
 /* Function to create tasks. */
 void LIP_create_Tasks(void);
 
@@ -0,0 +1,54 @@
+/*
+ * Bank of first order low pass filters with transfer function:
+ * 1/(T*s+1)
+ * T - time constant, one per channel
+ * Discretized with Tustin (trapezoid) method, same as LP_filter.
+ *
+ * Coefficients are calculated when a time constant is set, not per sample.
+ * Channels are stored as struct of arrays, LP_bank_update() filters all of
+ * them in one pass without divisions.
+ *
+ *  eg. use
+ *      LP_bank bank;
+ *      LP_bank_init( &bank, 2, dt_ctrl );
+ *      LP_bank_set_time_constant( &bank, 0, 0.025f );
+ *      LP_bank_set_time_constant( &bank, 1, 0.2f );
+ *      ...
+ *      bank.in[ 0 ] = x0; bank.in[ 1 ] = x1;
+ *      LP_bank_update( &bank );            // outputs in bank.out[]
+ */
+
+#ifndef LP_BANK_H
+#define LP_BANK_H
+
+#include <stdint.h>
+
+#define LP_BANK_MAX_CHANNELS 8
+
+typedef struct
+{
+    uint32_t channels;
+    float samplingTime;
+    float timeConstant[ LP_BANK_MAX_CHANNELS ];
+
+    /* out = c1 * ( in + in_prev ) + c2 * out_prev */
+    float c1[ LP_BANK_MAX_CHANNELS ];
+    float c2[ LP_BANK_MAX_CHANNELS ];
+
+    /* Inputs are written by the caller before LP_bank_update(). */
+    float in[ LP_BANK_MAX_CHANNELS ];
+    float in_prev[ LP_BANK_MAX_CHANNELS ];
+    float out[ LP_BANK_MAX_CHANNELS ];
+
+} LP_bank;
+
+/* All channels with zero time constant (pass through trapezoid mean) and zero state. */
+void LP_bank_init( LP_bank *bank, uint32_t channels, float samplingTime );
+
+/* Set time constant of one channel, >= 0, recalculates its coefficients. */
+void LP_bank_set_time_constant( LP_bank *bank, uint32_t channel, float timeConstant );
+
+/* Filter bank->in[] of all channels, results in bank->out[]. */
+void LP_bank_update( LP_bank *bank );
+
+#endif // LP_BANK_H
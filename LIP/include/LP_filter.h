@@ -3,6 +3,8 @@
  * 1/(T*s+1)
  * T - time constant
  * Discretized with Tustin (trapezoid) method. 
+ * Coefficients are calculated in LP_init() and LP_update_time_Constant().
+ * For several filters updated together see LP_bank.h.
  */
 
 #ifndef LP_FILTER_H
@@ -14,6 +16,8 @@ typedef struct
 {
     float timeConstant;
     float samplingTime;
+    float c1;
+    float c2;
     float out[ 2 ];
     float in[ 2 ];
 
@@ -0,0 +1,49 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Cart velocity - mixed period/frequency (M/T) estimate from encoder edges.
+ *
+ * TIM4 counts the cart encoder in x4 quadrature mode, its CC1 channel captures
+ * the counter on every rising edge of encoder channel A (once per 4 counts,
+ * one full quadrature cycle, so duty and phase errors of the encoder cancel).
+ * The CC1 interrupt (dcm_encoder_driver.c) calls cart_vel_edge() with the
+ * captured count and the DWT cycle counter, the newest CART_VEL_EDGES edges
+ * are kept in a ring.
+ *
+ * cart_vel_update() runs once per control tick in util task:
+ *     - M/T estimate: counts between the newest edge and the oldest edge that
+ *       is at most CART_VEL_WINDOW_US older, divided by the time between them.
+ *       Both ends are edges, so there is no count quantization, at low speed
+ *       the window is one edge period. Estimate is centered half a window
+ *       before the newest edge, there is no low pass filter lag.
+ *     - No edge since the last edge: cart can't be faster than
+ *       CART_VEL_EDGE_COUNTS counts per time since that edge, the estimate
+ *       decays to this bound and is zero after CART_VEL_TIMEOUT_US, then the
+ *       edges are dropped and it stays zero until two new edges come in.
+ *
+ * Timestamps are taken in the CC1 interrupt (TIM4 is the position counter,
+ * it can't timestamp its own captures), interrupt latency is well below 1us.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef CART_VEL
+#define CART_VEL
+
+#include "stdint.h"
+
+/* Number of newest edges kept. */
+#define CART_VEL_EDGES          16
+
+/* Counts per capture edge (rising edges of channel A in x4 mode). */
+#define CART_VEL_EDGE_COUNTS    4
+
+/* Max time between the edges used for the estimate. */
+#define CART_VEL_WINDOW_US      2000UL
+
+/* Speed is zero when there was no edge for this long. */
+#define CART_VEL_TIMEOUT_US     100000UL
+
+/* Called from TIM4 CC1 interrupt, count is the captured counter value. */
+void cart_vel_edge( uint16_t count, uint32_t cycles );
+
+/* Cart velocity in cm/s, call once per control tick. */
+float cart_vel_update( void );
+
+#endif /* CART_VEL */
@@ -0,0 +1,88 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Control tick - hardware timer driven release of the control pipeline (util task).
+ *
+ * TIM7 update interrupt calls ctrl_tick_isr() CTRL_TICK_HZ times per second
+ * (see ctrl_tick_driver.h). The ISR gives a task notification on index
+ * CTRL_TICK_NOTIFY_INDEX to every registered task. Tasks call ctrl_tick_wait()
+ * once per period instead of vTaskDelayUntil(), so the control rate is not
+ * limited to and not quantized by configTICK_RATE_HZ.
+ *
+ * Jitter is measured with the DWT cycle counter:
+ *     isr period     : time between two ISR calls, shows interrupt latency
+ *                      variation (critical sections, higher priority ISRs)
+ *     wake latency   : time from ISR to return from ctrl_tick_wait() in the task
+ *     wake period    : time between two consecutive returns from ctrl_tick_wait()
+ *     overruns       : task called ctrl_tick_wait() after the next tick was already
+ *                      given, so it didn't finish within the period
+ * Wake ups that had more than one tick pending (task was suspended or overran
+ * by more than a period) are counted as overruns but not used for latency and
+ * period statistics.
+ *
+ * Stats are printed by "tick" cli command.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef CTRL_TICK
+#define CTRL_TICK
+
+#include "stdint.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Notification index used by the control tick, index 0 is used by cartworker and test tasks. */
+#define CTRL_TICK_NOTIFY_INDEX  1
+
+/* Max number of tasks released by the control tick. */
+#define CTRL_TICK_MAX_TASKS     4
+
+/* Statistics of one registered task, times in DWT cycles. */
+typedef struct
+{
+    TaskHandle_t task;
+    uint32_t wakeups;           /* wake ups used for statistics */
+    uint32_t overruns;
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint64_t latency_sum;
+    uint32_t period_min;
+    uint32_t period_max;
+
+    /* Private. */
+    uint32_t last_wake;         /* cycles at last return from ctrl_tick_wait() */
+    uint32_t woken_on_tick;     /* tick number the task was woken for */
+    uint8_t  woken;             /* task returned from ctrl_tick_wait() at least once */
+    uint8_t  last_wake_valid;   /* last_wake can be used for period statistics */
+} ctrl_tick_task_stats;
+
+/* Statistics of the control tick, times in DWT cycles. */
+typedef struct
+{
+    uint32_t ticks;             /* ISR calls since ctrl_tick_start() */
+    uint32_t isr_cycles;        /* cycles at last ISR call */
+    uint32_t isr_count;         /* ISR calls used for statistics */
+    uint32_t isr_period_min;
+    uint32_t isr_period_max;
+    uint32_t n_tasks;
+    ctrl_tick_task_stats task[ CTRL_TICK_MAX_TASKS ];
+} ctrl_tick_stats;
+
+/* Add task to be released by control tick, call before the scheduler is started. */
+void ctrl_tick_register( TaskHandle_t task );
+
+/* Start timer interrupt, call once from main_LIP_run() after the tasks are created. */
+void ctrl_tick_start( void );
+
+/* Called from TIM7 update interrupt. */
+void ctrl_tick_isr( void );
+
+/* Block calling (registered) task until the next control tick.
+Returns cycles at the ISR call of the latest tick, start of the period. */
+uint32_t ctrl_tick_wait( void );
+
+/* Copy of current statistics, consistent between ISR and tasks. */
+void ctrl_tick_get_stats( ctrl_tick_stats *out );
+
+/* Clear min/max/mean statistics and overrun counters. */
+void ctrl_tick_reset_stats( void );
+
+#endif /* CTRL_TICK */
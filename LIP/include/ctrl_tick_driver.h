@@ -0,0 +1,34 @@
+/*
+ * Description: Hardware part of the control tick (ctrl_tick.h)
+ *
+ * Notes: Timer for control tick is tim7 (htim7) (APB1@84MHz), basic timer,
+ *        update interrupt only, NVIC priority 5 (FreeRTOS FromISR API allowed)
+ *
+ *  PSC set to 83 (84) -> 1MHz counter clock
+ *  ARR set to CTRL_TICK_TIMER_HZ / CTRL_TICK_HZ - 1 in ctrl_tick_timer_start(),
+ *  value from CubeMX (9999, 100Hz) is overwritten
+ *
+ *  Jitter is measured with DWT cycle counter (CYCCNT) at core clock 168MHz.
+ *
+ */
+
+#ifndef CTRL_TICK_DRIVER
+#define CTRL_TICK_DRIVER
+
+#include "stdint.h"
+
+#define CTRL_TICK_TIMER_HANDLE  htim7
+
+/* TIM7 counter clock after prescaler. */
+#define CTRL_TICK_TIMER_HZ      1000000UL
+
+/* DWT cycle counter clock, core clock. */
+#define CTRL_TICK_CPU_HZ        168000000UL
+
+/* Set TIM7 period, enable DWT cycle counter and start update interrupt. */
+void ctrl_tick_timer_start( void );
+
+/* DWT cycle counter, wraps every 25.5s. */
+uint32_t ctrl_tick_cycles( void );
+
+#endif /* CTRL_TICK_DRIVER */
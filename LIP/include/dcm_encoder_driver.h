@@ -15,6 +15,18 @@
  *
  *	Counter mode: up
  *
+ *	CC1 interrupt on every rising edge of enc_A (once per 4 counts) feeds
+ *	cart velocity estimator, see cart_vel.h.
+ *
+ *	Extended count: every read adds the difference to the previous counter
+ *	value, wrapped into half a counter period either way, so position is a
+ *	signed 32bit count. No update interrupt: the direction bit at interrupt
+ *	time can't tell an underflow and overflow that bounced over count 0 (cart
+ *	resting on the zero position, no input filter) from a single wrap.
+ *	Left of the zero position it is negative, not ~7000 counts, and the
+ *	track can be longer than one counter period. Counts, cm and DWT
+ *	timestamp are read together with dcm_enc_get_snapshot().
+ *
  *	GPIOs used: PD12 for CH1 (alias enc_A)
  *		    	PD13 for CH2 (alias enc_B)
  *
@@ -28,12 +40,23 @@
 /* handle to timer */
 #define ENC_TIMER_HANDLE htim4
 
+/* Encoder timer auto-reload value, counter wraps to 0 above it */
+#define ENC_TIMER_ARR 7000
+
 /* Max encoder timer count */
 #define ENC_MAX_CNT 6488
 // #define TRACK_LEN_MAX_CM 47.0f
 #define TRACK_LEN_MAX_CM 40.7f
 #define ENCODER_MULTIPLIER 40.7f / 6488.0f
 
+/* Cart position read at one instant */
+typedef struct
+{
+	int32_t  counts;		/* extended count, 0 at the left limit switch */
+	float    position_cm;
+	uint32_t cycles;		/* DWT cycles at the read (ctrl_tick_cycles()) */
+} dcm_enc_snapshot;
+
 /* Start encoder timer in encoder mode */
 void enc_init(void);
 
@@ -43,6 +66,12 @@ uint16_t enc_get_count(void);
 /* Zero the encoder counter value */
 void dcm_enc_zero_counter(void);
 
+/* Extended counts, position in cm and timestamp, consistent with each other */
+void dcm_enc_get_snapshot(dcm_enc_snapshot *out);
+
+/* Returns signed extended encoder count */
+int32_t dcm_enc_get_counts(void);
+
 /* Returns cart position in cm */
 float dcm_enc_get_cart_position_cm(void);
 
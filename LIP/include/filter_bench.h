@@ -0,0 +1,36 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Filter benchmark - cost of the filters of the control pipeline per control tick.
+ *
+ * Every case runs the filtering work of one tick (e.g. the four low pass
+ * filters of util task) for a number of ticks on a fixed pseudo random input
+ * and reports clock ticks per control tick. The clock is passed in, so the
+ * same cases run on the target ("filterbench" cli command, DWT cycles) and on
+ * the host (sim/bench/sim_filter_bench.c, TSC cycles or ns).
+ *
+ * Cases that show an old implementation keep a private copy of it here.
+ * ISR cases (target only) time one filter update in a software triggered
+ * interrupt, from pending it to the return to the task.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef FILTER_BENCH_H
+#define FILTER_BENCH_H
+
+#include <stdint.h>
+
+/* Max number of results filter_bench_run() writes. */
+#define FILTER_BENCH_MAX_CASES 24
+
+/* Free running counter, wraps at 2^32. */
+typedef uint32_t ( *filter_bench_clock )( void );
+
+typedef struct
+{
+    const char *name;
+    float ticks_per_call;       /* clock ticks per control tick */
+} filter_bench_result;
+
+/* Run all cases for ticks control ticks each, returns number of results. */
+uint32_t filter_bench_run( filter_bench_clock clock, uint32_t ticks,
+                           filter_bench_result *results, uint32_t max_results );
+
+#endif /* FILTER_BENCH_H */
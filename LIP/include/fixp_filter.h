@@ -0,0 +1,155 @@
+/*
+ * Fixed point (Q15 / Q31) variants of LP_filter, FIR_filter, IIR_filter and
+ * of the Tustin derivative of util task.
+ *
+ * Update functions use only integer arithmetic, so they can run in timer or
+ * DMA interrupts without the FPU. An interrupt that uses the FPU while a task
+ * has an active FPU context pays for lazy stacking of S0-S15 and FPSCR on its
+ * first FPU instruction (see "filterbench" ISR cases).
+ * Init functions take float parameters like the float filters, call them
+ * from a task.
+ *
+ * Arithmetic is fully specified: products in 32 / 64 bit, results rounded
+ * half up ( ( acc + half ) >> shift, arithmetic shift) and saturated to the
+ * output format. Host and target give bit-exact results,
+ * sim/bench/sim_fixp_check.c compares them to a reference model.
+ *
+ * Formats:
+ *     Q15 - int16_t, value / 2^15, range [-1, 1)
+ *     Q31 - int32_t, value / 2^31, range [-1, 1)
+ *
+ *  eg. pendulum speed from an angle in Q15 (full scale pi rad) to Q15 speed
+ *  (full scale 32 rad/s):
+ *      deriv_q15 d;
+ *      LP_filter_q15 lp;
+ *      deriv_q15_init( &d, dt_ctrl, ( 3.14159265f / 32768.0f ) / ( 32.0f / 32768.0f ) );
+ *      LP_q15_init( &lp, 0.025f, dt_ctrl );
+ *      ...
+ *      speed = LP_q15_update( &lp, deriv_q15_update( &d, angle ) );
+ */
+
+#ifndef FIXP_FILTER_H
+#define FIXP_FILTER_H
+
+#include <stdint.h>
+#include "FIR_filter.h"
+
+/* Q31 FIR sums FIR_BUFF_LEN products of up to 2^62, each is shifted right by
+the guard bits first, log2( FIR_BUFF_LEN ). */
+#define FIR_Q31_GUARD_BITS 4
+
+/* Saturating conversions, for coefficients and tests. */
+int16_t fixp_q15_from_float( float x );
+int32_t fixp_q31_from_float( float x );
+float fixp_q15_to_float( int16_t x );
+float fixp_q31_to_float( int32_t x );
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * First order low pass 1/(T*s+1), Tustin, see LP_filter.h.
+ *     out = c1 * ( in + in_prev ) + c2 * out_prev
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    float timeConstant;
+    float samplingTime;
+    int16_t c1;         /* Q15 */
+    int16_t c2;         /* Q15 */
+    int16_t out;
+    int16_t in;
+} LP_filter_q15;
+
+typedef struct
+{
+    float timeConstant;
+    float samplingTime;
+    int32_t c1;         /* Q31 */
+    int32_t c2;         /* Q31 */
+    int32_t out;
+    int32_t in;
+} LP_filter_q31;
+
+void LP_q15_init( LP_filter_q15 *lp, float timeConstant, float samplingTime );
+int16_t LP_q15_update( LP_filter_q15 *lp, int16_t in );
+void LP_q15_update_time_Constant( LP_filter_q15 *lp, float newTimeConstant );
+
+void LP_q31_init( LP_filter_q31 *lp, float timeConstant, float samplingTime );
+int32_t LP_q31_update( LP_filter_q31 *lp, int32_t in );
+void LP_q31_update_time_Constant( LP_filter_q31 *lp, float newTimeConstant );
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FIR filter of FIR_BUFF_LEN taps, see FIR_filter.h. For other lengths and the
+ * SIMD kernel see FIR_engine_q15 in FIR_engine.h.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    int16_t buf[ FIR_BUFF_LEN ];
+    int16_t coeffs[ FIR_BUFF_LEN ];     /* coeffs[ 0 ] multiplies the newest sample */
+    uint8_t buf_index;
+    int16_t out;
+} FIR_filter_q15;
+
+typedef struct
+{
+    int32_t buf[ FIR_BUFF_LEN ];
+    int32_t coeffs[ FIR_BUFF_LEN ];
+    uint8_t buf_index;
+    int32_t out;
+} FIR_filter_q31;
+
+/* Coefficients as float, like FIR_init(), converted with saturation. */
+void FIR_q15_init( FIR_filter_q15 *fir, const float coeffs[ FIR_BUFF_LEN ] );
+int16_t FIR_q15_update( FIR_filter_q15 *fir, int16_t in );
+
+void FIR_q31_init( FIR_filter_q31 *fir, const float coeffs[ FIR_BUFF_LEN ] );
+int32_t FIR_q31_update( FIR_filter_q31 *fir, int32_t in );
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * First order IIR low pass, see IIR_filter.h.
+ *     y[n] = (1-a)*x[n] + a*y[n-1]
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    int32_t alpha;      /* Q15, 0 - 32768 */
+    int16_t out;
+} IIR_filter_q15;
+
+typedef struct
+{
+    int64_t alpha;      /* Q31, 0 - 2^31 */
+    int32_t out;
+} IIR_filter_q31;
+
+void IIR_q15_init_fo( IIR_filter_q15 *iir, float alpha );
+int16_t IIR_q15_update_fo( IIR_filter_q15 *iir, int16_t in );
+
+void IIR_q31_init_fo( IIR_filter_q31 *iir, float alpha );
+int32_t IIR_q31_update_fo( IIR_filter_q31 *iir, int32_t in );
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Tustin derivative, as pend_speed_raw / cart_speed_raw in util task.
+ *     out[n] = gain * ( in[n] - in[n-1] ) - out[n-1],  gain = 2 * scale / dt
+ * scale is output LSB per input LSB per second, gain is kept in Q16.16.
+ * Q31 input difference is saturated to 32 bits before the multiply (input
+ * steps larger than full scale). A saturated output also feeds back.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    int32_t gain;       /* Q16.16 */
+    int16_t in;
+    int16_t out;
+} deriv_q15;
+
+typedef struct
+{
+    int32_t gain;       /* Q16.16 */
+    int32_t in;
+    int32_t out;
+} deriv_q31;
+
+void deriv_q15_init( deriv_q15 *d, float samplingTime, float scale );
+int16_t deriv_q15_update( deriv_q15 *d, int16_t in );
+
+void deriv_q31_init( deriv_q31 *d, float samplingTime, float scale );
+int32_t deriv_q31_update( deriv_q31 *d, int32_t in );
+
+#endif // FIXP_FILTER_H
@@ -0,0 +1,101 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Gain sets of the full state feedback controllers (UPC, DPC).
+ *
+ * Named gain sets live in const tables (flash), one table per controller,
+ * each set with its own deadzone compensation, error dead bands and switch
+ * angle window. Cli command "gains" lists the tables and selects a schedule
+ * for a controller:
+ *     - one set, or
+ *     - two sets interpolated by an operating point variable, |cart position
+ *       error| (cm) or |pendulum angle error| (rad): set a below lo, set b
+ *       above hi, linear in between. Gains, deadzone and dead bands are
+ *       interpolated, the switch angle window is the union of both windows.
+ *
+ * One more set per controller lives in RAM, loaded at runtime by
+ * gain_sets_load() (LQR synthesis, lqr.h). It is listed and selected like the
+ * table sets, after the table sets.
+ *
+ * Cli task only posts the new schedule (gain_sched_request()), util task
+ * takes it at the start of a control tick (gain_sched_tick()) before any
+ * control law runs, so a law never sees a half written schedule and the
+ * switch always happens at a tick boundary.
+ *
+ * Gains are in the units of the controller design, u = F*(x_setpoint - x):
+ *     gains[ 0 ] - cart position error gain, V/m
+ *     gains[ 1 ] - pend angle error gain,    V/rad
+ *     gains[ 2 ] - cart speed error gain,    Vs/m
+ *     gains[ 3 ] - pend speed error gain,    Vs/rad
+ * laws convert the cart gains to V/cm.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef GAIN_SETS_H
+#define GAIN_SETS_H
+
+#include <stdint.h>
+
+#define GAIN_SET_NAME_LEN   12
+
+/* Controllers with gain set tables. */
+enum gain_set_ctrls
+{
+    GAIN_SET_DPC,
+    GAIN_SET_UPC,
+    GAIN_SET_CTRLS
+};
+
+/* Operating point variable of an interpolated schedule. */
+enum gain_sched_vars
+{
+    GAIN_SCHED_NONE,        /* set a only */
+    GAIN_SCHED_CART_ERROR,  /* |cart position error|, cm */
+    GAIN_SCHED_PEND_ERROR   /* |pendulum angle error|, rad */
+};
+
+typedef struct
+{
+    char name[ GAIN_SET_NAME_LEN ];
+    float gains[ 4 ];
+    float voltage_deadzone;         /* V, added with the sign of cart position error */
+    float cart_allowed_error_cm;    /* no cart position feedback inside +-, cm */
+    float pend_allowed_error;       /* no pend angle feedback inside +-, rad */
+    float switch_angle_low;         /* law runs only inside ( low, high ), base range angle, rad */
+    float switch_angle_high;
+} gain_set;
+
+typedef struct
+{
+    uint32_t a;                     /* table index */
+    uint32_t b;                     /* table index, used only with a schedule variable */
+    enum gain_sched_vars var;
+    float lo;
+    float hi;
+} gain_schedule;
+
+/* Number of sets of a controller, table sets and the RAM set once loaded. */
+uint32_t gain_sets_count( enum gain_set_ctrls ctrl );
+
+/* Copy of set with index < gain_sets_count(). The RAM set is the one in use by
+the laws, or the one posted by gain_sets_load() if util task didn't take it yet. */
+void gain_sets_get( enum gain_set_ctrls ctrl, uint32_t index, gain_set *out );
+
+/* Index of set with name (len chars, not terminated), -1 if there is none. */
+int32_t gain_sets_find( enum gain_set_ctrls ctrl, const char *name, uint32_t len );
+
+/* Post RAM set of a controller, taken by util task at the next tick.
+Returns its index. */
+uint32_t gain_sets_load( enum gain_set_ctrls ctrl, const gain_set *set );
+
+/* Post schedule for a controller, taken by util task at the next tick.
+Returns 1 if indices or breakpoints are invalid, nothing is posted then. */
+uint8_t gain_sched_request( enum gain_set_ctrls ctrl, const gain_schedule *sched );
+
+/* Schedule of a controller in use, or posted and not taken yet. */
+void gain_sched_get( enum gain_set_ctrls ctrl, gain_schedule *out );
+
+/* Take posted RAM sets and schedules, called by util task at the start of a tick. */
+void gain_sched_tick( void );
+
+/* Effective set of a controller at an operating point, called by control laws. */
+void gain_sched_eval( enum gain_set_ctrls ctrl, float cart_error_cm, float pend_error, gain_set *out );
+
+#endif // GAIN_SETS_H
@@ -0,0 +1,98 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Kalman filter for cart and pendulum state.
+ *
+ * Extended Kalman filter driven by the motor voltage applied during the last
+ * control period (dcm_get_output_voltage()) and corrected with both encoders.
+ * State (units of the rest of the app):
+ *     x[ KALMAN_X ]     - cart position                       cm
+ *     x[ KALMAN_TH ]    - pendulum angle, 0 is up              rad
+ *     x[ KALMAN_DX ]    - cart speed                           cm/s
+ *     x[ KALMAN_DTH ]   - pendulum speed                       rad/s
+ *     x[ KALMAN_DIST ]  - cart acceleration not explained by the motor model
+ *                         (friction, belt), random walk        cm/s^2
+ *
+ * Model:
+ *     cart        ddx    = -a dx + b u_eff + dist,  u_eff is u without the voltage deadzone
+ *     pendulum    ddth   = w0^2 sin(th) - c cos(th) ddx - d dth
+ * The cart part is discretized exactly for a voltage held over the period,
+ * the pendulum part with one trapezoid step driven by the mean cart
+ * acceleration over the period. Covariance is propagated with the Jacobian
+ * of the discrete model at the current estimate, so the same filter works
+ * around the up and the down position.
+ *
+ * Model parameters are not identified on the rig, they are the rigid body
+ * and motor parameters of the simulator plant (sim_plant_default_params(),
+ * translating mass 0.6 kg, 2.67 N/V, 18.8 Ns/m, pendulum m*l 0.015 kgm,
+ * J 0.003 kgm^2).
+ *
+ * A measurement that is far from the prediction (encoder zeroed at the left
+ * limit switch, pendulum angle offset changed from cli) resets the whole
+ * filter with kalman_reset() instead of being filtered: both positions to the
+ * measurement, speeds and disturbance to zero, the initial covariance. The
+ * other encoder's part of the state is reset too, the cart and pendulum
+ * states are coupled through the covariance.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef KALMAN_H
+#define KALMAN_H
+
+#include <stdint.h>
+
+/* State vector indices and size. */
+#define KALMAN_X        0
+#define KALMAN_TH       1
+#define KALMAN_DX       2
+#define KALMAN_DTH      3
+#define KALMAN_DIST     4
+#define KALMAN_N        5
+
+/* Cart model: speed pole (1/s) and acceleration per volt (cm/s^2/V). */
+#define KALMAN_CART_POLE        31.3f
+#define KALMAN_CART_GAIN        444.0f
+#define KALMAN_VOLTAGE_DEADZONE 1.0f
+
+/* Pendulum model: m*g*l/J (1/s^2), m*l/J (rad/cm), viscous friction / J (1/s). */
+#define KALMAN_PEND_W0_SQ       49.05f
+#define KALMAN_PEND_COUPLING    0.05f
+#define KALMAN_PEND_DAMPING     0.167f
+
+/* Measurement noise standard deviation, about one encoder count. */
+#define KALMAN_R_CART_CM        0.01f
+#define KALMAN_R_PEND_RAD       0.002f
+
+/* Process noise, standard deviation of unmodeled acceleration (per sqrt(s))
+and of the disturbance random walk. */
+#define KALMAN_Q_CART_ACC       30.0f
+#define KALMAN_Q_PEND_ACC       3.0f
+#define KALMAN_Q_DIST           300.0f
+
+/* Innovation that resets the state instead of correcting it. */
+#define KALMAN_RESET_CART_CM    2.0f
+#define KALMAN_RESET_PEND_RAD   0.5f
+
+typedef struct
+{
+    float x[ KALMAN_N ];
+    float P[ KALMAN_N ][ KALMAN_N ];
+
+    /* Discretization coefficients, set by kalman_init(). */
+    float dt;
+    float ea;           /* exp( -a dt ) */
+    float g1;           /* ( 1 - ea ) / a */
+    float g2;           /* ( dt - g1 ) / a */
+    float Q[ KALMAN_N ];
+
+    uint8_t initialized;
+    uint32_t resets;    /* state resets after large innovation */
+} kalman_filter;
+
+void kalman_init( kalman_filter *kf, float samplingTime );
+
+/* Set state to the measurement with zero speeds and disturbance. */
+void kalman_reset( kalman_filter *kf, float cart_cm, float pend_rad );
+
+/* One control period: predict with voltage applied during the last period,
+correct with the measurements taken now. First call resets the state. */
+void kalman_update( kalman_filter *kf, float voltage, float cart_cm, float pend_rad );
+
+#endif // KALMAN_H
@@ -0,0 +1,70 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Limit switches - interrupt driven motor cutoff at track ends.
+ *
+ * Both limit switches are wired to EXTI15_10 (rising edge, NVIC priority 5).
+ * HAL_GPIO_EXTI_Callback() in main_LIP.c calls limit_switch_isr(), which:
+ *     1. zeroes TIM3 PWM compare registers and forces update event, so the
+ *        motor voltage is zero right away and not at the end of PWM period
+ *     2. stops control law in util task (CTRL_LAW_NONE), so the pipeline
+ *        can't write its output again
+ *     3. notifies limit switch task (LIP_task_limitswitch.c) on index
+ *        LIMIT_SW_NOTIFY_INDEX with LIMIT_SW_LEFT / LIMIT_SW_RIGHT bit set
+ * Limit switch task does the rest (suspend tasks, app state change, encoder
+ * zeroing), it also polls the switches in case an edge was missed.
+ *
+ * Latency is measured with the DWT cycle counter from the callback entry:
+ *     switch to zero voltage : PWM compare registers zeroed and update generated
+ *     switch to handled      : limit switch task finished state change
+ * Interrupt entry and HAL dispatch before the callback (well below 1us) are
+ * not included.
+ *
+ * Stats are printed by "limitsw" cli command.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef LIMIT_SWITCH
+#define LIMIT_SWITCH
+
+#include "stdint.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Notification index used by limit switch task. */
+#define LIMIT_SW_NOTIFY_INDEX   0
+
+/* Notification value bits, switch that generated the edge. */
+#define LIMIT_SW_LEFT           0x01
+#define LIMIT_SW_RIGHT          0x02
+
+/* Statistics of limit switch interrupts, times in DWT cycles. */
+typedef struct
+{
+    uint32_t edges;             /* edges handled by limit_switch_isr() */
+    uint32_t cutoff_min;
+    uint32_t cutoff_max;
+    uint64_t cutoff_sum;
+    uint32_t handled;           /* notifications finished by limit switch task */
+    uint32_t handled_min;
+    uint32_t handled_max;
+    uint64_t handled_sum;
+
+    /* Private. */
+    uint32_t last_edge;         /* cycles at last limit_switch_isr() entry */
+} limit_switch_stats;
+
+/* Set task notified by limit_switch_isr(), call before the scheduler is started. */
+void limit_switch_init( TaskHandle_t task );
+
+/* Called from HAL_GPIO_EXTI_Callback(), other pins are ignored. */
+void limit_switch_isr( uint16_t GPIO_Pin );
+
+/* Called by limit switch task after notification was handled. */
+void limit_switch_handled( void );
+
+/* Copy of current statistics. */
+void limit_switch_get_stats( limit_switch_stats *out );
+
+/* Clear statistics. */
+void limit_switch_reset_stats( void );
+
+#endif /* LIMIT_SWITCH */
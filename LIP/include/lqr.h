@@ -0,0 +1,137 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Discrete LQR synthesis for the full state feedback controllers.
+ *
+ * Solver for the discrete algebraic Riccati equation (DARE)
+ *     P = Q + A' P A - A' P B ( R + B' P B )^-1 B' P A
+ * with 4 states and one input, and the gain u = -K x,
+ *     K = ( R + B' P B )^-1 B' P A.
+ * It uses the structure preserving doubling algorithm:
+ *     W      = I + G H
+ *     A_next = A W^-1 A
+ *     G_next = G + A W^-1 G A'
+ *     H_next = H + A' H W^-1 A
+ * starting from A, G = B R^-1 B', H = Q. H converges to P quadratically, one
+ * step doubles the horizon, so 10 - 20 steps are enough for any sampling
+ * time. All matrices are in the solver struct, there is no allocation; one
+ * step is about 600 multiply-adds and one 4x4 solve, the caller decides how
+ * many steps to run at once (lqr_step()).
+ *
+ * lqr_discretize() gives the zero order hold model of a continuous model
+ * (matrix exponential, scaling and squaring of a Taylor series) and
+ * lqr_cart_pendulum_model() the linearized continuous model of the rig,
+ * state x = { cart position m, pend angle rad, cart speed m/s, pend speed rad/s },
+ * input u is motor voltage without the deadzone:
+ *     ddx   = -a dx + b u
+ *     ddth  =  s w0^2 th - s c ddx - d dth
+ * s = 1 at the up position, s = -1 at the down position (th is the angle
+ * error from the position). Same model as the Kalman filter (kalman.h).
+ *
+ * Gains in this order and units are the gains of the gain sets (gain_sets.h),
+ * the laws use u = F*( x_setpoint - x ) = -F*x, so F = K.
+ *
+ * Background synthesis (LIP_task_lqr.c): lqr_synthesize() hands weights to
+ * the lqr task, which builds the model for the selected controller at dt_ctrl,
+ * solves it at low priority without disturbing the control tick, loads the
+ * gains as the "lqr" RAM gain set of that controller (deadzone, dead bands
+ * and window copied from the set in use) and selects it. The switch happens
+ * at a tick boundary like any "gains" selection.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef LQR_H
+#define LQR_H
+
+#include <stdint.h>
+
+#include "gain_sets.h"
+#include "kalman.h"
+
+/* Number of states. */
+#define LQR_N               4
+
+/* Convergence: relative change of H in one step. */
+#define LQR_TOLERANCE       1.0e-5f
+
+/* Doubling steps before the solver gives up. */
+#define LQR_MAX_STEPS       40
+
+/* Default weights, Q diagonal { cart position, pend angle, cart speed, pend speed }, R. */
+#define LQR_UPC_Q           { 5000.0f, 500.0f, 0.0f, 0.0f }
+#define LQR_UPC_R           1.0f
+#define LQR_DPC_Q           { 2000.0f, 100.0f, 0.0f, 0.0f }
+#define LQR_DPC_R           1.0f
+
+/* Linearized cart - pendulum model parameters. */
+typedef struct
+{
+    float cart_pole;        /* a, 1/s */
+    float cart_gain;        /* b, m/s^2/V */
+    float pend_w0_sq;       /* w0^2 = m g l / J, 1/s^2 */
+    float pend_coupling;    /* c = m l / J, rad/m */
+    float pend_damping;     /* d, 1/s */
+} lqr_plant_params;
+
+/* Default model, Kalman filter parameters in SI units. */
+#define LQR_PLANT_DEFAULT   { KALMAN_CART_POLE, KALMAN_CART_GAIN * 0.01f, KALMAN_PEND_W0_SQ, \
+                              KALMAN_PEND_COUPLING * 100.0f, KALMAN_PEND_DAMPING }
+
+typedef struct
+{
+    /* Problem. */
+    float A[ LQR_N ][ LQR_N ];
+    float B[ LQR_N ];
+    float Q[ LQR_N ];       /* diagonal of Q */
+    float R;
+
+    /* Doubling iterates, H is P when converged. */
+    float Ak[ LQR_N ][ LQR_N ];
+    float G[ LQR_N ][ LQR_N ];
+    float H[ LQR_N ][ LQR_N ];
+
+    uint32_t steps;
+    float change;           /* relative change of H in the last step */
+    uint8_t converged;
+    uint8_t failed;         /* singular W or not finite, weights or model not usable */
+} lqr_solver;
+
+/* Continuous model of the rig around the up ( down = 0 ) or down ( down = 1 ) position. */
+void lqr_cart_pendulum_model( const lqr_plant_params *p, uint8_t down,
+                              float Ac[ LQR_N ][ LQR_N ], float Bc[ LQR_N ] );
+
+/* Zero order hold discretization with sampling time dt. */
+void lqr_discretize( const float Ac[ LQR_N ][ LQR_N ], const float Bc[ LQR_N ], float dt,
+                     float A[ LQR_N ][ LQR_N ], float B[ LQR_N ] );
+
+/* Set up the solver for discrete A, B, diagonal Q ( >= 0 ) and R ( > 0 ). */
+void lqr_init( lqr_solver *s, const float A[ LQR_N ][ LQR_N ], const float B[ LQR_N ],
+               const float Q[ LQR_N ], float R );
+
+/* One doubling step. Returns 1 when converged or failed, see s->converged / s->failed. */
+uint8_t lqr_step( lqr_solver *s );
+
+/* Gain of the converged solution, u = -K x. */
+void lqr_gain( const lqr_solver *s, float K[ LQR_N ] );
+
+/* Result of the last synthesis by the lqr task. */
+typedef struct
+{
+    enum gain_set_ctrls ctrl;
+    float Q[ LQR_N ];
+    float R;
+    float K[ LQR_N ];
+    uint32_t steps;
+    uint32_t cycles;        /* DWT cycles spent in the solver (model, steps and gain) */
+    uint8_t busy;
+    uint8_t valid;          /* K was solved and loaded */
+} lqr_status;
+
+/* Start synthesis of ctrl gains with diagonal Q and R in the lqr task.
+Returns 1 if the task is still busy with the previous one. */
+uint8_t lqr_synthesize( enum gain_set_ctrls ctrl, const float Q[ LQR_N ], float R );
+
+void lqr_get_status( lqr_status *out );
+
+/* Model used by the next synthesis. */
+void lqr_set_plant( const lqr_plant_params *p );
+void lqr_get_plant( lqr_plant_params *out );
+
+#endif // LQR_H
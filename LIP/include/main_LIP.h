@@ -26,11 +26,25 @@
 #include "dcm_encoder_driver.h"
 #include "com_driver.h"
 #include "pend_enc_driver.h"
+#include "pot_adc_driver.h"
 #include "FIR_filter.h"
 #include "filters_coeffs.h"
 #include "IIR_filter.h"
 #include "LIP_tasks_common.h"
 #include "LP_filter.h"
+#include "LP_bank.h"
+#include "kalman.h"
+#include "poly_diff.h"
+#include "gain_sets.h"
+#include "lqr.h"
+#include "mpc.h"
+#include "swingup_energy.h"
+#include "swingup_tvlqr.h"
+#include "ctrl_tick.h"
+#include "task_prof.h"
+#include "limit_switch.h"
+#include "pend_enc_sampler.h"
+#include "cart_vel.h"
 
 /* Note: define only one COM_SEND_* */ 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
@@ -59,10 +73,18 @@ Send: pend angle, pend speed, 0,
 #define READ_ZERO_POSITION_REACHED HAL_GPIO_ReadPin( limitSW_left_GPIO_Port, limitSW_left_Pin )
 #define READ_MAX_POSITION_REACHED HAL_GPIO_ReadPin( limitSW_right_GPIO_Port, limitSW_right_Pin )
 
-/* Sampling period in ms for controllers and util tasks. */
+/* Control tick rate in Hz for util task (control pipeline). This task is released
+by TIM7 update interrupt (ctrl_tick.c), not by RTOS tick, so the rate doesn't depend
+on configTICK_RATE_HZ. Has to divide 1MHz (TIM7 counter clock), at most CTRL_TICK_HZ_MAX.
+Note: controller gains were designed for 100Hz. */
+#define CTRL_TICK_HZ        100
+#define CTRL_TICK_HZ_MAX    2000
+/* Sampling period in s for control laws and util task. */
+#define dt_ctrl             ( 1.0f / CTRL_TICK_HZ )
+/* multiply by dt_inv instead of dividing by dt_ctrl. */
+#define dt_inv              ( ( float ) CTRL_TICK_HZ )
+/* Sampling period in ms for tasks still timed by RTOS tick (swingdown, raw communication). */
 #define dt                  10
-/* multiply by dt_inv instead of dividing by dt. */
-#define dt_inv              100.0f
 /* Sampling period in ms for watchdog task. */
 #define dt_watchdog         25
 /* Sampling period in ms for console task. */
@@ -77,11 +99,13 @@ Don't change this value or swingup routing will not work properly.
 Swingup output voltage lookup table was calculated with 10ms sampling period. */
 #define dt_swingup          10
 
+/* Priority for limit switch task - runs right after limit switch interrupt. */
+#define PRIORITY_LIMITSW    5
 /* Priority for watchdog task. */
 #define PRIORITY_WATCHDOG   4 
-/* Priority for util task - has to be the same as for controler task. */
+/* Priority for util task - control pipeline, state estimation and control law. */
 #define PRIORITY_UTIL       3 
-/* Priority for any controller task. */
+/* Priority for swingup, swingdown and bounce off tasks. */
 #define PRIORITY_CTRL       3 
 /* Priority for console task. */
 #define PRIORITY_CONSOLE    2 
@@ -91,6 +115,8 @@ Swingup output voltage lookup table was calculated with 10ms sampling period. */
 #define PRIORITY_CARTWORKER 1 
 /* Priority for test task. */
 #define PRIORITY_TEST 2 
+/* Priority for lqr task - background gain synthesis. */
+#define PRIORITY_LQR        1
 
 /* For freertos config. */
 #define RTOS_USE_PREEMPTION     1
@@ -33,6 +33,7 @@
  */
 void dcm_init( void );
 void dcm_zero_output_voltage( void );
+void dcm_stop_from_isr( void );
 void dcm_set_output_volatage( float inV );
 float dcm_get_output_voltage( void );
 
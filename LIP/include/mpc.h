@@ -0,0 +1,110 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Constrained model predictive control around a state feedback.
+ *
+ * Prediction uses the pre-stabilized model (closed loop paradigm): input is
+ *     u_k = -K x_k + v_k
+ * with the discrete model x_k+1 = A x_k + B u_k and the feedback K of the
+ * running controller. The perturbation v is held over MPC_BLOCK ticks, there
+ * are MPC_MOVES blocks, after them v is zero. The cost is
+ *     J = 1/2 |v|^2
+ * so without active constraints v = 0 and the controller is exactly the state
+ * feedback, constraints are enforced with the smallest change of it. With the
+ * LQR gain of lqr.h this is the infinite horizon LQ cost up to a constant
+ * weight, with any stabilizing gain it is a minimum intervention correction.
+ *
+ * Constraints, both two sided:
+ *     position  x_k[ 0 ] in [ pos_min, pos_max ]   k = MPC_POS_STEP, 2 MPC_POS_STEP .. MPC_HORIZON
+ *     input     u_k      in [ -u_max, u_max ]      k = 0 .. MPC_U_ROWS - 1
+ * Input rows cover the ticks where v is free, after them the feedback runs
+ * alone and the motor driver limits the voltage.
+ *
+ * QP solver: dual coordinate ascent (Hildreth) on the constraint rows, every
+ * row update is exact for its dual variable,
+ *     y_i = ( r - clamp( r, lo, hi ) ) / |M_i|^2,  v = -M' y
+ * where r is the row value without its own dual. Duals are warm started from
+ * the previous tick, input duals shifted by one tick. Without active constraints one
+ * sweep finds the solution. Row coefficients are read from the response to a
+ * unit perturbation block (rebuilt only when K changes), nothing is stored
+ * per row except the free response and the dual.
+ *
+ * Cost of one solve: free response MPC_HORIZON * 20 MACs, warm start and
+ * one sweep about ( MPC_POS_ROWS + MPC_U_ROWS / 2 ) * MPC_MOVES MACs each.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef MPC_H
+#define MPC_H
+
+#include <stdint.h>
+
+/* Number of states, same order and units as lqr.h. */
+#define MPC_N               4
+
+/* Prediction horizon, ticks. */
+#define MPC_HORIZON         50
+
+/* Perturbation blocks and ticks per block. */
+#define MPC_MOVES           10
+#define MPC_BLOCK           2
+
+/* Position is constrained every MPC_POS_STEP ticks, rows of neighbouring
+ticks are almost parallel and slow the solver down. */
+#define MPC_POS_STEP        5
+#define MPC_POS_ROWS        ( MPC_HORIZON / MPC_POS_STEP )
+
+/* Input constraint rows, ticks with a free perturbation. */
+#define MPC_U_ROWS          ( MPC_MOVES * MPC_BLOCK )
+
+/* Max sweeps over all rows per solve. */
+#define MPC_MAX_SWEEPS      10
+
+/* Constraint violation accepted as converged, m and V. */
+#define MPC_TOL_POS         0.0005f
+#define MPC_TOL_U           0.05f
+
+/* Perturbation at which warm start is dropped, V. */
+#define MPC_V_LIMIT         1000.0f
+
+typedef struct
+{
+    /* Model and feedback. */
+    float A[ MPC_N ][ MPC_N ];
+    float B[ MPC_N ];
+    float K[ MPC_N ];
+    uint8_t gain_valid;                 /* K set since mpc_init() */
+    float Phi[ MPC_N ][ MPC_N ];        /* A - B K */
+
+    /* Response d ticks after the start of a unit perturbation block,
+    state and feedback K r[ d ], d = 0 .. MPC_HORIZON. */
+    float r[ MPC_HORIZON + 1 ][ MPC_N ];
+    float kr[ MPC_HORIZON + 1 ];
+
+    /* Squared norms of constraint rows. */
+    float a_pos[ MPC_POS_ROWS ];
+    float a_u[ MPC_U_ROWS ];
+
+    /* Free response ( v = 0 ) of the last solve. */
+    float c_pos[ MPC_POS_ROWS ];
+    float c_u[ MPC_U_ROWS ];
+
+    /* Duals, kept for warm start, and the perturbation. */
+    float y_pos[ MPC_POS_ROWS ];
+    float y_u[ MPC_U_ROWS ];
+    float v[ MPC_MOVES ];
+
+    /* Last solve. */
+    uint32_t sweeps;
+    uint32_t active;                    /* rows with nonzero dual */
+    uint8_t converged;
+} mpc_controller;
+
+/* Set discrete model, feedback is zero until mpc_set_gain(). */
+void mpc_init( mpc_controller *m, const float A[ MPC_N ][ MPC_N ], const float B[ MPC_N ] );
+
+/* Set feedback u = -K x, responses are rebuilt only if K changed. */
+void mpc_set_gain( mpc_controller *m, const float K[ MPC_N ] );
+
+/* Input for state x (relative to the setpoint), position limits relative to
+the setpoint. Returns -K x + v_0, clamped to +-u_max. */
+float mpc_solve( mpc_controller *m, const float x[ MPC_N ], float pos_min, float pos_max, float u_max );
+
+#endif // MPC_H
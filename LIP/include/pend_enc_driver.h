@@ -16,15 +16,34 @@
 #define PI  3.1415926536f
 #define PI2 6.2831853072f
 
+/* AS5600 counts per revolution. */
+#define PEND_ENC_COUNTS_PER_REV 4096
+
 uint8_t pend_enc_init( void );
 
+/* Start background sampling of raw angle (i2c1 interrupt transfers), call
+after the DWT cycle counter is enabled. */
+void pend_enc_sampling_start( void );
+
+/* Restart background sampling if there was no new sample since the last
+call, called periodically from watchdog task. */
+void pend_enc_sampling_check( void );
+
 uint8_t pend_enc_read_angle_deg( float *angle );
 uint8_t pend_enc_read_angle_rad( float *angle );
 
 uint8_t pend_enc_deinit( void );
 
+/* Unwrapped count of the newest sample. */
 int32_t pend_enc_get_cumulative_count( void );
 
+/* Mean unwrapped count of the last PEND_ENC_AVG_LEN samples (sub count resolution). */
+float pend_enc_get_cumulative_count_avg( void );
+
+/* Sum of unwrapped counts of the last PEND_ENC_AVG_LEN samples, integer
+form of the mean, valid for +-( 2^31 / ( 4096 * PEND_ENC_AVG_LEN ) ) revolutions. */
+int32_t pend_enc_get_cumulative_count_sum( void );
+
 int32_t pend_enc_get_base_count( void );
 
 /* Get number of full pendulum revolutions, negative number indicates negative revolution. */
@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Pendulum encoder sampler - newest AS5600 raw angle sample, double buffered.
+ *
+ * The AS5600 RAW ANGLE register is read in the background by an interrupt
+ * driven I2C transfer chain (pend_enc_driver.c), every finished transfer calls
+ * pend_enc_sampler_push() from the I2C interrupt. Tasks take the newest sample
+ * with pend_enc_sampler_read(), which never waits on the bus.
+ *
+ * Push writes the buffer that is not published and then publishes it, so a
+ * reader is never handed a half written sample. Read copies the published
+ * buffer and repeats the copy if a push overwrote it meanwhile (sequence
+ * number changed), so the ISR is never blocked either.
+ *
+ * Every sample is timestamped with the DWT cycle counter (ctrl_tick_cycles())
+ * at transfer complete, the age of the sample at read time is in the stats.
+ *
+ * Multi-rate acquisition: revolution unwrapping runs in push at the sample
+ * rate (about 8kHz with back to back 120us transfers, measured in the sim
+ * only, "as5600" shows the sample period on the rig), not in the 100Hz control loop. Unwrapping is correct as
+ * long as the arm turns less than half revolution between two samples, so the
+ * max trackable rate is 1/2 rev per longest sample period (AS5600 itself
+ * updates its output every PEND_ENC_AS5600_UPDATE_US). Push also keeps the sum
+ * of the last PEND_ENC_AVG_LEN unwrapped counts, the control loop reads their
+ * mean (pend_enc_sample_avg_count()), which is the sample stream decimated to
+ * the control rate with a short boxcar (about 0.5ms, 0.2ms delay).
+ *
+ * Stats are printed by "as5600" cli command.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef PEND_ENC_SAMPLER
+#define PEND_ENC_SAMPLER
+
+#include "stdint.h"
+
+/* Number of newest samples averaged for the control loop, power of two. */
+#define PEND_ENC_AVG_LEN            4
+
+/* AS5600 output update period (datasheet: sampling rate 150us). */
+#define PEND_ENC_AS5600_UPDATE_US   150
+
+/* One AS5600 raw angle sample. */
+typedef struct
+{
+    uint16_t raw;               /* RAW ANGLE register, 0 - 4095 */
+    int32_t  count;             /* unwrapped cumulative count */
+    int32_t  revolutions;       /* full revolutions, negative for negative direction */
+    int32_t  avg_offset;        /* sum of last PEND_ENC_AVG_LEN counts - PEND_ENC_AVG_LEN * count */
+    uint32_t cycles;            /* DWT cycles at transfer complete */
+    uint32_t seq;               /* sample number, 0 means no sample yet */
+} pend_enc_sample;
+
+/* Sum of the last PEND_ENC_AVG_LEN unwrapped counts of a sample, exact. */
+#define pend_enc_sample_sum_count( sample ) \
+    ( ( sample )->count * PEND_ENC_AVG_LEN + ( sample )->avg_offset )
+
+/* Mean of the last PEND_ENC_AVG_LEN unwrapped counts of a sample. */
+#define pend_enc_sample_avg_count( sample ) \
+    ( ( float ) ( sample )->count + ( float ) ( sample )->avg_offset * ( 1.0f / PEND_ENC_AVG_LEN ) )
+
+/* Statistics of the sampler, times in DWT cycles. */
+typedef struct
+{
+    uint32_t samples;           /* pushed samples */
+    uint32_t errors;            /* failed I2C transfers */
+    uint32_t restarts;          /* I2C peripheral reinitialized after the chain stopped */
+    uint32_t periods;           /* sample periods used for statistics */
+    uint32_t period_min;
+    uint32_t period_max;
+    uint64_t period_sum;
+    uint32_t step_max;          /* largest unwrapped step between two samples, counts */
+    uint32_t reads;             /* pend_enc_sampler_read() calls */
+    uint32_t stale_reads;       /* reads that got the same sample as the previous read */
+    uint32_t age_max;           /* sample age at read time */
+    uint64_t age_sum;
+
+    /* Private. */
+    uint32_t last_push;         /* cycles at last push */
+    uint32_t last_read_seq;     /* sequence number of last read sample */
+} pend_enc_sampler_stats;
+
+/* Clear statistics, call before the first push. */
+void pend_enc_sampler_init( void );
+
+/* Publish new sample, called from I2C transfer complete interrupt
+(or before the scheduler is started). */
+void pend_enc_sampler_push( uint16_t raw );
+
+/* Count failed transfer, called from I2C error interrupt. */
+void pend_enc_sampler_error( void );
+
+/* Count I2C peripheral restart. */
+void pend_enc_sampler_restarted( void );
+
+/* Copy newest sample into out, returns its sequence number (0 if there is no sample yet). */
+uint32_t pend_enc_sampler_read( pend_enc_sample *out );
+
+/* Sequence number of newest sample, no statistics update. */
+uint32_t pend_enc_sampler_seq( void );
+
+/* Copy of current statistics. */
+void pend_enc_sampler_get_stats( pend_enc_sampler_stats *out );
+
+/* Clear statistics. */
+void pend_enc_sampler_reset_stats( void );
+
+#endif /* PEND_ENC_SAMPLER */
@@ -0,0 +1,66 @@
+/*
+ * Least squares polynomial fit differentiator over a sliding window.
+ *
+ * A polynomial of order 1 or 2 is fitted to the last window samples and its
+ * derivative is evaluated delay samples before the newest one:
+ *     delay = 0                   - derivative at the newest sample, no lag
+ *                                   beyond the fit, more noise
+ *     delay = ( window - 1 ) / 2  - Savitzky-Golay derivative at the window
+ *                                   centre, least noise, lag of delay samples
+ * It is an FIR filter, unlike the Tustin derivative there is no pole at z = -1
+ * and quantization noise doesn't ring at Nyquist.
+ *
+ * Cost is O(1) per sample, independent of the window: the fit needs only the
+ * sums S_k = sum( j^k * y[ n - j ] ), j = 0 .. window - 1, which are updated
+ * incrementally when a sample enters and the oldest one leaves. The sums are
+ * taken relative to a reference sample and rebuilt from the window every
+ * window samples, so float rounding doesn't accumulate and large absolute
+ * values (pendulum angle after many revolutions) don't cost precision.
+ *
+ *  eg. use
+ *      poly_diff pd;
+ *      poly_diff_init( &pd, 8, 2, 0.0f, dt_ctrl );     // 8 samples, quadratic, newest
+ *      ...
+ *      speed = poly_diff_update( &pd, position );
+ */
+
+#ifndef POLY_DIFF_H
+#define POLY_DIFF_H
+
+#include <stdint.h>
+
+#define POLY_DIFF_MAX_WINDOW 32
+
+typedef struct
+{
+    uint32_t window;
+    uint32_t order;
+    float delay;
+    float samplingTime;
+
+    /* derivative = w[ 0 ] * S0 + w[ 1 ] * S1 + w[ 2 ] * S2, 1/dt included */
+    float w[ 3 ];
+
+    /* Window samples, newest is buf[ pos ]. */
+    float buf[ POLY_DIFF_MAX_WINDOW ];
+    uint32_t pos;
+
+    /* Sums of samples minus ref. */
+    float ref;
+    float s[ 3 ];
+    uint32_t rebuild;   /* samples until sums are rebuilt */
+
+    uint8_t initialized;
+} poly_diff;
+
+/* window 2 - POLY_DIFF_MAX_WINDOW (at least 3 for order 2), order 1 or 2,
+delay 0 - ( window - 1 ) samples. Parameters out of range are clamped.
+The first update fills the window with its sample (zero derivative). */
+void poly_diff_init( poly_diff *pd, uint32_t window, uint32_t order, float delay, float samplingTime );
+
+/* Fill the window with a constant input. */
+void poly_diff_reset( poly_diff *pd, float in );
+
+float poly_diff_update( poly_diff *pd, float in );
+
+#endif // POLY_DIFF_H
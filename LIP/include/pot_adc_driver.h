@@ -0,0 +1,47 @@
+/*
+ * Description: Setpoint potentiometer ADC acquisition in lockstep with the control tick
+ *
+ * GPIOs used: PA3 for ADC3 IN3 (alias adc_pot)
+ *
+ * Notes: ADC3 from CubeMX is triggered by TIM2 TRGO at 200Hz into one
+ *        halfword, asynchronous to the control tick. pot_adc_init()
+ *        reconfigures it for software start with POT_ADC_OVERSAMPLE ranks, all
+ *        channel 3 (scan mode), DMA2 stream 0 circular over the burst buffer.
+ *        TIM2 is not started.
+ *
+ *  ctrl_tick_isr() calls pot_adc_tick() at every control tick: the burst
+ *  started by the previous tick is summed and the next burst is started, so
+ *  one tick samples are taken at the same point of every control period and
+ *  the util task gets them one tick later.
+ *
+ *  ADCCLK 21MHz (PCLK2 / 4), 480 + 12 cycles per conversion, a burst of 16
+ *  conversions takes 375us, shorter than the control tick period at
+ *  CTRL_TICK_HZ_MAX. STM32F4 ADC has no hardware oversampling, averaging is
+ *  the sum in pot_adc_tick().
+ *
+ */
+
+#ifndef POT_ADC_DRIVER
+#define POT_ADC_DRIVER
+
+#include "stdint.h"
+
+/* Conversions per control tick, 1 - 16 (regular sequence length). */
+#define POT_ADC_OVERSAMPLE  16
+
+/* ADC full scale, counts. */
+#define POT_ADC_COUNTS      4096
+
+/* Reconfigure ADC3 and start the first burst, call before the control tick is started. */
+void pot_adc_init( void );
+
+/* Latch the last burst and start the next one, called from the control tick ISR. */
+void pot_adc_tick( void );
+
+/* Sum of the POT_ADC_OVERSAMPLE conversions of the last finished burst. */
+uint32_t pot_adc_get_sum( void );
+
+/* Mean of the last finished burst, counts (fractional). */
+float pot_adc_get_counts( void );
+
+#endif // POT_ADC_DRIVER
@@ -0,0 +1,90 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Energy shaping swingup (closed loop alternative to the voltage lookup table).
+ *
+ * Pendulum energy normalized by m g l, zero at the up position at rest, -2
+ * hanging at rest ( th is the angle from the up position ):
+ *     E = dth^2 / ( 2 w0^2 ) + cos( th ) - 1
+ * With the pendulum model of lqr.h, ddth = w0^2 sin( th ) - c ddx cos( th ) - d dth,
+ *     dE/dt = -( c / w0^2 ) ddx dth cos( th ) - d dth^2 / w0^2
+ * so the cart acceleration
+ *     ddx = k_energy ( E - energy_ref ) dth cos( th )
+ * drives E to energy_ref (slightly above zero for the friction). It is
+ * saturated to accel_max. From rest ( dth = 0 ) nothing happens, so a
+ * pendulum hanging still is kicked with kick_accel first.
+ *
+ * Track limits: a PD term pulls the cart to the centre ( x = 0, the cart
+ * setpoint ), and when the cart can't stop before x_min / x_max braking at
+ * brake_accel, the swingup term is dropped and the cart brakes with accel_max.
+ *
+ * Acceleration is turned into voltage with the cart model of lqr.h,
+ *     u = ( ddx + a dx ) / b
+ * plus deadzone compensation in the direction of u, clamped to u_max.
+ *
+ * x_min / x_max are where the brake plans to stop the cart on the model. A
+ * cart with less friction or more mass than the model overshoots them, the
+ * swingup task stops the law at a freezing zone.
+ *
+ * The pendulum comes up fast ( energy_ref ) and often with the cart off
+ * centre. Caught in that state UPC can run the cart into a freezing zone, so
+ * the watchdog hands over only when swingup_energy_catch_ok() predicts that
+ * UPC stops the cart inside the zones, otherwise the pendulum swings over and
+ * the law tries again on the next pass.
+ *
+ * Plain float code without RTOS calls, the sim tools link it directly.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SWINGUP_ENERGY_H
+#define SWINGUP_ENERGY_H
+
+#include <stdint.h>
+
+#include "lqr.h"
+
+typedef struct
+{
+    float k_energy;         /* m/s^2 per unit energy per rad/s */
+    float energy_ref;       /* target normalized energy */
+    float accel_max;        /* m/s^2 */
+    float kick_accel;       /* m/s^2, from rest */
+    float kick_speed;       /* rad/s, kick below this pendulum speed near the bottom */
+    float k_x;              /* 1/s^2, cart centering */
+    float k_v;              /* 1/s */
+    float x_min;            /* m, cart limits relative to the centre */
+    float x_max;
+    float brake_accel;      /* m/s^2, assumed for the stopping distance */
+    float deadzone;         /* V */
+    float u_max;            /* V */
+} swingup_energy_params;
+
+/* Default tuning, rig model of lqr.h. With the centre at 20 cm the brake
+plans to stop the cart 4 cm before the freezing zones, this is not a margin
+the cart keeps: with the default spreads of sim_swingup_compare 15 % of the
+episodes still reach a freezing zone during the swing. */
+#define SWINGUP_ENERGY_DEFAULT  { 20.0f, 0.2f, 8.0f, 4.0f, 0.3f, 20.0f, 6.0f, \
+                                  -0.13f, 0.13f, 8.0f, 1.0f, 12.0f }
+
+/* Watchdog hands the energy swingup over to UPC inside this angle from the
+up position, rad. */
+#define SWINGUP_ENERGY_CATCH_RAD    0.35f
+
+/* Catch prediction, swingup_energy_catch_ok(): model step, steps per 10 ms
+control tick, horizon and UPC window. */
+#define SWINGUP_ENERGY_CATCH_DT                 0.002f
+#define SWINGUP_ENERGY_CATCH_STEPS_PER_TICK     5
+#define SWINGUP_ENERGY_CATCH_STEPS              750
+#define SWINGUP_ENERGY_CATCH_WINDOW_RAD         ( 35.0f * 3.14159265f / 180.0f )
+
+/* Normalized pendulum energy, th from the up position. */
+float swingup_energy( const lqr_plant_params *p, float th, float dth );
+
+/* Motor voltage for state x, same order and units as lqr.h, position relative
+to the centre, angle from the up position in [ -PI, PI ]. */
+float swingup_energy_voltage( const swingup_energy_params *s, const lqr_plant_params *p, const float x[ LQR_N ] );
+
+/* 1 if UPC with gain K ( u = -K x, clamped to u_max, without the deadzone )
+started at state x keeps the cart between x_min and x_max and the pendulum
+in its window on the model, 0 otherwise. */
+uint8_t swingup_energy_catch_ok( const lqr_plant_params *p, const float K[ LQR_N ], const float x[ LQR_N ],
+                                 float x_min, float x_max, float u_max );
+
+#endif // SWINGUP_ENERGY_H
@@ -0,0 +1,82 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Time-varying LQR tracking of the optimized swingup trajectory.
+ *
+ * The table (swingup_tvlqr_table.c) holds for every 10 ms sample k the nominal
+ * voltage u_nom,k, the nominal state x_nom,k and the gain K_k of the finite
+ * horizon LQR along the trajectory, and the law is
+ *     u = u_nom,k + K_k ( x_nom,k - x )
+ * plus deadzone compensation in the direction of u, clamped to
+ * SWINGUP_TVLQR_U_MAX. State order and units as lqr.h, cart position
+ * relative to SWINGUP_TVLQR_START_CM, angle from the up position (the
+ * angle error is wrapped to [ -PI, PI ], x_nom is not).
+ *
+ * The table is generated by sim_swingup_tvlqr (sim/tools): iterative LQR
+ * on the rig model of lqr.h from rest hanging at the start position to
+ * upright at rest at the same position, within the track and with voltage
+ * headroom left for the feedback, then the backward Riccati recursion of
+ * the linearized trajectory with LQR_UPC_Q / LQR_UPC_R and the UPC LQR
+ * solution as terminal cost, so the last gains are the 'lqr' UPC gains.
+ *
+ * Storage: one int16_t per value, SWINGUP_TVLQR_COLUMNS values per sample,
+ * each column with its own float scale, value = q * scale[ column ]. That is
+ * 18 bytes per sample instead of 36 in float, the quantization step is
+ * 1/32767 of the largest value of the column.
+ *
+ * Plain float code without RTOS calls, the sim tools link it directly.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SWINGUP_TVLQR_H
+#define SWINGUP_TVLQR_H
+
+#include <stdint.h>
+
+#include "lqr.h"
+
+/* 10 ms samples, 2.5 s. */
+#define SWINGUP_TVLQR_DT_MS         10
+#define SWINGUP_TVLQR_SAMPLES       250
+
+/* Table columns, u_nom, x_nom[ LQR_N ], K[ LQR_N ]. */
+#define SWINGUP_TVLQR_COL_U         0
+#define SWINGUP_TVLQR_COL_X         1
+#define SWINGUP_TVLQR_COL_K         ( SWINGUP_TVLQR_COL_X + LQR_N )
+#define SWINGUP_TVLQR_COLUMNS       ( SWINGUP_TVLQR_COL_K + LQR_N )
+
+/* Cart position of the trajectory start and end, cm. DPC moves the cart
+there before the swingup, UPC keeps it as setpoint after it. */
+#define SWINGUP_TVLQR_START_CM      20.0f
+
+/* Nominal voltage limit of the optimizer, the rest up to SWINGUP_TVLQR_U_MAX
+is for the feedback and the deadzone, V. */
+#define SWINGUP_TVLQR_U_NOM_MAX     8.0f
+#define SWINGUP_TVLQR_U_MAX         12.0f
+#define SWINGUP_TVLQR_DEADZONE      1.0f
+
+/* Nominal cart position limit relative to the start position, m. */
+#define SWINGUP_TVLQR_X_MAX         0.10f
+
+/* Watchdog hands the tracking over to UPC inside this angle from the up
+position, rad. */
+#define SWINGUP_TVLQR_CATCH_RAD     0.2f
+
+typedef struct
+{
+    float scale[ SWINGUP_TVLQR_COLUMNS ];
+    int16_t q[ SWINGUP_TVLQR_SAMPLES ][ SWINGUP_TVLQR_COLUMNS ];
+} swingup_tvlqr_table_t;
+
+extern const swingup_tvlqr_table_t swingup_tvlqr_table;
+
+/* Nominal state of sample k. */
+void swingup_tvlqr_nominal( uint32_t k, float x_nom[ LQR_N ] );
+
+/* Motor voltage for sample k ( < SWINGUP_TVLQR_SAMPLES ) and state x. */
+float swingup_tvlqr_voltage( uint32_t k, const float x[ LQR_N ] );
+
+/* Motor voltage at fraction frac ( 0 - 1 ) of the interval after sample k,
+for control rates above the table rate. Nominal voltage and gain are held over
+the interval (the optimizer holds the voltage too), the nominal state is
+interpolated to the next sample. */
+float swingup_tvlqr_voltage_between( uint32_t k, float frac, const float x[ LQR_N ] );
+
+#endif // SWINGUP_TVLQR_H
@@ -0,0 +1,90 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Task profiler - execution time, wake period and jitter of app tasks.
+ *
+ * FreeRTOS calls task_prof_switched_in() / task_prof_switched_out() on every
+ * context switch (traceTASK_SWITCHED_IN / traceTASK_SWITCHED_OUT in
+ * FreeRTOSConfig.h). Registered tasks are found by their application task tag
+ * (slot number + 1), so a hook is a few loads and stores, unregistered tasks
+ * (idle, timer) only advance the elapsed time.
+ *
+ * Times are measured with the DWT cycle counter (ctrl_tick_cycles()):
+ *     job            : from switch in after the task blocked (or was suspended)
+ *                      to the next switch out where the task is not ready anymore
+ *     exec time      : cycles the task was running during one job, time the task
+ *                      was preempted is not counted
+ *     wake period    : time between starts of two consecutive jobs
+ *     jitter         : |wake period - nominal period|, histogram with bins
+ *                      <1, <4, <16, <64, <256, <1024, <4096, >=4096 us
+ *     overruns       : jobs that ended later than nominal period after their start
+ * Tasks with nominal period 0 (event driven) have no jitter and overruns.
+ * Wake period of a task that was suspended includes the time it was suspended.
+ *
+ * Hooks run in PendSV with interrupts up to configMAX_SYSCALL_INTERRUPT_PRIORITY
+ * masked, tasks read and clear statistics inside critical sections. Time spent in
+ * hooks is measured too and shown as profiler overhead.
+ *
+ * Stats are printed by "task-stats" cli command.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef TASK_PROF
+#define TASK_PROF
+
+#include "stdint.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Max number of profiled tasks. */
+#define TASK_PROF_MAX_TASKS     12
+
+/* Number of jitter histogram bins, bin i counts jitter below 4^i us, last bin the rest. */
+#define TASK_PROF_HIST_BINS     8
+
+/* Statistics of one profiled task, times in DWT cycles. */
+typedef struct
+{
+    TaskHandle_t task;
+    uint32_t period_nominal;    /* 0 for event driven task */
+    uint32_t jobs;
+    uint32_t exec_min;
+    uint32_t exec_max;
+    uint64_t exec_sum;
+    uint32_t periods;           /* wake periods used for statistics */
+    uint32_t period_min;
+    uint32_t period_max;
+    uint64_t period_sum;
+    uint32_t jitter_hist[ TASK_PROF_HIST_BINS ];
+    uint32_t overruns;
+
+    /* Private. */
+    uint32_t job_start;         /* cycles at switch in that started current job */
+    uint32_t job_exec;          /* cycles running in current job so far */
+    uint32_t slice_start;       /* cycles at last switch in */
+    uint8_t  in_job;            /* task didn't block since job_start */
+    uint8_t  job_start_valid;   /* job_start can be used for period statistics */
+} task_prof_task_stats;
+
+/* Statistics of all profiled tasks. */
+typedef struct
+{
+    uint64_t elapsed;           /* cycles since reset, advanced on every context switch */
+    uint64_t overhead;          /* cycles spent in profiler hooks since reset */
+    uint32_t last_switch;       /* cycles at last context switch */
+    uint32_t n_tasks;
+    task_prof_task_stats task[ TASK_PROF_MAX_TASKS ];
+} task_prof_stats;
+
+/* Add task to the profiler, nominal period in ms (0 for event driven task).
+Call before the scheduler is started. */
+void task_prof_register( TaskHandle_t task, uint32_t period_ms );
+
+/* Same as task_prof_register(), period in DWT cycles. */
+void task_prof_register_cycles( TaskHandle_t task, uint32_t period_cycles );
+
+/* Copy of current statistics. */
+void task_prof_get_stats( task_prof_stats *out );
+
+/* Clear all statistics. */
+void task_prof_reset_stats( void );
+
+#endif /* TASK_PROF */
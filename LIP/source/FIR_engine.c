@@ -0,0 +1,226 @@
+#include "FIR_engine.h"
+#include <math.h>
+#include <string.h>
+
+#if defined( __ARM_FEATURE_DSP )
+    #include "stm32f4xx.h"      /* CMSIS __SMLALD */
+#elif defined( __SSE2__ )
+    #include <immintrin.h>
+#endif
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Dot product kernels.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static float FIR_dot_f32( const float *h, const float *x, uint32_t n )
+{
+    uint32_t i = 0;
+    float sum;
+
+#if defined( __AVX__ )
+    __m256 acc8 = _mm256_setzero_ps();
+    __m128 acc4;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+        acc8 = _mm256_add_ps( acc8, _mm256_mul_ps( _mm256_loadu_ps( h + i ), _mm256_loadu_ps( x + i ) ) );
+    }
+    acc4 = _mm_add_ps( _mm256_castps256_ps128( acc8 ), _mm256_extractf128_ps( acc8, 1 ) );
+    acc4 = _mm_add_ps( acc4, _mm_movehl_ps( acc4, acc4 ) );
+    acc4 = _mm_add_ss( acc4, _mm_shuffle_ps( acc4, acc4, 1 ) );
+    sum = _mm_cvtss_f32( acc4 );
+#elif defined( __SSE2__ )
+    __m128 acc4 = _mm_setzero_ps();
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+        acc4 = _mm_add_ps( acc4, _mm_mul_ps( _mm_loadu_ps( h + i ), _mm_loadu_ps( x + i ) ) );
+    }
+    acc4 = _mm_add_ps( acc4, _mm_movehl_ps( acc4, acc4 ) );
+    acc4 = _mm_add_ss( acc4, _mm_shuffle_ps( acc4, acc4, 1 ) );
+    sum = _mm_cvtss_f32( acc4 );
+#else
+    /* Four independent partial sums, the FPU multiply accumulate has a
+    latency of 3 cycles, one chain would stall on every tap. */
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+    for( ; i + 4 <= n; i += 4 )
+    {
+        s0 += h[ i ]     * x[ i ];
+        s1 += h[ i + 1 ] * x[ i + 1 ];
+        s2 += h[ i + 2 ] * x[ i + 2 ];
+        s3 += h[ i + 3 ] * x[ i + 3 ];
+    }
+    sum = ( s0 + s1 ) + ( s2 + s3 );
+#endif
+
+    for( ; i < n; i++ )
+    {
+        sum += h[ i ] * x[ i ];
+    }
+    return sum;
+}
+
+static int64_t FIR_dot_q15( const int16_t *h, const int16_t *x, uint32_t n )
+{
+    uint32_t i = 0;
+    int64_t sum = 0;
+
+#if defined( __ARM_FEATURE_DSP )
+    uint32_t h2, x2;
+
+    /* Two samples per 32 bit load (unaligned loads are fine on Cortex-M4). */
+    for( ; i + 2 <= n; i += 2 )
+    {
+        memcpy( &h2, h + i, sizeof( h2 ) );
+        memcpy( &x2, x + i, sizeof( x2 ) );
+        sum = ( int64_t ) __SMLALD( h2, x2, ( uint64_t ) sum );
+    }
+#elif defined( __SSE2__ )
+    /* pmaddwd adds pairs of products into 32 bits like SMLAD, the pair sums are
+    widened to 64 bits before they are accumulated, like SMLALD. */
+    __m128i acc_lo = _mm_setzero_si128();
+    __m128i acc_hi = _mm_setzero_si128();
+    int64_t lanes[ 2 ];
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+        __m128i p = _mm_madd_epi16( _mm_loadu_si128( ( const __m128i * ) ( h + i ) ),
+                                    _mm_loadu_si128( ( const __m128i * ) ( x + i ) ) );
+        __m128i sign = _mm_srai_epi32( p, 31 );
+        acc_lo = _mm_add_epi64( acc_lo, _mm_unpacklo_epi32( p, sign ) );
+        acc_hi = _mm_add_epi64( acc_hi, _mm_unpackhi_epi32( p, sign ) );
+    }
+    _mm_storeu_si128( ( __m128i * ) lanes, _mm_add_epi64( acc_lo, acc_hi ) );
+    sum = lanes[ 0 ] + lanes[ 1 ];
+#endif
+
+    for( ; i < n; i++ )
+    {
+        sum += ( int32_t ) h[ i ] * x[ i ];
+    }
+    return sum;
+}
+
+/* Q30 sum of products to Q15, rounded and saturated. */
+static int16_t FIR_q15_from_acc( int64_t acc )
+{
+    acc = ( acc + ( 1 << 14 ) ) >> 15;
+    if( acc > INT16_MAX )
+    {
+        return INT16_MAX;
+    }
+    if( acc < INT16_MIN )
+    {
+        return INT16_MIN;
+    }
+    return ( int16_t ) acc;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Float engine.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+void FIR_engine_init( FIR_engine *fir, const float *coeffs, float *state, uint32_t taps )
+{
+    fir->taps   = taps;
+    fir->coeffs = coeffs;
+    fir->state  = state;
+    fir->pos    = 0;
+
+    for( uint32_t i = 0; i < FIR_ENGINE_STATE_LEN( taps ); i++ )
+    {
+        state[ i ] = 0.0f;
+    }
+}
+
+float FIR_engine_update( FIR_engine *fir, float in )
+{
+    /* Newest sample goes one place down, both copies. */
+    fir->pos = ( fir->pos == 0 ) ? fir->taps - 1 : fir->pos - 1;
+    fir->state[ fir->pos ] = in;
+    fir->state[ fir->pos + fir->taps ] = in;
+
+    return FIR_dot_f32( fir->coeffs, &fir->state[ fir->pos ], fir->taps );
+}
+
+void FIR_engine_block( FIR_engine *fir, const float *in, float *out, uint32_t n )
+{
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        out[ i ] = FIR_engine_update( fir, in[ i ] );
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Q15 engine.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+void FIR_engine_q15_init( FIR_engine_q15 *fir, const int16_t *coeffs, int16_t *state, uint32_t taps )
+{
+    fir->taps   = taps;
+    fir->coeffs = coeffs;
+    fir->state  = state;
+    fir->pos    = 0;
+
+    for( uint32_t i = 0; i < FIR_ENGINE_STATE_LEN( taps ); i++ )
+    {
+        state[ i ] = 0;
+    }
+}
+
+int16_t FIR_engine_q15_update( FIR_engine_q15 *fir, int16_t in )
+{
+    fir->pos = ( fir->pos == 0 ) ? fir->taps - 1 : fir->pos - 1;
+    fir->state[ fir->pos ] = in;
+    fir->state[ fir->pos + fir->taps ] = in;
+
+    return FIR_q15_from_acc( FIR_dot_q15( fir->coeffs, &fir->state[ fir->pos ], fir->taps ) );
+}
+
+void FIR_engine_q15_block( FIR_engine_q15 *fir, const int16_t *in, int16_t *out, uint32_t n )
+{
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        out[ i ] = FIR_engine_q15_update( fir, in[ i ] );
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Design helpers.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+void FIR_design_lowpass( float *coeffs, uint32_t taps, float cutoff )
+{
+    const float pi = 3.14159265f;
+    float middle = 0.5f * ( float ) ( taps - 1 );
+    float sum = 0.0f;
+
+    for( uint32_t i = 0; i < taps; i++ )
+    {
+        float t = ( float ) i - middle;
+        float sinc = ( t == 0.0f ) ? 2.0f * cutoff : sinf( 2.0f * pi * cutoff * t ) / ( pi * t );
+        float window = ( taps > 1 ) ? 0.54f - 0.46f * cosf( 2.0f * pi * ( float ) i / ( float ) ( taps - 1 ) ) : 1.0f;
+
+        coeffs[ i ] = sinc * window;
+        sum += coeffs[ i ];
+    }
+    for( uint32_t i = 0; i < taps; i++ )
+    {
+        coeffs[ i ] /= sum;
+    }
+}
+
+void FIR_coeffs_to_q15( const float *in, int16_t *out, uint32_t taps )
+{
+    for( uint32_t i = 0; i < taps; i++ )
+    {
+        float q = roundf( in[ i ] * 32768.0f );
+
+        if( q > 32767.0f )
+        {
+            q = 32767.0f;
+        }
+        else if( q < -32768.0f )
+        {
+            q = -32768.0f;
+        }
+        out[ i ] = ( int16_t ) q;
+    }
+}
@@ -0,0 +1,97 @@
+#include "IIR_biquad.h"
+#include <math.h>
+
+void IIR_biquad_init( IIR_biquad *iir, const IIR_biquad_coeffs *coeffs, uint32_t sections )
+{
+    if( sections > IIR_BIQUAD_MAX_SECTIONS )
+    {
+        sections = IIR_BIQUAD_MAX_SECTIONS;
+    }
+
+    iir->sections = sections;
+    iir->coeffs = coeffs;
+    IIR_biquad_reset( iir, 0.0f );
+}
+
+void IIR_biquad_reset( IIR_biquad *iir, float in )
+{
+    for( uint32_t i = 0; i < iir->sections; i++ )
+    {
+        const IIR_biquad_coeffs *c = &iir->coeffs[ i ];
+        float out = in * ( c->b0 + c->b1 + c->b2 ) / ( 1.0f + c->a1 + c->a2 );
+
+        iir->s2[ i ] = c->b2 * in - c->a2 * out;
+        iir->s1[ i ] = c->b1 * in - c->a1 * out + iir->s2[ i ];
+        in = out;
+    }
+}
+
+float IIR_biquad_update( IIR_biquad *iir, float in )
+{
+    const IIR_biquad_coeffs *c = iir->coeffs;
+    float *s1 = iir->s1;
+    float *s2 = iir->s2;
+
+    for( uint32_t i = 0; i < iir->sections; i++ )
+    {
+        float out = c[ i ].b0 * in + s1[ i ];
+
+        s1[ i ] = c[ i ].b1 * in - c[ i ].a1 * out + s2[ i ];
+        s2[ i ] = c[ i ].b2 * in - c[ i ].a2 * out;
+        in = out;
+    }
+
+    return in;
+}
+
+uint32_t IIR_biquad_design_butterworth_lp( IIR_biquad_coeffs *coeffs, uint32_t order, float fc, float dt )
+{
+    const float pi = 3.14159265f;
+    float K = tanf( pi * fc * dt );
+    uint32_t pairs = order / 2;
+
+    if( order == 0 || order > 2 * IIR_BIQUAD_MAX_SECTIONS )
+    {
+        return 0;
+    }
+
+    /* Pole pairs at angles pi * ( 2k + 1 ) / ( 2 * order ) from the negative
+    real axis, odd order starts one half step further (the real pole is at 0). */
+    for( uint32_t k = 0; k < pairs; k++ )
+    {
+        float angle = pi * ( float ) ( 2 * k + 1 + order % 2 ) / ( float ) ( 2 * order );
+        float q = 1.0f / ( 2.0f * cosf( angle ) );
+        float norm = 1.0f / ( 1.0f + K / q + K * K );
+
+        coeffs[ k ].b0 = K * K * norm;
+        coeffs[ k ].b1 = 2.0f * coeffs[ k ].b0;
+        coeffs[ k ].b2 = coeffs[ k ].b0;
+        coeffs[ k ].a1 = 2.0f * ( K * K - 1.0f ) * norm;
+        coeffs[ k ].a2 = ( 1.0f - K / q + K * K ) * norm;
+    }
+
+    /* Real pole, first order section. */
+    if( order % 2 )
+    {
+        coeffs[ pairs ].b0 = K / ( 1.0f + K );
+        coeffs[ pairs ].b1 = coeffs[ pairs ].b0;
+        coeffs[ pairs ].b2 = 0.0f;
+        coeffs[ pairs ].a1 = ( K - 1.0f ) / ( K + 1.0f );
+        coeffs[ pairs ].a2 = 0.0f;
+    }
+
+    return ( order + 1 ) / 2;
+}
+
+void IIR_biquad_design_notch( IIR_biquad_coeffs *coeffs, float f0, float q, float dt )
+{
+    const float pi = 3.14159265f;
+    float K = tanf( pi * f0 * dt );
+    float norm = 1.0f / ( 1.0f + K / q + K * K );
+
+    coeffs->b0 = ( 1.0f + K * K ) * norm;
+    coeffs->b1 = 2.0f * ( K * K - 1.0f ) * norm;
+    coeffs->b2 = coeffs->b0;
+    coeffs->a1 = coeffs->b1;
+    coeffs->a2 = ( 1.0f - K / q + K * K ) * norm;
+}
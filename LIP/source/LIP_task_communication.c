@@ -20,9 +20,9 @@ extern float cart_position[ 2 ];
 extern float cart_speed_raw[ 2 ];
 extern float cart_speed[ 2 ];
 extern float *cart_position_setpoint_cm;
-extern float number_of_pendulumarm_revolutions_dpc;
+extern int32_t number_of_pendulumarm_revolutions_dpc;
 extern float pendulum_angle_in_base_range_dpc;
-extern float number_of_pendulumarm_revolutions_upc;
+extern int32_t number_of_pendulumarm_revolutions_upc;
 extern float pendulum_angle_in_base_range_upc;
 extern float pendulum_arm_angle_setpoint_rad_dpc;
 extern float pendulum_arm_angle_setpoint_rad_upc;
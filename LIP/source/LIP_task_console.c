@@ -138,7 +138,9 @@ void console_task( void *pvParameters )
                                     MAX_OUTPUT_LENGTH/* The size of the output buffer. */
                                 );
 
-                    for ( int i = 0; i < ( xMoreDataToFollow == pdTRUE ? MAX_OUTPUT_LENGTH : strlen( ( const char * ) pcOutputString ) ); i++ )
+                    /* Commands that return pdTRUE (more data to follow) write null terminated strings too,
+                    don't send the rest of the buffer. */
+                    for ( int i = 0; i < strlen( ( const char * ) pcOutputString ); i++ )
                     {
                         sprintf( msg, "%c", *(pcOutputString + i) );
                         com_send( msg, strlen(msg) );
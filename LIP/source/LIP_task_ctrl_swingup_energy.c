@@ -0,0 +1,92 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * This file contains energy shaping swingup control law for linear inverted
+ * pendulum (swingup_energy.h), closed loop alternative to the voltage lookup
+ * table of swingup task.
+ *
+ * The law works with the state of this tick: pendulum angle from the up
+ * position, cart position relative to the cart position setpoint and both
+ * speeds. It pumps the pendulum energy to the up position level and brakes the
+ * cart to stop SWINGUP_ENERGY_ZONE_MARGIN_CM before both freezing zones (and
+ * inside the SWINGUP_ENERGY_DEFAULT limits around the setpoint), so the swingup
+ * can start from rest anywhere in the middle of the track. Model is the rig
+ * model of lqr.h ("lqr model ...").
+ *
+ * Watchdog hands over to UPC once the angle error is within
+ * SWINGUP_ENERGY_CATCH_RAD and ctrl_7_energy_swingup_catch_ok() predicts
+ * that UPC stops the cart SWINGUP_ENERGY_CATCH_MARGIN_CM inside the freezing
+ * zones, UPC keeps the same cart position setpoint.
+ *
+ * Called by util task every control tick when CTRL_LAW_SWINGUP runs
+ * ("swingup energy" cli command, swingup task).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "LIP_tasks_common.h"
+#include "math.h"
+
+/* These are defined in LIP_tasks_common.c */
+extern float cart_position[ 2 ];
+extern float cart_speed[ 2 ];
+extern float pend_speed[ 2 ];
+extern float *cart_position_setpoint_cm;
+extern float pendulum_angle_in_base_range_upc;
+
+/* State relative to the setpoint in SI units, same as controller 6. */
+static void ctrl_7_state( float x[ LQR_N ] )
+{
+    x[ 0 ] = ( cart_position[ 0 ] - *cart_position_setpoint_cm ) * 0.01f;
+    x[ 1 ] = pendulum_angle_in_base_range_upc - PENDULUM_ANGLE_UP_SETPOINT_BASE;
+    x[ 2 ] = cart_speed[ 0 ] * 0.01f;
+    x[ 3 ] = pend_speed[ 0 ];
+
+    /* Angle error in [ -PI, PI ], base range is shifted by the up setpoint. */
+    if( x[ 1 ] > PI )
+    {
+        x[ 1 ] -= PI2;
+    }
+    else if( x[ 1 ] < -PI )
+    {
+        x[ 1 ] += PI2;
+    }
+}
+
+float ctrl_7_energy_swingup_law( void )
+{
+    static const swingup_energy_params defaults = SWINGUP_ENERGY_DEFAULT;
+    swingup_energy_params params = defaults;
+    lqr_plant_params p;
+    float x[ LQR_N ];
+    float zone_min, zone_max;
+
+    lqr_get_plant( &p );
+
+    /* Cart limits relative to the setpoint, m, the tighter of the tuning and the zones. */
+    zone_min = ( OK_ZONE_LOWER_LIMIT + SWINGUP_ENERGY_ZONE_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+    zone_max = ( FREEZING_ZONE_R_LOWER_LIMIT - SWINGUP_ENERGY_ZONE_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+    params.x_min = fmaxf( params.x_min, zone_min );
+    params.x_max = fminf( params.x_max, zone_max );
+
+    ctrl_7_state( x );
+
+    return swingup_energy_voltage( &params, &p, x );
+}
+
+uint8_t ctrl_7_energy_swingup_catch_ok( void )
+{
+    /* UPC gain set in use (first set of a schedule), gains in SI units as the
+    model state. */
+    gain_schedule sched;
+    gain_set set;
+    lqr_plant_params p;
+    float x[ LQR_N ];
+    float zone_min, zone_max;
+
+    gain_sched_get( GAIN_SET_UPC, &sched );
+    gain_sets_get( GAIN_SET_UPC, sched.a, &set );
+    lqr_get_plant( &p );
+
+    zone_min = ( OK_ZONE_LOWER_LIMIT + SWINGUP_ENERGY_CATCH_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+    zone_max = ( FREEZING_ZONE_R_LOWER_LIMIT - SWINGUP_ENERGY_CATCH_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+    ctrl_7_state( x );
+
+    return swingup_energy_catch_ok( &p, set.gains, x, zone_min, zone_max, MAX_INPUT_VOLTAGE_POSITIVE - set.voltage_deadzone );
+}
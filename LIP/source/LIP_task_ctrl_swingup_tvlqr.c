@@ -0,0 +1,85 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * This file contains the time-varying LQR tracking law of the optimized
+ * swingup trajectory (swingup_tvlqr.h).
+ *
+ * The law works with the state of this tick: cart position relative to
+ * SWINGUP_TVLQR_START_CM, pendulum angle from the up position and the
+ * Kalman filter speeds, whatever "estimator" selects (it is always updated,
+ * runs the model of the trajectory and has no low-pass lag, the lag and the
+ * pendulum speed dead zone of the default filtered derivatives make the
+ * tracking diverge in the fast part of the swing).
+ *
+ * Table samples are 10 ms apart. Control tick runs at a multiple of 100 Hz,
+ * the law advances one sample every TVLQR_TICKS_PER_SAMPLE ticks and in
+ * between holds the nominal voltage and gain and interpolates the nominal
+ * state (swingup_tvlqr_voltage_between()). Tick count is reset by
+ * ctrl_8_tvlqr_swingup_reset() before the law is selected and advanced on
+ * every call, after the last sample the last gains (the UPC LQR gains) are
+ * kept until swingup task stops the law.
+ *
+ * Called by util task every control tick when CTRL_LAW_SWINGUP_TVLQR runs
+ * ("swingup tvlqr" cli command, swingup task).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "LIP_tasks_common.h"
+
+#if ( CTRL_TICK_HZ * SWINGUP_TVLQR_DT_MS ) % 1000 != 0
+    #error "swingup_tvlqr_table.c has 10 ms samples, CTRL_TICK_HZ has to be a multiple of 100"
+#endif
+
+/* Control ticks per table sample. */
+#define TVLQR_TICKS_PER_SAMPLE ( CTRL_TICK_HZ * SWINGUP_TVLQR_DT_MS / 1000 )
+#define TVLQR_TICKS ( SWINGUP_TVLQR_SAMPLES * TVLQR_TICKS_PER_SAMPLE )
+
+/* These are defined in LIP_tasks_common.c */
+extern float cart_position[ 2 ];
+extern float pendulum_angle_in_base_range_upc;
+extern kalman_filter KF_state;
+
+/* Control tick of the next call from the trajectory start, written by util task
+and ctrl_8_tvlqr_swingup_reset(). */
+static volatile uint32_t tvlqr_tick = 0;
+
+void ctrl_8_tvlqr_swingup_reset( void )
+{
+    tvlqr_tick = 0;
+}
+
+uint8_t ctrl_8_tvlqr_swingup_done( void )
+{
+    return tvlqr_tick >= TVLQR_TICKS;
+}
+
+float ctrl_8_tvlqr_swingup_law( void )
+{
+    uint32_t tick = tvlqr_tick;
+    float x[ LQR_N ];
+
+    /* State relative to the trajectory start in SI units. */
+    x[ 0 ] = ( cart_position[ 0 ] - SWINGUP_TVLQR_START_CM ) * 0.01f;
+    x[ 1 ] = pendulum_angle_in_base_range_upc - PENDULUM_ANGLE_UP_SETPOINT_BASE;
+    x[ 2 ] = KF_state.x[ KALMAN_DX ] * 0.01f;
+    x[ 3 ] = KF_state.x[ KALMAN_DTH ];
+
+    /* Angle error in [ -PI, PI ], base range is shifted by the up setpoint. */
+    if( x[ 1 ] > PI )
+    {
+        x[ 1 ] -= PI2;
+    }
+    else if( x[ 1 ] < -PI )
+    {
+        x[ 1 ] += PI2;
+    }
+
+    if( tick < TVLQR_TICKS )
+    {
+        tvlqr_tick = tick + 1;
+    }
+    else
+    {
+        tick = TVLQR_TICKS - 1;
+    }
+
+    return swingup_tvlqr_voltage_between( tick / TVLQR_TICKS_PER_SAMPLE,
+                                          ( float ) ( tick % TVLQR_TICKS_PER_SAMPLE ) / TVLQR_TICKS_PER_SAMPLE, x );
+}
@@ -0,0 +1,206 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * This file contains constrained MPC control law for linear inverted pendulum,
+ * pendulum in up position.
+ *
+ * The law runs a state feedback and corrects it with the smallest input change
+ * that keeps the predicted cart position out of both freezing zones (MPC_ZONE_MARGIN_CM
+ * from OK_ZONE_LOWER_LIMIT and FREEZING_ZONE_R_LOWER_LIMIT) and the voltage within
+ * the motor driver range, over MPC_HORIZON ticks (see mpc.h). While no
+ * constraint is active the output is the state feedback.
+ *
+ * Prediction model is the linearized rig model of lqr.h (plant set with
+ * "lqr model ..."), discretized at dt_ctrl. The feedback has to stabilize this
+ * model, otherwise the predicted free response grows and the constraints act
+ * on it, so the feedback is the LQR gain of the model with LQR_UPC_Q, LQR_UPC_R
+ * (hand tuned gain sets rely on the rig nonlinearities and do not always
+ * stabilize the linear model). Model and gain are computed by
+ * ctrl_6_MPC_uppos_reset() in the caller's task and taken by util task at the
+ * next tick. Deadzone compensation and switch angle window come from the UPC
+ * gain set schedule, as in controller 5.
+ *
+ * Called by util task every control tick when CTRL_LAW_UPC runs with
+ * upc_law_select( UPC_LAW_MPC ) ("upclaw mpc" cli command).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "LIP_tasks_common.h"
+#include "ctrl_tick_driver.h"
+#include "math.h"
+
+/* These are defined in LIP_tasks_common.c */
+extern float cart_position[ 2 ];
+extern float cart_speed[ 2 ];
+extern float pend_speed[ 2 ];
+extern float *cart_position_setpoint_cm;
+extern float pendulum_angle_in_base_range_upc;
+
+/* Used by util task only. */
+static mpc_controller mpc;
+static uint8_t mpc_ready = 0;
+
+/* Model and feedback posted by ctrl_6_MPC_uppos_reset(), taken by util task,
+accessed in critical sections. */
+static struct
+{
+    float A[ MPC_N ][ MPC_N ];
+    float B[ MPC_N ];
+    float K[ MPC_N ];
+    uint8_t posted;
+} mpc_model;
+
+/* Used by ctrl_6_MPC_uppos_reset() only. */
+static lqr_solver mpc_lqr;
+
+/* Shared with cli task, accessed in critical sections. */
+static mpc_law_stats stats;
+
+uint8_t ctrl_6_MPC_uppos_reset( void )
+{
+    static const float Q[ LQR_N ] = LQR_UPC_Q;
+    lqr_plant_params p;
+    float Ac[ LQR_N ][ LQR_N ];
+    float Bc[ LQR_N ];
+    float A[ LQR_N ][ LQR_N ];
+    float B[ LQR_N ];
+    float K[ LQR_N ];
+
+    lqr_get_plant( &p );
+    lqr_cart_pendulum_model( &p, 0, Ac, Bc );
+    lqr_discretize( ( const float ( * )[ LQR_N ] ) Ac, Bc, dt_ctrl, A, B );
+    lqr_init( &mpc_lqr, ( const float ( * )[ LQR_N ] ) A, B, Q, LQR_UPC_R );
+    while( !lqr_step( &mpc_lqr ) )
+    {
+    }
+    if( !mpc_lqr.converged )
+    {
+        return 1;
+    }
+    lqr_gain( &mpc_lqr, K );
+
+    taskENTER_CRITICAL();
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        for( uint32_t j = 0; j < MPC_N; j++ )
+        {
+            mpc_model.A[ i ][ j ] = A[ i ][ j ];
+        }
+        mpc_model.B[ i ] = B[ i ];
+        mpc_model.K[ i ] = K[ i ];
+    }
+    mpc_model.posted = 1;
+    taskEXIT_CRITICAL();
+
+    return 0;
+}
+
+void ctrl_6_MPC_uppos_get_stats( mpc_law_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+void ctrl_6_MPC_uppos_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    memset( &stats, 0, sizeof( stats ) );
+    taskEXIT_CRITICAL();
+}
+
+float ctrl_6_MPC_uppos_law( void )
+{
+    gain_set set;
+    float x[ MPC_N ];
+    float cart_position_error;
+    float deadzone;
+    float pos_min, pos_max;
+    float ctrl_signal;
+    uint32_t start, cycles;
+    float A[ MPC_N ][ MPC_N ];
+    float B[ MPC_N ];
+    float K[ MPC_N ];
+    uint8_t posted;
+
+    /* Model posted by ctrl_6_MPC_uppos_reset(). */
+    taskENTER_CRITICAL();
+    posted = mpc_model.posted;
+    if( posted )
+    {
+        memcpy( A, mpc_model.A, sizeof( A ) );
+        memcpy( B, mpc_model.B, sizeof( B ) );
+        memcpy( K, mpc_model.K, sizeof( K ) );
+        mpc_model.posted = 0;
+    }
+    taskEXIT_CRITICAL();
+
+    if( posted )
+    {
+        /* New model, duals of the old one are dropped. */
+        mpc_init( &mpc, ( const float ( * )[ MPC_N ] ) A, B );
+        mpc_set_gain( &mpc, K );
+        mpc_ready = 1;
+    }
+    if( !mpc_ready )
+    {
+        /* No model yet, ctrl_6_MPC_uppos_reset() was not called. */
+        return ctrl_5_FSF_uppos_law();
+    }
+
+    /* Errors as in controller 5, deadzone and window of the gain set at this
+    operating point. */
+    cart_position_error = *cart_position_setpoint_cm - cart_position[ 0 ];
+    gain_sched_eval( GAIN_SET_UPC, cart_position_error,
+                     PENDULUM_ANGLE_UP_SETPOINT_BASE - pendulum_angle_in_base_range_upc, &set );
+
+    if( !( set.switch_angle_low < pendulum_angle_in_base_range_upc && set.switch_angle_high > pendulum_angle_in_base_range_upc ) )
+    {
+        /* Angle not in specified range, output zero voltage. */
+        return 0.0f;
+    }
+
+    /* State relative to the setpoint in SI units, u = -K x is u = F*(x_setpoint - x)
+    of controller 5 with F = K. */
+    x[ 0 ] = - cart_position_error * 0.01f;
+    x[ 1 ] = pendulum_angle_in_base_range_upc - PENDULUM_ANGLE_UP_SETPOINT_BASE;
+    x[ 2 ] = cart_speed[ 0 ] * 0.01f;
+    x[ 3 ] = pend_speed[ 0 ];
+
+    /* Deadzone compensation is added after the solve, its voltage is
+    reserved from the range. */
+    if( cart_position_error > set.cart_allowed_error_cm )
+    {
+        deadzone = set.voltage_deadzone;
+    }
+    else if( cart_position_error < -set.cart_allowed_error_cm )
+    {
+        deadzone = -set.voltage_deadzone;
+    }
+    else
+    {
+        deadzone = 0.0f;
+    }
+
+    /* Cart limits relative to the setpoint, m. */
+    pos_min = ( OK_ZONE_LOWER_LIMIT + MPC_ZONE_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+    pos_max = ( FREEZING_ZONE_R_LOWER_LIMIT - MPC_ZONE_MARGIN_CM - *cart_position_setpoint_cm ) * 0.01f;
+
+    start = ctrl_tick_cycles();
+    ctrl_signal = mpc_solve( &mpc, x, pos_min, pos_max, MAX_INPUT_VOLTAGE_POSITIVE - fabsf( deadzone ) );
+    cycles = ctrl_tick_cycles() - start;
+
+    taskENTER_CRITICAL();
+    stats.solves++;
+    stats.cycles_sum += cycles;
+    if( cycles > stats.cycles_max )
+    {
+        stats.cycles_max = cycles;
+    }
+    if( mpc.sweeps > stats.sweeps_max )
+    {
+        stats.sweeps_max = mpc.sweeps;
+    }
+    stats.constrained   += ( mpc.active != 0 );
+    stats.not_converged += !mpc.converged;
+    taskEXIT_CRITICAL();
+
+    return ctrl_signal + deadzone;
+}
@@ -0,0 +1,82 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * This file provides limit switch task which:
+ *     - handles limit switches after limit_switch_isr() already set dc motor
+ *       voltage to zero and stopped the control law (see limit_switch.h)
+ *     - changes app state back to DEFAULT, zeroes cart position encoder at
+ *       leftmost position
+ *     - polls limit switches every dt_watchdog in case an edge was missed
+ *       (switch already closed at start up, bouncing)
+ *
+ * This task is blocked on notification at LIMIT_SW_NOTIFY_INDEX and has the
+ * highest priority of app tasks, so it runs right after the limit switch ISR.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+#include "LIP_tasks_common.h"
+#include "limit_switch.h"
+#include <stdint.h>
+
+/* Globals defined in LIP_tasks_common.c */
+extern enum lip_app_states app_current_state;
+
+void limit_switch_task( void * pvParameters )
+{
+    /* LIMIT_SW_LEFT / LIMIT_SW_RIGHT bits set by limit switch ISR. */
+    uint32_t edges;
+
+    for ( ;; )
+    {
+        edges = 0;
+        xTaskNotifyWaitIndexed( LIMIT_SW_NOTIFY_INDEX, /* Notification index */
+                                0x00,                  /* Bits to clear on entry (before save to third arg). */
+                                UINT32_MAX,            /* Bits to clear on exit (after save to). */
+                                &edges,                /* Value of received notification. */
+                                dt_watchdog );         /* Block time, poll switches when no edge came. */
+
+        if( ( edges & LIMIT_SW_LEFT ) || READ_ZERO_POSITION_REACHED )
+        {
+            /* Leftmost position reached (zero position). */
+
+            /* Set output voltage to zero. */
+            dcm_set_output_volatage( 0.0f );
+
+            /* Stop control law in util task. */
+            ctrl_select_law( CTRL_LAW_NONE );
+
+            /* Set output voltage to zero again in case any other task
+            managed to set any output voltage. */
+            dcm_set_output_volatage( 0.0f );
+
+            /* Leftmost switch was closed, zero cart position encoder. */
+            dcm_enc_zero_counter();
+
+            /* UPC or DPC controller was on, this means that app was already initialized (in default state).
+            Change app state back to default. */
+            app_current_state = DEFAULT;
+        }
+        else if( ( edges & LIMIT_SW_RIGHT ) || READ_MAX_POSITION_REACHED )
+        {
+            /* Rightmost position reached (max position). */
+
+            /* Set output voltage to zero. */
+            dcm_set_output_volatage( 0.0f );
+
+            /* Stop control law in util task. */
+            ctrl_select_law( CTRL_LAW_NONE );
+
+            /* Set output voltage to zero again in case any other task
+            managed to set any output voltage. */
+            dcm_set_output_volatage( 0.0f );
+
+            /* UPC or DPC controller was on, this means that app was already initialized (in default state).
+            Change app state back to default. */
+            if( app_current_state != UNINITIALIZED )
+            {
+                app_current_state = DEFAULT;
+            }
+        }
+
+        if( edges != 0 )
+        {
+            limit_switch_handled();
+        }
+    }
+}
@@ -0,0 +1,151 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * This file provides lqr task, which calculates UPC / DPC gains on the target
+ * (see lqr.h):
+ *     - waits for a job from lqr_synthesize() ("lqr" cli command)
+ *     - builds the linearized model of the selected controller with the
+ *       current plant parameters, discretized at dt_ctrl
+ *     - solves the DARE one doubling step at a time
+ *     - loads the gains as the "lqr" RAM gain set of the controller and
+ *       selects it, util task switches to it at the next control tick
+ *
+ * Priority is below util, watchdog and console tasks, so the solver only runs
+ * when they are blocked and never delays a control tick. It has its own
+ * solver struct, nothing is allocated.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+#include "LIP_tasks_common.h"
+#include "ctrl_tick_driver.h"
+#include "lqr.h"
+#include "limits.h"
+
+/* Defined in LIP_tasks_common.c */
+extern TaskHandle_t lqr_task_handle;
+
+/* Job and result, shared with cli task, accessed in critical sections. */
+static lqr_status status = { .ctrl = GAIN_SET_UPC };
+static lqr_plant_params plant = LQR_PLANT_DEFAULT;
+
+/* Used by lqr task only. */
+static lqr_solver solver;
+
+uint8_t lqr_synthesize( enum gain_set_ctrls ctrl, const float Q[ LQR_N ], float R )
+{
+    taskENTER_CRITICAL();
+    if( status.busy )
+    {
+        taskEXIT_CRITICAL();
+        return 1;
+    }
+    status.ctrl = ctrl;
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        status.Q[ i ] = Q[ i ];
+    }
+    status.R = R;
+    status.busy = 1;
+    taskEXIT_CRITICAL();
+
+    xTaskNotifyGiveIndexed( lqr_task_handle, 0 );
+    return 0;
+}
+
+void lqr_get_status( lqr_status *out )
+{
+    taskENTER_CRITICAL();
+    *out = status;
+    taskEXIT_CRITICAL();
+}
+
+void lqr_set_plant( const lqr_plant_params *p )
+{
+    taskENTER_CRITICAL();
+    plant = *p;
+    taskEXIT_CRITICAL();
+}
+
+void lqr_get_plant( lqr_plant_params *out )
+{
+    taskENTER_CRITICAL();
+    *out = plant;
+    taskEXIT_CRITICAL();
+}
+
+void lqr_task( void *pvParameters )
+{
+    float Ac[ LQR_N ][ LQR_N ];
+    float Bc[ LQR_N ];
+    float A[ LQR_N ][ LQR_N ];
+    float B[ LQR_N ];
+    float K[ LQR_N ];
+    lqr_status job;
+    lqr_plant_params p;
+    gain_schedule sched;
+    gain_set set;
+    uint32_t start;
+    uint32_t cycles;
+
+    for( ;; )
+    {
+        ulTaskNotifyTakeIndexed( 0, pdTRUE, portMAX_DELAY );
+
+        lqr_get_status( &job );
+        lqr_get_plant( &p );
+
+        /* Cycles are summed per step, time the task spent preempted between
+        steps is not counted. */
+        start = ctrl_tick_cycles();
+        lqr_cart_pendulum_model( &p, job.ctrl == GAIN_SET_DPC, Ac, Bc );
+        lqr_discretize( ( const float ( * )[ LQR_N ] ) Ac, Bc, dt_ctrl, A, B );
+        lqr_init( &solver, ( const float ( * )[ LQR_N ] ) A, B, job.Q, job.R );
+        cycles = ctrl_tick_cycles() - start;
+
+        for( ;; )
+        {
+            uint8_t done;
+
+            start = ctrl_tick_cycles();
+            done = lqr_step( &solver );
+            cycles += ctrl_tick_cycles() - start;
+
+            if( done )
+            {
+                break;
+            }
+            /* Let tasks of the same priority run between steps. */
+            taskYIELD();
+        }
+
+        if( solver.converged )
+        {
+            start = ctrl_tick_cycles();
+            lqr_gain( &solver, K );
+            cycles += ctrl_tick_cycles() - start;
+
+            /* Deadzone, dead bands and window of the set in use. */
+            gain_sched_get( job.ctrl, &sched );
+            gain_sets_get( job.ctrl, sched.a, &set );
+            strcpy( set.name, "lqr" );
+            for( uint32_t i = 0; i < LQR_N; i++ )
+            {
+                set.gains[ i ] = K[ i ];
+            }
+
+            sched.a   = gain_sets_load( job.ctrl, &set );
+            sched.b   = sched.a;
+            sched.var = GAIN_SCHED_NONE;
+            sched.lo  = 0.0f;
+            sched.hi  = 0.0f;
+            gain_sched_request( job.ctrl, &sched );
+        }
+
+        taskENTER_CRITICAL();
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            status.K[ i ] = solver.converged ? K[ i ] : 0.0f;
+        }
+        status.steps  = solver.steps;
+        status.cycles = cycles;
+        status.valid  = solver.converged;
+        status.busy   = 0;
+        taskEXIT_CRITICAL();
+    }
+}
@@ -21,8 +21,6 @@ extern float pendulum_angle_in_base_range_upc;
 extern enum lip_app_states app_current_state;
 extern uint32_t swingup_task_resumed;
 
-extern TaskHandle_t ctrl_downposition_task_handle;
-extern TaskHandle_t ctrl_upposition_task_handle;
 
 void swingdown_task( void *pvParameters )
 {
@@ -45,18 +43,18 @@ void swingdown_task( void *pvParameters )
                 /* Wait for the cart to reach setpoint. */
                 vTaskDelay(1000);
                 
-                /* Suspend UPC. */
-                vTaskSuspend( ctrl_upposition_task_handle );
+                /* Stop UPC. */
+                ctrl_select_law( CTRL_LAW_NONE );
 
                 /* Help pendulum swing freely in CCW direction */
                 dcm_set_output_volatage( 2.0f );
                 vTaskDelay( 100 );
                 dcm_set_output_volatage( 0.0f );
 
-                /* Resume DPC. */
-                vTaskResume( ctrl_downposition_task_handle );
+                /* Start DPC. */
+                ctrl_select_law( CTRL_LAW_DPC );
 
-                /* Resume DPC AND change app state do DPC. */
+                /* Start DPC AND change app state do DPC. */
                 app_current_state = DPC;
 
                 reset_swingdown = 0;
@@ -69,16 +67,16 @@ void swingdown_task( void *pvParameters )
                 /* Wait for the cart to reach setpoint. */
                 vTaskDelay(1000);
 
-                /* Suspend UPC. */
-                vTaskSuspend( ctrl_upposition_task_handle );
+                /* Stop UPC. */
+                ctrl_select_law( CTRL_LAW_NONE );
 
                 /* Help pendulum swing freely in CW direction */
                 dcm_set_output_volatage( -2.0f );
                 vTaskDelay( 100 );
                 dcm_set_output_volatage( 0.0f );
 
-                /* Resume DPC AND change app state do DPC. */
-                vTaskResume( ctrl_downposition_task_handle );
+                /* Start DPC AND change app state do DPC. */
+                ctrl_select_law( CTRL_LAW_DPC );
                 app_current_state = DPC;
 
                 reset_swingdown = 0;
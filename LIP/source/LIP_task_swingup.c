@@ -4,6 +4,21 @@
  *
  * Lookup table for swingup input voltage is saved
  * in swingup_input_voltage_lookup_table.c.
+ *
+ * Three procedures, selected with swingup_mode_select() ("swingup [table|energy|tvlqr]"):
+ *     table  - DPC moves the cart to SWINGUP_START_POSITION (3 s), then the
+ *              lookup table voltages are played open loop
+ *     energy - energy shaping law (ctrl_7_energy_swingup_law()) runs in util
+ *              task around the current cart position setpoint, this task only
+ *              times it out after SWINGUP_ENERGY_TIMEOUT_MS and stops it if the
+ *              cart reaches a freezing zone
+ *     tvlqr  - DPC moves the cart to SWINGUP_TVLQR_START_CM (3 s), then the
+ *              tracking law of the optimized trajectory of
+ *              swingup_tvlqr_table.c (ctrl_8_tvlqr_swingup_law()) runs in util
+ *              task, one sample per 10 ms, this task stops it at the
+ *              end of the trajectory or if the cart reaches a freezing zone
+ * In all modes watchdog task suspends this task and starts UPC when the
+ * pendulum gets close to the up position.
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 #include "LIP_tasks_common.h"
@@ -26,8 +41,6 @@ extern enum lip_app_states app_current_state;
 /* Defined in LIP_tasks_common.c. This flag indicates that the swingup task is running. */
 extern uint32_t swingup_task_resumed;
 
-/* Down position controller stask handle. */
-extern TaskHandle_t ctrl_downposition_task_handle;
 
 /* Voltage lookup tables for swingup. Comment/uncomment one or the other. */
 /* swingup_control_1 lookup table. */
@@ -43,74 +56,225 @@ extern TaskHandle_t ctrl_downposition_task_handle;
 #define LOOKUP_TABLE swingup_control_2
 extern float LOOKUP_TABLE[ 220 ];
 
-void swingup_task( void *pvParameters )
+/* Energy swingup gives up after this time. */
+#define SWINGUP_ENERGY_TIMEOUT_MS 15000
+
+/* TVLQR tracking gives up after twice the trajectory, in case util task
+didn't advance the samples. */
+#define SWINGUP_TVLQR_TIMEOUT_MS ( 2 * SWINGUP_TVLQR_SAMPLES * SWINGUP_TVLQR_DT_MS )
+
+/* Procedure of the next "swingup" command, written by swingup_mode_select(). */
+static volatile enum swingup_modes swingup_mode = SWINGUP_MODE_TABLE;
+
+void swingup_mode_select( enum swingup_modes mode )
 {
-    /* For RTOS vTaskDelayUntil(). */
-    TickType_t xLastWakeTime = xTaskGetTickCount();
+    swingup_mode = mode;
+}
+
+enum swingup_modes swingup_mode_selected( void )
+{
+    return swingup_mode;
+}
 
+/* DPC moves the cart to position_cm, then the app goes to SWINGUP state. */
+static void swingup_preposition( float position_cm, TickType_t *xLastWakeTime )
+{
+    // char msg[128];
+
+    /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+    /* Change to DPC state. */
+    ctrl_select_law( CTRL_LAW_DPC );
+    // app_current_state = DPC;
+    // com_send( "\r\nDPC ON\r\n", 10 );
+
+    /* Change DPC setpoint to necessary swingup cart start position. */
+    cart_position_setpoint_cm_cli_raw = position_cm;
+    // sprintf( msg, "\r\nSETPOINT CHANGED TO: %f\r\n", ( double ) position_cm );
+    // com_send( msg, strlen(msg) );
+
+    /* Wait for 3 seconds - should be enough for cart to reach the start position. */
+    vTaskDelay( 3000 );
+    ctrl_select_law( CTRL_LAW_NONE );
+    app_current_state = SWINGUP;
+
+    // com_send( "\r\nswingup in: 3.\r\n",  18 );
+    // vTaskDelay( 1000 );
+    // com_send(     "swingup in: 2.\r\n",  16 );
+    // vTaskDelay( 1000 );
+    // com_send(     "swingup in: 1.\r\n",  16 );
+    // vTaskDelay( 1000 );
+    // com_send(     "swingup in: 0.\r\n",  16 );
+    /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+    /* Reset task last wake time, so that when this task resumed, timing works properly. */
+    *xLastWakeTime = xTaskGetTickCount();
+}
+
+/* Lookup table swingup. Returns 0 if "swingup" was called with the other mode
+while this task was suspended in here, 1 when the table is done. */
+static uint8_t swingup_table_run( TickType_t *xLastWakeTime )
+{
     /* Index for swingup_control lookup table. */
     uint32_t lookup_index = 0;
 
-    // char msg[128];
+    /* APP HAS TO BE IN DEFAULT STATE - Cart position already calibrated. */
 
-    for( ;; )
+    for( lookup_index = 0; lookup_index < N_LOOKUP_SAMPLES; lookup_index++ )
     {
-        xLastWakeTime = xTaskGetTickCount();
+        /* This task can be suspended any time while in this for loop. */
+
+        if( reset_lookup_index )
+        {
+            /* This procedure runs on every call to "swingup" command. */
+            if( swingup_mode != SWINGUP_MODE_TABLE )
+            {
+                return 0;
+            }
+
+            /* Global reset lookup index variable was set to 1,
+            this means that command "swingup" was called and lookup_index should be set to zero. */
+            lookup_index = 0;
+            reset_lookup_index = 0;
+
+            swingup_preposition( SWINGUP_START_POSITION, xLastWakeTime );
+        }
+
+        /* Use the values from swingup_control lookup table to set
+        dc motor voltage. */
+        dcm_set_output_volatage( LOOKUP_TABLE[ lookup_index ] );
+
+        /* Delay for 10ms exacly. */
+        vTaskDelayUntil( xLastWakeTime, dt_swingup );
+        // vTaskDelay( dt_swingup );
+    }
+
+    return 1;
+}
+
+/* Energy shaping swingup, the law runs in util task. Returns 0 if "swingup"
+was called with the other mode while this task was suspended in here, 1 on
+timeout or when the cart reached a freezing zone. */
+static uint8_t swingup_energy_run( TickType_t *xLastWakeTime )
+{
+    uint32_t tick;
+
+    for( tick = 0; tick < SWINGUP_ENERGY_TIMEOUT_MS / dt_swingup; tick++ )
+    {
+        /* This task can be suspended any time while in this for loop. */
+
+        if( reset_lookup_index )
+        {
+            /* This procedure runs on every call to "swingup" command. */
+            if( swingup_mode != SWINGUP_MODE_ENERGY )
+            {
+                return 0;
+            }
+            tick = 0;
+            reset_lookup_index = 0;
+
+            /* No cart pre-positioning, the law starts from the current state
+            and keeps the cart around the cart position setpoint. */
+            app_current_state = SWINGUP;
+            ctrl_select_law( CTRL_LAW_SWINGUP );
 
-        /* APP HAS TO BE IN DEFAULT STATE - Cart position already calibrated. */
+            /* Reset task last wake time, so that when this task resumed, timing works properly. */
+            *xLastWakeTime = xTaskGetTickCount();
+        }
 
-        for( lookup_index = 0; lookup_index < N_LOOKUP_SAMPLES; lookup_index++ )
+        /* Watchdog checks the zones only in UPC and DPC states. */
+        if( cart_position[ 0 ] < OK_ZONE_LOWER_LIMIT || cart_position[ 0 ] > FREEZING_ZONE_R_LOWER_LIMIT )
         {
-            /* This task can be suspended any time while in this for loop. */
+            break;
+        }
+
+        vTaskDelayUntil( xLastWakeTime, dt_swingup );
+    }
+
+    /* Stop the law, voltage is set to zero by the caller. */
+    ctrl_select_law( CTRL_LAW_NONE );
 
-            if( reset_lookup_index )
+    return 1;
+}
+
+/* TVLQR tracking of the optimized trajectory, the law runs in util task.
+Returns 0 if "swingup" was called with the other mode while this task was
+suspended in here, 1 when the trajectory is done, on timeout or when the cart
+reached a freezing zone. */
+static uint8_t swingup_tvlqr_run( TickType_t *xLastWakeTime )
+{
+    uint32_t tick;
+
+    for( tick = 0; tick < SWINGUP_TVLQR_TIMEOUT_MS / dt_swingup; tick++ )
+    {
+        /* This task can be suspended any time while in this for loop. */
+
+        if( reset_lookup_index )
+        {
+            /* This procedure runs on every call to "swingup" command. */
+            if( swingup_mode != SWINGUP_MODE_TVLQR )
             {
-                /* This procedure runs on every call to "swingup" command. */
-
-                /* Global reset lookup index variable was set to 1,
-                this means that command "swingup" was called and lookup_index should be set to zero. */
-                lookup_index = 0;
-                reset_lookup_index = 0;
-
-                /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
-                /* Change to DPC state. */
-                vTaskResume( ctrl_downposition_task_handle );
-                // app_current_state = DPC;
-                // com_send( "\r\nDPC ON\r\n", 10 );
-                
-                /* Change DPC setpoint to necessary swingup cart start position. */
-                cart_position_setpoint_cm_cli_raw = SWINGUP_START_POSITION;
-                // sprintf( msg, "\r\nSETPOINT CHANGED TO: %f\r\n", ( double ) SWINGUP_START_POSITION );
-                // com_send( msg, strlen(msg) );
-
-                /* Wait for 3 seconds - should be enough for cart to reach SWINGUP_START_POSITION. */
-                vTaskDelay( 3000 );
-                vTaskSuspend( ctrl_downposition_task_handle );
-                app_current_state = SWINGUP;
-
-                // com_send( "\r\nswingup in: 3.\r\n",  18 );
-                // vTaskDelay( 1000 );
-                // com_send(     "swingup in: 2.\r\n",  16 );
-                // vTaskDelay( 1000 );
-                // com_send(     "swingup in: 1.\r\n",  16 );
-                // vTaskDelay( 1000 );
-                // com_send(     "swingup in: 0.\r\n",  16 );
-                /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
-
-                /* Reset task last wake time, so that when this task resumed, timing works properly. */
-                xLastWakeTime = xTaskGetTickCount();
+                return 0;
             }
+            tick = 0;
+            reset_lookup_index = 0;
+
+            swingup_preposition( SWINGUP_TVLQR_START_CM, xLastWakeTime );
+
+            /* Law starts from the first sample on the next control tick. */
+            ctrl_8_tvlqr_swingup_reset();
+            ctrl_select_law( CTRL_LAW_SWINGUP_TVLQR );
+        }
+
+        /* Watchdog checks the zones only in UPC and DPC states. */
+        if( cart_position[ 0 ] < OK_ZONE_LOWER_LIMIT || cart_position[ 0 ] > FREEZING_ZONE_R_LOWER_LIMIT )
+        {
+            break;
+        }
+
+        if( ctrl_8_tvlqr_swingup_done() )
+        {
+            break;
+        }
+
+        vTaskDelayUntil( xLastWakeTime, dt_swingup );
+    }
+
+    /* Stop the law, voltage is set to zero by the caller. */
+    ctrl_select_law( CTRL_LAW_NONE );
 
-            /* Use the values from swingup_control lookup table to set
-            dc motor voltage. */
-            dcm_set_output_volatage( LOOKUP_TABLE[ lookup_index ] );
+    return 1;
+}
 
-            /* Delay for 10ms exacly. */
-            vTaskDelayUntil( &xLastWakeTime, dt_swingup );
-            // vTaskDelay( dt_swingup );
+void swingup_task( void *pvParameters )
+{
+    /* For RTOS vTaskDelayUntil(). */
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+    uint8_t done;
+
+    for( ;; )
+    {
+        xLastWakeTime = xTaskGetTickCount();
+
+        if( swingup_mode == SWINGUP_MODE_ENERGY )
+        {
+            done = swingup_energy_run( &xLastWakeTime );
+        }
+        else if( swingup_mode == SWINGUP_MODE_TVLQR )
+        {
+            done = swingup_tvlqr_run( &xLastWakeTime );
+        }
+        else
+        {
+            done = swingup_table_run( &xLastWakeTime );
+        }
+
+        if( !done )
+        {
+            /* Restarted with the other mode, reset_lookup_index is still set. */
+            continue;
         }
 
-    /* No more data in the lookup table, set zero voltage. */
+    /* No more data in the lookup table (or energy swingup / tracking stopped), set zero voltage. */
     dcm_set_output_volatage( 0.0f );
 
     /* If this task wasn't suspended ealier it means that up position controller didn't take over control,
@@ -8,7 +8,6 @@ extern enum cart_position_zones cart_current_zone;
 extern float *cart_position_setpoint_cm;
 extern float cart_position_setpoint_cm_cli;
 extern enum lip_app_states app_current_state; 
-extern TaskHandle_t ctrl_downposition_task_handle;
 extern float cart_position_setpoint_cm_cli_raw;
 extern uint32_t swingup_task_resumed;
 extern uint32_t reset_lookup_index;
@@ -56,7 +55,7 @@ void testProcedure1( void )
     //     if( cart_position_setpoint_cm == &cart_position_setpoint_cm_cli )
     //     {
     //         /* Turn on down position controller, "dcp on" / "dpc 1" are both valid commands. */
-    //         vTaskResume( ctrl_downposition_task_handle );
+    //         ctrl_select_law( CTRL_LAW_DPC );
             
     //         /* Change app state to "down position controller" state. 
     //         This will ensure that some cli commands can't be called. */
@@ -125,7 +124,7 @@ void testProcedure1( void )
     // vTaskDelayUntil( &xLastWakeTime, 2000 );
 
     // /* [ 18 ] dpc off */
-    // vTaskSuspend( ctrl_downposition_task_handle );
+    // ctrl_select_law( CTRL_LAW_NONE );
     // // app_current_state = DEFAULT;
     // dcm_set_output_volatage( 0.0f );
 
@@ -1,13 +1,27 @@
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
- * This file contains task that implements full state feedback controller for
- * linear inverted pendulum. Controller keeps pendulum in down position
+ * This file contains util task, the control pipeline of linear inverted pendulum.
+ * Everything that depends on sensor readings runs here in one ordered pass
+ * per control tick, so the control law always uses the state sampled in the
+ * same period and there is no race between estimation and control tasks.
  *
  * This task is used to:
  *     1. Read dcm encoder,
  *     2. Read pendulum magnetic encoder
  *     3. Calculate derivatives of cart position and pend angular position
+ *        (cart speed optionally from encoder edge timestamps, cart_vel.h,
+ *        or both speeds from Kalman filter, kalman.h, or from polynomial
+ *        fit differentiators, poly_diff.h)
  *     4. Calculate cart position setpoint from adc potentiometer reading
  *     5. Calculate number of pendulum arm full revolutions
+ *     6. Call active control law (ctrl_select_law()) and set dc motor voltage
+ *
+ * Latency of the pipeline:
+ *     Sense to actuate latency (start of sensor reads to motor driver write) and
+ *     tick to actuate latency (TIM7 ISR to motor driver write) are measured with
+ *     DWT cycle counter on every tick with active control law, "tick" cli command
+ *     prints them. Pipeline has no blocking calls between ctrl_tick_wait() and
+ *     motor driver write other than sensor reads, so the latency is bounded by
+ *     its execution time, ticks that overrun the period are counted by ctrl_tick.
  *
  * Note about modulo:
  *     Calculate pendulum arm angle in base range [0 2pi]. This method uses modulo operation but implemented as
@@ -26,9 +40,12 @@
  *     cart position setpoint pot  |  cart_position_cm_setpoint_pot |  cm
  *     cart position setpoint cli  |  cart_position_cm_setpoint_cli |  cm
  *
- * Poll the pnedulum encoder at least 3 times per full revolution
+ * Pendulum encoder is sampled and unwrapped in the background at the i2c
+ * transfer rate (pend_enc_sampler.h), this task reads the mean of the newest samples, so the
+ * control rate doesn't limit the pendulum speed.
  *
- * This task runs every 10ms
+ * This task runs every control tick (CTRL_TICK_HZ, 100Hz by default),
+ * it is the only task released by the control tick.
  *
  * saving previous sample readings convention:
  *    reading [0] : reading [n]     : current sample (n)
@@ -37,10 +54,10 @@
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
 #include "LIP_tasks_common.h"
+#include "ctrl_tick_driver.h"
 #include <math.h>
 
 /* These are defined in LIP_tasks_common.c */
-extern volatile uint16_t adc_data_pot;
 extern float pend_angle[ 2 ];
 extern float pend_speed_raw[ 2 ];
 extern float pend_speed[ 2 ]; 
@@ -49,56 +66,209 @@ extern float cart_speed_raw[ 2 ];
 extern float cart_speed[ 2 ];
 // extern IIR_filter LP_filter_pendulum;
 // extern IIR_filter LP_filter_cart;
-extern LP_filter LP_filter_pendulum;
-extern LP_filter LP_filter_cart;
+extern LP_bank LP_filters;
+extern kalman_filter KF_state;
+extern poly_diff PD_pendulum;
+extern poly_diff PD_cart;
 extern float cart_position_setpoint_cm_pot_raw;
 extern float cart_position_setpoint_cm_pot;
 extern float cart_position_setpoint_cm_cli_raw;
 extern float cart_position_setpoint_cm_cli;
-extern float pend_init_angle_offset;
+extern int32_t pend_init_count_sum;
 extern enum lip_app_states app_current_state;
-extern float number_of_pendulumarm_revolutions_dpc;
+extern int32_t number_of_pendulumarm_revolutions_dpc;
 extern float pendulum_angle_in_base_range_dpc;
-extern float number_of_pendulumarm_revolutions_upc;
+extern int32_t number_of_pendulumarm_revolutions_upc;
 extern float pendulum_angle_in_base_range_upc;
 extern float pendulum_arm_angle_setpoint_rad_upc;
 extern float pendulum_arm_angle_setpoint_rad_dpc;
 
+/* Control law run by the pipeline, written by ctrl_select_law(). */
+static volatile enum ctrl_laws ctrl_active_law = CTRL_LAW_NONE;
+
+/* Cart speed estimate, written by cart_speed_select(). */
+static volatile enum cart_speed_sources cart_speed_source = CART_SPEED_LP;
+
+/* Speed estimator, written by state_est_select(). */
+static volatile enum state_estimators state_estimator = STATE_EST_LP;
+
+/* Law behind CTRL_LAW_UPC, written by upc_law_select(). */
+static volatile enum upc_laws upc_law_active = UPC_LAW_FSF;
+
+/* Pipeline latency statistics, read and cleared by cli task. */
+static ctrl_pipeline_stats pipeline_stats;
+
+/* Clear statistics, call inside critical section. */
+static void ctrl_pipeline_clear( void )
+{
+    pipeline_stats.count                = 0;
+    pipeline_stats.sense_to_actuate_min = UINT32_MAX;
+    pipeline_stats.sense_to_actuate_max = 0;
+    pipeline_stats.sense_to_actuate_sum = 0;
+    pipeline_stats.tick_to_actuate_min  = UINT32_MAX;
+    pipeline_stats.tick_to_actuate_max  = 0;
+    pipeline_stats.tick_to_actuate_sum  = 0;
+}
+
+/* Update statistics, call inside critical section. */
+static void ctrl_pipeline_record( uint32_t sense_to_actuate, uint32_t tick_to_actuate )
+{
+    if( sense_to_actuate < pipeline_stats.sense_to_actuate_min )
+    {
+        pipeline_stats.sense_to_actuate_min = sense_to_actuate;
+    }
+    if( sense_to_actuate > pipeline_stats.sense_to_actuate_max )
+    {
+        pipeline_stats.sense_to_actuate_max = sense_to_actuate;
+    }
+    pipeline_stats.sense_to_actuate_sum += sense_to_actuate;
+
+    if( tick_to_actuate < pipeline_stats.tick_to_actuate_min )
+    {
+        pipeline_stats.tick_to_actuate_min = tick_to_actuate;
+    }
+    if( tick_to_actuate > pipeline_stats.tick_to_actuate_max )
+    {
+        pipeline_stats.tick_to_actuate_max = tick_to_actuate;
+    }
+    pipeline_stats.tick_to_actuate_sum += tick_to_actuate;
+
+    pipeline_stats.count++;
+}
+
+void ctrl_select_law( enum ctrl_laws law )
+{
+    /* Pipeline writes the motor driver inside critical section only if the law didn't
+    change during the pass, so after this returns the old law can't set any voltage. */
+    taskENTER_CRITICAL();
+    ctrl_active_law = law;
+    taskEXIT_CRITICAL();
+}
+
+void ctrl_select_law_from_isr( enum ctrl_laws law )
+{
+    UBaseType_t saved_interrupt_status;
+
+    saved_interrupt_status = taskENTER_CRITICAL_FROM_ISR();
+    ctrl_active_law = law;
+    taskEXIT_CRITICAL_FROM_ISR( saved_interrupt_status );
+}
+
+void cart_speed_select( enum cart_speed_sources source )
+{
+    cart_speed_source = source;
+}
+
+enum cart_speed_sources cart_speed_selected( void )
+{
+    return cart_speed_source;
+}
+
+void state_est_select( enum state_estimators estimator )
+{
+    state_estimator = estimator;
+}
+
+enum state_estimators state_est_selected( void )
+{
+    return state_estimator;
+}
+
+void upc_law_select( enum upc_laws upc_law )
+{
+    upc_law_active = upc_law;
+}
+
+enum upc_laws upc_law_selected( void )
+{
+    return upc_law_active;
+}
+
+void ctrl_pipeline_get_stats( ctrl_pipeline_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = pipeline_stats;
+    taskEXIT_CRITICAL();
+}
+
+void ctrl_pipeline_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    ctrl_pipeline_clear();
+    taskEXIT_CRITICAL();
+}
+
 void util_task( void *pvParameters )
 {
-    /* For RTOS vTaskDelayUntil() */
-    TickType_t xLastWakeTime = xTaskGetTickCount();
+    /* DWT cycles at control tick ISR, start of sensor reads and motor driver write. */
+    uint32_t tick_cycles;
+    uint32_t sense_cycles;
+    uint32_t actuate_cycles;
+
+    /* Control law selected at the start of the pass and its output voltage. */
+    enum ctrl_laws law;
+    float ctrl_signal;
+
+    /* Motor voltage held over the last period, input of Kalman filter. */
+    float voltage_applied;
+
+    /* Pendulum angle as sum of encoder counts relative to startup down position
+    (PEND_ANGLE_SUM_PER_REV per revolution), and its base range parts. */
+    int32_t pend_angle_sum[ 2 ] = { 0, 0 };
+    int32_t pend_angle_rem;
+
+    /* Polynomial fit derivatives, used when selected. */
+    float pd_pend_speed;
+    float pd_cart_speed;
+
+    ctrl_pipeline_reset_stats();
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
      * Low pass filters for derivatives. Pendulum and cart speed.
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+    /* All low pass filters of the pipeline are channels of one bank (LP_bank.h),
+    coefficients are calculated here and by "tcc" / "tcp" cli commands only. */
+    LP_bank_init( &LP_filters, LP_CH_COUNT, dt_ctrl );
+
     /* IIR for pendulum position */
     // float alpha_pend = 0.65;
     // IIR_init_fo( &LP_filter_pendulum, alpha_pend );
-    LP_init( &LP_filter_pendulum, 0.025f, dt*0.001f );
+    LP_bank_set_time_constant( &LP_filters, LP_CH_PEND_SPEED, 0.025f );
 
     /* DCM encoder reading, IIR */
     // float alpha_cart = 0.54;
     // IIR_init_fo( &LP_filter_cart, alpha_cart );
-    LP_init( &LP_filter_cart, 0.025f, dt*0.001f );
+    LP_bank_set_time_constant( &LP_filters, LP_CH_CART_SPEED, 0.025f );
+
+    /* Kalman filter, state is set by the first update. */
+    kalman_init( &KF_state, dt_ctrl );
+
+    /* Polynomial fit differentiators, windows are filled by the first update. */
+    poly_diff_init( &PD_pendulum, PD_WINDOW, PD_ORDER, PD_DELAY, dt_ctrl );
+    poly_diff_init( &PD_cart, PD_WINDOW, PD_ORDER, PD_DELAY, dt_ctrl );
 
     /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
      * Low pass filters for setpoints - cli and pot.
      * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
-    /* Low pass filter for cart position setpoint (pot and cli), 0.2sec time constant, 0dc gain. */
-    LP_filter sp_filter_pot;
-    LP_init( &sp_filter_pot, 0.2f, dt*0.001f );
-    
-    LP_filter sp_filter_cli;
-    LP_init( &sp_filter_cli, 0.05f, dt*0.001f );
+    /* Low pass filter for cart position setpoint (pot and cli), 0dc gain. Pot is oversampled in
+    lockstep with the tick, 0.05sec time constant is enough (was 0.2sec with one asynchronous sample). */
+    LP_bank_set_time_constant( &LP_filters, LP_CH_SP_POT, 0.05f );
+    LP_bank_set_time_constant( &LP_filters, LP_CH_SP_CLI, 0.05f );
 
     for ( ;; )
     {
+        /* Wait for the next control tick. */
+        tick_cycles = ctrl_tick_wait();
+        sense_cycles = ctrl_tick_cycles();
+        voltage_applied = dcm_get_output_voltage();
+
         /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
          * Pendulum angular position - magnetic encoder reading 
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        pend_angle_sum[ 1 ] = pend_angle_sum[ 0 ];
+        pend_angle_sum[ 0 ] = pend_enc_get_cumulative_count_sum() - pend_init_count_sum;
         pend_angle[ 1 ] = pend_angle[ 0 ];
-        pend_angle[ 0 ] = ( float ) pend_enc_get_cumulative_count() / 4096.0f * PI2 - pend_init_angle_offset;
+        pend_angle[ 0 ] = ( float ) pend_angle_sum[ 0 ] * PEND_ANGLE_SUM_TO_RAD;
         
         /* ??? filter for pendulum angle ??? */
         // IIR_update_fo( &LP_filter_pendulum, pend_angle[ 0 ] );
@@ -108,21 +278,11 @@ void util_task( void *pvParameters )
          * Pendulum angular speed calculation with Tustin method 
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
         pend_speed_raw[ 1 ] = pend_speed_raw[ 0 ];
-        pend_speed_raw[ 0 ] = ( pend_angle[0] - pend_angle[1] ) * 2 * dt_inv - pend_speed_raw[ 1 ];
+        pend_speed_raw[ 0 ] = ( float ) ( pend_angle_sum[ 0 ] - pend_angle_sum[ 1 ] ) * ( PEND_ANGLE_SUM_TO_RAD * 2 * dt_inv ) - pend_speed_raw[ 1 ];
 
         /* IIR filter for pendulum speed. */
         // IIR_update_fo( &LP_filter_pendulum, pend_speed[ 0 ] );
         // pend_speed[ 0 ] = LP_filter_pendulum.out;
-        
-        /* Low-pass filter for pendulum angle derivative. */
-        LP_update( &LP_filter_pendulum, pend_speed_raw[ 0 ] );
-        pend_speed[ 0 ] = LP_filter_pendulum.out[ 0 ];
-
-        /* Dead zone for calculated pendulum speed, about +-10 deg/sec. */ 
-        if ( ( pend_speed[ 0 ] < 0.2 ) && ( pend_speed[ 0 ] > -0.2 ) )
-        {
-            pend_speed[ 0 ] = 0;
-        }
 
         /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
          * Cart position - DCM encoder reading 
@@ -144,26 +304,79 @@ void util_task( void *pvParameters )
         // IIR_update_fo( &LP_filter_cart, cart_speed[ 0 ] );
         // cart_speed[ 0 ] = LP_filter_cart.out;
 
-        /* Low-pass filter for cart speed. */
-        LP_update( &LP_filter_cart, cart_speed_raw[ 0 ] );
-        cart_speed[ 0 ] = LP_filter_cart.out[ 0 ];
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ 
+         * Cart position setpoint from potentiometer adc reading, mean of the burst converted after
+         * the previous tick (pot_adc_driver.h). 
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        cart_position_setpoint_cm_pot_raw = pot_adc_get_counts() * ( TRACK_LEN_MAX_CM / ( float ) POT_ADC_COUNTS );
 
         /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ 
-         * Cart position setpoint from potentiometer adc reading, global variable. 
+         * Low pass filters, all channels in one pass: pendulum and cart angle derivatives,
+         * setpoints (pot and cli). Cart speed channel is always updated so switching to it is smooth.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        LP_filters.in[ LP_CH_PEND_SPEED ] = pend_speed_raw[ 0 ];
+        LP_filters.in[ LP_CH_CART_SPEED ] = cart_speed_raw[ 0 ];
+        LP_filters.in[ LP_CH_SP_POT ]     = cart_position_setpoint_cm_pot_raw;
+        LP_filters.in[ LP_CH_SP_CLI ]     = cart_position_setpoint_cm_cli_raw;
+        LP_bank_update( &LP_filters );
+
+        /* Low-pass filtered pendulum angle derivative. */
+        pend_speed[ 0 ] = LP_filters.out[ LP_CH_PEND_SPEED ];
+
+        /* Dead zone for calculated pendulum speed, about +-10 deg/sec. */ 
+        if ( ( pend_speed[ 0 ] < 0.2 ) && ( pend_speed[ 0 ] > -0.2 ) )
+        {
+            pend_speed[ 0 ] = 0;
+        }
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ 
+         * Cart speed with M/T method from encoder edge timestamps (cart_vel.h), "cartvel mt".
+         * No quantization to encoder counts per period and no low-pass filter lag. UPC gains
+         * were tuned with the lag of the cart speed low-pass filter in the loop, so the filtered speed stays default.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        if( cart_speed_source == CART_SPEED_MT )
+        {
+            cart_speed[ 0 ] = cart_vel_update();
+        }
+        else
+        {
+            cart_vel_update();
+            cart_speed[ 0 ] = LP_filters.out[ LP_CH_CART_SPEED ];
+        }
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ 
+         * Kalman filter (kalman.h), "estimator kf". Always updated so switching to it is smooth,
+         * replaces both filtered derivatives (and the pendulum speed dead zone) when selected.
+         * Positions are the encoder readings, the filter doesn't improve them.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        kalman_update( &KF_state, voltage_applied, cart_position[ 0 ], pend_angle[ 0 ] );
+        if( state_estimator == STATE_EST_KF )
+        {
+            cart_speed[ 0 ] = KF_state.x[ KALMAN_DX ];
+            pend_speed[ 0 ] = KF_state.x[ KALMAN_DTH ];
+        }
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+         * Polynomial fit derivatives (poly_diff.h), "estimator pd". FIR differentiators, quantization
+         * noise doesn't ring like in the Tustin derivative, so there is no low-pass filter and no dead zone.
+         * Always updated so switching to them is smooth.
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
-        cart_position_setpoint_cm_pot_raw = (float) adc_data_pot / 4096.0f * TRACK_LEN_MAX_CM;
+        pd_pend_speed = poly_diff_update( &PD_pendulum, pend_angle[ 0 ] );
+        pd_cart_speed = poly_diff_update( &PD_cart, cart_position[ 0 ] );
+        if( state_estimator == STATE_EST_PD )
+        {
+            cart_speed[ 0 ] = pd_cart_speed;
+            pend_speed[ 0 ] = pd_pend_speed;
+        }
 
         /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
-         * Low pass filter for cart position setpoint (pot and cli), 0.2sec time constant, 0dc gain. 
+         * Low pass filtered cart position setpoint (pot and cli), 0.05sec time constant, 0dc gain. 
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
         /* input is cart_position_setpoint_cm_pot_raw or cart_position_setpoint_cm_cli_raw, 
-        output samples are stored internally in sp_filter struct.
+        output samples are stored in the filter bank.
         The latest sample is assiged to cart_position_setpoint_cm_pot or cart_position_setpoint_cm_cli_raw */
-        LP_update( &sp_filter_pot, cart_position_setpoint_cm_pot_raw );
-        cart_position_setpoint_cm_pot = sp_filter_pot.out[ 0 ];
-
-        LP_update( &sp_filter_cli, cart_position_setpoint_cm_cli_raw );
-        cart_position_setpoint_cm_cli = sp_filter_cli.out[ 0 ];
+        cart_position_setpoint_cm_pot = LP_filters.out[ LP_CH_SP_POT ];
+        cart_position_setpoint_cm_cli = LP_filters.out[ LP_CH_SP_CLI ];
 
         if( app_current_state == DEFAULT )
         {
@@ -184,52 +397,86 @@ void util_task( void *pvParameters )
          * Graph: https://www.desmos.com/calculator/qaacl2m3cu  
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
-        /* Calculate number of revolutions using floored division. */
-        number_of_pendulumarm_revolutions_dpc = floorf( pend_angle[ 0 ] / PI2 );
+        /* Calculate number of revolutions using floored division of integer angle. PEND_ANGLE_SUM_PER_REV
+        is a power of two, int32_t is two's complement, so the remainder of floored division is the low
+        bits of the angle and the division of what is left is exact. */
+        pend_angle_rem = pend_angle_sum[ 0 ] & ( PEND_ANGLE_SUM_PER_REV - 1 );
+        number_of_pendulumarm_revolutions_dpc = ( pend_angle_sum[ 0 ] - pend_angle_rem ) / PEND_ANGLE_SUM_PER_REV;
         
         /* Calculate pendulum angle in base range [0, 2PI].
         This range stays the same as original range in the model, so that pendulum angle of 180 degree
         or PI radians still corresponds to down position. */
-        pendulum_angle_in_base_range_dpc = pend_angle[ 0 ] - PI2 * number_of_pendulumarm_revolutions_dpc;
+        pendulum_angle_in_base_range_dpc = ( float ) pend_angle_rem * PEND_ANGLE_SUM_TO_RAD;
 
         /* Angle setpoint for pendulum arm. Down position corresponds to 180 degrees or pi radians.
         Controller works with angle in radians. "BASE" postfix indicates that this setpoint is from
         base angle range [0, 2PI]. Because pendulum arm can make many full revolutions,
         angles PI, 3PI, 5PI and so on, all correspond to the same down position, angle setpoint needs
-        to be changed accordingly. */
-        #define PENDULUM_ANGLE_DOWN_SETPOINT_BASE PI
-
-        /* Calculate real pendulum angle setpoint from setpoint in base range [0, 2PI] for DPC. */
-        pendulum_arm_angle_setpoint_rad_dpc = PENDULUM_ANGLE_DOWN_SETPOINT_BASE + number_of_pendulumarm_revolutions_dpc * PI2;
+        to be changed accordingly. DPC works with error in base range, setpoint is for telemetry. */
+        pendulum_arm_angle_setpoint_rad_dpc = PENDULUM_ANGLE_DOWN_SETPOINT_BASE + ( float ) number_of_pendulumarm_revolutions_dpc * PI2;
         
         /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
          * For UPC - Angle switching in down position - switching on top would generate
          * discontinuities in values of angle setpoint. 
          * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
     
-        /* Calculate number of revolutions using floored division. 
+        /* Calculate number of revolutions using floored division, floor( ( angle - PI ) / 2PI ) + 1. 
         Note: +1 because when pendulum starts in down position, transition to up position in CCW direction
-        counts as negative revolution adding one compensates for that. */
-        number_of_pendulumarm_revolutions_upc = floorf( ( pend_angle[ 0 ] - PI ) / PI2 ) + 1;
+        counts as negative revolution adding one compensates for that. Half revolution is added before
+        the split instead, same as for DPC. */
+        pend_angle_rem = ( pend_angle_sum[ 0 ] + PEND_ANGLE_SUM_PER_REV / 2 ) & ( PEND_ANGLE_SUM_PER_REV - 1 );
+        number_of_pendulumarm_revolutions_upc = ( pend_angle_sum[ 0 ] + PEND_ANGLE_SUM_PER_REV / 2 - pend_angle_rem ) / PEND_ANGLE_SUM_PER_REV;
         
         /* Calculate pendulum angle in base range [-PI, PI]. 
         This range is changed to [-PI, PI], so that pendulum angle of zero degree corresponds to up position
         and there is no discontinuity around zero degree angle. */
-        pendulum_angle_in_base_range_upc = pend_angle[ 0 ] - PI2 * number_of_pendulumarm_revolutions_upc;
+        pendulum_angle_in_base_range_upc = ( float ) ( pend_angle_rem - PEND_ANGLE_SUM_PER_REV / 2 ) * PEND_ANGLE_SUM_TO_RAD;
 
         /* Angle setpoint for pendulum arm. Up position corresponds to 0 degrees or 0 radians.
-        Controller works with angle in radians. "BASE" postfix indicates that this setpoint is from
-        base angle range [0, 2PI]. Because pendulum arm can make many full revolutions,
-        angles 0, 2PI, 4PI and so on, all correspond to the same up position, angle setpoint needs
-        to be changed accordingly. */
-        // non zero value because of pendulum encoder error
-        // #define PENDULUM_ANGLE_UP_SETPOINT_BASE 0.0f
-        #define PENDULUM_ANGLE_UP_SETPOINT_BASE -0.070563f // ??? probably not needed
+        Because pendulum arm can make many full revolutions, angles 0, 2PI, 4PI and so on, all correspond
+        to the same up position, angle setpoint needs to be changed accordingly. UPC and watchdog work
+        with error in base range, setpoint is for telemetry. */
+        pendulum_arm_angle_setpoint_rad_upc = PENDULUM_ANGLE_UP_SETPOINT_BASE + ( float ) number_of_pendulumarm_revolutions_upc * PI2;
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+         * Control law and motor output, state above is from this tick.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        /* Gain set schedules posted by cli are taken here, whole, before the law runs. */
+        gain_sched_tick();
 
-        /* Calculate real pendulum angle setpoint from setpoint in base range [-PI, PI] for UPC. */
-        pendulum_arm_angle_setpoint_rad_upc = PENDULUM_ANGLE_UP_SETPOINT_BASE + number_of_pendulumarm_revolutions_upc * PI2;
+        law = ctrl_active_law;
 
-        /* Task delay */
-        vTaskDelayUntil( &xLastWakeTime, dt );
+        if( law == CTRL_LAW_DPC )
+        {
+            ctrl_signal = ctrl_3_FSF_downpos_law();
+        }
+        else if( law == CTRL_LAW_UPC )
+        {
+            ctrl_signal = ( upc_law_active == UPC_LAW_MPC ) ? ctrl_6_MPC_uppos_law() : ctrl_5_FSF_uppos_law();
+        }
+        else if( law == CTRL_LAW_SWINGUP )
+        {
+            ctrl_signal = ctrl_7_energy_swingup_law();
+        }
+        else if( law == CTRL_LAW_SWINGUP_TVLQR )
+        {
+            ctrl_signal = ctrl_8_tvlqr_swingup_law();
+        }
+        else
+        {
+            /* No control law, motor is driven by other task (cart worker, swingup, ...) or stopped. */
+            continue;
+        }
+
+        /* Watchdog or cli could have changed the law (and set zero voltage) while the control
+        signal was calculated, don't overwrite it. */
+        taskENTER_CRITICAL();
+        if( law == ctrl_active_law )
+        {
+            dcm_set_output_volatage( ctrl_signal );
+            actuate_cycles = ctrl_tick_cycles();
+            ctrl_pipeline_record( actuate_cycles - sense_cycles, actuate_cycles - tick_cycles );
+        }
+        taskEXIT_CRITICAL();
     } /* for ( ;; ) */
 }
\ No newline at end of file
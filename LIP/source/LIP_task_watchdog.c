@@ -4,7 +4,8 @@
  *     - is the default entry point for LIP controller application 
  *     - is used for protection functionality for cart max/min positions
  *           - set the cart zones based on current cart position
- *           - set dc motor voltage to zero when any track limit is reached (gpio pooling) 
+ *           (track limit switches are handled by limit switch interrupt, limit_switch.h)
+ *     - restarts AS5600 background sampling if it stopped (pend_enc_driver.c)
  *     - is switching between controllers in swingup routine
  *       (swingup task - up position control task)
  * 
@@ -19,10 +20,8 @@
 #include "LIP_tasks_common.h"
 #include <math.h>
 
-/* Note: max cart run is 40.7cm */
-#define FREEZING_ZONE_L_LOWER_LIMIT     0.0f
-#define OK_ZONE_LOWER_LIMIT             3.0f
-#define FREEZING_ZONE_R_LOWER_LIMIT     (40.07f - OK_ZONE_LOWER_LIMIT)
+/* Zone limits FREEZING_ZONE_L_LOWER_LIMIT, OK_ZONE_LOWER_LIMIT and
+FREEZING_ZONE_R_LOWER_LIMIT are in LIP_tasks_common.h, MPC up position law uses them too. */
 
 /* Globals defined in LIP_tasks_common.c */
 extern float cart_position[ 2 ];
@@ -31,9 +30,9 @@ extern enum lip_app_states app_current_state;
 extern float cart_position[ 2 ]; 
 extern enum cart_position_zones cart_current_zone;
 extern uint32_t bounceoff_resumed;
-extern float number_of_pendulumarm_revolutions_dpc;
+extern int32_t number_of_pendulumarm_revolutions_dpc;
 extern float pendulum_angle_in_base_range_dpc;
-extern float number_of_pendulumarm_revolutions_upc;
+extern int32_t number_of_pendulumarm_revolutions_upc;
 extern float pendulum_angle_in_base_range_upc;
 extern float pendulum_arm_angle_setpoint_rad_dpc;
 extern float pendulum_arm_angle_setpoint_rad_upc;
@@ -41,10 +40,8 @@ extern float pendulum_arm_angle_setpoint_rad_upc;
 extern uint32_t bounce_off_action_on;
 extern uint32_t swingup_task_resumed;
 
-extern TaskHandle_t ctrl_downposition_task_handle;
 extern TaskHandle_t bounceoff_task_handle;
 extern TaskHandle_t swingup_task_handle;
-extern TaskHandle_t ctrl_upposition_task_handle;
 
 
 void watchdog_task( void * pvParameters )
@@ -55,6 +52,10 @@ void watchdog_task( void * pvParameters )
     /* For RTOS vTaskDelayUntil() */
     TickType_t xLastWakeTime = xTaskGetTickCount();
 
+    /* Swingup to UPC switching. */
+    float angle_error;
+    uint8_t catch_angle;
+
     /* Set start app state to uninitialized. */
     app_current_state = UNINITIALIZED;
 
@@ -71,9 +72,8 @@ void watchdog_task( void * pvParameters )
                 /* FREEZING_ZONE_L */
                 cart_current_zone = FREEZING_ZONE_L;
 
-                /* Suspend controller tasks. */
-                vTaskSuspend( ctrl_downposition_task_handle );
-                vTaskSuspend( ctrl_upposition_task_handle );
+                /* Stop control law in util task. */
+                ctrl_select_law( CTRL_LAW_NONE );
                 // vTaskSuspend( swingup_task_handle );
 
                 if( bounce_off_action_on )
@@ -104,9 +104,8 @@ void watchdog_task( void * pvParameters )
                 /* FREEZING_ZONE_R */
                 cart_current_zone = FREEZING_ZONE_R;
 
-                /* Suspend controller tasks. */
-                vTaskSuspend( ctrl_downposition_task_handle );
-                vTaskSuspend( ctrl_upposition_task_handle );
+                /* Stop control law in util task. */
+                ctrl_select_law( CTRL_LAW_NONE );
                 // vTaskSuspend( swingup_task_handle );
 
                 if( bounce_off_action_on )
@@ -129,57 +128,11 @@ void watchdog_task( void * pvParameters )
             }
         }
         
-        /* Limit switches. */
-        if( READ_ZERO_POSITION_REACHED )
-        {
-            /* Leftmost position reached (zero position). */
-
-            // ZERO_POSITION_REACHED_h = 1;
-            // MAX_POSITION_REACHED_h  = 0;
-
-            /* Set output voltage to zero. */
-            dcm_set_output_volatage( 0.0f );
-
-            /* Suspend controller tasks. */
-            vTaskSuspend( ctrl_downposition_task_handle );
-            vTaskSuspend( ctrl_upposition_task_handle );
-
-            /* Set output voltage to zero again in case any controller task 
-            managed to set any output voltage. */
-            dcm_set_output_volatage( 0.0f );
-
-            /* Leftmost switch was closed, zero cart position encoder. */
-            dcm_enc_zero_counter();
-
-            /* UPC or DPC controller was on, this means that app was already initialized (in default state).
-            Change app state back to default. */
-            app_current_state = DEFAULT;
-        }
-        else if( READ_MAX_POSITION_REACHED )
-        {
-            /* Rightmost position reached (max position). */
-
-            // MAX_POSITION_REACHED_h  = 1;
-            // ZERO_POSITION_REACHED_h = 0;
-            
-            /* Set output voltage to zero. */
-            dcm_set_output_volatage( 0.0f );
-
-            /* Suspend controller tasks. */
-            vTaskSuspend( ctrl_downposition_task_handle );
-            vTaskSuspend( ctrl_upposition_task_handle );
+        /* Limit switches are handled by limit switch interrupt and limit switch task,
+        see limit_switch.h. */
 
-            /* Set output voltage to zero again in case any controller task 
-            managed to set any output voltage. */
-            dcm_set_output_volatage( 0.0f );
-
-            /* UPC or DPC controller was on, this means that app was already initialized (in default state).
-            Change app state back to default. */
-            if( app_current_state != UNINITIALIZED )
-            {
-                app_current_state = DEFAULT;
-            }
-        }
+        /* Restart AS5600 background sampling if it stopped (i2c bus error). */
+        pend_enc_sampling_check();
 
         // MAX_POSITION_REACHED_h  = 0;
         // ZERO_POSITION_REACHED_h = 0;
@@ -188,9 +141,29 @@ void watchdog_task( void * pvParameters )
         if( app_current_state == SWINGUP )
         {
             /* App is in swingup state. */
+            angle_error = PENDULUM_ANGLE_UP_SETPOINT_BASE - pendulum_angle_in_base_range_upc;
+            if( swingup_mode_selected() == SWINGUP_MODE_ENERGY )
+            {
+                /* Energy swingup comes over the top from either side, UPC takes
+                it close to the top if it can stop the cart inside the zones from
+                there, otherwise the pendulum swings over and comes again. */
+                catch_angle = fabsf( angle_error ) < SWINGUP_ENERGY_CATCH_RAD && ctrl_7_energy_swingup_catch_ok();
+            }
+            else if( swingup_mode_selected() == SWINGUP_MODE_TVLQR )
+            {
+                /* Tracked trajectory ends upright at rest, the last gains are the
+                UPC LQR gains, so UPC takes over close to the top. */
+                catch_angle = fabsf( angle_error ) < SWINGUP_TVLQR_CATCH_RAD;
+            }
+            else
+            {
+                /* Lookup table swingup ends on one side, UPC outputs zero voltage
+                until the pendulum falls into its switch angle window. */
+                catch_angle = ( angle_error < 126.0f*PI/180.0f ) && ( angle_error > 0.0f );
+            }
+
             // if( fabsf( pendulum_arm_angle_setpoint_rad_upc - pend_angle[ 0 ] ) < 70.0f*PI/180.0f ) 
-            if( ( ( pendulum_arm_angle_setpoint_rad_upc - pend_angle[ 0 ] ) < 126.0f*PI/180.0f ) &&
-                ( ( pendulum_arm_angle_setpoint_rad_upc - pend_angle[ 0 ] ) > 0.0f ) ) 
+            if( catch_angle ) 
             {
                 /* Pendulum angle error is within pm. 25 degrees from up position. */
 
@@ -199,8 +172,8 @@ void watchdog_task( void * pvParameters )
                 dcm_set_output_volatage( 0.0f );
                 // app_current_state = DEFAULT;
 
-                /* Resume UPC, change app state to UPC. */
-                vTaskResume( ctrl_upposition_task_handle );    
+                /* Start UPC, change app state to UPC. */
+                ctrl_select_law( CTRL_LAW_UPC );
                 app_current_state = UPC;
             }
         }
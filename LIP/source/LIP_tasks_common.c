@@ -4,14 +4,12 @@
  * definition of LIP_create_Tasks function, which creates all app tasks.
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 #include "LIP_tasks_common.h"
+#include "ctrl_tick_driver.h"
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * Globals used by all tasks.
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
-/* Holds data from ADC3 tranfered over DMA, init code is in motor_driver.c/dcm_init(). */
-volatile uint16_t adc_data_pot;
-
 /* holds each byte received from console (uart3) */
 uint8_t cRxedChar = 0x00;
 
@@ -22,7 +20,6 @@ float pend_angle[ 2 ] = { 0.0f };   // Angle current & previous sample
 float pend_speed_raw[ 2 ] = { 0.0f };   // Angle derivative
 float pend_speed[ 2 ] = { 0.0f };
 // IIR_filter low_pass_IIR_pend;
-LP_filter LP_filter_pendulum;
 
 /* These are made global but only basic_test_task will write to them
 Only controller_task should read them
@@ -31,7 +28,18 @@ float cart_position[ 2 ] = { 0.0f };
 float cart_speed_raw[ 2 ] = { 0.0f };
 float cart_speed[ 2 ] = { 0.0f };
 // IIR_filter low_pass_IIR_cart;
-LP_filter LP_filter_cart;
+
+/* Low pass filters of util task, channels are enum lp_channels. */
+LP_bank LP_filters;
+
+/* Kalman filter for cart and pendulum state, util task updates it
+every tick and uses its speeds when selected (state_est_select()). */
+kalman_filter KF_state;
+
+/* Polynomial fit differentiators of pendulum angle and cart position, util task
+updates them every tick and uses them when selected (state_est_select()). */
+poly_diff PD_pendulum;
+poly_diff PD_cart;
 
 /* Cart position setpoint from adc reading, converetd to [0, 40.7] range in cm.
 [ 0 ] is current, [ 1 ] is previous sample. */
@@ -54,8 +62,8 @@ float pendulum_arm_angle_setpoint_rad_dpc;
 
 /* Holds number of pendulum full revolutions, negative number indicates
 full revolution in counter clockwise direction. */
-float number_of_pendulumarm_revolutions_dpc; // for dpc
-float number_of_pendulumarm_revolutions_upc; // for upc
+int32_t number_of_pendulumarm_revolutions_dpc; // for dpc
+int32_t number_of_pendulumarm_revolutions_upc; // for upc
 
 /* Pendulum arm angle in base range [0, 2pi]. */
 float pendulum_angle_in_base_range_dpc; // for dpc
@@ -63,9 +71,11 @@ float pendulum_angle_in_base_range_upc; // for upc
 
 /* Pendulum magnetic encoder reading at down position. The default pendulum
 position is assumed to be down position, from control/model perspective, down
-position corresponds to PI radians, so PI has to be subtracted from initial reading and
-resultant value is offset that has to subtracted from each angle reading. */
-float pend_init_angle_offset;
+position corresponds to PI radians, so half revolution has to be subtracted from
+initial reading and resultant value is offset that has to subtracted from each
+angle reading. Sum of PEND_ENC_AVG_LEN counts, same unit as
+pend_enc_get_cumulative_count_sum(). */
+int32_t pend_init_count_sum;
 
 /* lip_app_states enum instance, which indicates current LIP app state. */
 enum lip_app_states app_current_state; 
@@ -106,7 +116,7 @@ uint32_t reset_home = 0;
 // uint32_t reset_test = 0;
 
 /* These are used as global variables to hold four control signal components from 
-active controller task. COM_SEND_CTRL_DEBUG is defined in main_LIP.c */
+active control law. COM_SEND_CTRL_DEBUG is defined in main_LIP.c */
 #ifdef COM_SEND_CTRL_DEBUG
     float ctrl_xw = 0.0f;
     float ctrl_th = 0.0f;
@@ -119,13 +129,18 @@ TaskHandle_t watchdog_task_handle = NULL;
 StackType_t WATCHDOG_STACKBUFFER[ WATCHDOG_STACK_DEPTH ];
 StaticTask_t WATCHDOG_TASKBUFFER_TCB;
 
+/* Limit switch task - state change after limit switch interrupt. */
+TaskHandle_t limitsw_task_handle = NULL;
+StackType_t LIMITSW_STACKBUFFER[ LIMITSW_STACK_DEPTH ];
+StaticTask_t LIMITSW_TASKBUFFER_TCB;
+
 /* Console task */
 TaskHandle_t console_task_handle;
 StackType_t console_STACKBUFFER[ CONSOLE_STACKDEPTH ];
 StaticTask_t console_TASKBUFFER_TCB;
 TickType_t time_at_which_consoleMutex_was_taken;
 
-/* State estimation task */
+/* State estimation & control task (control pipeline) */
 TaskHandle_t util_task_handle = NULL;
 StackType_t utilTask_STACKBUFFER [ UTIL_STACK_DEPTH ];
 StaticTask_t utilTask_TASKBUFFER_TCB;
@@ -146,18 +161,6 @@ TaskHandle_t cartworker_TaskHandle = NULL;
 StackType_t CARTWORKER_STACKBUFFER [ CARTWORKER_STACK_DEPTH ];
 StaticTask_t CARTWORKER_TASKBUFFER_TCB;
 
-/* Down-position controller
-Full state feedback down position with deadzone compensation. */
-TaskHandle_t ctrl_downposition_task_handle = NULL;
-StackType_t ctrl_downposition_STACKBUFFER [ CTRL_3_FSF_DOWNPOS_STACK_DEPTH ];
-StaticTask_t ctrl_downposition_TASKBUFFER_TCB;
-
-/* Up-position controller
-Full state feedback up position with deadzone compensation. */
-TaskHandle_t ctrl_upposition_task_handle = NULL;
-StackType_t ctrl_upposition_STACKBUFFER [ CTRL_5_FSF_UPPOS_STACK_DEPTH ];
-StaticTask_t ctrl_upposition_TASKBUFFER_TCB;
-
 /* Swingup. */
 TaskHandle_t swingup_task_handle = NULL;
 StackType_t swingup_STACKBUFFER [ SWINGUP_STACK_DEPTH ];
@@ -178,6 +181,11 @@ TaskHandle_t test_task_handle = NULL;
 StackType_t test_STACKBUFFER [ TEST_STACK_DEPTH ];
 StaticTask_t test_TASKBUFFER_TCB;
 
+/* LQR task. */
+TaskHandle_t lqr_task_handle = NULL;
+StackType_t lqr_STACKBUFFER [ LQR_STACK_DEPTH ];
+StaticTask_t lqr_TASKBUFFER_TCB;
+
 /* CREATE TASKS. */
 void LIP_create_Tasks()
 {
@@ -189,6 +197,16 @@ void LIP_create_Tasks()
                                               WATCHDOG_STACKBUFFER,
                                               &WATCHDOG_TASKBUFFER_TCB );
 
+    /* Limit switch interrupt sets motor voltage to zero and notifies this task. */
+    limitsw_task_handle = xTaskCreateStatic( limit_switch_task,
+                                             (const char*) "LimitSwitch",
+                                             LIMITSW_STACK_DEPTH,
+                                             (void *) 0,
+                                             tskIDLE_PRIORITY+PRIORITY_LIMITSW,
+                                             LIMITSW_STACKBUFFER,
+                                             &LIMITSW_TASKBUFFER_TCB );
+    limit_switch_init( limitsw_task_handle );
+
     /* Task that implements FreeRTOS console functionality */
     console_task_handle = xTaskCreateStatic( console_task,
                                              (const char*) "Console",
@@ -198,7 +216,7 @@ void LIP_create_Tasks()
                                              console_STACKBUFFER,
                                              &console_TASKBUFFER_TCB );
 
-    /* State variables are calculated here. */
+    /* State variables and control signal are calculated here. */
     util_task_handle = xTaskCreateStatic( util_task,
                                           (const char*) "Util",
                                           UTIL_STACK_DEPTH,
@@ -259,31 +277,21 @@ void LIP_create_Tasks()
     /* Bounce off task is resumed only in case of emergency. */  
     vTaskSuspend( bounceoff_task_handle );
 
-    /* Down position controller
-    Full state feedback down position ctrl-er with "tanh switching" deadzone compensation 
-    (nonlinear cart position gain). */
-    ctrl_downposition_task_handle = xTaskCreateStatic( ctrl_3_FSF_downpos_task,
-                                                       ( const char* ) "DownPosCtrl",
-                                                       CTRL_3_FSF_DOWNPOS_STACK_DEPTH,
-                                                       ( void * ) 0,
-                                                       tskIDLE_PRIORITY+PRIORITY_CTRL,
-                                                       ctrl_downposition_STACKBUFFER,
-                                                       &ctrl_downposition_TASKBUFFER_TCB );
-    /* All controller tasks are suspended right after their creation. */  
-    vTaskSuspend( ctrl_downposition_task_handle );
-
-    /* Up position controller
-    Full state feedback up position ctrl-er with "tanh-switching" deadzone compensation
-    (nonlinear cart position gain). */
-    ctrl_upposition_task_handle = xTaskCreateStatic( ctrl_5_FSF_uppos_task,
-                                                     (const char*) "UpPosCtrl",
-                                                     CTRL_5_FSF_UPPOS_STACK_DEPTH,
-                                                     (void *) 0,
-                                                     tskIDLE_PRIORITY+PRIORITY_CTRL,
-                                                     ctrl_upposition_STACKBUFFER,
-                                                     &ctrl_upposition_TASKBUFFER_TCB );
-    /* All controller tasks are suspended right after their creation. */  
-    vTaskSuspend( ctrl_upposition_task_handle );
+    /* Util task runs the whole control pipeline (sensors, estimation, control law, motor output)
+    and is released by TIM7 control tick. */
+    ctrl_tick_register( util_task_handle );
+
+    /* Execution time, wake period and jitter of app tasks, "task-stats" cli command.
+    Nominal period in ms, 0 for event driven tasks. */
+    task_prof_register_cycles( util_task_handle, CTRL_TICK_CPU_HZ / CTRL_TICK_HZ );
+    task_prof_register( watchdog_task_handle, dt_watchdog );
+    task_prof_register( limitsw_task_handle, 0 );
+    task_prof_register( console_task_handle, dt_console );
+    task_prof_register( com_task_handle, dt_com );
+    task_prof_register( cartworker_TaskHandle, dt_cartworker );
+    task_prof_register( swingup_task_handle, dt_swingup );
+    task_prof_register( swingdown_task_handle, dt );
+    task_prof_register( bounceoff_task_handle, 0 );
 
     /* Raw byte communication task. */
     // rawcom_task_handle = xTaskCreateStatic( raw_com_task,
@@ -301,4 +309,15 @@ void LIP_create_Tasks()
                                           tskIDLE_PRIORITY+PRIORITY_TEST,
                                           test_STACKBUFFER,
                                           &test_TASKBUFFER_TCB );
+    task_prof_register( test_task_handle, 0 );
+
+    /* Gain synthesis, runs only when a job is given by "lqr" cli command. */
+    lqr_task_handle = xTaskCreateStatic( lqr_task,
+                                         (const char*) "LQR",
+                                         LQR_STACK_DEPTH,
+                                         (void *) 0,
+                                         tskIDLE_PRIORITY+PRIORITY_LQR,
+                                         lqr_STACKBUFFER,
+                                         &lqr_TASKBUFFER_TCB );
+    task_prof_register( lqr_task_handle, 0 );
 }
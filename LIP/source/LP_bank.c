@@ -0,0 +1,66 @@
+#include "LP_bank.h"
+
+void LP_bank_init( LP_bank *bank, uint32_t channels, float samplingTime )
+{
+    /* This function initializes bank of low-pass filters. */
+    if( channels > LP_BANK_MAX_CHANNELS )
+    {
+        channels = LP_BANK_MAX_CHANNELS;
+    }
+    bank->channels = channels;
+
+    if( samplingTime < 0.0f )
+    {
+        bank->samplingTime = 0.0f;
+    }
+    else
+    {
+        bank->samplingTime = samplingTime;
+    }
+
+    for( uint32_t i = 0; i < LP_BANK_MAX_CHANNELS; i++ )
+    {
+        bank->in[ i ]      = 0.0f;
+        bank->in_prev[ i ] = 0.0f;
+        bank->out[ i ]     = 0.0f;
+        LP_bank_set_time_constant( bank, i, 0.0f );
+    }
+}
+
+void LP_bank_set_time_constant( LP_bank *bank, uint32_t channel, float timeConstant )
+{
+    /* Same coefficients as LP_update(), divisions are done only here. */
+    float den;
+
+    if( channel >= LP_BANK_MAX_CHANNELS )
+    {
+        return;
+    }
+    if( timeConstant < 0.0f )
+    {
+        timeConstant = 0.0f;
+    }
+    bank->timeConstant[ channel ] = timeConstant;
+
+    den = 2 * timeConstant + bank->samplingTime;
+    if( den > 0.0f )
+    {
+        bank->c1[ channel ] = bank->samplingTime / den;
+        bank->c2[ channel ] = ( 2 * timeConstant - bank->samplingTime ) / den;
+    }
+    else
+    {
+        bank->c1[ channel ] = 0.5f;
+        bank->c2[ channel ] = 0.0f;
+    }
+}
+
+void LP_bank_update( LP_bank *bank )
+{
+    /* This function calculates outputs of all channels. */
+    for( uint32_t i = 0; i < bank->channels; i++ )
+    {
+        bank->out[ i ]     = bank->c1[ i ] * ( bank->in[ i ] + bank->in_prev[ i ] ) + bank->c2[ i ] * bank->out[ i ];
+        bank->in_prev[ i ] = bank->in[ i ];
+    }
+}
@@ -1,5 +1,22 @@
 #include "LP_filter.h"
 
+/* Calculate coefficients from time constant and sampling time. */
+static void LP_coeffs( LP_filter *lp )
+{
+    float den = 2*lp->timeConstant + lp->samplingTime;
+
+    if( den > 0.0f )
+    {
+        lp->c1 = lp->samplingTime / den;
+        lp->c2 = (2*lp->timeConstant - lp->samplingTime) / den;
+    }
+    else
+    {
+        lp->c1 = 0.5f;
+        lp->c2 = 0.0f;
+    }
+}
+
 void LP_init( LP_filter *lp, float timeConstant, float samplingTime )
 {
     /* This function initizalies lp low-pass filter. */
@@ -20,6 +37,8 @@ void LP_init( LP_filter *lp, float timeConstant, float samplingTime )
         lp->samplingTime = samplingTime;
     }
 
+    LP_coeffs( lp );
+
     lp->out[ 0 ] = 0.0f;
     lp->out[ 1 ] = 0.0f;
     lp->in[ 0 ]  = 0.0f;
@@ -33,10 +52,7 @@ float LP_update( LP_filter *lp, float in )
     lp->in[ 1 ]  = lp->in[ 0 ];
     lp->in[ 0 ]  = in;
 
-    float c1, c2;
-    c1 = lp->samplingTime / ( 2*lp->timeConstant + lp->samplingTime );
-    c2 = (2*lp->timeConstant - lp->samplingTime) / (2*lp->timeConstant + lp->samplingTime);
-    lp->out[ 0 ] = c1 * ( lp->in[ 0 ] + lp->in[ 1 ] ) + c2 * lp->out[ 1 ] ;
+    lp->out[ 0 ] = lp->c1 * ( lp->in[ 0 ] + lp->in[ 1 ] ) + lp->c2 * lp->out[ 1 ] ;
 
     return lp->out[ 0 ];
 }
@@ -52,4 +68,5 @@ void LP_update_time_Constant( LP_filter *lp, float newTimeConstant )
     {
         lp->timeConstant = newTimeConstant;
     }
+    LP_coeffs( lp );
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Cart velocity - mixed period/frequency (M/T) estimate from encoder edges,
+ * see cart_vel.h.
+ *
+ * Edge ring is written by TIM4 interrupt (NVIC priority 5), util task reads
+ * it inside a critical section, which masks it.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "main_LIP.h"
+#include "cart_vel.h"
+#include "ctrl_tick_driver.h"
+
+/* DWT cycles per microsecond. */
+#define CYCLES_PER_US   ( CTRL_TICK_CPU_HZ / 1000000UL )
+
+/* TIM4 counter period, captured counts wrap around at ARR. */
+#define COUNT_PERIOD    ( ENC_TIMER_ARR + 1 )
+
+/* Newest edges, edge_total is the number of edges since start (or since the
+ring went stale), newest edge is at ( edge_total - 1 ) % CART_VEL_EDGES. */
+static uint16_t edge_count[ CART_VEL_EDGES ];
+static uint32_t edge_cycles[ CART_VEL_EDGES ];
+static uint32_t edge_total = 0;
+
+void cart_vel_edge( uint16_t count, uint32_t cycles )
+{
+    uint32_t i = edge_total % CART_VEL_EDGES;
+
+    edge_count[ i ]  = count;
+    edge_cycles[ i ] = cycles;
+    edge_total++;
+}
+
+float cart_vel_update( void )
+{
+    uint32_t now = ctrl_tick_cycles();
+    uint32_t total;
+    uint32_t newest;
+    uint32_t older;
+    uint32_t n;
+    uint32_t newest_cycles = 0;
+    uint32_t period = 0;
+    uint32_t since;
+    int32_t counts = 0;
+    float speed;
+    float bound;
+
+    taskENTER_CRITICAL();
+    total = edge_total;
+    n = total < CART_VEL_EDGES ? total : CART_VEL_EDGES;
+    if( n >= 2 )
+    {
+        newest = ( total - 1 ) % CART_VEL_EDGES;
+        newest_cycles = edge_cycles[ newest ];
+
+        /* Oldest edge within the window, at least the edge before the newest. */
+        older = ( total - 2 ) % CART_VEL_EDGES;
+        for( uint32_t k = 3; k <= n; k++ )
+        {
+            uint32_t i = ( total - k ) % CART_VEL_EDGES;
+            if( newest_cycles - edge_cycles[ i ] > CART_VEL_WINDOW_US * CYCLES_PER_US )
+            {
+                break;
+            }
+            older = i;
+        }
+        counts = ( int32_t ) edge_count[ newest ] - edge_count[ older ];
+        period = newest_cycles - edge_cycles[ older ];
+    }
+    taskEXIT_CRITICAL();
+
+    if( n < 2 )
+    {
+        return 0.0f;
+    }
+
+    /* Counter wrapped between the edges. */
+    if( counts > COUNT_PERIOD / 2 )
+    {
+        counts -= COUNT_PERIOD;
+    }
+    else if( counts < -COUNT_PERIOD / 2 )
+    {
+        counts += COUNT_PERIOD;
+    }
+
+    speed = ( float ) counts * ENCODER_MULTIPLIER * ( ( float ) CTRL_TICK_CPU_HZ / ( float ) period );
+
+    /* No edge for a while, cart is slower than one edge per time since the newest edge. */
+    since = now - newest_cycles;
+    if( since > CART_VEL_TIMEOUT_US * CYCLES_PER_US )
+    {
+        /* The ring is stale: since wraps with the 32 bit DWT counter (about 25.6s
+        at 168MHz) and would bring the old estimate back, so forget the edges,
+        speed is 0 until two new edges come in. Runs every control tick, long
+        before the wrap. An edge that came in after the read is kept. */
+        taskENTER_CRITICAL();
+        if( edge_total == total )
+        {
+            edge_total = 0;
+        }
+        taskEXIT_CRITICAL();
+        speed = 0.0f;
+    }
+    else if( since > 0 )
+    {
+        bound = CART_VEL_EDGE_COUNTS * ENCODER_MULTIPLIER * ( ( float ) CTRL_TICK_CPU_HZ / ( float ) since );
+        if( speed > bound )
+        {
+            speed = bound;
+        }
+        else if( speed < -bound )
+        {
+            speed = -bound;
+        }
+    }
+
+    return speed;
+}
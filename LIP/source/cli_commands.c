@@ -10,7 +10,7 @@
  *     TESTS
  *
  * Commands:
- *     task-stats       -    Displays a table showing the state of each FreeRTOS task
+ *     task-stats       -    Execution time, wake period, jitter and overruns of app tasks
  *     <enter-key>      -    Start/stop data streaming
  *     home             -    Go to home cart position - center of the track, no controller used
  *     reset/rr         -    Reset uC
@@ -23,9 +23,19 @@
  *     dpci             -    Turn on/off down position controller with integral action on cart position error
  *     upc              -    Turn on/off up position controller
  *     upci             -    Turn on/off up position controller with integral action on cart position error
- *     swingup          -    Turn on pendulum swingup procedure
+ *     swingup          -    Turn on pendulum swingup procedure, lookup table, closed loop energy shaping or TVLQR tracking
  *     swingdown
  *     bounceoff        -    Turn on or off cart min max bounce off protection
+ *     tick             -    Control tick rate, jitter and overruns of util task, control pipeline latency
+ *     limitsw          -    Limit switch interrupts, switch to zero voltage latency
+ *     as5600           -    Pendulum encoder background sampling rate, errors, sample age and max arm speed
+ *     cartvel          -    Select cart speed estimate, M/T from encoder edges or low-pass filtered derivative
+ *     estimator        -    Select speed estimator, low-pass filtered derivatives, Kalman filter or polynomial fit
+ *     filterbench      -    Cycles per control tick of the pipeline filters, old and new implementations
+ *     polydiff         -    Window, order and delay of polynomial fit differentiators ("estimator pd")
+ *     gains            -    List, select or interpolate UPC / DPC gain sets from flash tables
+ *     lqr              -    Solve UPC / DPC gains on the target (DARE) and switch to them
+ *     upclaw           -    Select up position law, full state feedback or MPC with cart and voltage constraints
  *
  * Note: commands callback functions change app state, which is indicated by
  * preprompt string in cli prompt ( (preprompt)>>> ). All logic related to
@@ -44,6 +54,8 @@
 #include "math.h"
 
 #include "main_LIP.h"
+#include "ctrl_tick_driver.h"
+#include "filter_bench.h"
 
 /* App globals defined in LIP_tasks_common.c */
 extern float cart_position[ 2 ];
@@ -59,8 +71,7 @@ extern enum lip_app_states app_current_state;
 extern uint32_t reset_lookup_index;
 extern uint32_t reset_swingdown;
 extern uint32_t reset_home;
-extern LP_filter LP_filter_cart;
-extern LP_filter LP_filter_pendulum;
+extern LP_bank LP_filters;
 
 extern TaskHandle_t watchdog_task_handle;
 extern TaskHandle_t console_task_handle;
@@ -68,8 +79,6 @@ extern TaskHandle_t util_task_handle;
 extern TaskHandle_t com_task_handle;
 extern TaskHandle_t rawcom_task_handle;
 extern TaskHandle_t cartworker_TaskHandle;
-extern TaskHandle_t ctrl_downposition_task_handle;
-extern TaskHandle_t ctrl_upposition_task_handle;
 extern TaskHandle_t swingup_task_handle;
 extern TaskHandle_t swingdown_task_handle;
 extern TaskHandle_t test_task_handle;
@@ -78,8 +87,8 @@ extern TaskHandle_t test_task_handle;
  * CLI commands prototypes
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
-/* This command shows task statistics
-command : task-stats */
+/* This command shows task statistics from task profiler (task_prof.c)
+command : task-stats [reset] */
 static portBASE_TYPE taskStats_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
 
 /* Command to turn communication on or off,
@@ -123,7 +132,7 @@ command: sp */
 static portBASE_TYPE sp_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
 
 /* Command to start swingup action,
-command: swingup */
+command: swingup [table|energy|tvlqr] */
 static portBASE_TYPE swingup_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
 
 /* Command to start swingdown action,
@@ -154,6 +163,46 @@ static portBASE_TYPE tcc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
 /* command: tcp */
 static portBASE_TYPE tcp_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
 
+/* Command to show control tick jitter statistics,
+command: tick [reset] */
+static portBASE_TYPE tick_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to show limit switch interrupt latency,
+command: limitsw [reset] */
+static portBASE_TYPE limitsw_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to show pendulum encoder sampling statistics,
+command: as5600 [reset] */
+static portBASE_TYPE as5600_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to select cart speed estimate,
+command: cartvel [mt|lp] */
+static portBASE_TYPE cartvel_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to select speed estimator,
+command: estimator [lp|kf|pd] */
+static portBASE_TYPE estimator_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to benchmark filters,
+command: filterbench [ticks] */
+static portBASE_TYPE filterbench_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to set polynomial fit differentiators,
+command: polydiff [window order delay] */
+static portBASE_TYPE polydiff_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to list and select controller gain sets,
+command: gains [upc|dpc set [set_b cart|angle lo hi]] */
+static portBASE_TYPE gains_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to calculate LQR gains and load them as "lqr" gain set,
+command: lqr [upc|dpc [q_x q_th q_dx q_dth r]] or lqr model a b w0^2 c d */
+static portBASE_TYPE lqr_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
+/* Command to select up position control law and show MPC solver statistics,
+command: upclaw [fsf|mpc|reset] */
+static portBASE_TYPE upclaw_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString );
+
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * CLI commands definition structures & registration
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -162,9 +211,9 @@ static const CLI_Command_Definition_t commands_list[] =
 {
     {
         .pcCommand                      = ( const int8_t * const ) "task-stats",
-        .pcHelpString                   = ( const int8_t * const ) "task-stats  :    Displays a table showing the state of each FreeRTOS task\r\n                 (B)blocked, (R)Ready, (D)Deleted, (S)Suspended or block w/o timeout\r\n",
+        .pcHelpString                   = ( const int8_t * const ) "task-stats  :    Execution time, wake period, jitter histogram and overruns of app tasks\r\n                 task-stats reset - clear statistics\r\n",
         .pxCommandInterpreter           = taskStats_command,
-        .cExpectedNumberOfParameters    = 0
+        .cExpectedNumberOfParameters    = -1
     },
     {
         .pcCommand                      = ( const int8_t * const ) "",
@@ -234,15 +283,15 @@ static const CLI_Command_Definition_t commands_list[] =
     },
     {
         .pcCommand                      = ( const int8_t * const ) "swingup",
-        .pcHelpString                   = ( const int8_t * const ) "swingup     :    Start pendulum swingup routine\r\n",
+        .pcHelpString                   = ( const int8_t * const ) "swingup     :    Start pendulum swingup routine, mode is kept for next calls\r\n                 swingup table - voltage lookup table from 11cm, DPC moves the cart there first (default)\r\n                 swingup energy - closed loop energy shaping around the cart setpoint, no pre-positioning, UPC catches with lqr upc gains\r\n                 swingup tvlqr - optimized trajectory from 20cm tracked with time-varying LQR, DPC moves the cart there first, UPC catches with lqr upc gains\r\n",
         .pxCommandInterpreter           = swingup_command,
-        .cExpectedNumberOfParameters    = 0
+        .cExpectedNumberOfParameters    = -1
     },
     {
         .pcCommand                      = ( const int8_t * const ) "swu",
         .pcHelpString                   = ( const int8_t * const ) "swu         :    Alias for swingup command\r\n",
         .pxCommandInterpreter           = swingup_command,
-        .cExpectedNumberOfParameters    = 0
+        .cExpectedNumberOfParameters    = -1
     },
     {
         .pcCommand                      = ( const int8_t * const ) "swingdown",
@@ -300,16 +349,76 @@ static const CLI_Command_Definition_t commands_list[] =
     },
     {
         .pcCommand                      = ( const int8_t * const ) "tcc",
-        .pcHelpString                   = ( const int8_t * const ) "tcc         :    Starts a test procedure\r\n",
+        .pcHelpString                   = ( const int8_t * const ) "tcc         :    Set time constant of cart speed low-pass filter in s, eg. tcc 0.025\r\n",
         .pxCommandInterpreter           = tcc_command,
         .cExpectedNumberOfParameters    = 1
     },
     {
         .pcCommand                      = ( const int8_t * const ) "tcp",
-        .pcHelpString                   = ( const int8_t * const ) "tcp         :    Starts a test procedure\r\n",
+        .pcHelpString                   = ( const int8_t * const ) "tcp         :    Set time constant of pendulum speed low-pass filter in s, eg. tcp 0.025\r\n",
         .pxCommandInterpreter           = tcp_command,
         .cExpectedNumberOfParameters    = 1
     },
+    {
+        .pcCommand                      = ( const int8_t * const ) "tick",
+        .pcHelpString                   = ( const int8_t * const ) "tick        :    Control tick rate, ISR period, task wake latency and period, overruns, pipeline latency\r\n                 tick reset - clear statistics\r\n",
+        .pxCommandInterpreter           = tick_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "limitsw",
+        .pcHelpString                   = ( const int8_t * const ) "limitsw     :    Limit switch interrupts, switch to zero voltage and to handled latency\r\n                 limitsw reset - clear statistics\r\n",
+        .pxCommandInterpreter           = limitsw_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "as5600",
+        .pcHelpString                   = ( const int8_t * const ) "as5600      :    Pendulum encoder background sampling, sample period, errors, sample age at read, max arm speed\r\n                 as5600 reset - clear statistics\r\n",
+        .pxCommandInterpreter           = as5600_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "cartvel",
+        .pcHelpString                   = ( const int8_t * const ) "cartvel     :    Show or select cart speed estimate\r\n                 cartvel mt - M/T estimate from encoder edge timestamps\r\n                 cartvel lp - Tustin derivative with low-pass filter (time constant \"tcc\", default)\r\n",
+        .pxCommandInterpreter           = cartvel_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "estimator",
+        .pcHelpString                   = ( const int8_t * const ) "estimator   :    Show or select cart and pendulum speed estimator\r\n                 estimator lp - filtered derivatives (default)\r\n                 estimator kf - Kalman filter driven by motor voltage\r\n                 estimator pd - polynomial fit derivatives, see polydiff\r\n",
+        .pxCommandInterpreter           = estimator_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "filterbench",
+        .pcHelpString                   = ( const int8_t * const ) "filterbench :    DWT cycles per control tick of pipeline filters (default 1000 ticks)\r\n                 blocks other tasks while it runs, don't use with a control law on\r\n",
+        .pxCommandInterpreter           = filterbench_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "polydiff",
+        .pcHelpString                   = ( const int8_t * const ) "polydiff    :    Show or set polynomial fit differentiators of \"estimator pd\"\r\n                 polydiff <window 2-32> <order 1|2> <delay samples>\r\n                 delay 0 is the newest sample, (window-1)/2 is Savitzky-Golay\r\n",
+        .pxCommandInterpreter           = polydiff_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "gains",
+        .pcHelpString                   = ( const int8_t * const ) "gains       :    List UPC / DPC gain sets, select one or interpolate two by operating point\r\n                 gains upc stiff\r\n                 gains upc default stiff cart 1 4 - default below 1cm cart error, stiff above 4cm\r\n                 gains dpc default soft angle 5 20 - by pendulum angle error in degrees\r\n                 switch happens at the next control tick\r\n",
+        .pxCommandInterpreter           = gains_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "lqr",
+        .pcHelpString                   = ( const int8_t * const ) "lqr         :    Solve discrete LQR for UPC / DPC on the target, load and select gains as set \"lqr\"\r\n                 lqr upc - default weights, lqr upc 5000 500 0 0 1 - diag Q (x th dx dth), R\r\n                 lqr model 31.3 4.44 49.05 5 0.167 - cart pole, V to acc, w0^2, m*l/J, pend damping\r\n                 lqr - show model and last result\r\n",
+        .pxCommandInterpreter           = lqr_command,
+        .cExpectedNumberOfParameters    = -1
+    },
+    {
+        .pcCommand                      = ( const int8_t * const ) "upclaw",
+        .pcHelpString                   = ( const int8_t * const ) "upclaw      :    Show or select law run by up position controller\r\n                 upclaw fsf - full state feedback (default)\r\n                 upclaw mpc - same feedback, corrected to keep cart out of freezing zones and voltage in range\r\n                 upclaw reset - clear MPC statistics\r\n",
+        .pxCommandInterpreter           = upclaw_command,
+        .cExpectedNumberOfParameters    = -1
+    },
     {
         .pcCommand = NULL
     }
@@ -331,17 +440,91 @@ void vRegisterCLICommands(void)
 /* command: task-stats */
 static portBASE_TYPE taskStats_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
 {
-    // const int8_t *const pcTaskTableHeader = ( int8_t * ) "Task          State  Priority  Stack	#\r\n******************************************\r\n";
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    task_prof_task_stats *t;
+
+    /* Statistics are copied on the first call, then one task is printed per call,
+    output of all tasks doesn't fit in the output buffer. */
+    static task_prof_stats stats;
+    static uint32_t task_index = 0;
+
+    /* Cycles to microseconds. */
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
 
-    ( void ) pcCommandString;
-    ( void ) xWriteBufferLen;
     configASSERT( pcWriteBuffer );
 
-    /* Generate a table of task stats. */
-    // strcpy( ( char * ) pcWriteBuffer, ( const char * ) pcTaskTableHeader );
-    // vTaskList( (char *) pcWriteBuffer + strlen( ( const char * ) pcTaskTableHeader ) );
-    // configSTATS_BUFFER_MAX_LENGTH
+    if( task_index == 0 )
+    {
+        pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+        if( pcParameter1 != NULL )
+        {
+            pcParameter1[ xParameter1StringLength ] = 0x00;
+            if( !strcmp( ( const char * ) pcParameter1, "reset" ) )
+            {
+                task_prof_reset_stats();
+                strcpy( ( char * ) pcWriteBuffer, "\r\nTask statistics cleared\r\n" );
+            }
+            else
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: task-stats [reset]\r\n" );
+            }
+            return pdFALSE;
+        }
+
+        task_prof_get_stats( &stats );
+
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+                  "\r\nTask profile over %.1f s, profiler overhead %.3f %% CPU\r\n"
+                  "exec us min/mean/max, wake period us min/mean/max, CPU load, overruns\r\n"
+                  "jitter us histogram <1 <4 <16 <64 <256 <1k <4k >=4k\r\n",
+                  ( double ) ( ( float ) stats.elapsed / CTRL_TICK_CPU_HZ ),
+                  ( double ) ( stats.elapsed ? ( float ) stats.overhead / ( float ) stats.elapsed * 100.0f : 0.0f ) );
+
+        task_index = 1;
+        return stats.n_tasks > 0 ? pdTRUE : pdFALSE;
+    }
+
+    t = &stats.task[ task_index - 1 ];
+
+    if( t->jobs == 0 )
+    {
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "%-13s no jobs\r\n", pcTaskGetName( t->task ) );
+    }
+    else
+    {
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+                  "%-13s exec %.1f/%.1f/%.1f, period %.1f/%.1f/%.1f, load %.2f %%, overruns %lu\r\n",
+                  pcTaskGetName( t->task ),
+                  ( double ) ( t->exec_min * us ),
+                  ( double ) ( ( float ) t->exec_sum / t->jobs * us ),
+                  ( double ) ( t->exec_max * us ),
+                  ( double ) ( t->periods ? t->period_min * us : 0.0f ),
+                  ( double ) ( t->periods ? ( float ) t->period_sum / t->periods * us : 0.0f ),
+                  ( double ) ( t->period_max * us ),
+                  ( double ) ( stats.elapsed ? ( float ) t->exec_sum / ( float ) stats.elapsed * 100.0f : 0.0f ),
+                  ( unsigned long ) t->overruns );
+
+        if( t->period_nominal != 0 )
+        {
+            size_t len = strlen( ( const char * ) pcWriteBuffer );
+
+            snprintf( ( char * ) pcWriteBuffer + len, xWriteBufferLen - len,
+                      "              jitter %lu %lu %lu %lu %lu %lu %lu %lu\r\n",
+                      ( unsigned long ) t->jitter_hist[ 0 ], ( unsigned long ) t->jitter_hist[ 1 ],
+                      ( unsigned long ) t->jitter_hist[ 2 ], ( unsigned long ) t->jitter_hist[ 3 ],
+                      ( unsigned long ) t->jitter_hist[ 4 ], ( unsigned long ) t->jitter_hist[ 5 ],
+                      ( unsigned long ) t->jitter_hist[ 6 ], ( unsigned long ) t->jitter_hist[ 7 ] );
+        }
+    }
 
+    if( task_index < stats.n_tasks )
+    {
+        task_index++;
+        return pdTRUE;
+    }
+
+    task_index = 0;
     return pdFALSE;
 }
 
@@ -493,7 +676,7 @@ static portBASE_TYPE dpc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     {
         /* Controller Turn off case. */
         /* Turn off down position controller, "dcp off" / "dpc 0" are both valid commands. */
-        vTaskSuspend( ctrl_downposition_task_handle );
+        ctrl_select_law( CTRL_LAW_NONE );
         dcm_set_output_volatage( 0.0f );
 
         /* Change current app state back to DEFAULT. */
@@ -522,7 +705,7 @@ static portBASE_TYPE dpc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
                     This means that it's not possible to use this command while app is in UNINITIALIZED, SWINGUP or UPPOSITION CONTROLLER state. */
 
                     /* Turn on down position controller, "dcp on" / "dpc 1" are both valid commands. */
-                    vTaskResume( ctrl_downposition_task_handle );
+                    ctrl_select_law( CTRL_LAW_DPC );
 
                     /* Change app state to "down position controller" state.
                     This will ensure that some cli commands can't be called. */
@@ -571,7 +754,7 @@ static portBASE_TYPE dpci_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen
     {
         /* Controller Turn off case. */
         /* Turn off down position controller, "dcp off" / "dpc 0" are both valid commands. */
-        vTaskSuspend( ctrl_downposition_task_handle );
+        ctrl_select_law( CTRL_LAW_NONE );
         dcm_set_output_volatage( 0.0f );
 
         /* Change current app state back to DEFAULT. */
@@ -600,7 +783,7 @@ static portBASE_TYPE dpci_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen
                     This means that it's not possible to use this command while app is in UNINITIALIZED, SWINGUP or UPPOSITION CONTROLLER state. */
 
                     /* Turn on down position controller, "dcp on" / "dpc 1" are both valid commands. */
-                    vTaskResume( ctrl_downposition_task_handle );
+                    ctrl_select_law( CTRL_LAW_DPC );
 
                     /* Change app state to "down position controller" state.
                     This will ensure that some cli commands can't be called. */
@@ -649,7 +832,7 @@ static portBASE_TYPE upc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     {
         /* Controller Turn off case. */
         /* Turn off controller, "upc off" / "upc 0" are both valid commands. */
-        vTaskSuspend( ctrl_upposition_task_handle );
+        ctrl_select_law( CTRL_LAW_NONE );
         dcm_set_output_volatage( 0.0f );
 
         /* Change current app state back to DEFAULT. */
@@ -678,7 +861,7 @@ static portBASE_TYPE upc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
                     This means that it's not possible to use this command while app is in UNINITIALIZED, SWINGUP or DOWN POSITION CONTROLLER state. */
 
                     /* Turn on up position controller, "upc on" / "upc 1" are both valid commands. */
-                    vTaskResume( ctrl_upposition_task_handle );
+                    ctrl_select_law( CTRL_LAW_UPC );
 
                     /* Change app state to "down position controller" state.
                     This will ensure that some cli commands can't be called. */
@@ -727,7 +910,7 @@ static portBASE_TYPE upci_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen
     {
         /* Controller Turn off case. */
         /* Turn off controller, "upc off" / "upc 0" are both valid commands. */
-        vTaskSuspend( ctrl_upposition_task_handle );
+        ctrl_select_law( CTRL_LAW_NONE );
         dcm_set_output_volatage( 0.0f );
 
         /* Change current app state back to DEFAULT. */
@@ -756,7 +939,7 @@ static portBASE_TYPE upci_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen
                     This means that it's not possible to use this command while app is in UNINITIALIZED, SWINGUP or DOWN POSITION CONTROLLER state. */
 
                     /* Turn on up position controller, "upc on" / "upc 1" are both valid commands. */
-                    vTaskResume( ctrl_upposition_task_handle );
+                    ctrl_select_law( CTRL_LAW_UPC );
 
                     /* Change app state to "down position controller" state.
                     This will ensure that some cli commands can't be called. */
@@ -902,18 +1085,91 @@ static portBASE_TYPE sp_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     return pdFALSE;
 }
 
-/* command: swingup */
+/* Solver takes well under a millisecond, wait for the result. */
+static void lqr_wait( lqr_status *status )
+{
+    for( uint32_t i = 0; i < 100; i++ )
+    {
+        lqr_get_status( status );
+        if( !status->busy )
+        {
+            break;
+        }
+        vTaskDelay( 1 );
+    }
+}
+
+/* Energy swingup catch is tuned for the LQR_UPC_Q / LQR_UPC_R gain of the
+lqr model and the TVLQR trajectory ends on it, the hand tuned default set
+stays in a 12 V limit cycle after the catch.
+Synthesizes and selects the "lqr" UPC set unless the UPC schedule is that set
+alone already (kept with its own weights). Returns 1 if there is no solution. */
+static uint8_t swingup_lqr_upc( void )
+{
+    static const float upc_Q[ LQR_N ] = LQR_UPC_Q;
+    gain_schedule sched;
+    gain_set set;
+    lqr_status status;
+
+    gain_sched_get( GAIN_SET_UPC, &sched );
+    gain_sets_get( GAIN_SET_UPC, sched.a, &set );
+    if( sched.var == GAIN_SCHED_NONE && !strcmp( set.name, "lqr" ) )
+    {
+        return 0;
+    }
+
+    if( lqr_synthesize( GAIN_SET_UPC, upc_Q, LQR_UPC_R ) )
+    {
+        return 1;
+    }
+    lqr_wait( &status );
+
+    return status.busy || !status.valid;
+}
+
+/* command: swingup [table|energy|tvlqr] */
 static portBASE_TYPE swingup_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
 {
-    ( void ) pcCommandString;
-    ( void ) xWriteBufferLen;
+    static const char *mode_names[] = { "lookup table", "energy shaping", "tvlqr tracking" };
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+
     configASSERT( pcWriteBuffer );
 
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "table" ) )
+        {
+            swingup_mode_select( SWINGUP_MODE_TABLE );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "energy" ) )
+        {
+            swingup_mode_select( SWINGUP_MODE_ENERGY );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "tvlqr" ) )
+        {
+            swingup_mode_select( SWINGUP_MODE_TVLQR );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: swingup [table|energy|tvlqr]\r\n" );
+            return pdFALSE;
+        }
+    }
+
     if( app_current_state == DEFAULT )
     {
         /* App is in DEFAULT STATE and cart position is at position 20cm pm 1cm.
         Swingup can be started. */
 
+        if( swingup_mode_selected() != SWINGUP_MODE_TABLE && swingup_lqr_upc() )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: no LQR solution for the UPC gain set, see lqr\r\n" );
+            return pdFALSE;
+        }
+
         /* Reset lookup_index in swingup task for loop. */
         reset_lookup_index = 1;
 
@@ -926,6 +1182,8 @@ static portBASE_TYPE swingup_command( int8_t *pcWriteBuffer, size_t xWriteBuffer
 
         /* Resume swingup task. */
         vTaskResume( swingup_task_handle );
+
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "\r\nSwingup: %s\r\n", mode_names[ swingup_mode_selected() ] );
     }
     else
     {
@@ -1032,11 +1290,10 @@ static portBASE_TYPE br_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     {
         app_current_state = DEFAULT;
 
-        /* Suspend any control task. Calls to vTaskSuspend are not cumulative
+        /* Stop control law in util task and suspend swingup. Calls to vTaskSuspend are not cumulative
         so it can be used on task which is already suspended and one vTaskResume will
         be enoguh to bring that task back to work. */
-        vTaskSuspend( ctrl_downposition_task_handle );
-        vTaskSuspend( ctrl_upposition_task_handle );
+        ctrl_select_law( CTRL_LAW_NONE );
         vTaskSuspend( swingup_task_handle );
     }
 
@@ -1125,24 +1382,18 @@ static portBASE_TYPE tcc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     // ( void ) xWriteBufferLen;
     // configASSERT( pcWriteBuffer );
     int8_t *command_param_1;
-    int8_t *command_param_2;
     BaseType_t command_param_str_len_1;
-    BaseType_t command_param_str_len_2;
     char* errCheck;
 
     float new_time_constant;
 
-    /* Get command arguemnts. */
+    /* Get command arguemnt, there is only one (FreeRTOS_CLIGetParameter() returns NULL for the second). */
     command_param_1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString,           /* The command string itself. */
                                                              1,                         /* Which parameter to return. */
                                                              &command_param_str_len_1); /* Store the parameter string length. */
-    command_param_2 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString,
-                                                             2,
-                                                             &command_param_str_len_2);
 
     /* Terminate arguemnt string. */
     command_param_1[ command_param_str_len_1 ] = 0x00;
-    command_param_2[ command_param_str_len_2 ] = 0x00;
 
     new_time_constant = strtof( ( const char * )command_param_1, &errCheck );
     if( ( int8_t * ) errCheck == command_param_1 )
@@ -1151,7 +1402,7 @@ static portBASE_TYPE tcc_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     }
     else
     {
-        LP_update_time_Constant( &LP_filter_cart, new_time_constant );
+        LP_bank_set_time_constant( &LP_filters, LP_CH_CART_SPEED, new_time_constant );
     }
 
     return pdFALSE;
@@ -1165,24 +1416,18 @@ static portBASE_TYPE tcp_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     // ( void ) xWriteBufferLen;
     // configASSERT( pcWriteBuffer );
     int8_t *command_param_1;
-    int8_t *command_param_2;
     BaseType_t command_param_str_len_1;
-    BaseType_t command_param_str_len_2;
     char* errCheck;
 
     float new_time_constant;
 
-    /* Get command arguemnts. */
+    /* Get command arguemnt, there is only one (FreeRTOS_CLIGetParameter() returns NULL for the second). */
     command_param_1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString,           /* The command string itself. */
                                                              1,                         /* Which parameter to return. */
                                                              &command_param_str_len_1); /* Store the parameter string length. */
-    command_param_2 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString,
-                                                             2,
-                                                             &command_param_str_len_2);
 
     /* Terminate arguemnt string. */
     command_param_1[ command_param_str_len_1 ] = 0x00;
-    command_param_2[ command_param_str_len_2 ] = 0x00;
 
     new_time_constant = strtof( ( const char * )command_param_1, &errCheck );
     if( ( int8_t * ) errCheck == command_param_1 )
@@ -1191,8 +1436,754 @@ static portBASE_TYPE tcp_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen,
     }
     else
     {
-        LP_update_time_Constant( &LP_filter_pendulum, new_time_constant );
+        LP_bank_set_time_constant( &LP_filters, LP_CH_PEND_SPEED, new_time_constant );
+    }
+
+    return pdFALSE;
+}
+
+/* command: tick */
+static portBASE_TYPE tick_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    ctrl_tick_stats stats;
+    ctrl_pipeline_stats pipeline;
+    size_t len;
+
+    /* Cycles to microseconds. */
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
+
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "reset" ) )
+        {
+            ctrl_tick_reset_stats();
+            ctrl_pipeline_reset_stats();
+            strcpy( ( char * ) pcWriteBuffer, "\r\nControl tick statistics cleared\r\n" );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: tick [reset]\r\n" );
+        }
+        return pdFALSE;
+    }
+
+    ctrl_tick_get_stats( &stats );
+
+    len = snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+                    "\r\nControl tick %d Hz, %lu ticks\r\nISR period us: min %.2f max %.2f\r\n",
+                    CTRL_TICK_HZ, ( unsigned long ) stats.ticks,
+                    ( double ) ( stats.isr_count ? stats.isr_period_min * us : 0.0f ),
+                    ( double ) ( stats.isr_period_max * us ) );
+
+    for( uint32_t i = 0; i < stats.n_tasks && len < xWriteBufferLen; i++ )
+    {
+        ctrl_tick_task_stats *t = &stats.task[ i ];
+
+        if( t->wakeups == 0 )
+        {
+            len += snprintf( ( char * ) pcWriteBuffer + len, xWriteBufferLen - len,
+                             "%-12s no wake ups, overruns %lu\r\n",
+                             pcTaskGetName( t->task ), ( unsigned long ) t->overruns );
+            continue;
+        }
+
+        /* Wake latency min/mean/max and wake up period min-max. */
+        len += snprintf( ( char * ) pcWriteBuffer + len, xWriteBufferLen - len,
+                         "%-12s latency us %.2f/%.2f/%.2f, period us %.2f-%.2f, overruns %lu\r\n",
+                         pcTaskGetName( t->task ),
+                         ( double ) ( t->latency_min * us ),
+                         ( double ) ( ( float ) t->latency_sum / t->wakeups * us ),
+                         ( double ) ( t->latency_max * us ),
+                         ( double ) ( t->period_max ? t->period_min * us : 0.0f ),
+                         ( double ) ( t->period_max * us ),
+                         ( unsigned long ) t->overruns );
+    }
+
+    /* Control pipeline latency min/mean/max, only while a control law is active. */
+    ctrl_pipeline_get_stats( &pipeline );
+    if( pipeline.count > 0 && len < xWriteBufferLen )
+    {
+        snprintf( ( char * ) pcWriteBuffer + len, xWriteBufferLen - len,
+                  "Pipeline sense->actuate us %.2f/%.2f/%.2f, tick->actuate us %.2f/%.2f/%.2f\r\n",
+                  ( double ) ( pipeline.sense_to_actuate_min * us ),
+                  ( double ) ( ( float ) pipeline.sense_to_actuate_sum / pipeline.count * us ),
+                  ( double ) ( pipeline.sense_to_actuate_max * us ),
+                  ( double ) ( pipeline.tick_to_actuate_min * us ),
+                  ( double ) ( ( float ) pipeline.tick_to_actuate_sum / pipeline.count * us ),
+                  ( double ) ( pipeline.tick_to_actuate_max * us ) );
+    }
+
+    return pdFALSE;
+}
+
+/* command: limitsw */
+static portBASE_TYPE limitsw_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    limit_switch_stats stats;
+
+    /* Cycles to microseconds. */
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
+
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "reset" ) )
+        {
+            limit_switch_reset_stats();
+            strcpy( ( char * ) pcWriteBuffer, "\r\nLimit switch statistics cleared\r\n" );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: limitsw [reset]\r\n" );
+        }
+        return pdFALSE;
+    }
+
+    limit_switch_get_stats( &stats );
+
+    if( stats.edges == 0 )
+    {
+        strcpy( ( char * ) pcWriteBuffer, "\r\nNo limit switch interrupts\r\n" );
+        return pdFALSE;
+    }
+
+    /* Latency min/mean/max. */
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nLimit switch edges %lu, handled %lu\r\n"
+              "switch -> 0V us      %.2f/%.2f/%.2f\r\n"
+              "switch -> handled us %.2f/%.2f/%.2f\r\n",
+              ( unsigned long ) stats.edges, ( unsigned long ) stats.handled,
+              ( double ) ( stats.cutoff_min * us ),
+              ( double ) ( ( float ) stats.cutoff_sum / stats.edges * us ),
+              ( double ) ( stats.cutoff_max * us ),
+              ( double ) ( stats.handled ? stats.handled_min * us : 0.0f ),
+              ( double ) ( stats.handled ? ( float ) stats.handled_sum / stats.handled * us : 0.0f ),
+              ( double ) ( stats.handled_max * us ) );
+
+    return pdFALSE;
+}
+
+/* command: as5600 */
+static portBASE_TYPE as5600_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    pend_enc_sampler_stats stats;
+    float period_worst_us;
+
+    /* Cycles to microseconds. */
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
+
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "reset" ) )
+        {
+            pend_enc_sampler_reset_stats();
+            strcpy( ( char * ) pcWriteBuffer, "\r\nAS5600 sampling statistics cleared\r\n" );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: as5600 [reset]\r\n" );
+        }
+        return pdFALSE;
+    }
+
+    pend_enc_sampler_get_stats( &stats );
+
+    if( stats.periods == 0 || stats.reads == 0 )
+    {
+        strcpy( ( char * ) pcWriteBuffer, "\r\nNo AS5600 samples yet\r\n" );
+        return pdFALSE;
+    }
+
+    /* Unwrapping needs less than half revolution per sample, the longest sample
+    period (or AS5600 output update period if it is longer) limits the arm speed. */
+    period_worst_us = stats.period_max * us;
+    if( period_worst_us < PEND_ENC_AS5600_UPDATE_US )
+    {
+        period_worst_us = PEND_ENC_AS5600_UPDATE_US;
+    }
+
+    /* Sample period and age min/mean/max. */
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nAS5600 samples %lu, errors %lu, restarts %lu\r\n"
+              "sample period us  %.2f/%.2f/%.2f (%.0f Hz)\r\n"
+              "reads %lu, stale %lu, age us %.2f/%.2f\r\n"
+              "max arm speed rev/s %.0f, peak step %lu counts\r\n",
+              ( unsigned long ) stats.samples, ( unsigned long ) stats.errors, ( unsigned long ) stats.restarts,
+              ( double ) ( stats.period_min * us ),
+              ( double ) ( ( float ) stats.period_sum / stats.periods * us ),
+              ( double ) ( stats.period_max * us ),
+              ( double ) ( 1.0e6f / ( ( float ) stats.period_sum / stats.periods * us ) ),
+              ( unsigned long ) stats.reads, ( unsigned long ) stats.stale_reads,
+              ( double ) ( ( float ) stats.age_sum / stats.reads * us ),
+              ( double ) ( stats.age_max * us ),
+              ( double ) ( 0.5e6f / period_worst_us ), ( unsigned long ) stats.step_max );
+
+    return pdFALSE;
+}
+
+/* command: cartvel */
+static portBASE_TYPE cartvel_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+
+    ( void ) xWriteBufferLen;
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "mt" ) )
+        {
+            cart_speed_select( CART_SPEED_MT );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "lp" ) )
+        {
+            cart_speed_select( CART_SPEED_LP );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: cartvel [mt|lp]\r\n" );
+            return pdFALSE;
+        }
+    }
+
+    if( cart_speed_selected() == CART_SPEED_MT )
+    {
+        strcpy( ( char * ) pcWriteBuffer, "\r\nCart speed: M/T estimate from encoder edges\r\n" );
+    }
+    else
+    {
+        strcpy( ( char * ) pcWriteBuffer, "\r\nCart speed: low-pass filtered derivative\r\n" );
     }
 
     return pdFALSE;
 }
+
+/* command: estimator */
+static portBASE_TYPE estimator_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    extern kalman_filter KF_state;
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "lp" ) )
+        {
+            state_est_select( STATE_EST_LP );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "kf" ) )
+        {
+            state_est_select( STATE_EST_KF );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "pd" ) )
+        {
+            state_est_select( STATE_EST_PD );
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: estimator [lp|kf|pd]\r\n" );
+            return pdFALSE;
+        }
+    }
+
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nSpeed estimator: %s\r\n"
+              "Kalman filter: dx %.2f cm/s, dth %.3f rad/s, disturbance %.1f cm/s^2, resets %lu\r\n",
+              state_est_selected() == STATE_EST_KF ? "Kalman filter" :
+              state_est_selected() == STATE_EST_PD ? "polynomial fit derivatives" : "filtered derivatives",
+              ( double ) KF_state.x[ KALMAN_DX ],
+              ( double ) KF_state.x[ KALMAN_DTH ],
+              ( double ) KF_state.x[ KALMAN_DIST ],
+              ( unsigned long ) KF_state.resets );
+
+    return pdFALSE;
+}
+
+/* command: filterbench */
+static portBASE_TYPE filterbench_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    uint32_t ticks = 1000;
+
+    /* Benchmark runs on the first call, then one case is printed per call. */
+    static filter_bench_result results[ FILTER_BENCH_MAX_CASES ];
+    static uint32_t n_results = 0;
+    static uint32_t result_index = 0;
+
+    configASSERT( pcWriteBuffer );
+
+    if( result_index == 0 )
+    {
+        pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+        if( pcParameter1 != NULL )
+        {
+            pcParameter1[ xParameter1StringLength ] = 0x00;
+            ticks = strtoul( ( const char * ) pcParameter1, NULL, 10 );
+            if( ticks == 0 )
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: filterbench [ticks]\r\n" );
+                return pdFALSE;
+            }
+        }
+
+        n_results = filter_bench_run( ctrl_tick_cycles, ticks, results, FILTER_BENCH_MAX_CASES );
+
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+                  "\r\nFilter benchmark, %lu ticks, DWT cycles per control tick\r\n",
+                  ( unsigned long ) ticks );
+
+        result_index = 1;
+        return n_results > 0 ? pdTRUE : pdFALSE;
+    }
+
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "%8.1f  %s\r\n",
+              ( double ) results[ result_index - 1 ].ticks_per_call,
+              results[ result_index - 1 ].name );
+
+    if( result_index < n_results )
+    {
+        result_index++;
+        return pdTRUE;
+    }
+
+    result_index = 0;
+    return pdFALSE;
+}
+
+/* command: polydiff */
+static portBASE_TYPE polydiff_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    extern poly_diff PD_pendulum;
+    extern poly_diff PD_cart;
+    const int8_t *pcParameter[ 3 ];
+    BaseType_t xParameterStringLength;
+    uint32_t window, order;
+    float delay;
+    char *errCheck;
+
+    configASSERT( pcWriteBuffer );
+
+    /* Parameters are parsed in place, numbers end at the separating space. */
+    for( uint32_t i = 0; i < 3; i++ )
+    {
+        pcParameter[ i ] = ( const int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, i + 1, &xParameterStringLength );
+    }
+
+    if( pcParameter[ 0 ] != NULL )
+    {
+        if( pcParameter[ 1 ] == NULL || pcParameter[ 2 ] == NULL )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: polydiff [window order delay]\r\n" );
+            return pdFALSE;
+        }
+        window = strtoul( ( const char * ) pcParameter[ 0 ], NULL, 10 );
+        order = strtoul( ( const char * ) pcParameter[ 1 ], NULL, 10 );
+        delay = strtof( ( const char * ) pcParameter[ 2 ], &errCheck );
+        if( window == 0 || order == 0 || ( const int8_t * ) errCheck == pcParameter[ 2 ] )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: parameters have to be numbers\r\n" );
+            return pdFALSE;
+        }
+
+        /* Cli task doesn't preempt util task, both windows are refilled by their next update. */
+        poly_diff_init( &PD_pendulum, window, order, delay, dt_ctrl );
+        poly_diff_init( &PD_cart, window, order, delay, dt_ctrl );
+    }
+
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nPolynomial fit derivatives: window %lu, order %lu, delay %.1f samples%s\r\n",
+              ( unsigned long ) PD_pendulum.window,
+              ( unsigned long ) PD_pendulum.order,
+              ( double ) PD_pendulum.delay,
+              state_est_selected() == STATE_EST_PD ? ", selected" : "" );
+
+    return pdFALSE;
+}
+
+/* Print schedule of a controller. */
+static void gains_print_schedule( int8_t *pcWriteBuffer, size_t xWriteBufferLen, enum gain_set_ctrls ctrl )
+{
+    static const char *ctrl_names[ GAIN_SET_CTRLS ] = { "DPC", "UPC" };
+    gain_schedule sched;
+    gain_set a, b;
+
+    gain_sched_get( ctrl, &sched );
+    gain_sets_get( ctrl, sched.a, &a );
+    gain_sets_get( ctrl, sched.b, &b );
+
+    if( sched.var == GAIN_SCHED_NONE )
+    {
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "\r\n%s gains: %s\r\n",
+                  ctrl_names[ ctrl ], a.name );
+    }
+    else if( sched.var == GAIN_SCHED_CART_ERROR )
+    {
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "\r\n%s gains: %s below %.2f cm cart error, %s above %.2f cm\r\n",
+                  ctrl_names[ ctrl ], a.name, ( double ) sched.lo, b.name, ( double ) sched.hi );
+    }
+    else
+    {
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen, "\r\n%s gains: %s below %.1f deg angle error, %s above %.1f deg\r\n",
+                  ctrl_names[ ctrl ], a.name, ( double ) ( sched.lo * 180.0f / PI ),
+                  b.name, ( double ) ( sched.hi * 180.0f / PI ) );
+    }
+}
+
+/* command: gains */
+static portBASE_TYPE gains_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    const int8_t *pcParameter[ 6 ];
+    BaseType_t xParameterStringLength[ 6 ];
+    uint32_t n_params = 0;
+    enum gain_set_ctrls ctrl;
+    gain_schedule sched;
+    gain_set g;
+    uint32_t n_sets;
+    int32_t a, b = 0;
+    char *errCheck;
+
+    /* Listing prints schedule and one set per call, ctrl then set index. */
+    static uint32_t list_ctrl = 0;
+    static uint32_t list_set = 0;
+
+    configASSERT( pcWriteBuffer );
+
+    if( list_ctrl == 0 && list_set == 0 )
+    {
+        for( uint32_t i = 0; i < 6; i++ )
+        {
+            pcParameter[ i ] = ( const int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, i + 1, &xParameterStringLength[ i ] );
+            if( pcParameter[ i ] == NULL )
+            {
+                break;
+            }
+            n_params++;
+        }
+
+        if( n_params > 0 )
+        {
+            if( xParameterStringLength[ 0 ] == 3 && !strncmp( ( const char * ) pcParameter[ 0 ], "upc", 3 ) )
+            {
+                ctrl = GAIN_SET_UPC;
+            }
+            else if( xParameterStringLength[ 0 ] == 3 && !strncmp( ( const char * ) pcParameter[ 0 ], "dpc", 3 ) )
+            {
+                ctrl = GAIN_SET_DPC;
+            }
+            else
+            {
+                n_params = 0;
+            }
+
+            if( n_params != 2 && n_params != 6 )
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: gains [upc|dpc set [set_b cart|angle lo hi]]\r\n" );
+                return pdFALSE;
+            }
+
+            a = gain_sets_find( ctrl, ( const char * ) pcParameter[ 1 ], ( uint32_t ) xParameterStringLength[ 1 ] );
+            if( n_params == 6 )
+            {
+                b = gain_sets_find( ctrl, ( const char * ) pcParameter[ 2 ], ( uint32_t ) xParameterStringLength[ 2 ] );
+            }
+            if( a < 0 || b < 0 )
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: no such gain set, \"gains\" lists them\r\n" );
+                return pdFALSE;
+            }
+
+            sched.a   = ( uint32_t ) a;
+            sched.b   = ( uint32_t ) b;
+            sched.var = GAIN_SCHED_NONE;
+            sched.lo  = 0.0f;
+            sched.hi  = 0.0f;
+
+            if( n_params == 6 )
+            {
+                if( xParameterStringLength[ 3 ] == 4 && !strncmp( ( const char * ) pcParameter[ 3 ], "cart", 4 ) )
+                {
+                    sched.var = GAIN_SCHED_CART_ERROR;
+                }
+                else if( xParameterStringLength[ 3 ] == 5 && !strncmp( ( const char * ) pcParameter[ 3 ], "angle", 5 ) )
+                {
+                    sched.var = GAIN_SCHED_PEND_ERROR;
+                }
+                else
+                {
+                    strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: operating point is cart or angle\r\n" );
+                    return pdFALSE;
+                }
+
+                /* Numbers end at the separating space or at the end of the command. */
+                sched.lo = strtof( ( const char * ) pcParameter[ 4 ], &errCheck );
+                if( ( const int8_t * ) errCheck == pcParameter[ 4 ] )
+                {
+                    sched.hi = sched.lo;
+                }
+                else
+                {
+                    sched.hi = strtof( ( const char * ) pcParameter[ 5 ], &errCheck );
+                    if( ( const int8_t * ) errCheck == pcParameter[ 5 ] )
+                    {
+                        sched.hi = sched.lo;
+                    }
+                }
+                if( sched.var == GAIN_SCHED_PEND_ERROR )
+                {
+                    sched.lo *= PI / 180.0f;
+                    sched.hi *= PI / 180.0f;
+                }
+            }
+
+            if( gain_sched_request( ctrl, &sched ) )
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: breakpoints have to be numbers, lo < hi\r\n" );
+                return pdFALSE;
+            }
+
+            gains_print_schedule( pcWriteBuffer, xWriteBufferLen, ctrl );
+            return pdFALSE;
+        }
+    }
+
+    /* List both tables, schedule line first. */
+    ctrl = ( enum gain_set_ctrls ) list_ctrl;
+    n_sets = gain_sets_count( ctrl );
+
+    if( list_set == 0 )
+    {
+        gains_print_schedule( pcWriteBuffer, xWriteBufferLen, ctrl );
+    }
+    else
+    {
+        gain_sets_get( ctrl, list_set - 1, &g );
+        snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+                  "  %-11s F %.3f %.3f %.3f %.3f, dz %.2f V, band %.2f cm %.1f deg, window %.0f %.0f deg\r\n",
+                  g.name,
+                  ( double ) g.gains[ 0 ], ( double ) g.gains[ 1 ], ( double ) g.gains[ 2 ], ( double ) g.gains[ 3 ],
+                  ( double ) g.voltage_deadzone,
+                  ( double ) g.cart_allowed_error_cm,
+                  ( double ) ( g.pend_allowed_error * 180.0f / PI ),
+                  ( double ) ( g.switch_angle_low * 180.0f / PI ),
+                  ( double ) ( g.switch_angle_high * 180.0f / PI ) );
+    }
+
+    if( list_set < n_sets )
+    {
+        list_set++;
+        return pdTRUE;
+    }
+    list_set = 0;
+    if( list_ctrl + 1 < GAIN_SET_CTRLS )
+    {
+        list_ctrl++;
+        return pdTRUE;
+    }
+
+    list_ctrl = 0;
+    return pdFALSE;
+}
+
+/* command: lqr */
+static portBASE_TYPE lqr_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    static const float upc_Q[ LQR_N ] = LQR_UPC_Q;
+    static const float dpc_Q[ LQR_N ] = LQR_DPC_Q;
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
+    const int8_t *pcParameter[ 6 ];
+    BaseType_t xParameterStringLength[ 6 ];
+    uint32_t n_params = 0;
+    float values[ 5 ];
+    enum gain_set_ctrls ctrl;
+    lqr_plant_params plant;
+    lqr_status status;
+    char *errCheck;
+    float Q[ LQR_N ];
+    float R;
+
+    configASSERT( pcWriteBuffer );
+
+    for( uint32_t i = 0; i < 6; i++ )
+    {
+        pcParameter[ i ] = ( const int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, i + 1, &xParameterStringLength[ i ] );
+        if( pcParameter[ i ] == NULL )
+        {
+            break;
+        }
+        n_params++;
+    }
+
+    /* Numbers end at the separating space or at the end of the command. */
+    for( uint32_t i = 1; i < n_params; i++ )
+    {
+        values[ i - 1 ] = strtof( ( const char * ) pcParameter[ i ], &errCheck );
+        if( ( const int8_t * ) errCheck == pcParameter[ i ] || !isfinite( values[ i - 1 ] ) )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: parameters have to be numbers\r\n" );
+            return pdFALSE;
+        }
+    }
+
+    if( n_params == 6 && xParameterStringLength[ 0 ] == 5 && !strncmp( ( const char * ) pcParameter[ 0 ], "model", 5 ) )
+    {
+        /* Model is used by the lqr solver, MPC and both swingups, u = ( ddx + a dx ) / b
+        is NaN with b = 0. Signs as the rig, d can be 0. */
+        if( !( values[ 0 ] > 0.0f ) || !( values[ 1 ] > 0.0f ) || !( values[ 2 ] > 0.0f ) || !( values[ 3 ] > 0.0f ) || values[ 4 ] < 0.0f )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: model has to be a > 0, b > 0, w0^2 > 0, c > 0, d >= 0\r\n" );
+            return pdFALSE;
+        }
+        plant.cart_pole     = values[ 0 ];
+        plant.cart_gain     = values[ 1 ];
+        plant.pend_w0_sq    = values[ 2 ];
+        plant.pend_coupling = values[ 3 ];
+        plant.pend_damping  = values[ 4 ];
+        lqr_set_plant( &plant );
+    }
+    else if( n_params == 1 || n_params == 6 )
+    {
+        if( xParameterStringLength[ 0 ] == 3 && !strncmp( ( const char * ) pcParameter[ 0 ], "upc", 3 ) )
+        {
+            ctrl = GAIN_SET_UPC;
+            memcpy( Q, upc_Q, sizeof( Q ) );
+            R = LQR_UPC_R;
+        }
+        else if( xParameterStringLength[ 0 ] == 3 && !strncmp( ( const char * ) pcParameter[ 0 ], "dpc", 3 ) )
+        {
+            ctrl = GAIN_SET_DPC;
+            memcpy( Q, dpc_Q, sizeof( Q ) );
+            R = LQR_DPC_R;
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: lqr [upc|dpc [q_x q_th q_dx q_dth r]] or lqr model a b w0^2 c d\r\n" );
+            return pdFALSE;
+        }
+
+        if( n_params == 6 )
+        {
+            memcpy( Q, values, sizeof( Q ) );
+            R = values[ 4 ];
+        }
+        if( Q[ 0 ] < 0.0f || Q[ 1 ] < 0.0f || Q[ 2 ] < 0.0f || Q[ 3 ] < 0.0f || !( R > 0.0f ) )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: Q has to be >= 0, R > 0\r\n" );
+            return pdFALSE;
+        }
+
+        if( lqr_synthesize( ctrl, Q, R ) )
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: lqr task is busy\r\n" );
+            return pdFALSE;
+        }
+
+        lqr_wait( &status );
+    }
+    else if( n_params != 0 )
+    {
+        strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: lqr [upc|dpc [q_x q_th q_dx q_dth r]] or lqr model a b w0^2 c d\r\n" );
+        return pdFALSE;
+    }
+
+    lqr_get_plant( &plant );
+    lqr_get_status( &status );
+
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nmodel: a %.3f 1/s, b %.4f m/s^2/V, w0^2 %.3f 1/s^2, c %.4f rad/m, d %.4f 1/s, dt %.4f s\r\n"
+              "last:  %s, Q %.4g %.4g %.4g %.4g, R %.4g\r\n"
+              "       %s, %lu steps, %.1f us\r\n"
+              "       K %.3f %.3f %.3f %.3f\r\n",
+              ( double ) plant.cart_pole, ( double ) plant.cart_gain, ( double ) plant.pend_w0_sq,
+              ( double ) plant.pend_coupling, ( double ) plant.pend_damping, ( double ) dt_ctrl,
+              status.ctrl == GAIN_SET_DPC ? "DPC" : "UPC",
+              ( double ) status.Q[ 0 ], ( double ) status.Q[ 1 ], ( double ) status.Q[ 2 ], ( double ) status.Q[ 3 ],
+              ( double ) status.R,
+              status.busy ? "busy" : status.valid ? "loaded as set lqr" : "no solution",
+              ( unsigned long ) status.steps, ( double ) ( ( float ) status.cycles * us ),
+              ( double ) status.K[ 0 ], ( double ) status.K[ 1 ], ( double ) status.K[ 2 ], ( double ) status.K[ 3 ] );
+
+    return pdFALSE;
+}
+
+/* command: upclaw */
+static portBASE_TYPE upclaw_command( int8_t *pcWriteBuffer, size_t xWriteBufferLen, const int8_t *pcCommandString )
+{
+    const float us = 1.0e6f / CTRL_TICK_CPU_HZ;
+    int8_t *pcParameter1;
+    BaseType_t xParameter1StringLength;
+    mpc_law_stats stats;
+
+    configASSERT( pcWriteBuffer );
+
+    pcParameter1 = ( int8_t * ) FreeRTOS_CLIGetParameter( pcCommandString, 1, &xParameter1StringLength );
+    if( pcParameter1 != NULL )
+    {
+        pcParameter1[ xParameter1StringLength ] = 0x00;
+        if( !strcmp( ( const char * ) pcParameter1, "fsf" ) )
+        {
+            upc_law_select( UPC_LAW_FSF );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "mpc" ) )
+        {
+            /* Model and feedback of the current "lqr model", solved here. */
+            if( ctrl_6_MPC_uppos_reset() )
+            {
+                strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: no LQR solution for MPC model, see lqr\r\n" );
+                return pdFALSE;
+            }
+            ctrl_6_MPC_uppos_reset_stats();
+            upc_law_select( UPC_LAW_MPC );
+        }
+        else if( !strcmp( ( const char * ) pcParameter1, "reset" ) )
+        {
+            ctrl_6_MPC_uppos_reset_stats();
+        }
+        else
+        {
+            strcpy( ( char * ) pcWriteBuffer, "\r\nERROR: usage: upclaw [fsf|mpc|reset]\r\n" );
+            return pdFALSE;
+        }
+    }
+
+    ctrl_6_MPC_uppos_get_stats( &stats );
+
+    snprintf( ( char * ) pcWriteBuffer, xWriteBufferLen,
+              "\r\nUp position law: %s\r\n"
+              "MPC: horizon %u ticks, %u moves of %u ticks, cart %.1f - %.1f cm\r\n"
+              "     solves %lu, constrained %lu, not converged %lu, sweeps max %lu\r\n"
+              "     solve us mean %.1f, max %.1f\r\n",
+              upc_law_selected() == UPC_LAW_MPC ? "MPC" : "full state feedback",
+              ( unsigned ) MPC_HORIZON, ( unsigned ) MPC_MOVES, ( unsigned ) MPC_BLOCK,
+              ( double ) ( OK_ZONE_LOWER_LIMIT + MPC_ZONE_MARGIN_CM ), ( double ) ( FREEZING_ZONE_R_LOWER_LIMIT - MPC_ZONE_MARGIN_CM ),
+              ( unsigned long ) stats.solves, ( unsigned long ) stats.constrained,
+              ( unsigned long ) stats.not_converged, ( unsigned long ) stats.sweeps_max,
+              ( double ) ( stats.solves ? ( float ) stats.cycles_sum / stats.solves * us : 0.0f ),
+              ( double ) ( ( float ) stats.cycles_max * us ) );
+
+    return pdFALSE;
+}
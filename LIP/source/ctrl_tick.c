@@ -0,0 +1,187 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Control tick - hardware timer driven release of the control pipeline (util task),
+ * see ctrl_tick.h.
+ *
+ * Everything here is hardware independent, timer and cycle counter are in
+ * ctrl_tick_driver.c (sim_ctrl_tick_driver.c in SIL build).
+ *
+ * Statistics are shared between the ISR and tasks, tasks update and read them
+ * inside critical sections, which also mask TIM7 interrupt (NVIC priority 5 is
+ * not above configMAX_SYSCALL_INTERRUPT_PRIORITY).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "main_LIP.h"
+#include "ctrl_tick_driver.h"
+
+#if ( CTRL_TICK_HZ > CTRL_TICK_HZ_MAX ) || ( ( CTRL_TICK_TIMER_HZ % CTRL_TICK_HZ ) != 0 )
+    #error "CTRL_TICK_HZ has to divide CTRL_TICK_TIMER_HZ and be at most CTRL_TICK_HZ_MAX"
+#endif
+
+static ctrl_tick_stats stats;
+
+/* Clear statistics, call with TIM7 interrupt masked. */
+static void ctrl_tick_clear( void )
+{
+    stats.isr_count      = 0;
+    stats.isr_period_min = UINT32_MAX;
+    stats.isr_period_max = 0;
+
+    for( uint32_t i = 0; i < stats.n_tasks; i++ )
+    {
+        stats.task[ i ].wakeups     = 0;
+        stats.task[ i ].overruns    = 0;
+        stats.task[ i ].latency_min = UINT32_MAX;
+        stats.task[ i ].latency_max = 0;
+        stats.task[ i ].latency_sum = 0;
+        stats.task[ i ].period_min  = UINT32_MAX;
+        stats.task[ i ].period_max  = 0;
+    }
+}
+
+static ctrl_tick_task_stats *ctrl_tick_find( TaskHandle_t task )
+{
+    for( uint32_t i = 0; i < stats.n_tasks; i++ )
+    {
+        if( stats.task[ i ].task == task )
+        {
+            return &stats.task[ i ];
+        }
+    }
+
+    /* Task calls ctrl_tick_wait() but wasn't registered. */
+    configASSERT( 0 );
+    return NULL;
+}
+
+void ctrl_tick_register( TaskHandle_t task )
+{
+    configASSERT( stats.n_tasks < CTRL_TICK_MAX_TASKS );
+
+    stats.task[ stats.n_tasks ].task = task;
+    stats.n_tasks++;
+}
+
+void ctrl_tick_start( void )
+{
+    ctrl_tick_clear();
+    ctrl_tick_timer_start();
+}
+
+void ctrl_tick_isr( void )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t now = ctrl_tick_cycles();
+    uint32_t period;
+
+    if( stats.ticks > 0 )
+    {
+        period = now - stats.isr_cycles;
+        if( period < stats.isr_period_min )
+        {
+            stats.isr_period_min = period;
+        }
+        if( period > stats.isr_period_max )
+        {
+            stats.isr_period_max = period;
+        }
+        stats.isr_count++;
+    }
+    stats.isr_cycles = now;
+    stats.ticks++;
+
+    /* Setpoint pot conversions in lockstep with the tick. */
+    pot_adc_tick();
+
+    /* Notification value is used as a counting semaphore, more than one pending
+    tick at wake up means that ticks were missed. */
+    for( uint32_t i = 0; i < stats.n_tasks; i++ )
+    {
+        vTaskNotifyGiveIndexedFromISR( stats.task[ i ].task, CTRL_TICK_NOTIFY_INDEX, &xHigherPriorityTaskWoken );
+    }
+
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+uint32_t ctrl_tick_wait( void )
+{
+    ctrl_tick_task_stats *t = ctrl_tick_find( xTaskGetCurrentTaskHandle() );
+    uint32_t pending;
+    uint32_t now;
+    uint32_t tick_cycles;
+    uint32_t latency;
+    uint32_t period;
+
+    /* Next tick was given before this one was finished. */
+    taskENTER_CRITICAL();
+    if( t->woken && stats.ticks != t->woken_on_tick )
+    {
+        t->overruns++;
+    }
+    taskEXIT_CRITICAL();
+
+    /* Take returns 0 if the task was suspended while blocked here and resumed
+    before the next tick. */
+    do
+    {
+        pending = ulTaskNotifyTakeIndexed( CTRL_TICK_NOTIFY_INDEX, pdTRUE, portMAX_DELAY );
+    } while( pending == 0 );
+
+    taskENTER_CRITICAL();
+    now = ctrl_tick_cycles();
+    tick_cycles = stats.isr_cycles;
+    t->woken_on_tick = stats.ticks;
+    t->woken = 1;
+
+    if( pending == 1 )
+    {
+        latency = now - stats.isr_cycles;
+        if( latency < t->latency_min )
+        {
+            t->latency_min = latency;
+        }
+        if( latency > t->latency_max )
+        {
+            t->latency_max = latency;
+        }
+        t->latency_sum += latency;
+
+        if( t->last_wake_valid )
+        {
+            period = now - t->last_wake;
+            if( period < t->period_min )
+            {
+                t->period_min = period;
+            }
+            if( period > t->period_max )
+            {
+                t->period_max = period;
+            }
+        }
+        t->wakeups++;
+        t->last_wake_valid = 1;
+    }
+    else
+    {
+        /* Task was suspended or overran by more than a period, don't use this
+        wake up for statistics. Overrun was already counted. */
+        t->last_wake_valid = 0;
+    }
+    t->last_wake = now;
+    taskEXIT_CRITICAL();
+
+    return tick_cycles;
+}
+
+void ctrl_tick_get_stats( ctrl_tick_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+void ctrl_tick_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    ctrl_tick_clear();
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,42 @@
+/*
+ * Description: Hardware part of the control tick (ctrl_tick.h)
+ *
+ * Notes:
+ * 	Timer for control tick is tim7 (CTRL_TICK_TIMER_HANDLE=htim7) (APB1@84MHz),
+ * 	update interrupt calls ctrl_tick_isr() from HAL_TIM_PeriodElapsedCallback()
+ * 	in main.c
+ *
+ * 	PSC set @ 83 (84) -> 1MHz
+ * 	ARR set here from CTRL_TICK_HZ
+ *	Auto-reload preload: enabled
+ *
+ * 	DWT cycle counter is enabled here, it runs at core clock (168MHz).
+ *
+ */
+
+#include "tim.h" // from autogenerated code
+#include "main_LIP.h"
+#include "ctrl_tick_driver.h"
+
+/*
+ * Function to set control tick period and start TIM7 update interrupt
+ */
+void ctrl_tick_timer_start( void )
+{
+    /* Enable DWT cycle counter. */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    __HAL_TIM_SET_AUTORELOAD( &CTRL_TICK_TIMER_HANDLE, CTRL_TICK_TIMER_HZ / CTRL_TICK_HZ - 1 );
+    __HAL_TIM_SET_COUNTER( &CTRL_TICK_TIMER_HANDLE, 0 );
+    HAL_TIM_Base_Start_IT( &CTRL_TICK_TIMER_HANDLE );
+}
+
+/*
+ * Function to read DWT cycle counter
+ */
+uint32_t ctrl_tick_cycles( void )
+{
+    return DWT->CYCCNT;
+}
@@ -1,7 +1,17 @@
 #include "dcm_encoder_driver.h"
+#include "cart_vel.h"
+#include "ctrl_tick_driver.h"
 
-static uint16_t enc_read_raw = 0;
-static float cart_position = 0.0f;
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Encoder counter period, one wrap of the counter */
+#define ENC_COUNT_PERIOD ( ENC_TIMER_ARR + 1 )
+
+/* Extended count since zeroing and the counter value it was extended from,
+written only inside the critical section of dcm_enc_get_snapshot() */
+static int32_t enc_counts = 0;
+static uint16_t enc_last_count = 0;
 
 /* Start encoder timer in encoder mode */
 void enc_init(void)
@@ -10,6 +20,19 @@ void enc_init(void)
 	HAL_TIM_Encoder_Start( &ENC_TIMER_HANDLE, TIM_CHANNEL_ALL );
 
 	// HAL_TIM_Encoder_Start_IT( &ENC_TIMER_HANDLE, TIM_CHANNEL_ALL );
+
+	/* CC1 captures the counter on enc_A rising edges, interrupt only for
+	this channel, edges of enc_B would give the same information twice. */
+	__HAL_TIM_ENABLE_IT( &ENC_TIMER_HANDLE, TIM_IT_CC1 );
+}
+
+/* TIM4 CC1 interrupt, edge timestamp for cart velocity estimator */
+void HAL_TIM_IC_CaptureCallback( TIM_HandleTypeDef *htim )
+{
+	if( htim == &ENC_TIMER_HANDLE && htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1 )
+	{
+		cart_vel_edge( ( uint16_t ) HAL_TIM_ReadCapturedValue( htim, TIM_CHANNEL_1 ), ctrl_tick_cycles() );
+	}
 }
 
 /* Return: raw encoder timer count (uint16_t) */
@@ -21,14 +44,57 @@ uint16_t enc_get_count(void)
 /* Zero the encoder counter value */
 void dcm_enc_zero_counter(void)
 {
+	taskENTER_CRITICAL();
 	__HAL_TIM_SetCounter( &ENC_TIMER_HANDLE, 0 ); // htim4.Instance->CNT = 0;
+	enc_counts = 0;
+	enc_last_count = 0;
+	taskEXIT_CRITICAL();
+}
+
+/* Extended counts, position in cm and timestamp */
+void dcm_enc_get_snapshot(dcm_enc_snapshot *out)
+{
+	uint16_t count;
+	int32_t delta;
+
+	/* Difference to the previous read, wrapped into half a counter period either
+	way. The cart can't move half a period (about 22cm) between two reads, util
+	task reads every control tick, so a counter wrap in either direction, or a
+	bounce back and forth over it, comes out as the small signed difference. */
+	taskENTER_CRITICAL();
+	count = enc_get_count();
+	out->cycles = ctrl_tick_cycles();
+	delta = ( int32_t ) count - ( int32_t ) enc_last_count;
+	if( delta > ENC_COUNT_PERIOD / 2 )
+	{
+		delta -= ENC_COUNT_PERIOD;
+	}
+	else if( delta < -ENC_COUNT_PERIOD / 2 )
+	{
+		delta += ENC_COUNT_PERIOD;
+	}
+	enc_counts += delta;
+	enc_last_count = count;
+	out->counts = enc_counts;
+	taskEXIT_CRITICAL();
+
+	out->position_cm = ( float ) out->counts * ENCODER_MULTIPLIER;
+}
+
+/* Returns signed extended encoder count */
+int32_t dcm_enc_get_counts(void)
+{
+	dcm_enc_snapshot snapshot;
+
+	dcm_enc_get_snapshot( &snapshot );
+	return snapshot.counts;
 }
 
 /* Returns cart position in cm */
 float dcm_enc_get_cart_position_cm(void)
 {
-	enc_read_raw = enc_get_count();
-	// cart_position = (float) enc_read_raw * 0.00724414303f; // div by (float) ENC_MAX_CNT mult by TRACK_LEN_MAX_CM;
-	cart_position = (float) enc_read_raw * ENCODER_MULTIPLIER; // div by (float) ENC_MAX_CNT mult by TRACK_LEN_MAX_CM;
-	return cart_position;
-}
\ No newline at end of file
+	dcm_enc_snapshot snapshot;
+
+	dcm_enc_get_snapshot( &snapshot );
+	return snapshot.position_cm;
+}
@@ -0,0 +1,673 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Filter benchmark, see filter_bench.h.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "filter_bench.h"
+#include "LP_filter.h"
+#include "LP_bank.h"
+#include "FIR_filter.h"
+#include "FIR_engine.h"
+#include "IIR_biquad.h"
+#include "IIR_filter.h"
+#include "fixp_filter.h"
+
+#if defined( __ARM_ARCH_7EM__ )
+    #include "stm32f4xx.h"      /* NVIC, ISR cases */
+#endif
+
+/* Length of the input signal, power of two. */
+#define BENCH_INPUT_LEN 64
+
+/* Sampling time of the benchmarked filters, 100Hz control tick. */
+#define BENCH_DT 0.01f
+
+/* Outputs are summed here, so the compiler can't drop the work. */
+static volatile float bench_sink;
+
+static float bench_input[ BENCH_INPUT_LEN ];
+
+/* Pseudo random input in [-1, 1), same on target and host. */
+static void bench_fill_input( void )
+{
+    uint32_t state = 12345;
+
+    for( uint32_t i = 0; i < BENCH_INPUT_LEN; i++ )
+    {
+        state = state * 1664525UL + 1013904223UL;
+        bench_input[ i ] = ( float ) ( int32_t ) ( state >> 8 ) / 8388608.0f - 1.0f;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Low pass filters of util task: pendulum speed, cart speed, pot and cli setpoints.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+#define BENCH_LP_CHANNELS 4
+
+static const float bench_lp_time_constants[ BENCH_LP_CHANNELS ] = { 0.025f, 0.025f, 0.2f, 0.05f };
+
+/* LP_update() before coefficients were precomputed, two divisions per sample.
+Not inlined, like LP_update() called from util task, otherwise the compiler
+hoists the divisions out of the benchmark loop. */
+static float __attribute__( ( noinline ) ) bench_LP_update_div( LP_filter *lp, float in )
+{
+    lp->out[ 1 ] = lp->out[ 0 ];
+    lp->in[ 1 ]  = lp->in[ 0 ];
+    lp->in[ 0 ]  = in;
+
+    float c1, c2;
+    c1 = lp->samplingTime / ( 2*lp->timeConstant + lp->samplingTime );
+    c2 = (2*lp->timeConstant - lp->samplingTime) / (2*lp->timeConstant + lp->samplingTime);
+    lp->out[ 0 ] = c1 * ( lp->in[ 0 ] + lp->in[ 1 ] ) + c2 * lp->out[ 1 ] ;
+
+    return lp->out[ 0 ];
+}
+
+static uint32_t bench_lp_div( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_filter lp[ BENCH_LP_CHANNELS ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+    {
+        LP_init( &lp[ c ], bench_lp_time_constants[ c ], BENCH_DT );
+    }
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            sum += bench_LP_update_div( &lp[ c ], bench_input[ ( t + c ) & ( BENCH_INPUT_LEN - 1 ) ] );
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_lp( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_filter lp[ BENCH_LP_CHANNELS ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+    {
+        LP_init( &lp[ c ], bench_lp_time_constants[ c ], BENCH_DT );
+    }
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            sum += LP_update( &lp[ c ], bench_input[ ( t + c ) & ( BENCH_INPUT_LEN - 1 ) ] );
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_lp_bank( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_bank bank;
+    float sum = 0.0f;
+    uint32_t start;
+
+    LP_bank_init( &bank, BENCH_LP_CHANNELS, BENCH_DT );
+    for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+    {
+        LP_bank_set_time_constant( &bank, c, bench_lp_time_constants[ c ] );
+    }
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            bank.in[ c ] = bench_input[ ( t + c ) & ( BENCH_INPUT_LEN - 1 ) ];
+        }
+        LP_bank_update( &bank );
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            sum += bank.out[ c ];
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FIR filters on both encoders, one sample per encoder per tick, or a block of
+ * BENCH_FIR_BLOCK samples per encoder per tick (oversampled encoder stream).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+#define BENCH_FIR_TAPS  64
+#define BENCH_FIR_BLOCK 16
+
+static float bench_fir_coeffs[ BENCH_FIR_TAPS ];
+static int16_t bench_fir_coeffs_q15[ BENCH_FIR_TAPS ];
+static float bench_fir_state[ 2 ][ FIR_ENGINE_STATE_LEN( BENCH_FIR_TAPS ) ];
+static int16_t bench_fir_state_q15[ 2 ][ FIR_ENGINE_STATE_LEN( BENCH_FIR_TAPS ) ];
+
+static uint32_t bench_fir_old( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_filter fir[ 2 ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    /* Old filter has fixed FIR_BUFF_LEN taps. */
+    FIR_init( &fir[ 0 ], bench_fir_coeffs );
+    FIR_init( &fir[ 1 ], bench_fir_coeffs );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += FIR_update( &fir[ 0 ], bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum += FIR_update( &fir[ 1 ], bench_input[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_fir_engine( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_engine fir[ 2 ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    FIR_engine_init( &fir[ 0 ], bench_fir_coeffs, bench_fir_state[ 0 ], BENCH_FIR_TAPS );
+    FIR_engine_init( &fir[ 1 ], bench_fir_coeffs, bench_fir_state[ 1 ], BENCH_FIR_TAPS );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += FIR_engine_update( &fir[ 0 ], bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum += FIR_engine_update( &fir[ 1 ], bench_input[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_fir_engine_q15( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_engine_q15 fir[ 2 ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    FIR_engine_q15_init( &fir[ 0 ], bench_fir_coeffs_q15, bench_fir_state_q15[ 0 ], BENCH_FIR_TAPS );
+    FIR_engine_q15_init( &fir[ 1 ], bench_fir_coeffs_q15, bench_fir_state_q15[ 1 ], BENCH_FIR_TAPS );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += FIR_engine_q15_update( &fir[ 0 ], ( int16_t ) ( bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] * 16384.0f ) );
+        sum += FIR_engine_q15_update( &fir[ 1 ], ( int16_t ) ( bench_input[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] * 16384.0f ) );
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+static uint32_t bench_fir_engine_block( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_engine fir[ 2 ];
+    float out[ BENCH_FIR_BLOCK ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    FIR_engine_init( &fir[ 0 ], bench_fir_coeffs, bench_fir_state[ 0 ], BENCH_FIR_TAPS );
+    FIR_engine_init( &fir[ 1 ], bench_fir_coeffs, bench_fir_state[ 1 ], BENCH_FIR_TAPS );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        uint32_t offset = ( t * BENCH_FIR_BLOCK ) & ( BENCH_INPUT_LEN - BENCH_FIR_BLOCK );
+
+        for( uint32_t e = 0; e < 2; e++ )
+        {
+            FIR_engine_block( &fir[ e ], &bench_input[ offset ], out, BENCH_FIR_BLOCK );
+            sum += out[ BENCH_FIR_BLOCK - 1 ];
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_fir_engine_q15_block( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_engine_q15 fir[ 2 ];
+    int16_t in[ BENCH_INPUT_LEN ];
+    int16_t out[ BENCH_FIR_BLOCK ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    for( uint32_t i = 0; i < BENCH_INPUT_LEN; i++ )
+    {
+        in[ i ] = ( int16_t ) ( bench_input[ i ] * 16384.0f );
+    }
+    FIR_engine_q15_init( &fir[ 0 ], bench_fir_coeffs_q15, bench_fir_state_q15[ 0 ], BENCH_FIR_TAPS );
+    FIR_engine_q15_init( &fir[ 1 ], bench_fir_coeffs_q15, bench_fir_state_q15[ 1 ], BENCH_FIR_TAPS );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        uint32_t offset = ( t * BENCH_FIR_BLOCK ) & ( BENCH_INPUT_LEN - BENCH_FIR_BLOCK );
+
+        for( uint32_t e = 0; e < 2; e++ )
+        {
+            FIR_engine_q15_block( &fir[ e ], &in[ offset ], out, BENCH_FIR_BLOCK );
+            sum += out[ BENCH_FIR_BLOCK - 1 ];
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * One channel through a first order LP_filter or 2 to 4 biquad sections, 4th
+ * order Butterworth low pass at 10Hz and notches at 25Hz and 40Hz. Coefficients
+ * are compile time constants.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static const IIR_biquad_coeffs bench_biquad_coeffs[ IIR_BIQUAD_MAX_SECTIONS ] =
+{
+    IIR_BIQUAD_LP( 10.0f, IIR_BIQUAD_BUTTER4_Q1, BENCH_DT ),
+    IIR_BIQUAD_LP( 10.0f, IIR_BIQUAD_BUTTER4_Q2, BENCH_DT ),
+    IIR_BIQUAD_NOTCH( 25.0f, 2.0f, BENCH_DT ),
+    IIR_BIQUAD_NOTCH( 40.0f, 2.0f, BENCH_DT ),
+};
+
+static uint32_t bench_lp_single( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_filter lp;
+    float sum = 0.0f;
+    uint32_t start;
+
+    LP_init( &lp, 0.025f, BENCH_DT );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += LP_update( &lp, bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_biquad( filter_bench_clock clock, uint32_t ticks, uint32_t sections )
+{
+    IIR_biquad iir;
+    float sum = 0.0f;
+    uint32_t start;
+
+    IIR_biquad_init( &iir, bench_biquad_coeffs, sections );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += IIR_biquad_update( &iir, bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_biquad_2( filter_bench_clock clock, uint32_t ticks )
+{
+    return bench_biquad( clock, ticks, 2 );
+}
+
+static uint32_t bench_biquad_3( filter_bench_clock clock, uint32_t ticks )
+{
+    return bench_biquad( clock, ticks, 3 );
+}
+
+static uint32_t bench_biquad_4( filter_bench_clock clock, uint32_t ticks )
+{
+    return bench_biquad( clock, ticks, 4 );
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Fixed point filters against the float ones, same work per tick as the float
+ * cases above. Inputs are converted to Q15 / Q31 once, before the clock starts.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static int16_t bench_input_q15[ BENCH_INPUT_LEN ];
+static int32_t bench_input_q31[ BENCH_INPUT_LEN ];
+
+/* Output LSB per input LSB per second of the derivative cases. */
+#define BENCH_DERIV_SCALE 0.01f
+
+static uint32_t bench_lp_q15( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_filter_q15 lp[ BENCH_LP_CHANNELS ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+    {
+        LP_q15_init( &lp[ c ], bench_lp_time_constants[ c ], BENCH_DT );
+    }
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            sum += LP_q15_update( &lp[ c ], bench_input_q15[ ( t + c ) & ( BENCH_INPUT_LEN - 1 ) ] );
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+static uint32_t bench_lp_q31( filter_bench_clock clock, uint32_t ticks )
+{
+    LP_filter_q31 lp[ BENCH_LP_CHANNELS ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+    {
+        LP_q31_init( &lp[ c ], bench_lp_time_constants[ c ], BENCH_DT );
+    }
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t c = 0; c < BENCH_LP_CHANNELS; c++ )
+        {
+            sum ^= LP_q31_update( &lp[ c ], bench_input_q31[ ( t + c ) & ( BENCH_INPUT_LEN - 1 ) ] );
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+static uint32_t bench_fir_q15( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_filter_q15 fir[ 2 ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    FIR_q15_init( &fir[ 0 ], bench_fir_coeffs );
+    FIR_q15_init( &fir[ 1 ], bench_fir_coeffs );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += FIR_q15_update( &fir[ 0 ], bench_input_q15[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum += FIR_q15_update( &fir[ 1 ], bench_input_q15[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+static uint32_t bench_fir_q31( filter_bench_clock clock, uint32_t ticks )
+{
+    FIR_filter_q31 fir[ 2 ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    FIR_q31_init( &fir[ 0 ], bench_fir_coeffs );
+    FIR_q31_init( &fir[ 1 ], bench_fir_coeffs );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum ^= FIR_q31_update( &fir[ 0 ], bench_input_q31[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum ^= FIR_q31_update( &fir[ 1 ], bench_input_q31[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+static uint32_t bench_iir( filter_bench_clock clock, uint32_t ticks )
+{
+    IIR_filter iir[ 2 ];
+    float sum = 0.0f;
+    uint32_t start;
+
+    IIR_init_fo( &iir[ 0 ], 0.8f );
+    IIR_init_fo( &iir[ 1 ], 0.95f );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += IIR_update_fo( &iir[ 0 ], bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum += IIR_update_fo( &iir[ 1 ], bench_input[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_iir_q15( filter_bench_clock clock, uint32_t ticks )
+{
+    IIR_filter_q15 iir[ 2 ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    IIR_q15_init_fo( &iir[ 0 ], 0.8f );
+    IIR_q15_init_fo( &iir[ 1 ], 0.95f );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum += IIR_q15_update_fo( &iir[ 0 ], bench_input_q15[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum += IIR_q15_update_fo( &iir[ 1 ], bench_input_q15[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+/* Tustin derivative as pend_speed_raw / cart_speed_raw in util task. */
+static uint32_t bench_deriv( filter_bench_clock clock, uint32_t ticks )
+{
+    float in[ 2 ][ 2 ] = { { 0.0f, 0.0f }, { 0.0f, 0.0f } };
+    float out[ 2 ][ 2 ] = { { 0.0f, 0.0f }, { 0.0f, 0.0f } };
+    float gain = 2.0f * BENCH_DERIV_SCALE / BENCH_DT;
+    float sum = 0.0f;
+    uint32_t start;
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        for( uint32_t e = 0; e < 2; e++ )
+        {
+            in[ e ][ 1 ] = in[ e ][ 0 ];
+            in[ e ][ 0 ] = bench_input[ ( t + 7 * e ) & ( BENCH_INPUT_LEN - 1 ) ];
+            out[ e ][ 1 ] = out[ e ][ 0 ];
+            out[ e ][ 0 ] = ( in[ e ][ 0 ] - in[ e ][ 1 ] ) * gain - out[ e ][ 1 ];
+            sum += out[ e ][ 0 ];
+        }
+    }
+    start = clock() - start;
+
+    bench_sink = sum;
+    return start;
+}
+
+static uint32_t bench_deriv_q31( filter_bench_clock clock, uint32_t ticks )
+{
+    deriv_q31 d[ 2 ];
+    int32_t sum = 0;
+    uint32_t start;
+
+    deriv_q31_init( &d[ 0 ], BENCH_DT, BENCH_DERIV_SCALE );
+    deriv_q31_init( &d[ 1 ], BENCH_DT, BENCH_DERIV_SCALE );
+
+    start = clock();
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        sum ^= deriv_q31_update( &d[ 0 ], bench_input_q31[ t & ( BENCH_INPUT_LEN - 1 ) ] );
+        sum ^= deriv_q31_update( &d[ 1 ], bench_input_q31[ ( t + 7 ) & ( BENCH_INPUT_LEN - 1 ) ] );
+    }
+    start = clock() - start;
+
+    bench_sink = ( float ) sum;
+    return start;
+}
+
+#if defined( __ARM_ARCH_7EM__ )
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Target only: one low pass update in an interrupt, cycles from pending the
+ * interrupt to being back in the task. SPI6 is not used by the app, its
+ * vector serves as a software interrupt. The task has an active FPU context
+ * (float sum), so a float ISR also pays for lazy stacking of the FPU
+ * registers on its first FPU instruction, the Q15 ISR doesn't.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static LP_filter bench_isr_lp;
+static LP_filter_q15 bench_isr_lp_q15;
+static volatile uint32_t bench_isr_q15;
+static volatile uint32_t bench_isr_index;
+
+void SPI6_IRQHandler( void )
+{
+    uint32_t i = bench_isr_index & ( BENCH_INPUT_LEN - 1 );
+
+    if( bench_isr_q15 )
+    {
+        LP_q15_update( &bench_isr_lp_q15, bench_input_q15[ i ] );
+    }
+    else
+    {
+        LP_update( &bench_isr_lp, bench_input[ i ] );
+    }
+}
+
+static uint32_t bench_isr( filter_bench_clock clock, uint32_t ticks, uint32_t q15 )
+{
+    float sum = 0.0f;
+    uint32_t total = 0;
+    uint32_t start;
+
+    LP_init( &bench_isr_lp, 0.025f, BENCH_DT );
+    LP_q15_init( &bench_isr_lp_q15, 0.025f, BENCH_DT );
+    bench_isr_q15 = q15;
+
+    NVIC_SetPriority( SPI6_IRQn, 5 );
+    NVIC_ClearPendingIRQ( SPI6_IRQn );
+    NVIC_EnableIRQ( SPI6_IRQn );
+
+    for( uint32_t t = 0; t < ticks; t++ )
+    {
+        /* Task uses the FPU between the interrupts, like util task. */
+        sum += bench_input[ t & ( BENCH_INPUT_LEN - 1 ) ];
+        bench_isr_index = t;
+
+        start = clock();
+        NVIC_SetPendingIRQ( SPI6_IRQn );
+        __DSB();
+        __ISB();
+        total += clock() - start;
+    }
+
+    NVIC_DisableIRQ( SPI6_IRQn );
+
+    bench_sink = sum;
+    return total;
+}
+
+static uint32_t bench_isr_float( filter_bench_clock clock, uint32_t ticks )
+{
+    return bench_isr( clock, ticks, 0 );
+}
+
+static uint32_t bench_isr_fixp( filter_bench_clock clock, uint32_t ticks )
+{
+    return bench_isr( clock, ticks, 1 );
+}
+#endif
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Cases.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    const char *name;
+    uint32_t ( *run )( filter_bench_clock clock, uint32_t ticks );
+} bench_case;
+
+static const bench_case bench_cases[] =
+{
+    { "4x LP_update, divisions per sample (old)", bench_lp_div  },
+    { "4x LP_update, precomputed coefficients",   bench_lp      },
+    { "LP_bank, 4 channels",                      bench_lp_bank },
+    { "2x FIR_update, 16 taps (old)",             bench_fir_old },
+    { "2x FIR engine, 64 taps float",             bench_fir_engine },
+    { "2x FIR engine, 64 taps Q15",               bench_fir_engine_q15 },
+    { "2x FIR engine, 64 taps float, 16 samples", bench_fir_engine_block },
+    { "2x FIR engine, 64 taps Q15, 16 samples",   bench_fir_engine_q15_block },
+    { "1x LP_update",                             bench_lp_single },
+    { "biquad cascade, 2 sections",               bench_biquad_2 },
+    { "biquad cascade, 3 sections",               bench_biquad_3 },
+    { "biquad cascade, 4 sections",               bench_biquad_4 },
+    { "4x LP Q15",                                bench_lp_q15 },
+    { "4x LP Q31",                                bench_lp_q31 },
+    { "2x FIR Q15, 16 taps",                      bench_fir_q15 },
+    { "2x FIR Q31, 16 taps",                      bench_fir_q31 },
+    { "2x IIR_update_fo",                         bench_iir },
+    { "2x IIR fo Q15",                            bench_iir_q15 },
+    { "2x Tustin derivative",                     bench_deriv },
+    { "2x Tustin derivative Q31",                 bench_deriv_q31 },
+#if defined( __ARM_ARCH_7EM__ )
+    { "ISR, LP_update",                           bench_isr_float },
+    { "ISR, LP Q15",                              bench_isr_fixp },
+#endif
+};
+
+uint32_t filter_bench_run( filter_bench_clock clock, uint32_t ticks,
+                           filter_bench_result *results, uint32_t max_results )
+{
+    uint32_t n = 0;
+
+    if( ticks == 0 )
+    {
+        ticks = 1;
+    }
+    bench_fill_input();
+    FIR_design_lowpass( bench_fir_coeffs, BENCH_FIR_TAPS, 0.05f );
+    FIR_coeffs_to_q15( bench_fir_coeffs, bench_fir_coeffs_q15, BENCH_FIR_TAPS );
+    for( uint32_t i = 0; i < BENCH_INPUT_LEN; i++ )
+    {
+        bench_input_q15[ i ] = fixp_q15_from_float( bench_input[ i ] );
+        bench_input_q31[ i ] = fixp_q31_from_float( bench_input[ i ] );
+    }
+
+    for( uint32_t i = 0; i < sizeof( bench_cases ) / sizeof( bench_cases[ 0 ] ) && n < max_results; i++ )
+    {
+        results[ n ].name = bench_cases[ i ].name;
+        results[ n ].ticks_per_call = ( float ) bench_cases[ i ].run( clock, ticks ) / ( float ) ticks;
+        n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,326 @@
+#include "fixp_filter.h"
+#include <math.h>
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Rounding and saturation.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static inline int16_t fixp_sat_q15( int32_t x )
+{
+    if( x > INT16_MAX )
+    {
+        return INT16_MAX;
+    }
+    if( x < INT16_MIN )
+    {
+        return INT16_MIN;
+    }
+    return ( int16_t ) x;
+}
+
+static inline int32_t fixp_sat_q31( int64_t x )
+{
+    if( x > INT32_MAX )
+    {
+        return INT32_MAX;
+    }
+    if( x < INT32_MIN )
+    {
+        return INT32_MIN;
+    }
+    return ( int32_t ) x;
+}
+
+/* Round half up and shift right, shift > 0. */
+static inline int32_t fixp_round32( int32_t acc, uint32_t shift )
+{
+    return ( acc + ( ( int32_t ) 1 << ( shift - 1 ) ) ) >> shift;
+}
+
+static inline int64_t fixp_round64( int64_t acc, uint32_t shift )
+{
+    return ( acc + ( ( int64_t ) 1 << ( shift - 1 ) ) ) >> shift;
+}
+
+int16_t fixp_q15_from_float( float x )
+{
+    float q = roundf( x * 32768.0f );
+
+    if( q >= 32767.0f )
+    {
+        return INT16_MAX;
+    }
+    if( q <= -32768.0f )
+    {
+        return INT16_MIN;
+    }
+    return ( int16_t ) q;
+}
+
+int32_t fixp_q31_from_float( float x )
+{
+    float q = roundf( x * 2147483648.0f );
+
+    /* 2^31 - 1 isn't a float, anything from 2^31 down saturates. */
+    if( q >= 2147483648.0f )
+    {
+        return INT32_MAX;
+    }
+    if( q <= -2147483648.0f )
+    {
+        return INT32_MIN;
+    }
+    return ( int32_t ) q;
+}
+
+float fixp_q15_to_float( int16_t x )
+{
+    return ( float ) x / 32768.0f;
+}
+
+float fixp_q31_to_float( int32_t x )
+{
+    return ( float ) x / 2147483648.0f;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Low pass.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+/* Same coefficients as LP_filter. */
+static void LP_fixp_coeffs( float timeConstant, float samplingTime, float *c1, float *c2 )
+{
+    float den = 2*timeConstant + samplingTime;
+
+    if( den > 0.0f )
+    {
+        *c1 = samplingTime / den;
+        *c2 = (2*timeConstant - samplingTime) / den;
+    }
+    else
+    {
+        *c1 = 0.5f;
+        *c2 = 0.0f;
+    }
+}
+
+void LP_q15_init( LP_filter_q15 *lp, float timeConstant, float samplingTime )
+{
+    lp->samplingTime = samplingTime < 0.0f ? 0.0f : samplingTime;
+    LP_q15_update_time_Constant( lp, timeConstant );
+
+    lp->out = 0;
+    lp->in  = 0;
+}
+
+void LP_q15_update_time_Constant( LP_filter_q15 *lp, float newTimeConstant )
+{
+    float c1, c2;
+
+    lp->timeConstant = newTimeConstant < 0.0f ? 0.0f : newTimeConstant;
+    LP_fixp_coeffs( lp->timeConstant, lp->samplingTime, &c1, &c2 );
+    lp->c1 = fixp_q15_from_float( c1 );
+    lp->c2 = fixp_q15_from_float( c2 );
+}
+
+int16_t LP_q15_update( LP_filter_q15 *lp, int16_t in )
+{
+    /* 2 * c1 + |c2| <= 1, accumulator stays below 2^30 (plus rounding of the
+    coefficients), 32 bits are enough. */
+    int32_t acc = ( int32_t ) lp->c1 * ( ( int32_t ) in + lp->in ) + ( int32_t ) lp->c2 * lp->out;
+
+    lp->in  = in;
+    lp->out = fixp_sat_q15( fixp_round32( acc, 15 ) );
+
+    return lp->out;
+}
+
+void LP_q31_init( LP_filter_q31 *lp, float timeConstant, float samplingTime )
+{
+    lp->samplingTime = samplingTime < 0.0f ? 0.0f : samplingTime;
+    LP_q31_update_time_Constant( lp, timeConstant );
+
+    lp->out = 0;
+    lp->in  = 0;
+}
+
+void LP_q31_update_time_Constant( LP_filter_q31 *lp, float newTimeConstant )
+{
+    float c1, c2;
+
+    lp->timeConstant = newTimeConstant < 0.0f ? 0.0f : newTimeConstant;
+    LP_fixp_coeffs( lp->timeConstant, lp->samplingTime, &c1, &c2 );
+    lp->c1 = fixp_q31_from_float( c1 );
+    lp->c2 = fixp_q31_from_float( c2 );
+}
+
+int32_t LP_q31_update( LP_filter_q31 *lp, int32_t in )
+{
+    int64_t acc = ( int64_t ) lp->c1 * ( ( int64_t ) in + lp->in ) + ( int64_t ) lp->c2 * lp->out;
+
+    lp->in  = in;
+    lp->out = fixp_sat_q31( fixp_round64( acc, 31 ) );
+
+    return lp->out;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FIR.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+void FIR_q15_init( FIR_filter_q15 *fir, const float coeffs[ FIR_BUFF_LEN ] )
+{
+    for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+    {
+        fir->buf[ i ] = 0;
+        fir->coeffs[ i ] = fixp_q15_from_float( coeffs[ i ] );
+    }
+    fir->buf_index = 0;
+    fir->out = 0;
+}
+
+int16_t FIR_q15_update( FIR_filter_q15 *fir, int16_t in )
+{
+    /* Q30 products, 16 of them fit in 64 bits with room to spare. */
+    int64_t acc = 0;
+    uint32_t index = fir->buf_index;
+
+    fir->buf[ index ] = in;
+    for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+    {
+        acc += ( int32_t ) fir->coeffs[ i ] * fir->buf[ index ];
+        index = ( index == 0 ) ? FIR_BUFF_LEN - 1 : index - 1;
+    }
+
+    fir->buf_index = ( fir->buf_index + 1 == FIR_BUFF_LEN ) ? 0 : fir->buf_index + 1;
+    fir->out = fixp_sat_q15( fixp_sat_q31( fixp_round64( acc, 15 ) ) );
+
+    return fir->out;
+}
+
+void FIR_q31_init( FIR_filter_q31 *fir, const float coeffs[ FIR_BUFF_LEN ] )
+{
+    for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+    {
+        fir->buf[ i ] = 0;
+        fir->coeffs[ i ] = fixp_q31_from_float( coeffs[ i ] );
+    }
+    fir->buf_index = 0;
+    fir->out = 0;
+}
+
+int32_t FIR_q31_update( FIR_filter_q31 *fir, int32_t in )
+{
+    int64_t acc = 0;
+    uint32_t index = fir->buf_index;
+
+    fir->buf[ index ] = in;
+    for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+    {
+        acc += ( ( int64_t ) fir->coeffs[ i ] * fir->buf[ index ] ) >> FIR_Q31_GUARD_BITS;
+        index = ( index == 0 ) ? FIR_BUFF_LEN - 1 : index - 1;
+    }
+
+    fir->buf_index = ( fir->buf_index + 1 == FIR_BUFF_LEN ) ? 0 : fir->buf_index + 1;
+    fir->out = fixp_sat_q31( fixp_round64( acc, 31 - FIR_Q31_GUARD_BITS ) );
+
+    return fir->out;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * First order IIR.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static float IIR_fixp_alpha( float alpha )
+{
+    if( alpha < 0.0f )
+    {
+        return 0.0f;
+    }
+    if( alpha > 1.0f )
+    {
+        return 1.0f;
+    }
+    return alpha;
+}
+
+void IIR_q15_init_fo( IIR_filter_q15 *iir, float alpha )
+{
+    /* 1.0 is a valid alpha, not a Q15 value, rounded here directly. */
+    iir->alpha = ( int32_t ) roundf( IIR_fixp_alpha( alpha ) * 32768.0f );
+    iir->out = 0;
+}
+
+int16_t IIR_q15_update_fo( IIR_filter_q15 *iir, int16_t in )
+{
+    int32_t acc = ( 32768 - iir->alpha ) * in + iir->alpha * iir->out;
+
+    iir->out = fixp_sat_q15( fixp_round32( acc, 15 ) );
+
+    return iir->out;
+}
+
+void IIR_q31_init_fo( IIR_filter_q31 *iir, float alpha )
+{
+    iir->alpha = ( int64_t ) roundf( IIR_fixp_alpha( alpha ) * 2147483648.0f );
+    iir->out = 0;
+}
+
+int32_t IIR_q31_update_fo( IIR_filter_q31 *iir, int32_t in )
+{
+    int64_t acc = ( ( 1LL << 31 ) - iir->alpha ) * in + iir->alpha * iir->out;
+
+    iir->out = fixp_sat_q31( fixp_round64( acc, 31 ) );
+
+    return iir->out;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Tustin derivative.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static int32_t deriv_fixp_gain( float samplingTime, float scale )
+{
+    float gain = samplingTime > 0.0f ? 2.0f * scale / samplingTime : 0.0f;
+    float q = roundf( gain * 65536.0f );
+
+    if( q >= 2147483648.0f )
+    {
+        return INT32_MAX;
+    }
+    if( q <= -2147483648.0f )
+    {
+        return INT32_MIN;
+    }
+    return ( int32_t ) q;
+}
+
+void deriv_q15_init( deriv_q15 *d, float samplingTime, float scale )
+{
+    d->gain = deriv_fixp_gain( samplingTime, scale );
+    d->in  = 0;
+    d->out = 0;
+}
+
+int16_t deriv_q15_update( deriv_q15 *d, int16_t in )
+{
+    int64_t acc = ( int64_t ) d->gain * ( ( int32_t ) in - d->in );
+
+    d->in  = in;
+    d->out = fixp_sat_q15( fixp_sat_q31( fixp_round64( acc, 16 ) - d->out ) );
+
+    return d->out;
+}
+
+void deriv_q31_init( deriv_q31 *d, float samplingTime, float scale )
+{
+    d->gain = deriv_fixp_gain( samplingTime, scale );
+    d->in  = 0;
+    d->out = 0;
+}
+
+int32_t deriv_q31_update( deriv_q31 *d, int32_t in )
+{
+    int64_t diff = fixp_sat_q31( ( int64_t ) in - d->in );
+    int64_t acc = d->gain * diff;
+
+    d->in  = in;
+    d->out = fixp_sat_q31( fixp_round64( acc, 16 ) - d->out );
+
+    return d->out;
+}
@@ -0,0 +1,198 @@
+#include "main_LIP.h"
+#include "gain_sets.h"
+#include <math.h>
+
+#define DEG ( PI / 180.0f )
+
+/* Down position sets. */
+static const gain_set dpc_sets[] =
+{
+    /* Pendulum down, pm. 80 degree works very well with swingdown routine. */
+    { "default", { 44.721360f, 20.131541f, 5.820552f, -0.529622f }, 1.0f, 0.2f, 3.0f * DEG, 100.0f * DEG, 260.0f * DEG },
+    /* Half cart position gain, slower return to setpoint. */
+    { "soft",    { 22.360680f, 20.131541f, 5.820552f, -0.529622f }, 1.0f, 0.2f, 3.0f * DEG, 100.0f * DEG, 260.0f * DEG },
+};
+
+/* Up position sets, no dead bands. */
+static const gain_set upc_sets[] =
+{
+    { "default", { -74.5f,      -76.0f,      -51.5f,      -9.0f      }, 1.0f, 0.0f, 0.0f, -35.0f * DEG, 35.0f * DEG },
+    /* Gains from first test iteration. There is about 2cm error in cart position. */
+    { "first",   { -70.710678f, -76.351277f, -50.892920f, -9.096002f }, 1.0f, 0.0f, 0.0f, -35.0f * DEG, 35.0f * DEG },
+    { "stiff",   { -90.0f,      -76.0f,      -51.5f,      -9.0f      }, 1.0f, 0.0f, 0.0f, -35.0f * DEG, 35.0f * DEG },
+    { "damped",  { -74.5f,      -76.0f,      -40.5f,      -11.0f     }, 1.0f, 0.0f, 0.0f, -35.0f * DEG, 35.0f * DEG },
+};
+
+static const gain_set * const tables[ GAIN_SET_CTRLS ] = { dpc_sets, upc_sets };
+
+static const uint32_t table_len[ GAIN_SET_CTRLS ] =
+{
+    sizeof( dpc_sets ) / sizeof( dpc_sets[ 0 ] ),
+    sizeof( upc_sets ) / sizeof( upc_sets[ 0 ] )
+};
+
+/* Set calculated at runtime (LQR synthesis), one per controller, index
+table_len[ ctrl ] once loaded. Cli / lqr task post it, util task takes it. */
+static gain_set ram_active[ GAIN_SET_CTRLS ];
+static gain_set ram_posted[ GAIN_SET_CTRLS ];
+static volatile uint8_t ram_pending[ GAIN_SET_CTRLS ];
+static volatile uint8_t ram_loaded[ GAIN_SET_CTRLS ];
+
+/* Schedules used by the laws, written only by util task. */
+static gain_schedule active[ GAIN_SET_CTRLS ];
+
+/* Schedules posted by cli, pending flag set until util task takes them. */
+static gain_schedule posted[ GAIN_SET_CTRLS ];
+static volatile uint8_t pending[ GAIN_SET_CTRLS ];
+
+uint32_t gain_sets_count( enum gain_set_ctrls ctrl )
+{
+    return table_len[ ctrl ] + ( ram_loaded[ ctrl ] ? 1 : 0 );
+}
+
+/* Set used by the laws, util task only, it is the one writing ram_active. */
+static const gain_set *gain_sets_active( enum gain_set_ctrls ctrl, uint32_t index )
+{
+    if( index < table_len[ ctrl ] )
+    {
+        return &tables[ ctrl ][ index ];
+    }
+    return &ram_active[ ctrl ];
+}
+
+void gain_sets_get( enum gain_set_ctrls ctrl, uint32_t index, gain_set *out )
+{
+    if( index < table_len[ ctrl ] )
+    {
+        *out = tables[ ctrl ][ index ];
+        return;
+    }
+
+    /* Util task overwrites ram_active when it takes a posted set, a set that
+    is posted and not taken yet is the newest one. */
+    taskENTER_CRITICAL();
+    *out = ram_pending[ ctrl ] ? ram_posted[ ctrl ] : ram_active[ ctrl ];
+    taskEXIT_CRITICAL();
+}
+
+int32_t gain_sets_find( enum gain_set_ctrls ctrl, const char *name, uint32_t len )
+{
+    char ram_name[ GAIN_SET_NAME_LEN ];
+    uint8_t loaded;
+
+    /* Lqr task may post a new set while cli looks for a name. */
+    taskENTER_CRITICAL();
+    memcpy( ram_name, ram_posted[ ctrl ].name, GAIN_SET_NAME_LEN );
+    loaded = ram_loaded[ ctrl ];
+    taskEXIT_CRITICAL();
+
+    for( uint32_t i = 0; i < table_len[ ctrl ] + ( loaded ? 1 : 0 ); i++ )
+    {
+        const char *set_name = i < table_len[ ctrl ] ? tables[ ctrl ][ i ].name : ram_name;
+
+        if( len < GAIN_SET_NAME_LEN && strncmp( set_name, name, len ) == 0 && set_name[ len ] == '\0' )
+        {
+            return ( int32_t ) i;
+        }
+    }
+    return -1;
+}
+
+uint32_t gain_sets_load( enum gain_set_ctrls ctrl, const gain_set *set )
+{
+    taskENTER_CRITICAL();
+    ram_posted[ ctrl ] = *set;
+    ram_posted[ ctrl ].name[ GAIN_SET_NAME_LEN - 1 ] = '\0';
+    ram_pending[ ctrl ] = 1;
+    ram_loaded[ ctrl ] = 1;
+    taskEXIT_CRITICAL();
+
+    return table_len[ ctrl ];
+}
+
+uint8_t gain_sched_request( enum gain_set_ctrls ctrl, const gain_schedule *sched )
+{
+    uint32_t n_sets = gain_sets_count( ctrl );
+
+    if( sched->a >= n_sets ||
+        ( sched->var != GAIN_SCHED_NONE && ( sched->b >= n_sets || !( sched->hi > sched->lo ) ) ) )
+    {
+        return 1;
+    }
+
+    taskENTER_CRITICAL();
+    posted[ ctrl ] = *sched;
+    pending[ ctrl ] = 1;
+    taskEXIT_CRITICAL();
+
+    return 0;
+}
+
+void gain_sched_get( enum gain_set_ctrls ctrl, gain_schedule *out )
+{
+    taskENTER_CRITICAL();
+    *out = pending[ ctrl ] ? posted[ ctrl ] : active[ ctrl ];
+    taskEXIT_CRITICAL();
+}
+
+void gain_sched_tick( void )
+{
+    for( uint32_t c = 0; c < GAIN_SET_CTRLS; c++ )
+    {
+        /* Set first, a schedule posted with it may already use it. */
+        if( ram_pending[ c ] )
+        {
+            taskENTER_CRITICAL();
+            ram_active[ c ] = ram_posted[ c ];
+            ram_pending[ c ] = 0;
+            taskEXIT_CRITICAL();
+        }
+        if( pending[ c ] )
+        {
+            taskENTER_CRITICAL();
+            active[ c ] = posted[ c ];
+            pending[ c ] = 0;
+            taskEXIT_CRITICAL();
+        }
+    }
+}
+
+void gain_sched_eval( enum gain_set_ctrls ctrl, float cart_error_cm, float pend_error, gain_set *out )
+{
+    const gain_schedule *s = &active[ ctrl ];
+    const gain_set *a = gain_sets_active( ctrl, s->a );
+    const gain_set *b;
+    float v, w;
+
+    if( s->var == GAIN_SCHED_NONE )
+    {
+        *out = *a;
+        return;
+    }
+
+    b = gain_sets_active( ctrl, s->b );
+    v = fabsf( s->var == GAIN_SCHED_CART_ERROR ? cart_error_cm : pend_error );
+    if( v <= s->lo )
+    {
+        w = 0.0f;
+    }
+    else if( v >= s->hi )
+    {
+        w = 1.0f;
+    }
+    else
+    {
+        w = ( v - s->lo ) / ( s->hi - s->lo );
+    }
+
+    for( uint32_t k = 0; k < 4; k++ )
+    {
+        out->gains[ k ] = a->gains[ k ] + w * ( b->gains[ k ] - a->gains[ k ] );
+    }
+    out->voltage_deadzone      = a->voltage_deadzone + w * ( b->voltage_deadzone - a->voltage_deadzone );
+    out->cart_allowed_error_cm = a->cart_allowed_error_cm + w * ( b->cart_allowed_error_cm - a->cart_allowed_error_cm );
+    out->pend_allowed_error    = a->pend_allowed_error + w * ( b->pend_allowed_error - a->pend_allowed_error );
+    out->switch_angle_low      = fminf( a->switch_angle_low, b->switch_angle_low );
+    out->switch_angle_high     = fmaxf( a->switch_angle_high, b->switch_angle_high );
+    out->name[ 0 ] = '\0';
+}
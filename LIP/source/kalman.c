@@ -0,0 +1,205 @@
+#include "kalman.h"
+#include <math.h>
+
+/* Motor voltage without the deadzone of the driver and motor static friction. */
+static float kalman_deadzone( float voltage )
+{
+    if( voltage > KALMAN_VOLTAGE_DEADZONE )
+    {
+        return voltage - KALMAN_VOLTAGE_DEADZONE;
+    }
+    if( voltage < -KALMAN_VOLTAGE_DEADZONE )
+    {
+        return voltage + KALMAN_VOLTAGE_DEADZONE;
+    }
+    return 0.0f;
+}
+
+void kalman_init( kalman_filter *kf, float samplingTime )
+{
+    /* This function initializes kf Kalman filter, state is set by the first update. */
+    float dt = samplingTime;
+    float a  = KALMAN_CART_POLE;
+
+    kf->dt = dt;
+    kf->ea = expf( -a * dt );
+    kf->g1 = ( 1.0f - kf->ea ) / a;
+    kf->g2 = ( dt - kf->g1 ) / a;
+
+    /* Discrete process noise, diagonal approximation of white acceleration noise. */
+    kf->Q[ KALMAN_X ]    = KALMAN_Q_CART_ACC * KALMAN_Q_CART_ACC * dt * dt * dt / 3.0f;
+    kf->Q[ KALMAN_TH ]   = KALMAN_Q_PEND_ACC * KALMAN_Q_PEND_ACC * dt * dt * dt / 3.0f;
+    kf->Q[ KALMAN_DX ]   = KALMAN_Q_CART_ACC * KALMAN_Q_CART_ACC * dt;
+    kf->Q[ KALMAN_DTH ]  = KALMAN_Q_PEND_ACC * KALMAN_Q_PEND_ACC * dt;
+    kf->Q[ KALMAN_DIST ] = KALMAN_Q_DIST * KALMAN_Q_DIST * dt;
+
+    kf->initialized = 0;
+    kf->resets = 0;
+    kalman_reset( kf, 0.0f, 0.0f );
+}
+
+void kalman_reset( kalman_filter *kf, float cart_cm, float pend_rad )
+{
+    /* State is the measurement, speeds unknown. */
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        kf->x[ i ] = 0.0f;
+        for( uint32_t j = 0; j < KALMAN_N; j++ )
+        {
+            kf->P[ i ][ j ] = 0.0f;
+        }
+    }
+    kf->x[ KALMAN_X ]  = cart_cm;
+    kf->x[ KALMAN_TH ] = pend_rad;
+
+    kf->P[ KALMAN_X ][ KALMAN_X ]       = KALMAN_R_CART_CM * KALMAN_R_CART_CM;
+    kf->P[ KALMAN_TH ][ KALMAN_TH ]     = KALMAN_R_PEND_RAD * KALMAN_R_PEND_RAD;
+    kf->P[ KALMAN_DX ][ KALMAN_DX ]     = 100.0f;
+    kf->P[ KALMAN_DTH ][ KALMAN_DTH ]   = 10.0f;
+    kf->P[ KALMAN_DIST ][ KALMAN_DIST ] = KALMAN_Q_DIST * KALMAN_Q_DIST;
+
+    kf->initialized = 1;
+}
+
+void kalman_update( kalman_filter *kf, float voltage, float cart_cm, float pend_rad )
+{
+    /* This function calculates new state estimate. */
+    float F[ KALMAN_N ][ KALMAN_N ];
+    float FP[ KALMAN_N ][ KALMAN_N ];
+    float K[ KALMAN_N ][ 2 ];
+    float dt = kf->dt;
+    float *x = kf->x;
+    float force, dx_next, acc, dth_next;
+    float s, c, dacc_ddx, dacc_ddist, ddth_dth;
+    float e_x, e_th, S00, S01, S11, det;
+
+    if( !kf->initialized )
+    {
+        kalman_reset( kf, cart_cm, pend_rad );
+        return;
+    }
+
+    /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * Prediction, voltage was held over the last period.
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+    force    = KALMAN_CART_GAIN * kalman_deadzone( voltage ) + x[ KALMAN_DIST ];
+    dx_next  = kf->ea * x[ KALMAN_DX ] + kf->g1 * force;
+    acc      = ( dx_next - x[ KALMAN_DX ] ) / dt;
+    s        = sinf( x[ KALMAN_TH ] );
+    c        = cosf( x[ KALMAN_TH ] );
+    dth_next = x[ KALMAN_DTH ] + dt * ( KALMAN_PEND_W0_SQ * s
+                                       - KALMAN_PEND_COUPLING * c * acc
+                                       - KALMAN_PEND_DAMPING * x[ KALMAN_DTH ] );
+
+    /* Jacobian of the discrete model. */
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        for( uint32_t j = 0; j < KALMAN_N; j++ )
+        {
+            F[ i ][ j ] = 0.0f;
+        }
+    }
+    dacc_ddx   = ( kf->ea - 1.0f ) / dt;
+    dacc_ddist = kf->g1 / dt;
+
+    F[ KALMAN_X ][ KALMAN_X ]       = 1.0f;
+    F[ KALMAN_X ][ KALMAN_DX ]      = kf->g1;
+    F[ KALMAN_X ][ KALMAN_DIST ]    = kf->g2;
+    F[ KALMAN_DX ][ KALMAN_DX ]     = kf->ea;
+    F[ KALMAN_DX ][ KALMAN_DIST ]   = kf->g1;
+    F[ KALMAN_DIST ][ KALMAN_DIST ] = 1.0f;
+
+    F[ KALMAN_DTH ][ KALMAN_TH ]    = dt * ( KALMAN_PEND_W0_SQ * c + KALMAN_PEND_COUPLING * s * acc );
+    ddth_dth                        = 1.0f - dt * KALMAN_PEND_DAMPING;
+    F[ KALMAN_DTH ][ KALMAN_DTH ]   = ddth_dth;
+    F[ KALMAN_DTH ][ KALMAN_DX ]    = -dt * KALMAN_PEND_COUPLING * c * dacc_ddx;
+    F[ KALMAN_DTH ][ KALMAN_DIST ]  = -dt * KALMAN_PEND_COUPLING * c * dacc_ddist;
+
+    /* th_next = th + dt/2 * ( dth + dth_next ). */
+    F[ KALMAN_TH ][ KALMAN_TH ]     = 1.0f + 0.5f * dt * F[ KALMAN_DTH ][ KALMAN_TH ];
+    F[ KALMAN_TH ][ KALMAN_DTH ]    = 0.5f * dt * ( 1.0f + ddth_dth );
+    F[ KALMAN_TH ][ KALMAN_DX ]     = 0.5f * dt * F[ KALMAN_DTH ][ KALMAN_DX ];
+    F[ KALMAN_TH ][ KALMAN_DIST ]   = 0.5f * dt * F[ KALMAN_DTH ][ KALMAN_DIST ];
+
+    x[ KALMAN_X ]  += kf->g1 * x[ KALMAN_DX ] + kf->g2 * force;
+    x[ KALMAN_TH ] += 0.5f * dt * ( x[ KALMAN_DTH ] + dth_next );
+    x[ KALMAN_DX ]  = dx_next;
+    x[ KALMAN_DTH ] = dth_next;
+
+    /* P = F P F' + Q */
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        for( uint32_t j = 0; j < KALMAN_N; j++ )
+        {
+            FP[ i ][ j ] = 0.0f;
+            for( uint32_t k = 0; k < KALMAN_N; k++ )
+            {
+                FP[ i ][ j ] += F[ i ][ k ] * kf->P[ k ][ j ];
+            }
+        }
+    }
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        for( uint32_t j = i; j < KALMAN_N; j++ )
+        {
+            float sum = 0.0f;
+            for( uint32_t k = 0; k < KALMAN_N; k++ )
+            {
+                sum += FP[ i ][ k ] * F[ j ][ k ];
+            }
+            kf->P[ i ][ j ] = sum;
+            kf->P[ j ][ i ] = sum;
+        }
+        kf->P[ i ][ i ] += kf->Q[ i ];
+    }
+
+    /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+     * Correction, both encoders measure a state directly (H selects x and th).
+     * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+    e_x  = cart_cm - x[ KALMAN_X ];
+    e_th = pend_rad - x[ KALMAN_TH ];
+
+    if( fabsf( e_x ) > KALMAN_RESET_CART_CM || fabsf( e_th ) > KALMAN_RESET_PEND_RAD )
+    {
+        kf->resets++;
+        kalman_reset( kf, cart_cm, pend_rad );
+        return;
+    }
+
+    S00 = kf->P[ KALMAN_X ][ KALMAN_X ] + KALMAN_R_CART_CM * KALMAN_R_CART_CM;
+    S01 = kf->P[ KALMAN_X ][ KALMAN_TH ];
+    S11 = kf->P[ KALMAN_TH ][ KALMAN_TH ] + KALMAN_R_PEND_RAD * KALMAN_R_PEND_RAD;
+    det = S00 * S11 - S01 * S01;
+
+    /* K = P H' S^-1 */
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        float p0 = kf->P[ i ][ KALMAN_X ];
+        float p1 = kf->P[ i ][ KALMAN_TH ];
+        K[ i ][ 0 ] = (  p0 * S11 - p1 * S01 ) / det;
+        K[ i ][ 1 ] = ( -p0 * S01 + p1 * S00 ) / det;
+    }
+
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        x[ i ] += K[ i ][ 0 ] * e_x + K[ i ][ 1 ] * e_th;
+    }
+
+    /* P = ( I - K H ) P, rows of H P are rows x and th of P. */
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        for( uint32_t j = 0; j < KALMAN_N; j++ )
+        {
+            FP[ i ][ j ] = kf->P[ i ][ j ] - K[ i ][ 0 ] * kf->P[ KALMAN_X ][ j ] - K[ i ][ 1 ] * kf->P[ KALMAN_TH ][ j ];
+        }
+    }
+    for( uint32_t i = 0; i < KALMAN_N; i++ )
+    {
+        for( uint32_t j = i; j < KALMAN_N; j++ )
+        {
+            float sym = 0.5f * ( FP[ i ][ j ] + FP[ j ][ i ] );
+            kf->P[ i ][ j ] = sym;
+            kf->P[ j ][ i ] = sym;
+        }
+    }
+}
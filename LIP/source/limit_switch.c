@@ -0,0 +1,113 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Limit switches - interrupt driven motor cutoff at track ends, see limit_switch.h.
+ *
+ * Statistics are shared between the ISR and tasks, tasks update and read them
+ * inside critical sections, which also mask EXTI15_10 interrupt (NVIC priority 5
+ * is not above configMAX_SYSCALL_INTERRUPT_PRIORITY).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "main_LIP.h"
+#include "limit_switch.h"
+#include "ctrl_tick_driver.h"
+
+static limit_switch_stats stats;
+
+/* Task notified on every edge. */
+static TaskHandle_t handler_task = NULL;
+
+/* Clear statistics, call with EXTI interrupt masked. */
+static void limit_switch_clear( void )
+{
+    stats.edges       = 0;
+    stats.cutoff_min  = UINT32_MAX;
+    stats.cutoff_max  = 0;
+    stats.cutoff_sum  = 0;
+    stats.handled     = 0;
+    stats.handled_min = UINT32_MAX;
+    stats.handled_max = 0;
+    stats.handled_sum = 0;
+}
+
+void limit_switch_init( TaskHandle_t task )
+{
+    handler_task = task;
+    limit_switch_clear();
+}
+
+void limit_switch_isr( uint16_t GPIO_Pin )
+{
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t start = ctrl_tick_cycles();
+    uint32_t cutoff;
+    uint32_t edge;
+
+    if( GPIO_Pin == limitSW_left_Pin )
+    {
+        edge = LIMIT_SW_LEFT;
+    }
+    else if( GPIO_Pin == limitSW_right_Pin )
+    {
+        edge = LIMIT_SW_RIGHT;
+    }
+    else
+    {
+        return;
+    }
+
+    /* Zero voltage first, everything else can wait. */
+    dcm_stop_from_isr();
+    ctrl_select_law_from_isr( CTRL_LAW_NONE );
+
+    cutoff = ctrl_tick_cycles() - start;
+    if( cutoff < stats.cutoff_min )
+    {
+        stats.cutoff_min = cutoff;
+    }
+    if( cutoff > stats.cutoff_max )
+    {
+        stats.cutoff_max = cutoff;
+    }
+    stats.cutoff_sum += cutoff;
+    stats.edges++;
+    stats.last_edge = start;
+
+    if( handler_task != NULL )
+    {
+        xTaskNotifyIndexedFromISR( handler_task, LIMIT_SW_NOTIFY_INDEX, edge, eSetBits, &xHigherPriorityTaskWoken );
+    }
+
+    portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
+}
+
+void limit_switch_handled( void )
+{
+    uint32_t latency;
+
+    taskENTER_CRITICAL();
+    latency = ctrl_tick_cycles() - stats.last_edge;
+    if( latency < stats.handled_min )
+    {
+        stats.handled_min = latency;
+    }
+    if( latency > stats.handled_max )
+    {
+        stats.handled_max = latency;
+    }
+    stats.handled_sum += latency;
+    stats.handled++;
+    taskEXIT_CRITICAL();
+}
+
+void limit_switch_get_stats( limit_switch_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+void limit_switch_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    limit_switch_clear();
+    taskEXIT_CRITICAL();
+}
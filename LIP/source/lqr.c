@@ -0,0 +1,364 @@
+#include "lqr.h"
+#include <math.h>
+
+/* Taylor series terms of the matrix exponential, after scaling to norm <= 0.5. */
+#define LQR_EXP_TERMS   8
+
+/* Size of the augmented matrix [ Ac Bc; 0 0 ] of the discretization. */
+#define LQR_AUG         ( LQR_N + 1 )
+
+void lqr_cart_pendulum_model( const lqr_plant_params *p, uint8_t down,
+                              float Ac[ LQR_N ][ LQR_N ], float Bc[ LQR_N ] )
+{
+    /* This function fills the linearized continuous model, see lqr.h. */
+    float sgn = down ? -1.0f : 1.0f;
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            Ac[ i ][ j ] = 0.0f;
+        }
+    }
+
+    Ac[ 0 ][ 2 ] = 1.0f;
+    Ac[ 1 ][ 3 ] = 1.0f;
+
+    /* Cart, speed pole. */
+    Ac[ 2 ][ 2 ] = -p->cart_pole;
+
+    /* Pendulum, driven by the cart acceleration. */
+    Ac[ 3 ][ 1 ] =  sgn * p->pend_w0_sq;
+    Ac[ 3 ][ 2 ] =  sgn * p->pend_coupling * p->cart_pole;
+    Ac[ 3 ][ 3 ] = -p->pend_damping;
+
+    Bc[ 0 ] = 0.0f;
+    Bc[ 1 ] = 0.0f;
+    Bc[ 2 ] = p->cart_gain;
+    Bc[ 3 ] = -sgn * p->pend_coupling * p->cart_gain;
+}
+
+void lqr_discretize( const float Ac[ LQR_N ][ LQR_N ], const float Bc[ LQR_N ], float dt,
+                     float A[ LQR_N ][ LQR_N ], float B[ LQR_N ] )
+{
+    /* This function calculates exp( [ Ac Bc; 0 0 ] dt ) = [ A B; 0 1 ]. */
+    float M[ LQR_AUG ][ LQR_AUG ];
+    float E[ LQR_AUG ][ LQR_AUG ];
+    float T[ LQR_AUG ][ LQR_AUG ];
+    float X[ LQR_AUG ][ LQR_AUG ];
+    float norm = 0.0f;
+    uint32_t squarings = 0;
+    float scale;
+
+    for( uint32_t i = 0; i < LQR_AUG; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_AUG; j++ )
+        {
+            M[ i ][ j ] = 0.0f;
+        }
+    }
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        float row = fabsf( Bc[ i ] * dt );
+
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            M[ i ][ j ] = Ac[ i ][ j ] * dt;
+            row += fabsf( M[ i ][ j ] );
+        }
+        M[ i ][ LQR_N ] = Bc[ i ] * dt;
+        norm = fmaxf( norm, row );
+    }
+
+    /* Scale to infinity norm <= 0.5. */
+    scale = 1.0f;
+    while( norm * scale > 0.5f && squarings < 30 )
+    {
+        scale *= 0.5f;
+        squarings++;
+    }
+
+    /* E = I + M + M^2/2! + ..., T is the last term. */
+    for( uint32_t i = 0; i < LQR_AUG; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_AUG; j++ )
+        {
+            M[ i ][ j ] *= scale;
+            E[ i ][ j ] = ( i == j ) ? 1.0f : 0.0f;
+            T[ i ][ j ] = E[ i ][ j ];
+        }
+    }
+    for( uint32_t k = 1; k <= LQR_EXP_TERMS; k++ )
+    {
+        for( uint32_t i = 0; i < LQR_AUG; i++ )
+        {
+            for( uint32_t j = 0; j < LQR_AUG; j++ )
+            {
+                float sum = 0.0f;
+
+                for( uint32_t l = 0; l < LQR_AUG; l++ )
+                {
+                    sum += T[ i ][ l ] * M[ l ][ j ];
+                }
+                X[ i ][ j ] = sum / ( float ) k;
+            }
+        }
+        for( uint32_t i = 0; i < LQR_AUG; i++ )
+        {
+            for( uint32_t j = 0; j < LQR_AUG; j++ )
+            {
+                T[ i ][ j ] = X[ i ][ j ];
+                E[ i ][ j ] += X[ i ][ j ];
+            }
+        }
+    }
+
+    /* Undo scaling, exp( M ) = exp( M / 2^s )^( 2^s ). */
+    for( uint32_t s = 0; s < squarings; s++ )
+    {
+        for( uint32_t i = 0; i < LQR_AUG; i++ )
+        {
+            for( uint32_t j = 0; j < LQR_AUG; j++ )
+            {
+                float sum = 0.0f;
+
+                for( uint32_t l = 0; l < LQR_AUG; l++ )
+                {
+                    sum += E[ i ][ l ] * E[ l ][ j ];
+                }
+                X[ i ][ j ] = sum;
+            }
+        }
+        for( uint32_t i = 0; i < LQR_AUG; i++ )
+        {
+            for( uint32_t j = 0; j < LQR_AUG; j++ )
+            {
+                E[ i ][ j ] = X[ i ][ j ];
+            }
+        }
+    }
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            A[ i ][ j ] = E[ i ][ j ];
+        }
+        B[ i ] = E[ i ][ LQR_N ];
+    }
+}
+
+void lqr_init( lqr_solver *s, const float A[ LQR_N ][ LQR_N ], const float B[ LQR_N ],
+               const float Q[ LQR_N ], float R )
+{
+    /* This function sets up the doubling iterates, A0 = A, G0 = B R^-1 B', H0 = Q. */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            s->A[ i ][ j ]  = A[ i ][ j ];
+            s->Ak[ i ][ j ] = A[ i ][ j ];
+            s->G[ i ][ j ]  = B[ i ] * B[ j ] / R;
+            s->H[ i ][ j ]  = ( i == j ) ? Q[ i ] : 0.0f;
+        }
+        s->B[ i ] = B[ i ];
+        s->Q[ i ] = Q[ i ];
+    }
+    s->R = R;
+
+    s->steps = 0;
+    s->change = 1.0f;
+    s->converged = 0;
+    s->failed = !( R > 0.0f );
+}
+
+uint8_t lqr_step( lqr_solver *s )
+{
+    /* This function runs one doubling step. W X = [ A G ] is solved by Gauss
+    elimination with partial pivoting, X1 = W^-1 A and X2 = W^-1 G. */
+    float W[ LQR_N ][ 3 * LQR_N ];
+    float An[ LQR_N ][ LQR_N ];
+    float Gn[ LQR_N ][ LQR_N ];
+    float Hn[ LQR_N ][ LQR_N ];
+    float T[ LQR_N ][ LQR_N ];
+    float diff = 0.0f;
+    float size = 0.0f;
+
+    if( s->converged || s->failed )
+    {
+        return 1;
+    }
+
+    /* [ I + G H | A | G ] */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            float sum = ( i == j ) ? 1.0f : 0.0f;
+
+            for( uint32_t l = 0; l < LQR_N; l++ )
+            {
+                sum += s->G[ i ][ l ] * s->H[ l ][ j ];
+            }
+            W[ i ][ j ] = sum;
+            W[ i ][ LQR_N + j ] = s->Ak[ i ][ j ];
+            W[ i ][ 2 * LQR_N + j ] = s->G[ i ][ j ];
+        }
+    }
+
+    for( uint32_t c = 0; c < LQR_N; c++ )
+    {
+        uint32_t pivot = c;
+        float inv;
+
+        for( uint32_t i = c + 1; i < LQR_N; i++ )
+        {
+            if( fabsf( W[ i ][ c ] ) > fabsf( W[ pivot ][ c ] ) )
+            {
+                pivot = i;
+            }
+        }
+        if( !( fabsf( W[ pivot ][ c ] ) > 1.0e-12f ) )
+        {
+            s->failed = 1;
+            return 1;
+        }
+        if( pivot != c )
+        {
+            for( uint32_t j = 0; j < 3 * LQR_N; j++ )
+            {
+                float tmp = W[ c ][ j ];
+
+                W[ c ][ j ] = W[ pivot ][ j ];
+                W[ pivot ][ j ] = tmp;
+            }
+        }
+
+        inv = 1.0f / W[ c ][ c ];
+        for( uint32_t j = c; j < 3 * LQR_N; j++ )
+        {
+            W[ c ][ j ] *= inv;
+        }
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            float f = W[ i ][ c ];
+
+            if( i == c || f == 0.0f )
+            {
+                continue;
+            }
+            for( uint32_t j = c; j < 3 * LQR_N; j++ )
+            {
+                W[ i ][ j ] -= f * W[ c ][ j ];
+            }
+        }
+    }
+
+    /* An = A X1, T = A X2, Gn = G + T A', Hn = H + A' H X1. */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            float a = 0.0f;
+            float t = 0.0f;
+            float h = 0.0f;
+
+            for( uint32_t l = 0; l < LQR_N; l++ )
+            {
+                a += s->Ak[ i ][ l ] * W[ l ][ LQR_N + j ];
+                t += s->Ak[ i ][ l ] * W[ l ][ 2 * LQR_N + j ];
+                h += s->H[ i ][ l ] * W[ l ][ LQR_N + j ];
+            }
+            An[ i ][ j ] = a;
+            Gn[ i ][ j ] = t;
+            Hn[ i ][ j ] = h;
+        }
+    }
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            float g = 0.0f;
+            float h = 0.0f;
+
+            for( uint32_t l = 0; l < LQR_N; l++ )
+            {
+                g += Gn[ i ][ l ] * s->Ak[ j ][ l ];
+                h += s->Ak[ l ][ i ] * Hn[ l ][ j ];
+            }
+            T[ i ][ j ] = g;
+            W[ i ][ j ] = h;
+        }
+    }
+
+    /* Symmetric parts, rounding makes G and H drift from symmetric. */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            float g = s->G[ i ][ j ] + 0.5f * ( T[ i ][ j ] + T[ j ][ i ] );
+            float h = s->H[ i ][ j ] + 0.5f * ( W[ i ][ j ] + W[ j ][ i ] );
+
+            diff = fmaxf( diff, fabsf( h - s->H[ i ][ j ] ) );
+            size = fmaxf( size, fabsf( h ) );
+            Gn[ i ][ j ] = g;
+            Hn[ i ][ j ] = h;
+        }
+    }
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            s->Ak[ i ][ j ] = An[ i ][ j ];
+            s->G[ i ][ j ]  = Gn[ i ][ j ];
+            s->H[ i ][ j ]  = Hn[ i ][ j ];
+        }
+    }
+
+    s->steps++;
+    s->change = diff / size;
+    if( !isfinite( s->change ) )
+    {
+        s->failed = 1;
+    }
+    else if( s->change < LQR_TOLERANCE )
+    {
+        s->converged = 1;
+    }
+    else if( s->steps >= LQR_MAX_STEPS )
+    {
+        s->failed = 1;
+    }
+
+    return s->converged || s->failed;
+}
+
+void lqr_gain( const lqr_solver *s, float K[ LQR_N ] )
+{
+    /* This function calculates K = ( R + B' P B )^-1 B' P A. */
+    float PB[ LQR_N ];
+    float den = s->R;
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        float sum = 0.0f;
+
+        for( uint32_t l = 0; l < LQR_N; l++ )
+        {
+            sum += s->H[ i ][ l ] * s->B[ l ];
+        }
+        PB[ i ] = sum;
+        den += s->B[ i ] * sum;
+    }
+    for( uint32_t j = 0; j < LQR_N; j++ )
+    {
+        float sum = 0.0f;
+
+        for( uint32_t l = 0; l < LQR_N; l++ )
+        {
+            sum += PB[ l ] * s->A[ l ][ j ];
+        }
+        K[ j ] = sum / den;
+    }
+}
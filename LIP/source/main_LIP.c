@@ -7,9 +7,7 @@
 // #define READ_ZERO_POSITION_REACHED HAL_GPIO_ReadPin( limitSW_left_GPIO_Port, limitSW_left_Pin )
 // #define READ_MAX_POSITION_REACHED HAL_GPIO_ReadPin( limitSW_right_GPIO_Port, limitSW_right_Pin )
 
-extern ADC_HandleTypeDef hadc3;
-extern volatile uint16_t adc_data_pot;
-extern float pend_init_angle_offset;
+extern int32_t pend_init_count_sum;
 
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  * LIP INIT & RUN
@@ -21,28 +19,31 @@ void main_LIP_init( void )
                                                  // FPU must be enabled before any FPU
                                                  // instruction is executed, otherwise
                                                  // hardware exception will be raised.
-    HAL_TIM_Base_Start( &htim2 );                // Start timer for ADC3 pot read
-    HAL_ADC_Start_DMA(
-        &hadc3, (uint32_t *) &adc_data_pot, 1 ); // init dma for adc
+    pot_adc_init();                              // ADC3 pot bursts, triggered by control tick
     dcm_init();                                  // Initialize PWM timer and zero its PWM output
     enc_init();                                  // Initialize encoder timer
     pend_enc_init();                             // Initialize AS5600 encoder
 
-    pend_init_angle_offset = (float) pend_enc_get_cumulative_count() / 4096.0f * PI2 - PI;
+    pend_init_count_sum = ( pend_enc_get_cumulative_count() - PEND_ENC_COUNTS_PER_REV / 2 ) * PEND_ENC_AVG_LEN;
 }
 void main_LIP_run( void )
 {
     LIP_create_Tasks();
+    ctrl_tick_start();                           // Start TIM7 control tick, its interrupt
+                                                 // stays masked until scheduler starts
+    pend_enc_sampling_start();                   // Start AS5600 background i2c reads
     vTaskStartScheduler();
 
     for (;;) { /* void */ }
 }
 
-/* Built in button interrupt callback function. */
+/* Built in button and limit switches interrupt callback function (EXTI15_10). */
 // uint8_t ZERO_POSITION_REACHED = 0;  // 1 only if left limit switch activated
 // uint8_t MAX_POSITION_REACHED = 0;   // 1 only if right limit switch activated
 void HAL_GPIO_EXTI_Callback( uint16_t GPIO_Pin )
 {
+    /* Zero motor voltage right away, state change is done by limit switch task. */
+    limit_switch_isr( GPIO_Pin );
 }
 
 /* Uart receive interrupt */
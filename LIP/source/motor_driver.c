@@ -49,6 +49,19 @@ void dcm_zero_output_voltage(void)
     dcm_set_ch2_dutycycle( 0 );
 }
 
+/*
+ * Function to zero the output voltage immediately, used by limit switch interrupt
+ * Compare registers are preloaded, update event is generated so that zero
+ * dutycycle is applied now and not at the end of current PWM period
+ */
+void dcm_stop_from_isr( void )
+{
+    dcm_set_ch1_dutycycle( 0 );
+    dcm_set_ch2_dutycycle( 0 );
+    __HAL_TIM_GENERATE_EVENT( &TIMER_HANDLE, TIM_EVENTSOURCE_UPDATE );
+    dutycycle = 0.0f;
+}
+
 /*
  * Function to set output voltage in range [-12, 12]V
  */
@@ -0,0 +1,332 @@
+#include "mpc.h"
+#include <math.h>
+
+/* Coefficient of block j in position at tick k ( x_k[ 0 ], k >= 1 ). */
+static inline float mpc_pos_coef( const mpc_controller *m, uint32_t k, uint32_t j )
+{
+    return ( k > j * MPC_BLOCK ) ? m->r[ k - j * MPC_BLOCK ][ 0 ] : 0.0f;
+}
+
+/* Coefficient of block j in input row k ( u_k = -K x_k + v_k, k >= 0 ). */
+static inline float mpc_u_coef( const mpc_controller *m, uint32_t k, uint32_t j )
+{
+    float c = ( k > j * MPC_BLOCK ) ? -m->kr[ k - j * MPC_BLOCK ] : 0.0f;
+
+    return ( k / MPC_BLOCK == j ) ? c + 1.0f : c;
+}
+
+/* Blocks that can change row k. */
+static inline uint32_t mpc_row_moves( uint32_t k )
+{
+    uint32_t n = k / MPC_BLOCK + 1;
+
+    return n < MPC_MOVES ? n : MPC_MOVES;
+}
+
+static inline float mpc_clamp( float r, float lo, float hi )
+{
+    return r < lo ? lo : r > hi ? hi : r;
+}
+
+void mpc_init( mpc_controller *m, const float A[ MPC_N ][ MPC_N ], const float B[ MPC_N ] )
+{
+    /* This function sets the model, feedback, duals and perturbation are zeroed. */
+    float K[ MPC_N ] = { 0.0f };
+
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        for( uint32_t j = 0; j < MPC_N; j++ )
+        {
+            m->A[ i ][ j ] = A[ i ][ j ];
+        }
+        m->B[ i ] = B[ i ];
+    }
+    /* Forces rebuild in mpc_set_gain(). */
+    m->gain_valid = 0;
+    for( uint32_t k = 0; k < MPC_POS_ROWS; k++ )
+    {
+        m->y_pos[ k ] = 0.0f;
+    }
+    for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+    {
+        m->y_u[ k ] = 0.0f;
+    }
+    for( uint32_t j = 0; j < MPC_MOVES; j++ )
+    {
+        m->v[ j ] = 0.0f;
+    }
+    m->sweeps = 0;
+    m->active = 0;
+    m->converged = 1;
+
+    mpc_set_gain( m, K );
+}
+
+void mpc_set_gain( mpc_controller *m, const float K[ MPC_N ] )
+{
+    /* This function rebuilds block response and row norms for a new feedback. */
+    uint8_t same = m->gain_valid;
+
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        if( m->K[ i ] != K[ i ] )
+        {
+            same = 0;
+        }
+    }
+    if( same )
+    {
+        return;
+    }
+    m->gain_valid = 1;
+
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        m->K[ i ] = K[ i ];
+        for( uint32_t j = 0; j < MPC_N; j++ )
+        {
+            m->Phi[ i ][ j ] = m->A[ i ][ j ] - m->B[ i ] * K[ j ];
+        }
+    }
+
+    /* r[ d + 1 ] = Phi r[ d ] + B during the block. */
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        m->r[ 0 ][ i ] = 0.0f;
+    }
+    m->kr[ 0 ] = 0.0f;
+    for( uint32_t d = 0; d < MPC_HORIZON; d++ )
+    {
+        float kr = 0.0f;
+
+        for( uint32_t i = 0; i < MPC_N; i++ )
+        {
+            float sum = ( d < MPC_BLOCK ) ? m->B[ i ] : 0.0f;
+
+            for( uint32_t j = 0; j < MPC_N; j++ )
+            {
+                sum += m->Phi[ i ][ j ] * m->r[ d ][ j ];
+            }
+            m->r[ d + 1 ][ i ] = sum;
+            kr += K[ i ] * sum;
+        }
+        m->kr[ d + 1 ] = kr;
+    }
+
+    for( uint32_t i = 0; i < MPC_POS_ROWS; i++ )
+    {
+        uint32_t k = ( i + 1 ) * MPC_POS_STEP;
+        float a = 0.0f;
+
+        for( uint32_t j = 0; j < mpc_row_moves( k ); j++ )
+        {
+            float c = mpc_pos_coef( m, k, j );
+
+            a += c * c;
+        }
+        m->a_pos[ i ] = a;
+    }
+    for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+    {
+        float a = 0.0f;
+
+        for( uint32_t j = 0; j < mpc_row_moves( k ); j++ )
+        {
+            float c = mpc_u_coef( m, k, j );
+
+            a += c * c;
+        }
+        m->a_u[ k ] = a;
+    }
+}
+
+float mpc_solve( mpc_controller *m, const float x[ MPC_N ], float pos_min, float pos_max, float u_max )
+{
+    /* This function solves the QP for state x and returns the first input. */
+    float xk[ MPC_N ];
+    float xn[ MPC_N ];
+    uint32_t sweep;
+
+    /* Free response. */
+    for( uint32_t i = 0; i < MPC_N; i++ )
+    {
+        xk[ i ] = x[ i ];
+    }
+    for( uint32_t k = 0; k < MPC_HORIZON; k++ )
+    {
+        if( k < MPC_U_ROWS )
+        {
+            float u = 0.0f;
+
+            for( uint32_t i = 0; i < MPC_N; i++ )
+            {
+                u -= m->K[ i ] * xk[ i ];
+            }
+            m->c_u[ k ] = u;
+        }
+        for( uint32_t i = 0; i < MPC_N; i++ )
+        {
+            float sum = 0.0f;
+
+            for( uint32_t j = 0; j < MPC_N; j++ )
+            {
+                sum += m->Phi[ i ][ j ] * xk[ j ];
+            }
+            xn[ i ] = sum;
+        }
+        for( uint32_t i = 0; i < MPC_N; i++ )
+        {
+            xk[ i ] = xn[ i ];
+        }
+        if( ( k + 1 ) % MPC_POS_STEP == 0 )
+        {
+            m->c_pos[ ( k + 1 ) / MPC_POS_STEP - 1 ] = xk[ 0 ];
+        }
+    }
+
+    /* Warm start, duals of the last tick, input duals shifted by one tick
+    (position rows are MPC_POS_STEP ticks apart and kept), v = -M' y. */
+    for( uint32_t k = 0; k + 1 < MPC_U_ROWS; k++ )
+    {
+        m->y_u[ k ] = m->y_u[ k + 1 ];
+    }
+    m->y_u[ MPC_U_ROWS - 1 ] = 0.0f;
+
+    for( uint32_t j = 0; j < MPC_MOVES; j++ )
+    {
+        m->v[ j ] = 0.0f;
+    }
+    for( uint32_t i = 0; i < MPC_POS_ROWS; i++ )
+    {
+        uint32_t k = ( i + 1 ) * MPC_POS_STEP;
+        float y = m->y_pos[ i ];
+
+        if( y != 0.0f )
+        {
+            for( uint32_t j = 0; j < mpc_row_moves( k ); j++ )
+            {
+                m->v[ j ] -= y * mpc_pos_coef( m, k, j );
+            }
+        }
+    }
+    for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+    {
+        float y = m->y_u[ k ];
+
+        if( y != 0.0f )
+        {
+            for( uint32_t j = 0; j < mpc_row_moves( k ); j++ )
+            {
+                m->v[ j ] -= y * mpc_u_coef( m, k, j );
+            }
+        }
+    }
+
+    /* Sweeps, converged when no row was violated by more than the tolerance. */
+    m->converged = 0;
+    for( sweep = 0; sweep < MPC_MAX_SWEEPS && !m->converged; sweep++ )
+    {
+        uint8_t violated = 0;
+
+        for( uint32_t i = 0; i < MPC_POS_ROWS; i++ )
+        {
+            uint32_t k = ( i + 1 ) * MPC_POS_STEP;
+            uint32_t n = mpc_row_moves( k );
+            float a = m->a_pos[ i ];
+            float r = m->c_pos[ i ];
+            float rm, y, dy;
+
+            if( !( a > 0.0f ) )
+            {
+                continue;
+            }
+            for( uint32_t j = 0; j < n; j++ )
+            {
+                r += mpc_pos_coef( m, k, j ) * m->v[ j ];
+            }
+            if( fabsf( r - mpc_clamp( r, pos_min, pos_max ) ) > MPC_TOL_POS )
+            {
+                violated = 1;
+            }
+
+            rm = r + a * m->y_pos[ i ];
+            y  = ( rm - mpc_clamp( rm, pos_min, pos_max ) ) / a;
+            dy = y - m->y_pos[ i ];
+            if( dy != 0.0f )
+            {
+                for( uint32_t j = 0; j < n; j++ )
+                {
+                    m->v[ j ] -= dy * mpc_pos_coef( m, k, j );
+                }
+                m->y_pos[ i ] = y;
+            }
+        }
+
+        for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+        {
+            uint32_t n = mpc_row_moves( k );
+            float a = m->a_u[ k ];
+            float r = m->c_u[ k ];
+            float rm, y, dy;
+
+            if( !( a > 0.0f ) )
+            {
+                continue;
+            }
+            for( uint32_t j = 0; j < n; j++ )
+            {
+                r += mpc_u_coef( m, k, j ) * m->v[ j ];
+            }
+            if( fabsf( r - mpc_clamp( r, -u_max, u_max ) ) > MPC_TOL_U )
+            {
+                violated = 1;
+            }
+
+            rm = r + a * m->y_u[ k ];
+            y  = ( rm - mpc_clamp( rm, -u_max, u_max ) ) / a;
+            dy = y - m->y_u[ k ];
+            if( dy != 0.0f )
+            {
+                for( uint32_t j = 0; j < n; j++ )
+                {
+                    m->v[ j ] -= dy * mpc_u_coef( m, k, j );
+                }
+                m->y_u[ k ] = y;
+            }
+        }
+
+        m->converged = !violated;
+    }
+    m->sweeps = sweep;
+
+    /* Infeasible problem (cart too fast to stop before the limit) makes duals
+    grow every sweep, start from zero next time once the correction is beyond
+    any usable voltage. */
+    if( !( fabsf( m->v[ 0 ] ) <= MPC_V_LIMIT ) )
+    {
+        for( uint32_t k = 0; k < MPC_POS_ROWS; k++ )
+        {
+            m->y_pos[ k ] = 0.0f;
+        }
+        for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+        {
+            m->y_u[ k ] = 0.0f;
+        }
+        for( uint32_t j = 0; j < MPC_MOVES; j++ )
+        {
+            m->v[ j ] = 0.0f;
+        }
+    }
+
+    m->active = 0;
+    for( uint32_t k = 0; k < MPC_POS_ROWS; k++ )
+    {
+        m->active += ( m->y_pos[ k ] != 0.0f );
+    }
+    for( uint32_t k = 0; k < MPC_U_ROWS; k++ )
+    {
+        m->active += ( m->y_u[ k ] != 0.0f );
+    }
+
+    return mpc_clamp( m->c_u[ 0 ] + m->v[ 0 ], -u_max, u_max );
+}
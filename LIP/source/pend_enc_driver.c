@@ -9,17 +9,45 @@
  *             PB9 for i2c1 sda (alias I2C1_SDA)
  *
  * The code is almost the same as in driver_as5600_basic.c/h
+ *
+ * After pend_enc_sampling_start() the RAW ANGLE register is read in the
+ * background, i2c1 runs at 400kHz (fast mode, max for STM32F4 i2c) in interrupt
+ * mode (I2C1_EV, I2C1_ER at NVIC priority 5). Transfer complete callback pushes
+ * the sample to pend_enc_sampler.h and starts the next transfer right away
+ * (about 120us per 2 byte register read), so the newest sample is never older
+ * than one transfer. Functions below only read the newest sample, they never
+ * wait on the bus. Blocking as5600 driver functions can be used only before
+ * sampling is started.
+ *
+ * If the transfer chain stops (bus error with SDA held low, lost interrupt),
+ * pend_enc_sampling_check() reinitializes i2c1 and starts it again.
  * 
  */
 
 #include "pend_enc_driver.h"
+#include "pend_enc_sampler.h"
+#include "i2c.h"
+
+/* AS5600 i2c address (8 bit form for HAL) and RAW ANGLE high byte register. */
+#define PEND_ENC_I2C_ADDRESS        0x6C
+#define PEND_ENC_REG_RAW_ANGLE_H    0x0C
+
+/* Polls of CR1 STOP in the transfer complete callback. STOP condition takes
+about 2.5us at 400kHz (420 cycles at 168MHz), the bound is about 10 times that. */
+#define PEND_ENC_STOP_WAIT_LOOPS    1000
 
 static as5600_handle_t gs_handle;
 
+/* Receive buffer of background transfer. */
+static uint8_t rx_buf[ 2 ];
+
+/* Set while background transfer chain is running. */
+static volatile uint8_t sampling_on = 0;
+
+/* Sample sequence number seen by the last pend_enc_sampling_check(). */
+static uint32_t check_seq = 0;
+
 static uint16_t angle_raw = 0;
-static int32_t cumulative_count = 0;
-static uint16_t last_count = 0;
-static int32_t num_of_revolutions = 0;
 
 uint8_t pend_enc_init( void )
 {
@@ -41,23 +69,120 @@ uint8_t pend_enc_init( void )
        
         return 1;
     }
+
+    /* Blocking read of the first sample, so there is a valid sample before
+    background sampling is started. */
+    pend_enc_sampler_init();
+    as5600_get_raw_angle( &gs_handle, &angle_raw );
+    pend_enc_sampler_push( angle_raw );
+
     return 0;
 }
 
+/* Start background transfer chain, called from task. */
+static void pend_enc_transfer_start( void )
+{
+    /* HAL_I2C_Mem_Read_IT() busy waits up to 25ms for a busy bus, don't start
+    the transfer at all, pend_enc_sampling_check() will recover the bus. */
+    if( __HAL_I2C_GET_FLAG( &hi2c1, I2C_FLAG_BUSY ) ||
+        HAL_I2C_Mem_Read_IT( &hi2c1, PEND_ENC_I2C_ADDRESS, PEND_ENC_REG_RAW_ANGLE_H,
+                             I2C_MEMADD_SIZE_8BIT, rx_buf, 2 ) != HAL_OK )
+    {
+        sampling_on = 0;
+    }
+}
+
+/* Start next background transfer from i2c interrupt. HAL calls the callbacks
+right after it requests STOP, BUSY is still set until the STOP condition is on
+the bus (CR1 STOP is cleared then), so wait for it a bounded time instead of
+testing BUSY. A STOP that doesn't finish stops the chain, the watchdog task
+recovers the bus. */
+static void pend_enc_transfer_restart( void )
+{
+    uint32_t n = PEND_ENC_STOP_WAIT_LOOPS;
+
+    while( ( hi2c1.Instance->CR1 & I2C_CR1_STOP ) && --n )
+    {
+    }
+
+    if( n == 0 ||
+        HAL_I2C_Mem_Read_IT( &hi2c1, PEND_ENC_I2C_ADDRESS, PEND_ENC_REG_RAW_ANGLE_H,
+                             I2C_MEMADD_SIZE_8BIT, rx_buf, 2 ) != HAL_OK )
+    {
+        sampling_on = 0;
+    }
+}
+
+void pend_enc_sampling_start( void )
+{
+    check_seq = pend_enc_sampler_seq();
+    sampling_on = 1;
+    pend_enc_transfer_start();
+}
+
+void pend_enc_sampling_check( void )
+{
+    uint32_t seq = pend_enc_sampler_seq();
+
+    /* No new sample since the last check, chain is stopped or stuck. */
+    if( !sampling_on || seq == check_seq )
+    {
+        sampling_on = 0;
+
+        /* MspDeInit disables i2c1 interrupts, HAL_I2C_Init() resets the
+        peripheral (SWRST) and MspInit enables the interrupts again. */
+        HAL_I2C_DeInit( &hi2c1 );
+        MX_I2C1_Init();
+        pend_enc_sampler_restarted();
+
+        sampling_on = 1;
+        pend_enc_transfer_start();
+    }
+    check_seq = seq;
+}
+
+void HAL_I2C_MemRxCpltCallback( I2C_HandleTypeDef *hi2c )
+{
+    if( hi2c == &hi2c1 )
+    {
+        pend_enc_sampler_push( ( uint16_t ) ( ( ( rx_buf[ 0 ] & 0x0F ) << 8 ) | rx_buf[ 1 ] ) );
+        if( sampling_on )
+        {
+            pend_enc_transfer_restart();
+        }
+    }
+}
+
+void HAL_I2C_ErrorCallback( I2C_HandleTypeDef *hi2c )
+{
+    if( hi2c == &hi2c1 )
+    {
+        pend_enc_sampler_error();
+        if( sampling_on )
+        {
+            pend_enc_transfer_restart();
+        }
+    }
+}
+
 uint8_t pend_enc_read_angle_deg( float *angle )
 {
+    pend_enc_sample sample;
+
     /* Writes angle value in degree into &angle */
-    as5600_read( &gs_handle, &angle_raw, angle );
+    pend_enc_sampler_read( &sample );
+    *angle = ( float ) sample.raw * ( 360.0f / 4096.0f );
 
     return 0;
 }
 
 uint8_t pend_enc_read_angle_rad( float *angle )
 {
-    /* Writes raw angle value into &angle_raw */
-    as5600_get_raw_angle( &gs_handle, &angle_raw );
+    pend_enc_sample sample;
 
-    *angle = ( float ) angle_raw * 0.001533980788; // 0.001533980788 = 1 / 4096.0f * PI2;
+    /* Writes raw angle value into &angle */
+    pend_enc_sampler_read( &sample );
+    *angle = ( float ) sample.raw * 0.001533980788; // 0.001533980788 = 1 / 4096.0f * PI2;
     
     return 0;
 }
@@ -74,41 +199,51 @@ uint8_t pend_enc_deinit( void )
     }
 }
 
-/* Have to be called often enough, at least 3 times per revolution (from some arduino library) */
+/* Unwrapped count of the newest sample, unwrapping runs at sample rate
+in pend_enc_sampler_push(). */
 int32_t pend_enc_get_cumulative_count( void )
 {
-    // as5600_read_raw_fast(&gs_handle, &angle_raw);
-    as5600_get_raw_angle(&gs_handle, &angle_raw);
-    if ( ( last_count > 2048 ) && ( angle_raw < (last_count - 2048) ) )
-    {
-        cumulative_count = cumulative_count + 4096 - last_count + angle_raw;
-        // REMOVE IT
-        num_of_revolutions += 1;
-    }
-    else if ( ( angle_raw > 2048 ) && ( last_count < ( angle_raw - 2048 ) ) )
-    {
-        cumulative_count = cumulative_count - 4096 - last_count + angle_raw;
-        // REMOVE IT
-        num_of_revolutions -= 1;
-    }
-    else
-    {
-        cumulative_count = cumulative_count - last_count + angle_raw;
-    }
-    last_count = angle_raw;
-    
-    return cumulative_count;
+    pend_enc_sample sample;
+
+    /* Newest sample from background transfer, no bus access here. */
+    pend_enc_sampler_read( &sample );
+
+    return sample.count;
+}
+
+/* Mean unwrapped count of the last PEND_ENC_AVG_LEN samples. */
+float pend_enc_get_cumulative_count_avg( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+
+    return pend_enc_sample_avg_count( &sample );
+}
+
+/* Sum of unwrapped counts of the last PEND_ENC_AVG_LEN samples. */
+int32_t pend_enc_get_cumulative_count_sum( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+
+    return pend_enc_sample_sum_count( &sample );
 }
 
 int32_t pend_enc_get_base_count( void )
 {
-    as5600_get_raw_angle(&gs_handle, &angle_raw);
-    return angle_raw;
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    return sample.raw;
 }
 
 /* Get number of full pendulum revolutions, negative number indicates negative revolution. */
-// REMOVE IT
 int32_t get_num_of_revolutions( void )
 {
-    return num_of_revolutions;
-}
\ No newline at end of file
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    return sample.revolutions;
+}
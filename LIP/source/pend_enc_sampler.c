@@ -0,0 +1,191 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Pendulum encoder sampler - newest AS5600 raw angle sample, double buffered,
+ * see pend_enc_sampler.h.
+ *
+ * Push runs in the I2C interrupt (NVIC priority 5), tasks update their part of
+ * the statistics inside critical sections, which mask it.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "main_LIP.h"
+#include "pend_enc_sampler.h"
+#include "ctrl_tick_driver.h"
+
+/* Double buffer, published is the index of the newest complete sample. */
+static volatile pend_enc_sample buffer[ 2 ];
+static volatile uint32_t published = 0;
+static uint32_t seq = 0;
+
+/* Unwrapping state, last raw angle starts at 0 (first sample above 2048
+counts is taken as negative revolution, same as the old polled unwrapping). */
+static uint16_t last_raw = 0;
+static int32_t count = 0;
+static int32_t revolutions = 0;
+
+/* Last PEND_ENC_AVG_LEN unwrapped counts and their sum. */
+static int32_t avg_ring[ PEND_ENC_AVG_LEN ];
+static int64_t avg_sum = 0;
+static uint32_t avg_pos = 0;
+
+static pend_enc_sampler_stats stats;
+
+/* Clear statistics, call with I2C interrupt masked. */
+static void pend_enc_sampler_clear( void )
+{
+    stats.samples     = 0;
+    stats.errors      = 0;
+    stats.restarts    = 0;
+    stats.periods     = 0;
+    stats.period_min  = UINT32_MAX;
+    stats.period_max  = 0;
+    stats.period_sum  = 0;
+    stats.step_max    = 0;
+    stats.reads       = 0;
+    stats.stale_reads = 0;
+    stats.age_max     = 0;
+    stats.age_sum     = 0;
+}
+
+void pend_enc_sampler_init( void )
+{
+    pend_enc_sampler_clear();
+}
+
+void pend_enc_sampler_push( uint16_t raw )
+{
+    uint32_t now = ctrl_tick_cycles();
+    uint32_t back = published ^ 1;
+    uint32_t period;
+    int32_t step;
+
+    /* Unwrap, the arm turned less than half revolution since the last sample. */
+    if( ( last_raw > 2048 ) && ( raw < ( last_raw - 2048 ) ) )
+    {
+        step = 4096 - last_raw + raw;
+        revolutions += 1;
+    }
+    else if( ( raw > 2048 ) && ( last_raw < ( raw - 2048 ) ) )
+    {
+        step = -4096 - last_raw + raw;
+        revolutions -= 1;
+    }
+    else
+    {
+        step = ( int32_t ) raw - last_raw;
+    }
+    last_raw = raw;
+    count += step;
+
+    /* Moving sum of the last counts, ring is filled with the first one. */
+    if( seq == 0 )
+    {
+        for( uint32_t i = 0; i < PEND_ENC_AVG_LEN; i++ )
+        {
+            avg_ring[ i ] = count;
+        }
+        avg_sum = ( int64_t ) count * PEND_ENC_AVG_LEN;
+    }
+    else
+    {
+        avg_sum += count - avg_ring[ avg_pos ];
+        avg_ring[ avg_pos ] = count;
+        avg_pos = ( avg_pos + 1 ) & ( PEND_ENC_AVG_LEN - 1 );
+
+        if( ( uint32_t ) ( step < 0 ? -step : step ) > stats.step_max )
+        {
+            stats.step_max = ( uint32_t ) ( step < 0 ? -step : step );
+        }
+    }
+
+    buffer[ back ].raw         = raw;
+    buffer[ back ].count       = count;
+    buffer[ back ].revolutions = revolutions;
+    buffer[ back ].avg_offset  = ( int32_t ) ( avg_sum - ( int64_t ) count * PEND_ENC_AVG_LEN );
+    buffer[ back ].cycles      = now;
+    buffer[ back ].seq         = ++seq;
+    published = back;
+
+    if( stats.samples != 0 )
+    {
+        period = now - stats.last_push;
+        if( period < stats.period_min )
+        {
+            stats.period_min = period;
+        }
+        if( period > stats.period_max )
+        {
+            stats.period_max = period;
+        }
+        stats.period_sum += period;
+        stats.periods++;
+    }
+    stats.last_push = now;
+    stats.samples++;
+}
+
+void pend_enc_sampler_error( void )
+{
+    stats.errors++;
+}
+
+void pend_enc_sampler_restarted( void )
+{
+    taskENTER_CRITICAL();
+    stats.restarts++;
+    taskEXIT_CRITICAL();
+}
+
+uint32_t pend_enc_sampler_read( pend_enc_sample *out )
+{
+    uint32_t index;
+    uint32_t age;
+
+    /* Push can't be interrupted by a task, if sequence number of the copied
+    buffer didn't change, the copy is consistent. */
+    do
+    {
+        index            = published;
+        out->seq         = buffer[ index ].seq;
+        out->raw         = buffer[ index ].raw;
+        out->count       = buffer[ index ].count;
+        out->revolutions = buffer[ index ].revolutions;
+        out->avg_offset  = buffer[ index ].avg_offset;
+        out->cycles      = buffer[ index ].cycles;
+    } while( buffer[ index ].seq != out->seq );
+
+    age = ctrl_tick_cycles() - out->cycles;
+
+    taskENTER_CRITICAL();
+    if( out->seq == stats.last_read_seq )
+    {
+        stats.stale_reads++;
+    }
+    if( age > stats.age_max )
+    {
+        stats.age_max = age;
+    }
+    stats.age_sum += age;
+    stats.reads++;
+    stats.last_read_seq = out->seq;
+    taskEXIT_CRITICAL();
+
+    return out->seq;
+}
+
+uint32_t pend_enc_sampler_seq( void )
+{
+    return buffer[ published ].seq;
+}
+
+void pend_enc_sampler_get_stats( pend_enc_sampler_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+void pend_enc_sampler_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    pend_enc_sampler_clear();
+    taskEXIT_CRITICAL();
+}
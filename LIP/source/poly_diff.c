@@ -0,0 +1,134 @@
+#include "poly_diff.h"
+
+/* Sums S0..S2 of the window samples minus ref. */
+static void poly_diff_rebuild( poly_diff *pd )
+{
+    uint32_t i = pd->pos;
+
+    pd->ref = pd->buf[ pd->pos ];
+    pd->s[ 0 ] = 0.0f;
+    pd->s[ 1 ] = 0.0f;
+    pd->s[ 2 ] = 0.0f;
+
+    for( uint32_t j = 0; j < pd->window; j++ )
+    {
+        float y = pd->buf[ i ] - pd->ref;
+        float fj = ( float ) j;
+
+        pd->s[ 0 ] += y;
+        pd->s[ 1 ] += fj * y;
+        pd->s[ 2 ] += fj * fj * y;
+        i = ( i + 1 == pd->window ) ? 0 : i + 1;
+    }
+
+    pd->rebuild = pd->window;
+}
+
+void poly_diff_init( poly_diff *pd, uint32_t window, uint32_t order, float delay, float samplingTime )
+{
+    float N, h, u0, U2, U4, D;
+
+    if( order < 1 )
+    {
+        order = 1;
+    }
+    else if( order > 2 )
+    {
+        order = 2;
+    }
+    if( window < order + 1 )
+    {
+        window = order + 1;
+    }
+    else if( window > POLY_DIFF_MAX_WINDOW )
+    {
+        window = POLY_DIFF_MAX_WINDOW;
+    }
+    if( delay < 0.0f )
+    {
+        delay = 0.0f;
+    }
+    else if( delay > ( float ) ( window - 1 ) )
+    {
+        delay = ( float ) ( window - 1 );
+    }
+
+    pd->window = window;
+    pd->order = order;
+    pd->delay = delay;
+    pd->samplingTime = samplingTime;
+
+    /* Fit in time u (samples) from the window centre, u = h - j, sample j = 0
+    is the newest. Odd moments of u vanish, so the normal equations have a
+    closed form:
+        c1 = sum( u y ) / U2
+        c2 = ( N sum( u^2 y ) - U2 sum( y ) ) / ( N U4 - U2^2 )
+        derivative at u0 = c1 + 2 c2 u0
+    with sum( u y ) = h S0 - S1, sum( u^2 y ) = S2 - 2h S1 + h^2 S0. */
+    N  = ( float ) window;
+    h  = 0.5f * ( N - 1.0f );
+    u0 = h - delay;
+    U2 = N * ( N * N - 1.0f ) / 12.0f;
+    U4 = N * ( N * N - 1.0f ) * ( 3.0f * N * N - 7.0f ) / 240.0f;
+    D  = N * U4 - U2 * U2;
+
+    pd->w[ 0 ] = h / U2;
+    pd->w[ 1 ] = -1.0f / U2;
+    pd->w[ 2 ] = 0.0f;
+    if( order == 2 )
+    {
+        pd->w[ 0 ] += 2.0f * u0 * ( N * h * h - U2 ) / D;
+        pd->w[ 1 ] += 2.0f * u0 * ( -2.0f * N * h ) / D;
+        pd->w[ 2 ] += 2.0f * u0 * N / D;
+    }
+    for( uint32_t k = 0; k < 3; k++ )
+    {
+        pd->w[ k ] = samplingTime > 0.0f ? pd->w[ k ] / samplingTime : 0.0f;
+    }
+
+    pd->initialized = 0;
+    poly_diff_reset( pd, 0.0f );
+}
+
+void poly_diff_reset( poly_diff *pd, float in )
+{
+    for( uint32_t j = 0; j < pd->window; j++ )
+    {
+        pd->buf[ j ] = in;
+    }
+    pd->pos = 0;
+    pd->initialized = 1;
+    poly_diff_rebuild( pd );
+}
+
+float poly_diff_update( poly_diff *pd, float in )
+{
+    float N = ( float ) pd->window;
+    float *s = pd->s;
+    float out;
+
+    if( !pd->initialized )
+    {
+        poly_diff_reset( pd, in );
+        return 0.0f;
+    }
+
+    /* Oldest sample, j = window - 1, leaves and its slot takes the new one. */
+    pd->pos = ( pd->pos == 0 ) ? pd->window - 1 : pd->pos - 1;
+    out = pd->buf[ pd->pos ] - pd->ref;
+    pd->buf[ pd->pos ] = in;
+
+    if( --pd->rebuild == 0 )
+    {
+        poly_diff_rebuild( pd );
+    }
+    else
+    {
+        /* Every sample moves one place older, j -> j + 1. */
+        s[ 2 ] += 2.0f * s[ 1 ] + s[ 0 ] - N * N * out;
+        s[ 1 ] += s[ 0 ] - N * out;
+        s[ 0 ] += ( in - pd->ref ) - out;
+    }
+
+    return pd->w[ 0 ] * s[ 0 ] + pd->w[ 1 ] * s[ 1 ] + pd->w[ 2 ] * s[ 2 ];
+}
@@ -0,0 +1,81 @@
+/*
+ * Description: Setpoint potentiometer ADC acquisition in lockstep with the control tick
+ *
+ * GPIOs used: PA3 for ADC3 IN3 (alias adc_pot)
+ *
+ * See pot_adc_driver.h. ADC3 settings from CubeMX (adc.c) are overwritten
+ * here, only the trigger, scan length and EOC selection change, DMA2 stream 0
+ * (circular, halfword) stays as generated.
+ *
+ */
+
+#include "adc.h" // from autogenerated code
+#include "main_LIP.h"
+#include "pot_adc_driver.h"
+
+#if ( POT_ADC_OVERSAMPLE < 1 ) || ( POT_ADC_OVERSAMPLE > 16 )
+    #error "POT_ADC_OVERSAMPLE has to be 1 - 16, length of ADC regular sequence"
+#endif
+
+/* DMA target, one burst. Circular DMA wraps after every burst, one burst per
+tick keeps index 0 at the first conversion. */
+static volatile uint16_t burst[ POT_ADC_OVERSAMPLE ];
+
+/* Sum of the last finished burst, written by the tick ISR only. */
+static volatile uint32_t burst_sum = 0;
+
+void pot_adc_init( void )
+{
+    ADC_ChannelConfTypeDef sConfig = { 0 };
+
+    hadc3.Init.ScanConvMode          = ENABLE;
+    hadc3.Init.ContinuousConvMode    = DISABLE;
+    hadc3.Init.ExternalTrigConvEdge  = ADC_EXTERNALTRIGCONVEDGE_NONE;
+    hadc3.Init.ExternalTrigConv      = ADC_SOFTWARE_START;
+    hadc3.Init.NbrOfConversion       = POT_ADC_OVERSAMPLE;
+    hadc3.Init.DMAContinuousRequests = ENABLE;
+    hadc3.Init.EOCSelection          = ADC_EOC_SEQ_CONV;
+    if( HAL_ADC_Init( &hadc3 ) != HAL_OK )
+    {
+        Error_Handler();
+    }
+
+    /* Same channel in every rank. */
+    sConfig.Channel      = ADC_CHANNEL_3;
+    sConfig.SamplingTime = ADC_SAMPLETIME_480CYCLES;
+    for( uint32_t rank = 1; rank <= POT_ADC_OVERSAMPLE; rank++ )
+    {
+        sConfig.Rank = rank;
+        if( HAL_ADC_ConfigChannel( &hadc3, &sConfig ) != HAL_OK )
+        {
+            Error_Handler();
+        }
+    }
+
+    /* Software trigger, HAL starts the first burst. */
+    HAL_ADC_Start_DMA( &hadc3, ( uint32_t * ) burst, POT_ADC_OVERSAMPLE );
+}
+
+void pot_adc_tick( void )
+{
+    uint32_t sum = 0;
+
+    /* Burst started by the previous tick is done, it is shorter than the tick period. */
+    for( uint32_t i = 0; i < POT_ADC_OVERSAMPLE; i++ )
+    {
+        sum += burst[ i ];
+    }
+    burst_sum = sum;
+
+    hadc3.Instance->CR2 |= ADC_CR2_SWSTART;
+}
+
+uint32_t pot_adc_get_sum( void )
+{
+    return burst_sum;
+}
+
+float pot_adc_get_counts( void )
+{
+    return ( float ) burst_sum * ( 1.0f / POT_ADC_OVERSAMPLE );
+}
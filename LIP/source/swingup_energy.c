@@ -0,0 +1,86 @@
+#include "swingup_energy.h"
+#include <math.h>
+
+static inline float swingup_clamp( float v, float lo, float hi )
+{
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+float swingup_energy( const lqr_plant_params *p, float th, float dth )
+{
+    /* This function returns pendulum energy normalized by m g l, zero up at rest. */
+    return 0.5f * dth * dth / p->pend_w0_sq + cosf( th ) - 1.0f;
+}
+
+float swingup_energy_voltage( const swingup_energy_params *s, const lqr_plant_params *p, const float x[ LQR_N ] )
+{
+    /* This function calculates swingup motor voltage for state x. */
+    float energy = swingup_energy( p, x[ 1 ], x[ 3 ] );
+    float pump   = x[ 3 ] * cosf( x[ 1 ] );
+    float stop   = 0.5f * x[ 2 ] * x[ 2 ] / s->brake_accel;
+    float accel, u;
+
+    if( energy < -1.9f && fabsf( x[ 3 ] ) < s->kick_speed )
+    {
+        /* Hanging (almost) still, start the swing. */
+        accel = ( x[ 0 ] > 0.0f ) ? -s->kick_accel : s->kick_accel;
+    }
+    else
+    {
+        accel = swingup_clamp( s->k_energy * ( energy - s->energy_ref ) * pump, -s->accel_max, s->accel_max );
+    }
+
+    /* Keep the cart around the centre. */
+    accel = swingup_clamp( accel - s->k_x * x[ 0 ] - s->k_v * x[ 2 ], -s->accel_max, s->accel_max );
+
+    /* Brake if the cart can't stop before a limit. */
+    if( x[ 2 ] > 0.0f && x[ 0 ] + stop > s->x_max )
+    {
+        accel = -s->accel_max;
+    }
+    else if( x[ 2 ] < 0.0f && x[ 0 ] - stop < s->x_min )
+    {
+        accel = s->accel_max;
+    }
+
+    u = ( accel + p->cart_pole * x[ 2 ] ) / p->cart_gain;
+    if( u > 0.0f )
+    {
+        u += s->deadzone;
+    }
+    else if( u < 0.0f )
+    {
+        u -= s->deadzone;
+    }
+
+    return swingup_clamp( u, -s->u_max, s->u_max );
+}
+
+uint8_t swingup_energy_catch_ok( const lqr_plant_params *p, const float K[ LQR_N ], const float x[ LQR_N ],
+                                 float x_min, float x_max, float u_max )
+{
+    /* This function runs UPC from state x on the model and checks the cart stays
+    between x_min and x_max and the pendulum in the window. */
+    float xs[ LQR_N ] = { x[ 0 ], x[ 1 ], x[ 2 ], x[ 3 ] };
+    float u = 0.0f, ddx, ddth;
+
+    for( uint32_t i = 0; i < SWINGUP_ENERGY_CATCH_STEPS; i++ )
+    {
+        if( xs[ 0 ] < x_min || xs[ 0 ] > x_max || fabsf( xs[ 1 ] ) > SWINGUP_ENERGY_CATCH_WINDOW_RAD )
+        {
+            return 0;
+        }
+        if( i % SWINGUP_ENERGY_CATCH_STEPS_PER_TICK == 0 )
+        {
+            u = swingup_clamp( -( K[ 0 ]*xs[ 0 ] + K[ 1 ]*xs[ 1 ] + K[ 2 ]*xs[ 2 ] + K[ 3 ]*xs[ 3 ] ), -u_max, u_max );
+        }
+        ddx  = -p->cart_pole * xs[ 2 ] + p->cart_gain * u;
+        ddth = p->pend_w0_sq * sinf( xs[ 1 ] ) - p->pend_coupling * ddx * cosf( xs[ 1 ] ) - p->pend_damping * xs[ 3 ];
+        xs[ 0 ] += SWINGUP_ENERGY_CATCH_DT * xs[ 2 ];
+        xs[ 1 ] += SWINGUP_ENERGY_CATCH_DT * xs[ 3 ];
+        xs[ 2 ] += SWINGUP_ENERGY_CATCH_DT * ddx;
+        xs[ 3 ] += SWINGUP_ENERGY_CATCH_DT * ddth;
+    }
+
+    return 1;
+}
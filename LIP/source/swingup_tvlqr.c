@@ -0,0 +1,64 @@
+#include "swingup_tvlqr.h"
+#include <math.h>
+
+static inline float swingup_tvlqr_value( uint32_t k, uint32_t column )
+{
+    return ( float ) swingup_tvlqr_table.q[ k ][ column ] * swingup_tvlqr_table.scale[ column ];
+}
+
+void swingup_tvlqr_nominal( uint32_t k, float x_nom[ LQR_N ] )
+{
+    /* This function decodes the nominal state of sample k. */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        x_nom[ i ] = swingup_tvlqr_value( k, SWINGUP_TVLQR_COL_X + i );
+    }
+}
+
+float swingup_tvlqr_voltage( uint32_t k, const float x[ LQR_N ] )
+{
+    return swingup_tvlqr_voltage_between( k, 0.0f, x );
+}
+
+float swingup_tvlqr_voltage_between( uint32_t k, float frac, const float x[ LQR_N ] )
+{
+    /* This function calculates tracking motor voltage at fraction frac of the
+    interval after sample k and state x. */
+    const float pi = 3.14159265f;
+    float x_nom[ LQR_N ];
+    float x_next[ LQR_N ];
+    float u = swingup_tvlqr_value( k, SWINGUP_TVLQR_COL_U );
+    float error;
+
+    swingup_tvlqr_nominal( k, x_nom );
+    if( frac > 0.0f && k + 1 < SWINGUP_TVLQR_SAMPLES )
+    {
+        swingup_tvlqr_nominal( k + 1, x_next );
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            x_nom[ i ] += frac * ( x_next[ i ] - x_nom[ i ] );
+        }
+    }
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        error = x_nom[ i ] - x[ i ];
+        if( i == 1 )
+        {
+            /* Nominal angle goes around, measured one is in [ -PI, PI ]. */
+            error -= 2.0f * pi * floorf( ( error + pi ) / ( 2.0f * pi ) );
+        }
+        u += swingup_tvlqr_value( k, SWINGUP_TVLQR_COL_K + i ) * error;
+    }
+
+    if( u > 0.0f )
+    {
+        u += SWINGUP_TVLQR_DEADZONE;
+    }
+    else if( u < 0.0f )
+    {
+        u -= SWINGUP_TVLQR_DEADZONE;
+    }
+
+    return fmaxf( -SWINGUP_TVLQR_U_MAX, fminf( SWINGUP_TVLQR_U_MAX, u ) );
+}
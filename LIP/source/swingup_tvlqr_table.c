@@ -0,0 +1,272 @@
+/* Swingup trajectory and TVLQR gains (swingup_tvlqr.h).
+ * Generated by sim_swingup_tvlqr (sim/tools), do not edit.
+ * Model: lqr model a 31.300 b 4.440 w0^2 49.050 c 5.000 d 0.167
+ * duration : 2.50 sec (250*10ms), start : rest hanging at SWINGUP_TVLQR_START_CM
+ * end : upright at rest, angle 6.2832 rad, cost 12.89
+ * Sampling time : 10ms
+ */
+#include "swingup_tvlqr.h"
+
+#if SWINGUP_TVLQR_SAMPLES != 250 || SWINGUP_TVLQR_COLUMNS != 9
+#error "swingup_tvlqr_table.c doesn't match swingup_tvlqr.h, run sim_swingup_tvlqr"
+#endif
+
+const swingup_tvlqr_table_t swingup_tvlqr_table =
+{
+    /* u V, x m, th rad, dx m/s, dth rad/s, K x, K th, K dx, K dth */
+    {
+        1.91477186e-04f, 3.05386425e-06f, 1.91749874e-04f, 2.31985814e-05f, 3.90383240e-04f, 5.59964171e-03f, 4.27282788e-03f, 1.79463159e-03f, 6.52937510e-04f
+    },
+    {
+        {  -4666,      0,  16384,      0,      0,  11537,   4260,   6156,  -2159 },
+        {  -5900,    -59,  16379,  -1468,   -435,  11584,   4274,   6219,  -2191 },
+        {  -7085,   -229,  16366,  -2930,   -866,  11635,   4286,   6280,  -2221 },
+        {  -8214,   -509,  16344,  -4372,  -1286,  11686,   4296,   6334,  -2249 },
+        {  -9280,   -897,  16313,  -5782,  -1689,  11735,   4303,   6378,  -2271 },
+        { -10276,  -1391,  16274,  -7148,  -2070,  11780,   4307,   6408,  -2287 },
+        { -11192,  -1987,  16229,  -8460,  -2425,  11817,   4306,   6420,  -2295 },
+        { -12023,  -2679,  16176,  -9708,  -2747,  11845,   4300,   6411,  -2294 },
+        { -12761,  -3464,  16117, -10882,  -3034,  11862,   4288,   6380,  -2281 },
+        { -13399,  -4334,  16052, -11973,  -3280,  11865,   4270,   6326,  -2258 },
+        { -13934,  -5283,  15983, -12972,  -3482,  11854,   4246,   6249,  -2224 },
+        { -14363,  -6305,  15910, -13870,  -3637,  11830,   4217,   6150,  -2180 },
+        { -14683,  -7390,  15835, -14662,  -3742,  11792,   4183,   6033,  -2127 },
+        { -14896,  -8531,  15758, -15342,  -3796,  11744,   4145,   5901,  -2067 },
+        { -15004,  -9719,  15681, -15906,  -3796,  11686,   4104,   5760,  -2003 },
+        { -15011, -10945,  15604, -16353,  -3743,  11623,   4061,   5614,  -1936 },
+        { -14923, -12200,  15529, -16681,  -3637,  11557,   4017,   5469,  -1869 },
+        { -14746, -13476,  15456, -16894,  -3480,  11491,   3975,   5330,  -1805 },
+        { -14486, -14763,  15388, -16993,  -3273,  11428,   3934,   5202,  -1746 },
+        { -14150, -16054,  15324, -16985,  -3018,  11368,   3896,   5089,  -1694 },
+        { -13745, -17340,  15265, -16872,  -2720,  11315,   3862,   4994,  -1651 },
+        { -13277, -18613,  15213, -16663,  -2382,  11268,   3833,   4919,  -1617 },
+        { -12750, -19867,  15169, -16363,  -2006,  11228,   3811,   4866,  -1594 },
+        { -12168, -21094,  15132, -15977,  -1597,  11193,   3794,   4836,  -1581 },
+        { -11532, -22289,  15104, -15512,  -1159,  11163,   3786,   4828,  -1578 },
+        { -10843, -23446,  15085, -14972,   -694,  11138,   3786,   4842,  -1586 },
+        { -10100, -24559,  15076, -14360,   -206,  11116,   3796,   4880,  -1603 },
+        {  -9304, -25623,  15077, -13679,    302,  11096,   3816,   4939,  -1631 },
+        {  -8451, -26632,  15089, -12930,    827,  11078,   3847,   5020,  -1668 },
+        {  -7540, -27582,  15111, -12114,   1367,  11062,   3892,   5123,  -1714 },
+        {  -6571, -28466,  15145, -11231,   1918,  11049,   3949,   5246,  -1768 },
+        {  -5545, -29282,  15190, -10280,   2480,  11038,   4020,   5391,  -1831 },
+        {  -4465, -30022,  15246,  -9262,   3049,  11031,   4106,   5556,  -1902 },
+        {  -3341, -30682,  15314,  -8178,   3623,  11030,   4207,   5741,  -1982 },
+        {  -2186, -31258,  15394,  -7031,   4197,  11038,   4322,   5946,  -2069 },
+        {  -1024, -31744,  15486,  -5829,   4767,  11057,   4452,   6168,  -2164 },
+        {    108, -32137,  15589,  -4585,   5327,  11090,   4596,   6407,  -2266 },
+        {   1160, -32435,  15703,  -3319,   5867,  11141,   4750,   6661,  -2375 },
+        {   2060, -32636,  15828,  -2062,   6377,  11213,   4914,   6927,  -2491 },
+        {   2711, -32745,  15962,   -859,   6839,  11307,   5082,   7199,  -2611 },
+        {   3833, -32767,  16106,    225,   7233,  11424,   5251,   7467,  -2733 },
+        {   5660, -32704,  16257,   1370,   7610,  11555,   5413,   7715,  -2848 },
+        {   7484, -32544,  16417,   2783,   8028,  11684,   5561,   7915,  -2946 },
+        {   9276, -32268,  16585,   4390,   8463,  11792,   5681,   8036,  -3011 },
+        {  11008, -31865,  16762,   6129,   8895,  11855,   5762,   8047,  -3029 },
+        {  12645, -31327,  16948,   7946,   9304,  11848,   5792,   7914,  -2984 },
+        {  14154, -30649,  17141,   9789,   9673,  11749,   5761,   7616,  -2862 },
+        {  15501, -29833,  17342,  11612,   9986,  11545,   5666,   7143,  -2656 },
+        {  16659, -28881,  17548,  13369,  10226,  11235,   5512,   6507,  -2367 },
+        {  17609, -27799,  17758,  15018,  10382,  10837,   5310,   5740,  -2006 },
+        {  18338, -26598,  17970,  16523,  10442,  10384,   5078,   4896,  -1596 },
+        {  18847, -25290,  18183,  17852,  10399,   9918,   4836,   4035,  -1165 },
+        {  19148, -23889,  18393,  18985,  10247,   9484,   4599,   3218,   -744 },
+        {  19262, -22410,  18599,  19908,   9987,   9123,   4381,   2497,   -360 },
+        {  19216, -20869,  18799,  20619,   9622,   8860,   4187,   1907,    -38 },
+        {  19047, -19282,  18990,  21124,   9157,   8710,   4018,   1465,    209 },
+        {  18790, -17665,  19171,  21440,   8603,   8674,   3869,   1176,    373 },
+        {  18481, -16030,  19340,  21591,   7969,   8742,   3734,   1028,    454 },
+        {  18155, -14390,  19495,  21604,   7269,   8896,   3610,   1006,    457 },
+        {  17839, -12752,  19636,  21510,   6515,   9116,   3490,   1086,    392 },
+        {  17557, -11125,  19760,  21343,   5719,   9380,   3372,   1247,    272 },
+        {  17324,  -9512,  19868,  21131,   4892,   9669,   3257,   1466,    110 },
+        {  17152,  -7916,  19959,  20904,   4044,   9965,   3143,   1723,    -81 },
+        {  17043,  -6337,  20033,  20683,   3185,  10256,   3033,   2001,   -287 },
+        {  16996,  -4774,  20089,  20487,   2322,  10532,   2930,   2287,   -499 },
+        {  17004,  -3224,  20127,  20329,   1460,  10786,   2835,   2573,   -708 },
+        {  17057,  -1684,  20148,  20216,    604,  11016,   2750,   2850,   -906 },
+        {  17140,   -151,  20152,  20150,   -241,  11220,   2678,   3116,  -1090 },
+        {  17235,   1379,  20138,  20128,  -1075,  11397,   2621,   3367,  -1256 },
+        {  17324,   2909,  20108,  20142,  -1895,  11551,   2580,   3605,  -1404 },
+        {  17385,   4440,  20061,  20180,  -2702,  11683,   2556,   3830,  -1535 },
+        {  17395,   5975,  19998,  20227,  -3495,  11797,   2550,   4045,  -1648 },
+        {  17332,   7513,  19919,  20265,  -4275,  11896,   2564,   4253,  -1747 },
+        {  17170,   9053,  19824,  20272,  -5045,  11988,   2598,   4457,  -1834 },
+        {  16885,  10591,  19714,  20227,  -5807,  12078,   2654,   4665,  -1914 },
+        {  16453,  12123,  19588,  20104,  -6563,  12175,   2733,   4880,  -1988 },
+        {  15849,  13641,  19446,  19878,  -7317,  12290,   2834,   5110,  -2062 },
+        {  15047,  15137,  19290,  19523,  -8073,  12432,   2961,   5359,  -2139 },
+        {  14024,  16599,  19117,  19011,  -8836,  12616,   3114,   5635,  -2222 },
+        {  12755,  18016,  18929,  18314,  -9611,  12852,   3295,   5940,  -2314 },
+        {  11219,  19370,  18726,  17406, -10403,  13152,   3506,   6274,  -2415 },
+        {   9397,  20647,  18505,  16258, -11217,  13522,   3746,   6633,  -2524 },
+        {   7277,  21825,  18268,  14846, -12057,  13960,   4016,   7004,  -2635 },
+        {   4852,  22885,  18013,  13146, -12928,  14450,   4311,   7357,  -2738 },
+        {   2132,  23804,  17741,  11140, -13832,  14948,   4621,   7646,  -2813 },
+        {   -859,  24557,  17449,   8817, -14769,  15377,   4927,   7799,  -2832 },
+        {  -4075,  25121,  17138,   6177, -15734,  15616,   5197,   7717,  -2751 },
+        {  -7439,  25473,  16807,   3235, -16717,  15503,   5390,   7282,  -2517 },
+        { -10848,  25590,  16456,     24, -17701,  14864,   5461,   6392,  -2079 },
+        { -14166,  25456,  16085,  -3396, -18659,  13579,   5381,   5005,  -1403 },
+        { -17236,  25056,  15695,  -6940, -19558,  11659,   5161,   3189,   -499 },
+        { -19895,  24387,  15288, -10499, -20353,   9276,   4855,   1128,    578 },
+        { -21988,  23452,  14867, -13937, -20997,   6727,   4552,   -937,   1739 },
+        { -23397,  22266,  14434, -17111, -21444,   4316,   4337,  -2791,   2899 },
+        { -24057,  20856,  13995, -19874, -21652,   2271,   4268,  -4303,   4000 },
+        { -23971,  19257,  13554, -22103, -21594,    711,   4362,  -5431,   5015 },
+        { -23205,  17514,  13117, -23705, -21263,   -329,   4601,  -6190,   5938 },
+        { -21878,  15676,  12690, -24636, -20668,   -863,   4947,  -6621,   6771 },
+        { -20139,  13794,  12278, -24899, -19837,   -925,   5348,  -6769,   7512 },
+        { -18146,  11917,  11884, -24545, -18810,   -551,   5743,  -6672,   8147 },
+        { -16041,  10088,  11513, -23658, -17632,    223,   6074,  -6361,   8648 },
+        { -13948,   8343,  11167, -22347, -16348,   1352,   6280,  -5863,   8974 },
+        { -11960,   6710,  10848, -20730, -14997,   2774,   6312,  -5207,   9075 },
+        { -10143,   5207,  10557, -18922, -13610,   4397,   6135,  -4430,   8907 },
+        {  -8542,   3846,  10295, -17029, -12211,   6105,   5740,  -3582,   8446 },
+        {  -7184,   2627,  10060, -15140, -10816,   7762,   5151,  -2718,   7700 },
+        {  -6083,   1550,   9854, -13332,  -9435,   9241,   4420,  -1893,   6719 },
+        {  -5244,    604,   9676, -11663,  -8074,  10452,   3615,  -1152,   5580 },
+        {  -4668,   -223,   9526, -10179,  -6732,  11353,   2808,   -519,   4374 },
+        {  -4350,   -946,   9402,  -8912,  -5412,  11950,   2057,      4,   3182 },
+        {  -4285,  -1582,   9305,  -7886,  -4111,  12287,   1399,    428,   2065 },
+        {  -4462,  -2150,   9234,  -7115,  -2828,  12423,    850,    774,   1058 },
+        {  -4872,  -2670,   9190,  -6607,  -1563,  12423,    412,   1066,    176 },
+        {  -5497,  -3162,   9171,  -6364,   -314,  12341,     77,   1326,   -579 },
+        {  -6320,  -3646,   9177,  -6383,    919,  12225,   -170,   1572,  -1216 },
+        {  -7316,  -4142,   9208,  -6656,   2135,  12110,   -342,   1819,  -1746 },
+        {  -8458,  -4668,   9264,  -7170,   3331,  12020,   -452,   2074,  -2182 },
+        {  -9713,  -5242,   9343,  -7904,   4507,  11972,   -514,   2343,  -2535 },
+        { -11043,  -5880,   9447,  -8836,   5659,  11976,   -534,   2628,  -2814 },
+        { -12405,  -6595,   9573,  -9936,   6783,  12035,   -519,   2926,  -3027 },
+        { -13754,  -7399,   9723, -11169,   7878,  12146,   -474,   3234,  -3180 },
+        { -15043,  -8301,   9894, -12496,   8941,  12306,   -399,   3546,  -3279 },
+        { -16222,  -9305,  10086, -13871,   9970,  12506,   -294,   3855,  -3328 },
+        { -17243, -10414,  10300, -15247,  10966,  12738,   -160,   4154,  -3333 },
+        { -18058, -11625,  10533, -16575,  11928,  12993,      5,   4437,  -3299 },
+        { -18622, -12933,  10785, -17803,  12860,  13267,    201,   4702,  -3235 },
+        { -18891, -14329,  11056, -18878,  13767,  13560,    428,   4946,  -3147 },
+        { -18823, -15798,  11345, -19749,  14656,  13876,    683,   5173,  -3044 },
+        { -18377, -17322,  11653, -20364,  15535,  14227,    964,   5387,  -2936 },
+        { -17512, -18882,  11978, -20674,  16415,  14627,   1269,   5592,  -2828 },
+        { -16188, -20450,  12321, -20628,  17308,  15090,   1596,   5792,  -2725 },
+        { -14367, -21999,  12683, -20178,  18227,  15623,   1942,   5981,  -2626 },
+        { -12011, -23496,  13064, -19276,  19189,  16217,   2305,   6142,  -2525 },
+        {  -9090, -24905,  13466, -17875,  20207,  16830,   2679,   6238,  -2407 },
+        {  -5589, -26185,  13888, -15931,  21296,  17372,   3053,   6207,  -2246 },
+        {  -1517, -27294,  14334, -13408,  22469,  17686,   3407,   5959,  -2005 },
+        {   3078, -28188,  14805, -10282,  23731,  17554,   3707,   5390,  -1640 },
+        {   8089, -28820,  15303,  -6550,  25079,  16734,   3913,   4416,  -1113 },
+        {  13336, -29145,  15829,  -2245,  26495,  15063,   3996,   3027,   -405 },
+        {  18559, -29124,  16384,   2555,  27940,  12575,   3964,   1333,    460 },
+        {  23425, -28724,  16968,   7708,  29351,   9547,   3876,   -447,   1423 },
+        {  27566, -27927,  17580,  13007,  30639,   6402,   3829,  -2069,   2413 },
+        {  30640, -26732,  18216,  18186,  31703,   3534,   3922,  -3351,   3379 },
+        {  32402, -25160,  18870,  22939,  32439,   1192,   4226,  -4213,   4304 },
+        {  32767, -23257,  19534,  26970,  32767,   -536,   4773,  -4655,   5200 },
+        {  31827, -21085,  20201,  30032,  32650,  -1669,   5563,  -4715,   6099 },
+        {  29824, -18726,  20861,  31976,  32105,  -2272,   6575,  -4435,   7036 },
+        {  27081, -16266,  21505,  32767,  31195,  -2418,   7783,  -3844,   8050 },
+        {  23928, -13788,  22128,  32482,  30017,  -2162,   9165,  -2952,   9180 },
+        {  20648, -11368,  22726,  31282,  28674,  -1531,  10715,  -1746,  10468 },
+        {  17448,  -9068,  23295,  29372,  27258,   -526,  12443,   -191,  11960 },
+        {  14461,  -6933,  23835,  26968,  25842,    887,  14383,   1770,  13712 },
+        {  11756,  -4992,  24347,  24271,  24474,   2775,  16585,   4220,  15782 },
+        {   9358,  -3261,  24832,  21447,  23178,   5244,  19105,   7262,  18234 },
+        {   7265,  -1745,  25292,  18628,  21967,   8429,  21983,  11007,  21110 },
+        {   5460,   -438,  25727,  15908,  20837,  12471,  25187,  15531,  24385 },
+        {   3918,    668,  26141,  13351,  19784,  17425,  28507,  20756,  27863 },
+        {   2612,   1588,  26534,  10996,  18798,  23068,  31387,  26229,  31006 },
+        {   1517,   2338,  26907,   8862,  17868,  28576,  32767,  30829,  32767 },
+        {    607,   2935,  27262,   6958,  16987,  32373,  31302,  32767,  31779 },
+        {   -140,   3396,  27599,   5279,  16145,  32767,  26294,  30517,  27266 },
+        {   -744,   3739,  27919,   3816,  15338,  29349,  18680,  24290,  20057 },
+        {  -1224,   3979,  28224,   2557,  14561,  23464,  10527,  16092,  12162 },
+        {  -1597,   4130,  28513,   1484,  13811,  16994,   3498,   8080,   5258 },
+        {  -1878,   4207,  28786,    583,  13085,  11166,  -1828,   1395,    -27 },
+        {  -2081,   4221,  29046,   -165,  12382,   6406,  -5595,  -3746,  -3796 },
+        {  -2219,   4184,  29291,   -775,  11702,   2689,  -8180,  -7560,  -6397 },
+        {  -2301,   4106,  29522,  -1265,  11045,   -166,  -9937, -10357,  -8174 },
+        {  -2338,   3994,  29741,  -1649,  10410,  -2356, -11135, -12413,  -9388 },
+        {  -2338,   3857,  29946,  -1942,   9799,  -4045, -11959, -13936, -10223 },
+        {  -2309,   3701,  30140,  -2156,   9212,  -5361, -12533, -15079, -10804 },
+        {  -2256,   3532,  30322,  -2303,   8648,  -6396, -12938, -15947, -11211 },
+        {  -2186,   3353,  30492,  -2394,   8109,  -7219, -13228, -16615, -11501 },
+        {  -2102,   3169,  30652,  -2438,   7595,  -7880, -13438, -17136, -11708 },
+        {  -2009,   2984,  30802,  -2444,   7105,  -8415, -13593, -17546, -11859 },
+        {  -1909,   2799,  30941,  -2420,   6640,  -8852, -13708, -17872, -11969 },
+        {  -1806,   2617,  31072,  -2370,   6200,  -9212, -13795, -18135, -12050 },
+        {  -1701,   2440,  31194,  -2301,   5783,  -9509, -13862, -18348, -12111 },
+        {  -1596,   2269,  31308,  -2218,   5390,  -9757, -13914, -18522, -12157 },
+        {  -1492,   2104,  31414,  -2124,   5020,  -9964, -13954, -18665, -12192 },
+        {  -1390,   1947,  31512,  -2023,   4671, -10138, -13986, -18783, -12219 },
+        {  -1291,   1797,  31604,  -1916,   4345, -10284, -14012, -18881, -12240 },
+        {  -1196,   1656,  31689,  -1808,   4038, -10407, -14033, -18964, -12256 },
+        {  -1104,   1523,  31768,  -1698,   3751, -10512, -14050, -19032, -12269 },
+        {  -1017,   1398,  31842,  -1589,   3483, -10601, -14064, -19090, -12279 },
+        {   -934,   1282,  31910,  -1482,   3232, -10676, -14076, -19139, -12288 },
+        {   -855,   1174,  31974,  -1377,   2999, -10740, -14085, -19181, -12295 },
+        {   -780,   1073,  32033,  -1276,   2781, -10795, -14094, -19216, -12300 },
+        {   -710,    980,  32087,  -1179,   2577, -10841, -14100, -19246, -12305 },
+        {   -644,    894,  32138,  -1085,   2388, -10881, -14106, -19271, -12308 },
+        {   -582,    815,  32184,   -996,   2213, -10915, -14111, -19293, -12311 },
+        {   -524,    743,  32228,   -912,   2049, -10944, -14115, -19311, -12314 },
+        {   -469,    677,  32268,   -831,   1897, -10968, -14119, -19327, -12316 },
+        {   -418,    617,  32305,   -756,   1756, -10989, -14122, -19340, -12318 },
+        {   -371,    562,  32339,   -684,   1625, -11007, -14124, -19351, -12319 },
+        {   -327,    513,  32371,   -617,   1503, -11023, -14126, -19361, -12321 },
+        {   -285,    468,  32401,   -554,   1390, -11036, -14128, -19369, -12322 },
+        {   -247,    429,  32428,   -495,   1285, -11047, -14130, -19376, -12323 },
+        {   -212,    393,  32453,   -440,   1188, -11057, -14131, -19383, -12324 },
+        {   -179,    362,  32476,   -388,   1098, -11065, -14132, -19388, -12324 },
+        {   -149,    334,  32498,   -340,   1015, -11072, -14133, -19392, -12325 },
+        {   -121,    310,  32518,   -295,    937, -11078, -14134, -19396, -12325 },
+        {    -95,    290,  32536,   -254,    865, -11084, -14135, -19399, -12326 },
+        {    -72,    272,  32553,   -216,    799, -11088, -14136, -19402, -12326 },
+        {    -50,    257,  32569,   -180,    737, -11092, -14136, -19404, -12327 },
+        {    -31,    245,  32583,   -148,    680, -11095, -14137, -19406, -12327 },
+        {    -13,    235,  32596,   -118,    627, -11098, -14137, -19408, -12327 },
+        {      3,    227,  32608,    -90,    578, -11100, -14137, -19410, -12327 },
+        {     17,    221,  32620,    -65,    533, -11102, -14138, -19411, -12327 },
+        {     29,    217,  32630,    -42,    491, -11104, -14138, -19412, -12327 },
+        {     40,    214,  32640,    -22,    452, -11105, -14138, -19413, -12328 },
+        {     49,    213,  32649,     -3,    416, -11107, -14138, -19414, -12328 },
+        {     57,    214,  32657,     13,    383, -11108, -14139, -19414, -12328 },
+        {     63,    215,  32664,     27,    352, -11109, -14139, -19415, -12328 },
+        {     68,    218,  32671,     40,    324, -11109, -14139, -19415, -12328 },
+        {     71,    221,  32677,     51,    298, -11110, -14139, -19416, -12328 },
+        {     73,    226,  32683,     59,    274, -11111, -14139, -19416, -12328 },
+        {     74,    230,  32689,     67,    252, -11111, -14139, -19417, -12328 },
+        {     73,    236,  32694,     72,    231, -11112, -14139, -19417, -12328 },
+        {     71,    241,  32698,     76,    212, -11112, -14139, -19417, -12328 },
+        {     67,    247,  32702,     78,    195, -11112, -14139, -19417, -12328 },
+        {     62,    253,  32706,     78,    180, -11113, -14139, -19418, -12328 },
+        {     55,    259,  32710,     76,    165, -11113, -14139, -19418, -12328 },
+        {     47,    265,  32713,     73,    152, -11113, -14139, -19418, -12328 },
+        {     38,    270,  32716,     69,    141, -11113, -14140, -19418, -12328 },
+        {     27,    275,  32719,     62,    130, -11114, -14140, -19418, -12328 },
+        {     14,    279,  32721,     54,    121, -11114, -14140, -19418, -12328 },
+        {      0,    283,  32723,     44,    113, -11114, -14140, -19418, -12328 },
+        {    -16,    286,  32726,     32,    106, -11114, -14140, -19418, -12328 },
+        {    -34,    288,  32728,     18,    100, -11114, -14140, -19418, -12328 },
+        {    -53,    288,  32730,      3,     95, -11114, -14140, -19418, -12328 },
+        {    -75,    288,  32732,    -15,     91, -11114, -14140, -19418, -12328 },
+        {    -97,    286,  32733,    -34,     88, -11114, -14140, -19419, -12328 },
+        {   -122,    283,  32735,    -56,     87, -11114, -14140, -19419, -12328 },
+        {   -148,    277,  32737,    -79,     86, -11114, -14140, -19418, -12328 },
+        {   -175,    270,  32739,   -104,     86, -11114, -14140, -19418, -12328 },
+        {   -203,    261,  32741,   -131,     87, -11114, -14139, -19418, -12328 },
+        {   -232,    250,  32742,   -160,     89, -11114, -14139, -19418, -12328 },
+        {   -261,    237,  32744,   -190,     92, -11114, -14139, -19418, -12328 },
+        {   -288,    221,  32746,   -221,     96, -11114, -14139, -19418, -12328 },
+        {   -313,    203,  32748,   -252,    100, -11114, -14139, -19418, -12328 },
+        {   -333,    183,  32750,   -283,    104, -11114, -14139, -19418, -12328 },
+        {   -346,    160,  32752,   -312,    109, -11114, -14139, -19418, -12328 },
+        {   -347,    135,  32755,   -337,    113, -11114, -14139, -19418, -12328 },
+        {   -331,    109,  32757,   -356,    115, -11114, -14139, -19418, -12328 },
+        {   -290,     82,  32759,   -364,    115, -11114, -14139, -19418, -12328 },
+        {   -214,     54,  32762,   -358,    111, -11114, -14139, -19418, -12328 },
+        {    -88,     28,  32764,   -329,    101, -11114, -14139, -19418, -12328 },
+        {    108,      6,  32766,   -268,     83, -11114, -14139, -19418, -12328 },
+        {    401,    -10,  32767,   -162,     51, -11114, -14139, -19418, -12328 }
+    }
+};
@@ -0,0 +1,184 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Task profiler - execution time, wake period and jitter of app tasks,
+ * see task_prof.h.
+ *
+ * Hooks are called from vTaskSwitchContext(), id is the application task tag of
+ * the task that is switched out or in, 0 for tasks that aren't profiled.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include "main_LIP.h"
+#include "task_prof.h"
+#include "ctrl_tick_driver.h"
+
+/* DWT cycles per microsecond. */
+#define CYCLES_PER_US   ( CTRL_TICK_CPU_HZ / 1000000UL )
+
+static task_prof_stats stats;
+
+/* Upper bounds of jitter histogram bins in cycles, 4^i us. */
+static const uint32_t hist_limit[ TASK_PROF_HIST_BINS - 1 ] =
+{
+    1 * CYCLES_PER_US,
+    4 * CYCLES_PER_US,
+    16 * CYCLES_PER_US,
+    64 * CYCLES_PER_US,
+    256 * CYCLES_PER_US,
+    1024 * CYCLES_PER_US,
+    4096 * CYCLES_PER_US
+};
+
+/* Clear statistics, call with PendSV masked. */
+static void task_prof_clear( void )
+{
+    stats.elapsed  = 0;
+    stats.overhead = 0;
+
+    for( uint32_t i = 0; i < stats.n_tasks; i++ )
+    {
+        task_prof_task_stats *t = &stats.task[ i ];
+
+        t->jobs       = 0;
+        t->exec_min   = UINT32_MAX;
+        t->exec_max   = 0;
+        t->exec_sum   = 0;
+        t->periods    = 0;
+        t->period_min = UINT32_MAX;
+        t->period_max = 0;
+        t->period_sum = 0;
+        t->overruns   = 0;
+        for( uint32_t j = 0; j < TASK_PROF_HIST_BINS; j++ )
+        {
+            t->jitter_hist[ j ] = 0;
+        }
+
+        /* Job in progress is still measured, but its start is older than reset. */
+        t->job_start_valid = 0;
+    }
+}
+
+void task_prof_register_cycles( TaskHandle_t task, uint32_t period_cycles )
+{
+    configASSERT( stats.n_tasks < TASK_PROF_MAX_TASKS );
+
+    stats.task[ stats.n_tasks ].task           = task;
+    stats.task[ stats.n_tasks ].period_nominal = period_cycles;
+    stats.n_tasks++;
+
+    /* Tag is slot number + 1, 0 means not profiled. */
+    vTaskSetApplicationTaskTag( task, ( TaskHookFunction_t ) ( uintptr_t ) stats.n_tasks );
+
+    task_prof_clear();
+}
+
+void task_prof_register( TaskHandle_t task, uint32_t period_ms )
+{
+    task_prof_register_cycles( task, period_ms * ( CTRL_TICK_CPU_HZ / 1000UL ) );
+}
+
+void task_prof_switched_out( uint32_t id, long still_ready )
+{
+    uint32_t now = ctrl_tick_cycles();
+    task_prof_task_stats *t;
+    uint32_t response;
+
+    stats.elapsed += now - stats.last_switch;
+    stats.last_switch = now;
+
+    if( id != 0 )
+    {
+        t = &stats.task[ id - 1 ];
+        t->job_exec += now - t->slice_start;
+
+        /* Task is still ready when it was preempted or yielded, job continues. */
+        if( !still_ready && t->in_job )
+        {
+            if( t->job_exec < t->exec_min )
+            {
+                t->exec_min = t->job_exec;
+            }
+            if( t->job_exec > t->exec_max )
+            {
+                t->exec_max = t->job_exec;
+            }
+            t->exec_sum += t->job_exec;
+            t->jobs++;
+
+            response = now - t->job_start;
+            if( t->period_nominal != 0 && response > t->period_nominal )
+            {
+                t->overruns++;
+            }
+            t->in_job = 0;
+        }
+    }
+
+    stats.overhead += ctrl_tick_cycles() - now;
+}
+
+void task_prof_switched_in( uint32_t id )
+{
+    uint32_t now = ctrl_tick_cycles();
+    task_prof_task_stats *t;
+    uint32_t period;
+    uint32_t jitter;
+    uint32_t bin;
+
+    stats.elapsed += now - stats.last_switch;
+    stats.last_switch = now;
+
+    if( id != 0 )
+    {
+        t = &stats.task[ id - 1 ];
+        t->slice_start = now;
+
+        if( !t->in_job )
+        {
+            /* Task was blocked or suspended, this is the start of a new job. */
+            if( t->job_start_valid )
+            {
+                period = now - t->job_start;
+                if( period < t->period_min )
+                {
+                    t->period_min = period;
+                }
+                if( period > t->period_max )
+                {
+                    t->period_max = period;
+                }
+                t->period_sum += period;
+                t->periods++;
+
+                if( t->period_nominal != 0 )
+                {
+                    jitter = period > t->period_nominal ? period - t->period_nominal : t->period_nominal - period;
+                    bin = 0;
+                    while( bin < TASK_PROF_HIST_BINS - 1 && jitter >= hist_limit[ bin ] )
+                    {
+                        bin++;
+                    }
+                    t->jitter_hist[ bin ]++;
+                }
+            }
+            t->job_start       = now;
+            t->job_exec        = 0;
+            t->job_start_valid = 1;
+            t->in_job          = 1;
+        }
+    }
+
+    stats.overhead += ctrl_tick_cycles() - now;
+}
+
+void task_prof_get_stats( task_prof_stats *out )
+{
+    taskENTER_CRITICAL();
+    *out = stats;
+    taskEXIT_CRITICAL();
+}
+
+void task_prof_reset_stats( void )
+{
+    taskENTER_CRITICAL();
+    task_prof_clear();
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,136 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Batch plant integrator benchmark, SIMD kernel against the scalar reference.
+ *
+ * Usage: sim_batch_bench [plants] [periods]
+ *
+ * All plants start balanced at the middle of the track with the pendulum
+ * released from a small pseudo random angle, and are closed with the up
+ * position controller. Both paths run the same batch, the report has the
+ * plant time simulated per wall clock second and the speedup.
+ *
+ * Agreement is checked by stepping both paths in lockstep. They differ in sin,
+ * cos and tanh rounding only, so the states agree to roundoff until a sensor
+ * quantization step flips in some lane. From there on the lanes follow
+ * different (equally valid) trajectories of the sampled, quantized loop.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim_batch.h"
+
+#define BENCH_DEFAULT_PLANTS    4096UL
+#define BENCH_DEFAULT_PERIODS   1000UL
+
+/* Initial angles are uniform in +-BENCH_ANGLE_SPREAD rad. */
+#define BENCH_ANGLE_SPREAD      0.1
+
+/* Lockstep agreement check. */
+#define BENCH_AGREE_PERIODS     100UL
+#define BENCH_AGREE_TOLERANCE   1e-9
+
+static double wall_clock_s( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+static void bench_init( sim_batch_t *b )
+{
+    uint32_t seed = 12345;
+
+    for( uint32_t i = 0; i < b->n_padded; i++ )
+    {
+        seed = seed * 1664525u + 1013904223u;
+        sim_batch_set_state( b, i, 0.2035, ( ( seed >> 8 ) / 8388608.0 - 1.0 ) * BENCH_ANGLE_SPREAD, 0.0, 0.0 );
+    }
+}
+
+static double bench_run( sim_batch_t *b, unsigned long periods, void ( *step )( sim_batch_t * ) )
+{
+    double start;
+
+    bench_init( b );
+    start = wall_clock_s();
+    for( unsigned long k = 0; k < periods; k++ )
+    {
+        step( b );
+    }
+    return wall_clock_s() - start;
+}
+
+static uint32_t bench_balanced( const sim_batch_t *b )
+{
+    uint32_t balanced = 0;
+
+    for( uint32_t i = 0; i < b->n; i++ )
+    {
+        balanced += fabs( b->theta[ i ] ) < 0.2 && b->x[ i ] > 0.03 && b->x[ i ] < 0.3707;
+    }
+    return balanced;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned long plants = argc > 1 ? strtoul( argv[ 1 ], NULL, 10 ) : BENCH_DEFAULT_PLANTS;
+    unsigned long periods = argc > 2 ? strtoul( argv[ 2 ], NULL, 10 ) : BENCH_DEFAULT_PERIODS;
+    sim_batch_t simd, ref;
+    double wall_simd, wall_ref, plant_s, dx_max = 0.0, dtheta_max = 0.0;
+    unsigned long diverged_at = 0;
+    uint32_t balanced_simd, balanced_ref;
+
+    if( plants == 0 || sim_batch_create( &simd, ( uint32_t ) plants ) || sim_batch_create( &ref, ( uint32_t ) plants ) )
+    {
+        fprintf( stderr, "sim_batch_bench: cannot allocate %lu plants\n", plants );
+        return EXIT_FAILURE;
+    }
+
+    wall_simd = bench_run( &simd, periods, sim_batch_step );
+    wall_ref = bench_run( &ref, periods, sim_batch_step_reference );
+    balanced_simd = bench_balanced( &simd );
+    balanced_ref = bench_balanced( &ref );
+    plant_s = ( double ) plants * ( double ) periods * SIM_BATCH_DT;
+
+    bench_init( &simd );
+    bench_init( &ref );
+    for( unsigned long k = 0; k < BENCH_AGREE_PERIODS && diverged_at == 0; k++ )
+    {
+        sim_batch_step( &simd );
+        sim_batch_step_reference( &ref );
+        for( uint32_t i = 0; i < simd.n; i++ )
+        {
+            dx_max = fmax( dx_max, fabs( simd.x[ i ] - ref.x[ i ] ) );
+            dtheta_max = fmax( dtheta_max, fabs( simd.theta[ i ] - ref.theta[ i ] ) );
+        }
+        if( dx_max > BENCH_AGREE_TOLERANCE || dtheta_max > BENCH_AGREE_TOLERANCE )
+        {
+            diverged_at = k + 1;
+        }
+    }
+
+    printf( "plants:             %lu, %lu periods of %.0f ms, %u RK4 substeps\n",
+            plants, periods, SIM_BATCH_DT * 1e3, simd.substeps );
+    printf( "simd:               %s, %u lanes\n", sim_batch_simd_name(), sim_batch_simd_width() );
+    printf( "simd wall time:     %.3f s, %.0f plant s / wall s\n", wall_simd, plant_s / wall_simd );
+    printf( "scalar wall time:   %.3f s, %.0f plant s / wall s\n", wall_ref, plant_s / wall_ref );
+    printf( "speedup:            %.2f\n", wall_ref / wall_simd );
+    printf( "balanced lanes:     simd %u, scalar %u of %lu\n", balanced_simd, balanced_ref, plants );
+    printf( "lockstep max diff:  x %.3g m, theta %.3g rad", dx_max, dtheta_max );
+    if( diverged_at != 0 )
+    {
+        printf( " (quantization flip at period %lu)\n", diverged_at );
+    }
+    else
+    {
+        printf( " over %lu periods\n", BENCH_AGREE_PERIODS );
+    }
+
+    sim_batch_destroy( &simd );
+    sim_batch_destroy( &ref );
+
+    return EXIT_SUCCESS;
+}
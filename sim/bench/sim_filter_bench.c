@@ -0,0 +1,74 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Pipeline filter benchmark on the host, same cases as "filterbench" cli
+ * command (LIP/source/filter_bench.c).
+ *
+ * Usage: sim_filter_bench [ticks] [repeats]
+ *
+ * Filter sources are built with the firmware float flags. The clock is the
+ * TSC on x86 (reference cycles), ns elsewhere. Every case runs repeats times,
+ * the fastest run is reported, so a preempted run doesn't count.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#endif
+
+#include "filter_bench.h"
+
+#define BENCH_DEFAULT_TICKS     100000UL
+#define BENCH_DEFAULT_REPEATS   20UL
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define BENCH_CLOCK_UNIT "TSC cycles"
+static uint32_t bench_clock( void )
+{
+    return ( uint32_t ) __rdtsc();
+}
+#else
+#define BENCH_CLOCK_UNIT "ns"
+static uint32_t bench_clock( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( uint32_t ) ( ( uint64_t ) ts.tv_sec * 1000000000ULL + ( uint64_t ) ts.tv_nsec );
+}
+#endif
+
+int main( int argc, char **argv )
+{
+    unsigned long ticks = argc > 1 ? strtoul( argv[ 1 ], NULL, 10 ) : BENCH_DEFAULT_TICKS;
+    unsigned long repeats = argc > 2 ? strtoul( argv[ 2 ], NULL, 10 ) : BENCH_DEFAULT_REPEATS;
+    filter_bench_result best[ FILTER_BENCH_MAX_CASES ];
+    filter_bench_result run[ FILTER_BENCH_MAX_CASES ];
+    uint32_t n = 0;
+
+    if( repeats == 0 )
+    {
+        repeats = 1;
+    }
+
+    for( unsigned long r = 0; r < repeats; r++ )
+    {
+        n = filter_bench_run( bench_clock, ( uint32_t ) ticks, run, FILTER_BENCH_MAX_CASES );
+        for( uint32_t i = 0; i < n; i++ )
+        {
+            if( r == 0 || run[ i ].ticks_per_call < best[ i ].ticks_per_call )
+            {
+                best[ i ] = run[ i ];
+            }
+        }
+    }
+
+    printf( "ticks: %lu, best of %lu runs, %s per control tick\n", ticks, repeats, BENCH_CLOCK_UNIT );
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        printf( "%10.1f  %s\n", ( double ) best[ i ].ticks_per_call, best[ i ].name );
+    }
+
+    return EXIT_SUCCESS;
+}
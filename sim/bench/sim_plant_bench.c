@@ -0,0 +1,58 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Plant model step rate benchmark.
+ *
+ * Usage: sim_plant_bench [steps]
+ *
+ * Steps one plant with h = 0.1 ms (the step used by lip_sim) and a square
+ * wave input voltage, so that the cart keeps moving and the pendulum swings.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "sim_plant.h"
+
+#define BENCH_STEP          1e-4
+#define BENCH_DEFAULT_STEPS 20000000UL
+
+static double wall_clock_s( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned long steps = argc > 1 ? strtoul( argv[ 1 ], NULL, 10 ) : BENCH_DEFAULT_STEPS;
+    sim_plant_params_t params;
+    sim_plant_t plant;
+    double start, wall;
+
+    sim_plant_default_params( &params );
+    sim_plant_init( &plant, &params, 0.2, M_PI - 0.5 );
+
+    start = wall_clock_s();
+    for( unsigned long i = 0; i < steps; i++ )
+    {
+        /* 4 V, 1 Hz square wave, the cart bounces between end stops at times. */
+        if( i % 10000 == 0 )
+        {
+            sim_plant_set_voltage( &plant, ( i / 5000 ) % 4 == 0 ? 4.0 : -4.0 );
+        }
+        sim_plant_step( &plant, BENCH_STEP );
+    }
+    wall = wall_clock_s() - start;
+
+    printf( "steps:            %lu (%.1f s of plant time)\n", steps, ( double ) steps * BENCH_STEP );
+    printf( "wall time:        %.3f s\n", wall );
+    printf( "step rate:        %.2f MHz\n", ( double ) steps / wall * 1e-6 );
+    printf( "ns per step:      %.1f\n", wall / ( double ) steps * 1e9 );
+    printf( "plant s / wall s: %.0f\n", ( double ) steps * BENCH_STEP / wall );
+    printf( "final state:      x %.4f m, theta %.4f rad\n", plant.x, plant.theta );
+
+    return EXIT_SUCCESS;
+}
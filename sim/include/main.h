@@ -0,0 +1,39 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Host stand-in for Core/Inc/main.h, SIL build only.
+ * Pin defines are the same as in the CubeMX generated file.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include "stm32f4xx_hal.h"
+
+void Error_Handler( void );
+
+#define blue_btn_Pin GPIO_PIN_13
+#define blue_btn_GPIO_Port GPIOC
+#define blue_btn_EXTI_IRQn EXTI15_10_IRQn
+#define adc_pot_Pin GPIO_PIN_3
+#define adc_pot_GPIO_Port GPIOA
+#define pwm1_dcmA1_Pin GPIO_PIN_6
+#define pwm1_dcmA1_GPIO_Port GPIOA
+#define pwm2_dcmA2_Pin GPIO_PIN_7
+#define pwm2_dcmA2_GPIO_Port GPIOA
+#define led_g_Pin GPIO_PIN_0
+#define led_g_GPIO_Port GPIOB
+#define limitSW_left_Pin GPIO_PIN_14
+#define limitSW_left_GPIO_Port GPIOF
+#define limitSW_left_EXTI_IRQn EXTI15_10_IRQn
+#define limitSW_right_Pin GPIO_PIN_15
+#define limitSW_right_GPIO_Port GPIOF
+#define limitSW_right_EXTI_IRQn EXTI15_10_IRQn
+#define led_r_Pin GPIO_PIN_14
+#define led_r_GPIO_Port GPIOB
+#define enc_A_Pin GPIO_PIN_12
+#define enc_A_GPIO_Port GPIOD
+#define enc_B_Pin GPIO_PIN_13
+#define enc_B_GPIO_Port GPIOD
+#define led_b_Pin GPIO_PIN_7
+#define led_b_GPIO_Port GPIOB
+
+#endif /* __MAIN_H */
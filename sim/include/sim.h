@@ -0,0 +1,57 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Host software-in-the-loop (SIL) build, shared between the sim port, the
+ * driver stand-ins and sim_main.c.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+#include "sim_plant.h"
+
+/* Simulated rig, defined in sim_main.c. */
+extern sim_plant_t sim_rig;
+
+/* Simulated time in ms, equal to the FreeRTOS tick count. */
+extern uint32_t sim_time_ms;
+
+/* Simulated time in us, advances between ticks when control tick is faster
+than the FreeRTOS tick. */
+extern uint64_t sim_time_us;
+
+/* Control tick (TIM7) period in us, 0 while the timer is stopped.
+Set by sim_ctrl_tick_driver.c. */
+extern uint32_t sim_ctrl_tick_period_us;
+
+/* AS5600 background i2c transfer time in us, 0 while sampling is stopped.
+Set by sim_pend_enc_driver.c. */
+extern uint32_t sim_pend_enc_transfer_us;
+
+/* Setpoint potentiometer level in ADC counts, without noise. Defined in
+sim_pot_adc_driver.c. */
+extern float sim_pot_counts;
+
+/* Echo everything sent over com_send() to stdout when set. */
+extern uint8_t sim_verbose;
+
+/* Called from the port whenever all tasks are blocked. Advances the plant to
+the next simulated interrupt, which is a control tick, end of AS5600 transfer
+or SysTick, and
+runs the simulated peripheral interrupts. Returns nonzero if SysTick is due,
+then the port runs the kernel tick. */
+int sim_tick_isr( void );
+
+/* Defined in sim_motor_driver.c. Voltage on the motor terminals as set by
+the PWM compare registers. */
+float sim_motor_pwm_voltage( void );
+
+/* Defined in sim_dcm_encoder_driver.c. TIM4 CC1 capture interrupts for enc_A
+edges the cart passed since it was at x_prev at t_prev_us. */
+void sim_dcm_enc_substep( double x_prev, uint64_t t_prev_us );
+
+/* Defined in sim_pend_enc_driver.c. AS5600 i2c transfer complete interrupt,
+pushes plant sample to the sampler. */
+void sim_pend_enc_transfer_done( void );
+
+#endif /* SIM_H */
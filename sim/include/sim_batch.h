@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Batch of plants closed with the up position controller, for robustness
+ * studies with many plants at once.
+ *
+ * N plants are kept in struct-of-arrays layout. sim_batch_step() advances all
+ * of them by one control period in a single SIMD kernel (see sim_simd.h):
+ * per lane it samples the encoders, runs the util task state estimation
+ * (Tustin derivative, LP filter, pendulum speed deadzone, UPC angle setpoint)
+ * and the LIP_task_ctrl_upposition.c full state feedback law, then holds the
+ * PWM quantized voltage over the period while integrating the plant with RK4.
+ *
+ * sim_batch_step_reference() does the same lane by lane with sim_plant_step()
+ * and libm, it is the scalar reference for the SIMD path.
+ *
+ * Only sim_batch_create() allocates.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_BATCH_H
+#define SIM_BATCH_H
+
+#include <stdint.h>
+
+#include "sim_plant.h"
+
+/* Control period and default number of RK4 substeps per period. */
+#define SIM_BATCH_DT        0.01
+#define SIM_BATCH_SUBSTEPS  100
+
+typedef struct
+{
+    /* Number of plants, arrays are padded to a multiple of the SIMD width. */
+    uint32_t n;
+    uint32_t n_padded;
+
+    /* RK4 substeps per control period. */
+    uint32_t substeps;
+
+    /* UPC gains as in LIP_task_ctrl_upposition.c, V/m, V/rad, Vs/m, Vs/rad. */
+    double gains[ 4 ];
+
+    /* Plant state. */
+    double *x;
+    double *theta;
+    double *dx;
+    double *dtheta;
+    double *current;
+
+    /* Plant parameters, as given and derived for the SIMD kernel. */
+    sim_plant_params_t *params;
+    double *mass;               /* cart + reflected motor inertia + pendulum */
+    double *ml;                 /* pendulum mass * com */
+    double *inertia;
+    double *pend_viscous;
+    double *cart_viscous;       /* cart + reflected motor viscous friction */
+    double *coulomb;
+    double *inv_coulomb_speed;
+    double *kt_r;               /* force per amp */
+    double *resistance;
+    double *ke_r;               /* back emf per m/s */
+    double *inv_inductance;
+    double *deadzone;
+    double *track;
+    double *enc_mount;
+    double *enc_eccentric;
+
+    /* Controller, per plant. Units are the app units (cm, rad). */
+    double *setpoint_cm;
+    double *angle_offset;       /* pend_init_count_sum in rad */
+    double *pend_angle;         /* previous sample */
+    double *pend_speed_raw;
+    double *pend_speed_lp;
+    double *cart_position;      /* previous sample */
+    double *cart_speed_raw;
+    double *cart_speed_lp;
+    double *voltage;            /* last applied voltage */
+
+    /* Sensor noise added to the next sample, rad and cm. Set by the caller
+    before each step, zero after create. */
+    double *pend_noise;
+    double *cart_noise;
+} sim_batch_t;
+
+/* Allocate a batch of n plants with default parameters, all hanging down at
+the middle of the track. Returns 0 on success. */
+int sim_batch_create( sim_batch_t *b, uint32_t n );
+void sim_batch_destroy( sim_batch_t *b );
+
+void sim_batch_set_params( sim_batch_t *b, uint32_t i, const sim_plant_params_t *p );
+
+/* Set plant state of plant i (SI units) and restart its controller as if the
+app was started with the pendulum down and has been sampling the current
+state for a while. */
+void sim_batch_set_state( sim_batch_t *b, uint32_t i, double x, double theta, double dx, double dtheta );
+
+/* Copy plant i out, e.g. to read sensors. */
+void sim_batch_get_plant( const sim_batch_t *b, uint32_t i, sim_plant_t *plant );
+
+/* Advance all plants by one control period. */
+void sim_batch_step( sim_batch_t *b );
+void sim_batch_step_reference( sim_batch_t *b );
+
+/* SIMD instruction set and lane count sim_batch_step() was built with. */
+const char *sim_batch_simd_name( void );
+uint32_t sim_batch_simd_width( void );
+
+#endif /* SIM_BATCH_H */
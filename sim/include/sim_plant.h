@@ -0,0 +1,106 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Nonlinear cart - pendulum - DC motor plant model.
+ *
+ * State (SI units):
+ *     x       - cart position from the left end stop     m
+ *     theta   - pendulum angle, 0 is up, pi is down,      rad
+ *               positive when the arm leans towards +x
+ *     dx      - cart speed                                m/s
+ *     dtheta  - pendulum angular speed                    rad/s
+ *     current - motor armature current                    A
+ *
+ * Input is the voltage on the motor terminals, positive voltage moves the cart
+ * towards +x (right, away from the zero position limit switch).
+ *
+ * The model is plain C, has no global state and never allocates, any number
+ * of plants can be stepped independently. sim_plant_step() is one fixed step
+ * of RK4, steps up to about 0.2 ms are stable (motor L/R is 0.4 ms).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <stdint.h>
+
+/* AS5600 resolution and cart encoder ticks over the whole track. */
+#define SIM_PEND_ENC_COUNTS 4096
+#define SIM_CART_ENC_COUNTS 6488
+
+/* Motor driver, same as MAX_INPUT_VOLTAGE_POSITIVE and TIM3 ARR + 1. */
+#define SIM_SUPPLY_VOLTAGE  12.0
+#define SIM_PWM_STEPS       1000
+
+typedef struct
+{
+    /* Cart and pendulum. */
+    double cart_mass;           /* kg */
+    double pend_mass;           /* kg */
+    double pend_com;            /* m, pivot to centre of mass */
+    double pend_inertia;        /* kg m^2, about the pivot */
+    double pend_viscous;        /* N m s/rad */
+
+    /* Cart friction. Coulomb friction is smoothed with tanh( dx / coulomb_speed ). */
+    double cart_viscous;        /* N s/m */
+    double cart_coulomb;        /* N */
+    double coulomb_speed;       /* m/s */
+
+    /* DC motor and belt drive. */
+    double motor_resistance;    /* Ohm */
+    double motor_inductance;    /* H */
+    double motor_kt;            /* N m/A */
+    double motor_ke;            /* V s/rad */
+    double motor_inertia;       /* kg m^2, rotor and pulley */
+    double motor_viscous;       /* N m s/rad */
+    double pulley_radius;       /* m */
+
+    /* Driver and motor static friction, seen by the controllers as an input
+    voltage deadzone. */
+    double voltage_deadzone;    /* V */
+
+    /* Track between end stops, limit switches close within switch_travel of an end stop. */
+    double track_length;        /* m */
+    double switch_travel;       /* m */
+
+    /* AS5600 mounting. */
+    double pend_enc_mount;      /* rad, reading at theta = 0 */
+    double pend_enc_eccentric;  /* rad, first harmonic reading error */
+} sim_plant_params_t;
+
+typedef struct
+{
+    sim_plant_params_t p;
+
+    double x;
+    double theta;
+    double dx;
+    double dtheta;
+    double current;
+
+    /* Inputs. Voltage on the motor terminals and external disturbance force on the cart. */
+    double voltage;
+    double force_ext;
+} sim_plant_t;
+
+void sim_plant_default_params( sim_plant_params_t *p );
+void sim_plant_init( sim_plant_t *plant, const sim_plant_params_t *p, double x, double theta );
+
+/* One RK4 step of h seconds, then end stops. */
+void sim_plant_step( sim_plant_t *plant, double h );
+
+/* n steps of h seconds. */
+void sim_plant_advance( sim_plant_t *plant, double h, uint32_t n );
+
+/* Set voltage the same way dcm_set_output_volatage() does: clamp to the
+supply voltage and quantize to PWM dutycycle. Returns applied voltage. */
+double sim_plant_set_voltage( sim_plant_t *plant, double volts );
+
+/* Total mechanical energy, J. Potential energy is zero with pendulum down. */
+double sim_plant_energy( const sim_plant_t *plant );
+
+/* Sensors. */
+uint16_t sim_plant_pend_raw( const sim_plant_t *plant );     /* 12 bit AS5600 raw angle */
+int32_t sim_plant_cart_counts( const sim_plant_t *plant );   /* quadrature counts from left end stop */
+uint8_t sim_plant_limit_left( const sim_plant_t *plant );
+uint8_t sim_plant_limit_right( const sim_plant_t *plant );
+
+#endif /* SIM_PLANT_H */
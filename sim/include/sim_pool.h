@@ -0,0 +1,29 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Work-stealing thread pool for host tools.
+ *
+ * sim_pool_run() runs jobs 0 .. n_jobs-1 on n_threads threads (the calling
+ * thread is worker 0) and returns when all are done. Every worker starts with
+ * a contiguous range of jobs and takes them from the front. A worker that runs
+ * out steals the back half of the largest remaining range.
+ *
+ * Which worker runs a job is not deterministic. Jobs must write their results
+ * to a slot of their own (indexed by job), then results are the same for any
+ * number of threads.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_POOL_H
+#define SIM_POOL_H
+
+#include <stdint.h>
+
+/* Job function, worker is 0 .. n_threads-1 and can index per thread scratch data. */
+typedef void ( *sim_pool_job_t )( void *ctx, uint32_t worker, uint32_t job );
+
+/* Returns 0 on success, nonzero if out of memory. If some threads can't be
+started, their jobs are run by the others. */
+int sim_pool_run( uint32_t n_threads, uint32_t n_jobs, sim_pool_job_t fn, void *ctx );
+
+/* Number of online CPUs, at least 1. */
+uint32_t sim_pool_cpus( void );
+
+#endif /* SIM_POOL_H */
@@ -0,0 +1,227 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Thin double precision SIMD layer for the batch plant integrator.
+ *
+ *     AVX2 (x86-64, -mavx2)      4 lanes
+ *     NEON (aarch64)             2 lanes
+ *     anything else              1 lane, plain C
+ *
+ * Only what sim_batch.c needs is provided. Masks are the result of compares
+ * and are used with simd_blend( mask, a, b ) = mask ? a : b per lane.
+ *
+ * simd_sincos() and simd_exp() are Cephes polynomial approximations, within
+ * a couple of ulp from libm for the argument ranges met in the plant model.
+ * This file has to be compiled without -ffast-math.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_SIMD_H
+#define SIM_SIMD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined( __AVX2__ )
+
+#include <immintrin.h>
+
+#define SIMD_WIDTH 4
+#define SIMD_NAME  "avx2"
+
+typedef __m256d simd_d;
+typedef __m256d simd_mask;
+
+static inline simd_d simd_set1( double a )                   { return _mm256_set1_pd( a ); }
+static inline simd_d simd_load( const double *p )            { return _mm256_load_pd( p ); }
+static inline void   simd_store( double *p, simd_d a )       { _mm256_store_pd( p, a ); }
+static inline simd_d simd_add( simd_d a, simd_d b )          { return _mm256_add_pd( a, b ); }
+static inline simd_d simd_sub( simd_d a, simd_d b )          { return _mm256_sub_pd( a, b ); }
+static inline simd_d simd_mul( simd_d a, simd_d b )          { return _mm256_mul_pd( a, b ); }
+static inline simd_d simd_div( simd_d a, simd_d b )          { return _mm256_div_pd( a, b ); }
+static inline simd_d simd_min( simd_d a, simd_d b )          { return _mm256_min_pd( a, b ); }
+static inline simd_d simd_max( simd_d a, simd_d b )          { return _mm256_max_pd( a, b ); }
+static inline simd_d simd_floor( simd_d a )                  { return _mm256_floor_pd( a ); }
+static inline simd_d simd_round( simd_d a )                  { return _mm256_round_pd( a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC ); }
+static inline simd_mask simd_lt( simd_d a, simd_d b )        { return _mm256_cmp_pd( a, b, _CMP_LT_OQ ); }
+static inline simd_mask simd_gt( simd_d a, simd_d b )        { return _mm256_cmp_pd( a, b, _CMP_GT_OQ ); }
+static inline simd_mask simd_eq( simd_d a, simd_d b )        { return _mm256_cmp_pd( a, b, _CMP_EQ_OQ ); }
+static inline simd_mask simd_and( simd_mask a, simd_mask b ) { return _mm256_and_pd( a, b ); }
+static inline simd_mask simd_or( simd_mask a, simd_mask b )  { return _mm256_or_pd( a, b ); }
+static inline simd_d simd_blend( simd_mask m, simd_d a, simd_d b ) { return _mm256_blendv_pd( b, a, m ); }
+static inline simd_d simd_abs( simd_d a )                    { return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a ); }
+static inline simd_d simd_neg( simd_d a )                    { return _mm256_xor_pd( _mm256_set1_pd( -0.0 ), a ); }
+static inline int    simd_any( simd_mask m )                 { return _mm256_movemask_pd( m ) != 0; }
+
+/* 2^n for integer valued n in [-1022, 1023]. */
+static inline simd_d simd_pow2n( simd_d n )
+{
+    /* Exponent bits end up in the low mantissa bits after adding 2^52 + 1023. */
+    __m256i bits = _mm256_castpd_si256( _mm256_add_pd( n, _mm256_set1_pd( 4503599627370496.0 + 1023.0 ) ) );
+    return _mm256_castsi256_pd( _mm256_slli_epi64( bits, 52 ) );
+}
+
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+
+#include <arm_neon.h>
+
+#define SIMD_WIDTH 2
+#define SIMD_NAME  "neon"
+
+typedef float64x2_t simd_d;
+typedef uint64x2_t simd_mask;
+
+static inline simd_d simd_set1( double a )                   { return vdupq_n_f64( a ); }
+static inline simd_d simd_load( const double *p )            { return vld1q_f64( p ); }
+static inline void   simd_store( double *p, simd_d a )       { vst1q_f64( p, a ); }
+static inline simd_d simd_add( simd_d a, simd_d b )          { return vaddq_f64( a, b ); }
+static inline simd_d simd_sub( simd_d a, simd_d b )          { return vsubq_f64( a, b ); }
+static inline simd_d simd_mul( simd_d a, simd_d b )          { return vmulq_f64( a, b ); }
+static inline simd_d simd_div( simd_d a, simd_d b )          { return vdivq_f64( a, b ); }
+static inline simd_d simd_min( simd_d a, simd_d b )          { return vminq_f64( a, b ); }
+static inline simd_d simd_max( simd_d a, simd_d b )          { return vmaxq_f64( a, b ); }
+static inline simd_d simd_floor( simd_d a )                  { return vrndmq_f64( a ); }
+static inline simd_d simd_round( simd_d a )                  { return vrndnq_f64( a ); }
+static inline simd_mask simd_lt( simd_d a, simd_d b )        { return vcltq_f64( a, b ); }
+static inline simd_mask simd_gt( simd_d a, simd_d b )        { return vcgtq_f64( a, b ); }
+static inline simd_mask simd_eq( simd_d a, simd_d b )        { return vceqq_f64( a, b ); }
+static inline simd_mask simd_and( simd_mask a, simd_mask b ) { return vandq_u64( a, b ); }
+static inline simd_mask simd_or( simd_mask a, simd_mask b )  { return vorrq_u64( a, b ); }
+static inline simd_d simd_blend( simd_mask m, simd_d a, simd_d b ) { return vbslq_f64( m, a, b ); }
+static inline simd_d simd_abs( simd_d a )                    { return vabsq_f64( a ); }
+static inline simd_d simd_neg( simd_d a )                    { return vnegq_f64( a ); }
+static inline int    simd_any( simd_mask m )                 { return vmaxvq_u32( vreinterpretq_u32_u64( m ) ) != 0; }
+
+static inline simd_d simd_pow2n( simd_d n )
+{
+    int64x2_t bits = vshlq_n_s64( vaddq_s64( vcvtq_s64_f64( n ), vdupq_n_s64( 1023 ) ), 52 );
+    return vreinterpretq_f64_s64( bits );
+}
+
+#else
+
+#include <math.h>
+
+#define SIMD_WIDTH 1
+#define SIMD_NAME  "scalar"
+
+typedef double simd_d;
+typedef int simd_mask;
+
+static inline simd_d simd_set1( double a )                   { return a; }
+static inline simd_d simd_load( const double *p )            { return *p; }
+static inline void   simd_store( double *p, simd_d a )       { *p = a; }
+static inline simd_d simd_add( simd_d a, simd_d b )          { return a + b; }
+static inline simd_d simd_sub( simd_d a, simd_d b )          { return a - b; }
+static inline simd_d simd_mul( simd_d a, simd_d b )          { return a * b; }
+static inline simd_d simd_div( simd_d a, simd_d b )          { return a / b; }
+static inline simd_d simd_min( simd_d a, simd_d b )          { return a < b ? a : b; }
+static inline simd_d simd_max( simd_d a, simd_d b )          { return a > b ? a : b; }
+static inline simd_d simd_floor( simd_d a )                  { return floor( a ); }
+static inline simd_d simd_round( simd_d a )                  { return nearbyint( a ); }
+static inline simd_mask simd_lt( simd_d a, simd_d b )        { return a < b; }
+static inline simd_mask simd_gt( simd_d a, simd_d b )        { return a > b; }
+static inline simd_mask simd_eq( simd_d a, simd_d b )        { return a == b; }
+static inline simd_mask simd_and( simd_mask a, simd_mask b ) { return a && b; }
+static inline simd_mask simd_or( simd_mask a, simd_mask b )  { return a || b; }
+static inline simd_d simd_blend( simd_mask m, simd_d a, simd_d b ) { return m ? a : b; }
+static inline simd_d simd_abs( simd_d a )                    { return fabs( a ); }
+static inline simd_d simd_neg( simd_d a )                    { return -a; }
+static inline int    simd_any( simd_mask m )                 { return m; }
+
+static inline simd_d simd_pow2n( simd_d n )
+{
+    uint64_t bits = ( uint64_t ) ( ( int64_t ) n + 1023 ) << 52;
+    double d;
+
+    memcpy( &d, &bits, sizeof( d ) );
+    return d;
+}
+
+#endif
+
+/* a * b + c */
+static inline simd_d simd_madd( simd_d a, simd_d b, simd_d c )
+{
+    return simd_add( simd_mul( a, b ), c );
+}
+
+/* sin( x ) and cos( x ), |x| up to about 1e5. */
+static inline void simd_sincos( simd_d x, simd_d *s, simd_d *c )
+{
+    /* pi/2 split in three parts, Cody-Waite reduction. */
+    const simd_d pio2_1 = simd_set1( 1.5707962512969970703125 );
+    const simd_d pio2_2 = simd_set1( 7.5497894158615963533e-8 );
+    const simd_d pio2_3 = simd_set1( 5.3903028581581190529e-15 );
+    simd_d q, r, z, ps, pc, qm, tmp;
+    simd_mask swap, neg_s, neg_c;
+
+    q = simd_round( simd_mul( x, simd_set1( 0.63661977236758134308 ) ) );
+    r = simd_sub( x, simd_mul( q, pio2_1 ) );
+    r = simd_sub( r, simd_mul( q, pio2_2 ) );
+    r = simd_sub( r, simd_mul( q, pio2_3 ) );
+    z = simd_mul( r, r );
+
+    /* sin( r ) and cos( r ) for |r| <= pi/4. */
+    ps = simd_set1( 1.58962301576546568060e-10 );
+    ps = simd_madd( ps, z, simd_set1( -2.50507477628578072866e-8 ) );
+    ps = simd_madd( ps, z, simd_set1( 2.75573136213857245213e-6 ) );
+    ps = simd_madd( ps, z, simd_set1( -1.98412698295895385996e-4 ) );
+    ps = simd_madd( ps, z, simd_set1( 8.33333333332211858878e-3 ) );
+    ps = simd_madd( ps, z, simd_set1( -1.66666666666666307295e-1 ) );
+    ps = simd_madd( simd_mul( ps, z ), r, r );
+
+    pc = simd_set1( -1.13585365213876817300e-11 );
+    pc = simd_madd( pc, z, simd_set1( 2.08757008419747316778e-9 ) );
+    pc = simd_madd( pc, z, simd_set1( -2.75573141792967388112e-7 ) );
+    pc = simd_madd( pc, z, simd_set1( 2.48015872888517045348e-5 ) );
+    pc = simd_madd( pc, z, simd_set1( -1.38888888888730564116e-3 ) );
+    pc = simd_madd( pc, z, simd_set1( 4.16666666666665929218e-2 ) );
+    pc = simd_add( simd_sub( simd_set1( 1.0 ), simd_mul( simd_set1( 0.5 ), z ) ), simd_mul( simd_mul( z, z ), pc ) );
+
+    /* Quadrant q mod 4: 0 -> ( s, c ), 1 -> ( c, -s ), 2 -> ( -s, -c ), 3 -> ( -c, s ). */
+    qm = simd_sub( q, simd_mul( simd_set1( 4.0 ), simd_floor( simd_mul( q, simd_set1( 0.25 ) ) ) ) );
+    swap  = simd_or( simd_eq( qm, simd_set1( 1.0 ) ), simd_eq( qm, simd_set1( 3.0 ) ) );
+    neg_s = simd_gt( qm, simd_set1( 1.5 ) );
+    neg_c = simd_or( simd_eq( qm, simd_set1( 1.0 ) ), simd_eq( qm, simd_set1( 2.0 ) ) );
+
+    tmp = simd_blend( swap, pc, ps );
+    pc  = simd_blend( swap, ps, pc );
+    *s  = simd_blend( neg_s, simd_neg( tmp ), tmp );
+    *c  = simd_blend( neg_c, simd_neg( pc ), pc );
+}
+
+/* exp( x ) for x in [-700, 700]. */
+static inline simd_d simd_exp( simd_d x )
+{
+    simd_d n, r, z, p, q;
+
+    n = simd_round( simd_mul( x, simd_set1( 1.4426950408889634074 ) ) );
+    r = simd_sub( x, simd_mul( n, simd_set1( 6.93145751953125e-1 ) ) );
+    r = simd_sub( r, simd_mul( n, simd_set1( 1.42860682030941723212e-6 ) ) );
+    z = simd_mul( r, r );
+
+    p = simd_set1( 1.26177193074810590878e-4 );
+    p = simd_madd( p, z, simd_set1( 3.02994407707441961300e-2 ) );
+    p = simd_madd( p, z, simd_set1( 9.99999999999999999910e-1 ) );
+    p = simd_mul( p, r );
+
+    q = simd_set1( 3.00198505138664455042e-6 );
+    q = simd_madd( q, z, simd_set1( 2.52448340349684104192e-3 ) );
+    q = simd_madd( q, z, simd_set1( 2.27265548208155028766e-1 ) );
+    q = simd_madd( q, z, simd_set1( 2.00000000000000000009e0 ) );
+
+    /* exp( r ) = 1 + 2 p / ( q - p ) */
+    r = simd_add( simd_set1( 1.0 ), simd_div( simd_mul( simd_set1( 2.0 ), p ), simd_sub( q, p ) ) );
+
+    return simd_mul( r, simd_pow2n( n ) );
+}
+
+/* tanh( x ), saturates to +-1 for |x| > 20. */
+static inline simd_d simd_tanh( simd_d x )
+{
+    simd_d ax = simd_min( simd_abs( x ), simd_set1( 20.0 ) );
+    simd_d e = simd_exp( simd_mul( simd_set1( 2.0 ), ax ) );
+    simd_d t = simd_sub( simd_set1( 1.0 ), simd_div( simd_set1( 2.0 ), simd_add( e, simd_set1( 1.0 ) ) ) );
+
+    return simd_blend( simd_lt( x, simd_set1( 0.0 ) ), simd_neg( t ), t );
+}
+
+#endif /* SIM_SIMD_H */
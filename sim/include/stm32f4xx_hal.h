@@ -0,0 +1,95 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Host stand-in for stm32f4xx_hal.h, SIL build only.
+ *
+ * Provides just the part of the HAL that LIP/source uses outside the
+ * hardware drivers (which are replaced as a whole, see sim/source/).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef SIM_STM32F4XX_HAL_H
+#define SIM_STM32F4XX_HAL_H
+
+#include <stdint.h>
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+typedef enum
+{
+    HAL_OK       = 0x00U,
+    HAL_ERROR    = 0x01U,
+    HAL_BUSY     = 0x02U,
+    HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+/* GPIO */
+typedef enum
+{
+    GPIO_PIN_RESET = 0,
+    GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+    uint32_t port_index;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef sim_gpio_ports[ 8 ];
+
+#define GPIOA (&sim_gpio_ports[ 0 ])
+#define GPIOB (&sim_gpio_ports[ 1 ])
+#define GPIOC (&sim_gpio_ports[ 2 ])
+#define GPIOD (&sim_gpio_ports[ 3 ])
+#define GPIOE (&sim_gpio_ports[ 4 ])
+#define GPIOF (&sim_gpio_ports[ 5 ])
+#define GPIOG (&sim_gpio_ports[ 6 ])
+#define GPIOH (&sim_gpio_ports[ 7 ])
+
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+GPIO_PinState HAL_GPIO_ReadPin( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin );
+
+/* IRQ numbers referenced by CubeMX pin defines. */
+typedef enum
+{
+    EXTI15_10_IRQn = 40
+} IRQn_Type;
+
+/* Peripheral handles, contents are not used by the SIL build. */
+typedef struct
+{
+    void *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} ADC_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} UART_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} I2C_HandleTypeDef;
+
+/* Cortex-M core. */
+void NVIC_SystemReset( void );
+
+#endif /* SIM_STM32F4XX_HAL_H */
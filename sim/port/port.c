@@ -0,0 +1,159 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FreeRTOS port for the host software-in-the-loop (SIL) build, see portmacro.h.
+ *
+ * Tasks are ucontext coroutines with their own host stacks (the StackType_t
+ * buffers given by the app are only used to hold a pointer to the context).
+ * Context switches are synchronous swapcontext() calls, so a run is fully
+ * deterministic and doesn't depend on host scheduling.
+ *
+ * Simulated time only advances in vPortSimTick(), which the app calls from
+ * vApplicationIdleHook(). That is the point where all tasks are blocked and
+ * on the real target the CPU would be sleeping until the next interrupt
+ * (SysTick or control tick timer).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <stdlib.h>
+#include <ucontext.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "sim.h"
+
+/* Host stack size of each task. Generous, because glibc printf family with
+%f needs a lot more stack than newlib-nano on the target. */
+#define SIM_TASK_STACK_SIZE ( 256U * 1024U )
+
+typedef struct
+{
+    ucontext_t xContext;
+    TaskFunction_t pxCode;
+    void *pvParameters;
+} SimThread_t;
+
+/* Context of the thread that called vTaskStartScheduler(). */
+static ucontext_t xSchedulerContext;
+
+static BaseType_t xSchedulerStarted = pdFALSE;
+static UBaseType_t uxCriticalNesting = 0;
+
+/* Context switch requested inside a critical section, performed on exit from
+the critical section (equivalent of pended PendSV on Cortex-M). */
+static BaseType_t xSwitchPending = pdFALSE;
+
+/* pxTopOfStack of each TCB points to a stack slot that holds the thread pointer. */
+static SimThread_t *prvGetThread( TaskHandle_t xTask )
+{
+    return ( SimThread_t * ) **( StackType_t ** ) xTask;
+}
+
+static void prvTaskEntry( void )
+{
+    SimThread_t *pxThread = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    pxThread->pxCode( pxThread->pvParameters );
+
+    /* FreeRTOS tasks must never return. */
+    configASSERT( 0 );
+}
+
+StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack,
+                                    TaskFunction_t pxCode,
+                                    void *pvParameters )
+{
+    SimThread_t *pxThread = malloc( sizeof( SimThread_t ) );
+    void *pvStack = malloc( SIM_TASK_STACK_SIZE );
+
+    configASSERT( pxThread != NULL && pvStack != NULL );
+
+    pxThread->pxCode = pxCode;
+    pxThread->pvParameters = pvParameters;
+
+    getcontext( &pxThread->xContext );
+    pxThread->xContext.uc_stack.ss_sp = pvStack;
+    pxThread->xContext.uc_stack.ss_size = SIM_TASK_STACK_SIZE;
+    pxThread->xContext.uc_link = NULL;
+    makecontext( &pxThread->xContext, prvTaskEntry, 0 );
+
+    *pxTopOfStack = ( StackType_t ) pxThread;
+
+    return pxTopOfStack;
+}
+
+BaseType_t xPortStartScheduler( void )
+{
+    SimThread_t *pxFirst = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    uxCriticalNesting = 0;
+    xSwitchPending = pdFALSE;
+    xSchedulerStarted = pdTRUE;
+
+    swapcontext( &xSchedulerContext, &pxFirst->xContext );
+
+    /* vPortEndScheduler() returns here. */
+    return pdFALSE;
+}
+
+void vPortEndScheduler( void )
+{
+    SimThread_t *pxCurrent = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    xSchedulerStarted = pdFALSE;
+    swapcontext( &pxCurrent->xContext, &xSchedulerContext );
+}
+
+void vPortYield( void )
+{
+    SimThread_t *pxPrevious;
+    SimThread_t *pxNext;
+
+    if( xSchedulerStarted == pdFALSE )
+    {
+        return;
+    }
+
+    if( uxCriticalNesting > 0 )
+    {
+        xSwitchPending = pdTRUE;
+        return;
+    }
+    xSwitchPending = pdFALSE;
+
+    pxPrevious = prvGetThread( xTaskGetCurrentTaskHandle() );
+    vTaskSwitchContext();
+    pxNext = prvGetThread( xTaskGetCurrentTaskHandle() );
+
+    if( pxNext != pxPrevious )
+    {
+        swapcontext( &pxPrevious->xContext, &pxNext->xContext );
+    }
+}
+
+void vPortEnterCritical( void )
+{
+    uxCriticalNesting++;
+}
+
+void vPortExitCritical( void )
+{
+    configASSERT( uxCriticalNesting > 0 );
+
+    uxCriticalNesting--;
+    if( uxCriticalNesting == 0 && xSwitchPending != pdFALSE )
+    {
+        vPortYield();
+    }
+}
+
+void vPortSimTick( void )
+{
+    vPortEnterCritical();
+
+    /* Simulated peripherals and their interrupts, then SysTick if it is due. */
+    if( sim_tick_isr() != 0 && xTaskIncrementTick() != pdFALSE )
+    {
+        vPortYield();
+    }
+
+    vPortExitCritical();
+}
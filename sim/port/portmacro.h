@@ -0,0 +1,94 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * FreeRTOS port for the host software-in-the-loop (SIL) build.
+ *
+ * Every task gets its own host stack and ucontext, only one context runs at a
+ * time, so the kernel sees a single core exactly like on the STM32. There are
+ * no asynchronous interrupts: the tick is generated from the idle hook
+ * (see vPortSimTick() in port.c), which means task code takes zero simulated
+ * time and the simulation runs as fast as the host allows.
+ *
+ * "Interrupts" of the simulated peripherals are called from the tick with the
+ * kernel in a critical section, FromISR API and portYIELD_FROM_ISR() work the
+ * same way as on the Cortex-M4 (context switch is deferred until the critical
+ * section is left, like PendSV).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Type definitions. */
+#define portCHAR          char
+#define portFLOAT         float
+#define portDOUBLE        double
+#define portLONG          long
+#define portSHORT         short
+#define portSTACK_TYPE    unsigned long
+#define portBASE_TYPE     long
+#define portPOINTER_SIZE_TYPE uintptr_t
+
+typedef portSTACK_TYPE   StackType_t;
+typedef long             BaseType_t;
+typedef unsigned long    UBaseType_t;
+
+#if ( configUSE_16_BIT_TICKS == 1 )
+    typedef uint16_t     TickType_t;
+    #define portMAX_DELAY              ( TickType_t ) 0xffff
+#else
+    typedef uint32_t     TickType_t;
+    #define portMAX_DELAY              ( TickType_t ) 0xffffffffUL
+    #define portTICK_TYPE_IS_ATOMIC    1
+#endif
+
+/* Architecture specifics. */
+#define portSTACK_GROWTH      ( -1 )
+#define portTICK_PERIOD_MS    ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT    8
+#define portDONT_DISCARD      __attribute__( ( used ) )
+
+/* Scheduler utilities. */
+void vPortYield( void );
+#define portYIELD()                                 vPortYield()
+#define portEND_SWITCHING_ISR( xSwitchRequired )    do { if( xSwitchRequired != pdFALSE ) { vPortYield(); } } while( 0 )
+#define portYIELD_FROM_ISR( x )                     portEND_SWITCHING_ISR( x )
+
+/* Critical section management. */
+void vPortEnterCritical( void );
+void vPortExitCritical( void );
+#define portSET_INTERRUPT_MASK_FROM_ISR()           ( vPortEnterCritical(), ( UBaseType_t ) 0 )
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR( x )      do { ( void ) ( x ); vPortExitCritical(); } while( 0 )
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()                        vPortEnterCritical()
+#define portEXIT_CRITICAL()                         vPortExitCritical()
+
+/* Port optimised task selection, the same bitmap scheme as ARM_CM4F. */
+#if ( configUSE_PORT_OPTIMISED_TASK_SELECTION == 1 )
+    #if ( configMAX_PRIORITIES > 32 )
+        #error configUSE_PORT_OPTIMISED_TASK_SELECTION can only be set to 1 when configMAX_PRIORITIES is less than or equal to 32.
+    #endif
+    #define portRECORD_READY_PRIORITY( uxPriority, uxReadyPriorities )    ( uxReadyPriorities ) |= ( 1UL << ( uxPriority ) )
+    #define portRESET_READY_PRIORITY( uxPriority, uxReadyPriorities )     ( uxReadyPriorities ) &= ~( 1UL << ( uxPriority ) )
+    #define portGET_HIGHEST_PRIORITY( uxTopPriority, uxReadyPriorities )  uxTopPriority = ( 63UL - ( UBaseType_t ) __builtin_clzl( ( uxReadyPriorities ) ) )
+#endif
+
+/* Task function macros as described on the FreeRTOS.org WEB site. */
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters )    void vFunction( void * pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters )          void vFunction( void * pvParameters )
+
+#define portNOP()
+#define portMEMORY_BARRIER()    __asm volatile ( "" ::: "memory" )
+
+/* Advance simulated time by one tick, called from the idle hook. */
+void vPortSimTick( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PORTMACRO_H */
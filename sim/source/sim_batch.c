@@ -0,0 +1,458 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Batch of plants closed with the up position controller, see sim_batch.h.
+ *
+ * Plant equations are the same as in sim_plant.c, controller and state
+ * estimation follow LIP_task_util.c and LIP_task_ctrl_upposition.c.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_batch.h"
+#include "sim_simd.h"
+
+#define SIM_G 9.81
+
+/* Arrays are aligned for the widest SIMD load. */
+#define SIM_BATCH_ALIGN 64
+
+/* App constants, see dcm_encoder_driver.h, pend_enc_driver.h and LIP_task_util.c. */
+#define APP_PI                  3.1415926536
+#define APP_PI2                 6.2831853072
+#define APP_ENCODER_MULTIPLIER  ( 40.7 / 6488.0 )
+#define APP_ANGLE_UP_SP_BASE    -0.070563
+#define APP_SPEED_DEADZONE      0.2
+#define APP_LP_TIME_CONSTANT    0.025
+
+/* LIP_task_ctrl_upposition.c */
+#define UPC_SWITCH_ANGLE        ( 35.0 * APP_PI / 180.0 )
+#define UPC_VOLTAGE_DEADZONE    1.0
+
+/* LP_filter coefficients for T = 0.025 s, dt = 10 ms. */
+#define LP_C1 ( SIM_BATCH_DT / ( 2.0 * APP_LP_TIME_CONSTANT + SIM_BATCH_DT ) )
+#define LP_C2 ( ( 2.0 * APP_LP_TIME_CONSTANT - SIM_BATCH_DT ) / ( 2.0 * APP_LP_TIME_CONSTANT + SIM_BATCH_DT ) )
+
+static double *sim_batch_alloc( uint32_t n )
+{
+    double *p = aligned_alloc( SIM_BATCH_ALIGN, ( ( n * sizeof( double ) + SIM_BATCH_ALIGN - 1 ) / SIM_BATCH_ALIGN ) * SIM_BATCH_ALIGN );
+
+    if( p != NULL )
+    {
+        memset( p, 0, n * sizeof( double ) );
+    }
+    return p;
+}
+
+/* All per plant double arrays, in one place for create and destroy. */
+#define SIM_BATCH_N_ARRAYS 31
+static void sim_batch_arrays( sim_batch_t *b, double **arrays[ SIM_BATCH_N_ARRAYS ] )
+{
+    double **list[ SIM_BATCH_N_ARRAYS ] =
+    {
+        &b->x, &b->theta, &b->dx, &b->dtheta, &b->current,
+        &b->mass, &b->ml, &b->inertia, &b->pend_viscous, &b->cart_viscous, &b->coulomb,
+        &b->inv_coulomb_speed, &b->kt_r, &b->resistance, &b->ke_r, &b->inv_inductance,
+        &b->deadzone, &b->track, &b->enc_mount, &b->enc_eccentric,
+        &b->setpoint_cm, &b->angle_offset, &b->pend_angle, &b->pend_speed_raw, &b->pend_speed_lp,
+        &b->cart_position, &b->cart_speed_raw, &b->cart_speed_lp, &b->voltage,
+        &b->pend_noise, &b->cart_noise
+    };
+
+    memcpy( arrays, list, sizeof( list ) );
+}
+
+int sim_batch_create( sim_batch_t *b, uint32_t n )
+{
+    double **arrays[ SIM_BATCH_N_ARRAYS ];
+    sim_plant_params_t p;
+
+    memset( b, 0, sizeof( *b ) );
+    b->n = n;
+    b->n_padded = ( n + SIMD_WIDTH - 1 ) / SIMD_WIDTH * SIMD_WIDTH;
+    b->substeps = SIM_BATCH_SUBSTEPS;
+    b->gains[ 0 ] = -74.5;
+    b->gains[ 1 ] = -76.0;
+    b->gains[ 2 ] = -51.5;
+    b->gains[ 3 ] = -9.0;
+
+    sim_batch_arrays( b, arrays );
+    for( uint32_t k = 0; k < SIM_BATCH_N_ARRAYS; k++ )
+    {
+        *arrays[ k ] = sim_batch_alloc( b->n_padded );
+        if( *arrays[ k ] == NULL )
+        {
+            sim_batch_destroy( b );
+            return 1;
+        }
+    }
+    b->params = calloc( b->n_padded, sizeof( sim_plant_params_t ) );
+    if( b->params == NULL )
+    {
+        sim_batch_destroy( b );
+        return 1;
+    }
+
+    /* Padding lanes are simulated too, they just hold valid plants. */
+    sim_plant_default_params( &p );
+    for( uint32_t i = 0; i < b->n_padded; i++ )
+    {
+        sim_batch_set_params( b, i, &p );
+        b->setpoint_cm[ i ] = 20.35;
+        sim_batch_set_state( b, i, 0.2035, M_PI, 0.0, 0.0 );
+    }
+    return 0;
+}
+
+void sim_batch_destroy( sim_batch_t *b )
+{
+    double **arrays[ SIM_BATCH_N_ARRAYS ];
+
+    sim_batch_arrays( b, arrays );
+    for( uint32_t k = 0; k < SIM_BATCH_N_ARRAYS; k++ )
+    {
+        free( *arrays[ k ] );
+        *arrays[ k ] = NULL;
+    }
+    free( b->params );
+    b->params = NULL;
+}
+
+void sim_batch_set_params( sim_batch_t *b, uint32_t i, const sim_plant_params_t *p )
+{
+    double r2 = p->pulley_radius * p->pulley_radius;
+
+    b->params[ i ]            = *p;
+    b->mass[ i ]              = p->cart_mass + p->motor_inertia / r2 + p->pend_mass;
+    b->ml[ i ]                = p->pend_mass * p->pend_com;
+    b->inertia[ i ]           = p->pend_inertia;
+    b->pend_viscous[ i ]      = p->pend_viscous;
+    b->cart_viscous[ i ]      = p->cart_viscous + p->motor_viscous / r2;
+    b->coulomb[ i ]           = p->cart_coulomb;
+    b->inv_coulomb_speed[ i ] = 1.0 / p->coulomb_speed;
+    b->kt_r[ i ]              = p->motor_kt / p->pulley_radius;
+    b->resistance[ i ]        = p->motor_resistance;
+    b->ke_r[ i ]              = p->motor_ke / p->pulley_radius;
+    b->inv_inductance[ i ]    = 1.0 / p->motor_inductance;
+    b->deadzone[ i ]          = p->voltage_deadzone;
+    b->track[ i ]             = p->track_length;
+    b->enc_mount[ i ]         = p->pend_enc_mount;
+    b->enc_eccentric[ i ]     = p->pend_enc_eccentric;
+}
+
+void sim_batch_get_plant( const sim_batch_t *b, uint32_t i, sim_plant_t *plant )
+{
+    sim_plant_init( plant, &b->params[ i ], b->x[ i ], b->theta[ i ] );
+    plant->dx = b->dx[ i ];
+    plant->dtheta = b->dtheta[ i ];
+    plant->current = b->current[ i ];
+    plant->voltage = b->voltage[ i ];
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Scalar reference.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+/* Pendulum angle as util task sees it, before the offset is subtracted. AS5600
+counts are taken as already unwrapped, like the cumulative count. */
+static double sim_batch_pend_reading( const sim_plant_params_t *p, double theta )
+{
+    double counts = floor( ( theta + p->pend_enc_mount + p->pend_enc_eccentric * cos( theta ) )
+                           * ( SIM_PEND_ENC_COUNTS / ( 2.0 * M_PI ) ) );
+
+    return counts * ( APP_PI2 / SIM_PEND_ENC_COUNTS );
+}
+
+static double sim_batch_cart_reading( const sim_plant_params_t *p, double x )
+{
+    return floor( x / p->track_length * SIM_CART_ENC_COUNTS ) * APP_ENCODER_MULTIPLIER;
+}
+
+void sim_batch_set_state( sim_batch_t *b, uint32_t i, double x, double theta, double dx, double dtheta )
+{
+    const sim_plant_params_t *p = &b->params[ i ];
+
+    b->x[ i ] = x;
+    b->theta[ i ] = theta;
+    b->dx[ i ] = dx;
+    b->dtheta[ i ] = dtheta;
+    b->current[ i ] = 0.0;
+    b->voltage[ i ] = 0.0;
+
+    /* main_LIP_init(), pendulum assumed to be down. */
+    b->angle_offset[ i ] = sim_batch_pend_reading( p, M_PI ) - APP_PI;
+
+    b->pend_angle[ i ] = sim_batch_pend_reading( p, theta ) - b->angle_offset[ i ];
+    b->pend_speed_raw[ i ] = 0.0;
+    b->pend_speed_lp[ i ] = 0.0;
+    b->cart_position[ i ] = sim_batch_cart_reading( p, x );
+    b->cart_speed_raw[ i ] = 0.0;
+    b->cart_speed_lp[ i ] = 0.0;
+}
+
+/* One util task + ctrl_5 sample of plant i, returns requested voltage. */
+static double sim_batch_ctrl_reference( sim_batch_t *b, uint32_t i )
+{
+    const sim_plant_params_t *p = &b->params[ i ];
+    double angle, raw, speed, position, revolutions, base, angle_sp, e, u;
+
+    /* Pendulum angle and speed. */
+    angle = sim_batch_pend_reading( p, b->theta[ i ] ) - b->angle_offset[ i ] + b->pend_noise[ i ];
+    raw = ( angle - b->pend_angle[ i ] ) * 2.0 / SIM_BATCH_DT - b->pend_speed_raw[ i ];
+    b->pend_speed_lp[ i ] = LP_C1 * ( raw + b->pend_speed_raw[ i ] ) + LP_C2 * b->pend_speed_lp[ i ];
+    b->pend_speed_raw[ i ] = raw;
+    b->pend_angle[ i ] = angle;
+    speed = fabs( b->pend_speed_lp[ i ] ) < APP_SPEED_DEADZONE ? 0.0 : b->pend_speed_lp[ i ];
+
+    /* Cart position and speed. */
+    position = sim_batch_cart_reading( p, b->x[ i ] ) + b->cart_noise[ i ];
+    raw = ( position - b->cart_position[ i ] ) * 2.0 / SIM_BATCH_DT - b->cart_speed_raw[ i ];
+    b->cart_speed_lp[ i ] = LP_C1 * ( raw + b->cart_speed_raw[ i ] ) + LP_C2 * b->cart_speed_lp[ i ];
+    b->cart_speed_raw[ i ] = raw;
+    b->cart_position[ i ] = position;
+
+    /* UPC angle range and setpoint. */
+    revolutions = floor( ( angle - APP_PI ) / APP_PI2 ) + 1.0;
+    base = angle - APP_PI2 * revolutions;
+    angle_sp = APP_ANGLE_UP_SP_BASE + revolutions * APP_PI2;
+
+    if( !( base > -UPC_SWITCH_ANGLE && base < UPC_SWITCH_ANGLE ) )
+    {
+        return 0.0;
+    }
+
+    e = b->setpoint_cm[ i ] - position;
+    if( e > 0.0 )
+    {
+        u = b->gains[ 0 ] * 0.01 * e + UPC_VOLTAGE_DEADZONE;
+    }
+    else if( e < 0.0 )
+    {
+        u = b->gains[ 0 ] * 0.01 * e - UPC_VOLTAGE_DEADZONE;
+    }
+    else
+    {
+        u = 0.0;
+    }
+    u += b->gains[ 1 ] * ( angle_sp - angle )
+       - b->gains[ 2 ] * 0.01 * b->cart_speed_lp[ i ]
+       - b->gains[ 3 ] * speed;
+
+    return u;
+}
+
+void sim_batch_step_reference( sim_batch_t *b )
+{
+    double h = SIM_BATCH_DT / b->substeps;
+    sim_plant_t plant;
+
+    for( uint32_t i = 0; i < b->n_padded; i++ )
+    {
+        double u = sim_batch_ctrl_reference( b, i );
+
+        sim_batch_get_plant( b, i, &plant );
+        b->voltage[ i ] = sim_plant_set_voltage( &plant, u );
+        sim_plant_advance( &plant, h, b->substeps );
+
+        b->x[ i ] = plant.x;
+        b->theta[ i ] = plant.theta;
+        b->dx[ i ] = plant.dx;
+        b->dtheta[ i ] = plant.dtheta;
+        b->current[ i ] = plant.current;
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * SIMD kernel.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+/* Plant parameters of one group of lanes. */
+typedef struct
+{
+    simd_d mass, ml, inertia, pend_viscous, cart_viscous, coulomb, inv_coulomb_speed;
+    simd_d kt_r, resistance, ke_r, inv_inductance;
+} simd_plant_t;
+
+static inline void simd_deriv( const simd_plant_t *p, simd_d v_eff,
+                               simd_d theta, simd_d dx, simd_d dtheta, simd_d current,
+                               simd_d *ddx, simd_d *ddtheta, simd_d *dcurrent )
+{
+    simd_d s, c, force, a12, b1, b2, inv_det;
+
+    simd_sincos( theta, &s, &c );
+
+    force = simd_mul( p->kt_r, current );
+    force = simd_sub( force, simd_mul( p->cart_viscous, dx ) );
+    force = simd_sub( force, simd_mul( p->coulomb, simd_tanh( simd_mul( dx, p->inv_coulomb_speed ) ) ) );
+
+    a12 = simd_mul( p->ml, c );
+    b1 = simd_add( force, simd_mul( simd_mul( p->ml, s ), simd_mul( dtheta, dtheta ) ) );
+    b2 = simd_sub( simd_mul( simd_mul( p->ml, simd_set1( SIM_G ) ), s ), simd_mul( p->pend_viscous, dtheta ) );
+    inv_det = simd_div( simd_set1( 1.0 ), simd_sub( simd_mul( p->mass, p->inertia ), simd_mul( a12, a12 ) ) );
+
+    *ddx = simd_mul( simd_sub( simd_mul( b1, p->inertia ), simd_mul( a12, b2 ) ), inv_det );
+    *ddtheta = simd_mul( simd_sub( simd_mul( p->mass, b2 ), simd_mul( a12, b1 ) ), inv_det );
+    *dcurrent = simd_mul( simd_sub( simd_sub( v_eff, simd_mul( p->resistance, current ) ),
+                                    simd_mul( p->ke_r, dx ) ), p->inv_inductance );
+}
+
+void sim_batch_step( sim_batch_t *b )
+{
+    const simd_d zero = simd_set1( 0.0 );
+    const simd_d one = simd_set1( 1.0 );
+    const simd_d two_over_dt = simd_set1( 2.0 / SIM_BATCH_DT );
+    const simd_d lp_c1 = simd_set1( LP_C1 );
+    const simd_d lp_c2 = simd_set1( LP_C2 );
+    const simd_d pi = simd_set1( APP_PI );
+    const simd_d pi2 = simd_set1( APP_PI2 );
+    const simd_d g0 = simd_set1( b->gains[ 0 ] * 0.01 );
+    const simd_d g1 = simd_set1( b->gains[ 1 ] );
+    const simd_d g2 = simd_set1( b->gains[ 2 ] * 0.01 );
+    const simd_d g3 = simd_set1( b->gains[ 3 ] );
+    const simd_d h = simd_set1( SIM_BATCH_DT / b->substeps );
+    const simd_d h2 = simd_set1( 0.5 * SIM_BATCH_DT / b->substeps );
+    const simd_d h6 = simd_set1( SIM_BATCH_DT / b->substeps / 6.0 );
+
+    for( uint32_t i = 0; i < b->n_padded; i += SIMD_WIDTH )
+    {
+        simd_plant_t p;
+        simd_d x = simd_load( &b->x[ i ] );
+        simd_d theta = simd_load( &b->theta[ i ] );
+        simd_d dx = simd_load( &b->dx[ i ] );
+        simd_d dtheta = simd_load( &b->dtheta[ i ] );
+        simd_d current = simd_load( &b->current[ i ] );
+        simd_d track = simd_load( &b->track[ i ] );
+        simd_d deadzone = simd_load( &b->deadzone[ i ] );
+        simd_d s, c, angle, raw, raw_prev, lp, speed, position, revolutions, base, angle_sp, e, u, v_eff;
+        simd_mask active;
+
+        p.mass              = simd_load( &b->mass[ i ] );
+        p.ml                = simd_load( &b->ml[ i ] );
+        p.inertia           = simd_load( &b->inertia[ i ] );
+        p.pend_viscous      = simd_load( &b->pend_viscous[ i ] );
+        p.cart_viscous      = simd_load( &b->cart_viscous[ i ] );
+        p.coulomb           = simd_load( &b->coulomb[ i ] );
+        p.inv_coulomb_speed = simd_load( &b->inv_coulomb_speed[ i ] );
+        p.kt_r              = simd_load( &b->kt_r[ i ] );
+        p.resistance        = simd_load( &b->resistance[ i ] );
+        p.ke_r              = simd_load( &b->ke_r[ i ] );
+        p.inv_inductance    = simd_load( &b->inv_inductance[ i ] );
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+         * Sensors and util task.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        simd_sincos( theta, &s, &c );
+        angle = simd_add( theta, simd_add( simd_load( &b->enc_mount[ i ] ), simd_mul( simd_load( &b->enc_eccentric[ i ] ), c ) ) );
+        angle = simd_floor( simd_mul( angle, simd_set1( SIM_PEND_ENC_COUNTS / ( 2.0 * M_PI ) ) ) );
+        angle = simd_sub( simd_mul( angle, simd_set1( APP_PI2 / SIM_PEND_ENC_COUNTS ) ), simd_load( &b->angle_offset[ i ] ) );
+        angle = simd_add( angle, simd_load( &b->pend_noise[ i ] ) );
+
+        raw_prev = simd_load( &b->pend_speed_raw[ i ] );
+        raw = simd_sub( simd_mul( simd_sub( angle, simd_load( &b->pend_angle[ i ] ) ), two_over_dt ), raw_prev );
+        lp = simd_add( simd_mul( lp_c1, simd_add( raw, raw_prev ) ), simd_mul( lp_c2, simd_load( &b->pend_speed_lp[ i ] ) ) );
+        simd_store( &b->pend_angle[ i ], angle );
+        simd_store( &b->pend_speed_raw[ i ], raw );
+        simd_store( &b->pend_speed_lp[ i ], lp );
+        speed = simd_blend( simd_lt( simd_abs( lp ), simd_set1( APP_SPEED_DEADZONE ) ), zero, lp );
+
+        position = simd_floor( simd_mul( simd_div( x, track ), simd_set1( SIM_CART_ENC_COUNTS ) ) );
+        position = simd_madd( position, simd_set1( APP_ENCODER_MULTIPLIER ), simd_load( &b->cart_noise[ i ] ) );
+        raw_prev = simd_load( &b->cart_speed_raw[ i ] );
+        raw = simd_sub( simd_mul( simd_sub( position, simd_load( &b->cart_position[ i ] ) ), two_over_dt ), raw_prev );
+        lp = simd_add( simd_mul( lp_c1, simd_add( raw, raw_prev ) ), simd_mul( lp_c2, simd_load( &b->cart_speed_lp[ i ] ) ) );
+        simd_store( &b->cart_position[ i ], position );
+        simd_store( &b->cart_speed_raw[ i ], raw );
+        simd_store( &b->cart_speed_lp[ i ], lp );
+
+        revolutions = simd_add( simd_floor( simd_div( simd_sub( angle, pi ), pi2 ) ), one );
+        base = simd_sub( angle, simd_mul( pi2, revolutions ) );
+        angle_sp = simd_add( simd_set1( APP_ANGLE_UP_SP_BASE ), simd_mul( revolutions, pi2 ) );
+        active = simd_and( simd_gt( base, simd_set1( -UPC_SWITCH_ANGLE ) ), simd_lt( base, simd_set1( UPC_SWITCH_ANGLE ) ) );
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+         * UPC law with deadzone compensation on the cart position error.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        e = simd_sub( simd_load( &b->setpoint_cm[ i ] ), position );
+        u = simd_mul( g0, e );
+        u = simd_blend( simd_gt( e, zero ), simd_add( u, simd_set1( UPC_VOLTAGE_DEADZONE ) ), u );
+        u = simd_blend( simd_lt( e, zero ), simd_sub( u, simd_set1( UPC_VOLTAGE_DEADZONE ) ), u );
+        u = simd_add( u, simd_mul( g1, simd_sub( angle_sp, angle ) ) );
+        u = simd_sub( u, simd_mul( g2, lp ) );
+        u = simd_sub( u, simd_mul( g3, speed ) );
+        u = simd_blend( active, u, zero );
+
+        /* dcm_set_output_volatage(): clamp and quantize to PWM dutycycle. */
+        e = simd_min( simd_abs( u ), simd_set1( SIM_SUPPLY_VOLTAGE ) );
+        e = simd_mul( simd_floor( simd_mul( e, simd_set1( SIM_PWM_STEPS / SIM_SUPPLY_VOLTAGE ) ) ),
+                      simd_set1( SIM_SUPPLY_VOLTAGE / SIM_PWM_STEPS ) );
+        u = simd_blend( simd_lt( u, zero ), simd_neg( e ), e );
+        simd_store( &b->voltage[ i ], u );
+
+        /* Deadzone of the plant. */
+        v_eff = simd_max( simd_sub( simd_abs( u ), deadzone ), zero );
+        v_eff = simd_blend( simd_lt( u, zero ), simd_neg( v_eff ), v_eff );
+
+        /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+         * Plant, RK4 substeps with voltage held over the period.
+         * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+        for( uint32_t k = 0; k < b->substeps; k++ )
+        {
+            simd_d k1v, k1w, k1i, k2v, k2w, k2i, k3v, k3w, k3i, k4v, k4w, k4i;
+            simd_d k2x, k2t, k3x, k3t, k4x, k4t;
+            simd_mask lo, hi;
+
+            simd_deriv( &p, v_eff, theta, dx, dtheta, current, &k1v, &k1w, &k1i );
+
+            k2x = simd_madd( h2, k1v, dx );
+            k2t = simd_madd( h2, k1w, dtheta );
+            simd_deriv( &p, v_eff, simd_madd( h2, dtheta, theta ), k2x, k2t, simd_madd( h2, k1i, current ),
+                        &k2v, &k2w, &k2i );
+
+            k3x = simd_madd( h2, k2v, dx );
+            k3t = simd_madd( h2, k2w, dtheta );
+            simd_deriv( &p, v_eff, simd_madd( h2, k2t, theta ), k3x, k3t, simd_madd( h2, k2i, current ),
+                        &k3v, &k3w, &k3i );
+
+            k4x = simd_madd( h, k3v, dx );
+            k4t = simd_madd( h, k3w, dtheta );
+            simd_deriv( &p, v_eff, simd_madd( h, k3t, theta ), k4x, k4t, simd_madd( h, k3i, current ),
+                        &k4v, &k4w, &k4i );
+
+            /* Position derivatives of the stages are the stage speeds. */
+            x = simd_madd( h6, simd_add( simd_add( dx, k4x ), simd_mul( simd_set1( 2.0 ), simd_add( k2x, k3x ) ) ), x );
+            theta = simd_madd( h6, simd_add( simd_add( dtheta, k4t ), simd_mul( simd_set1( 2.0 ), simd_add( k2t, k3t ) ) ), theta );
+            dx = simd_madd( h6, simd_add( simd_add( k1v, k4v ), simd_mul( simd_set1( 2.0 ), simd_add( k2v, k3v ) ) ), dx );
+            dtheta = simd_madd( h6, simd_add( simd_add( k1w, k4w ), simd_mul( simd_set1( 2.0 ), simd_add( k2w, k3w ) ) ), dtheta );
+            current = simd_madd( h6, simd_add( simd_add( k1i, k4i ), simd_mul( simd_set1( 2.0 ), simd_add( k2i, k3i ) ) ), current );
+
+            /* Inelastic end stops, see sim_plant_end_stop(). */
+            lo = simd_lt( x, zero );
+            hi = simd_gt( x, track );
+            if( simd_any( simd_or( lo, hi ) ) )
+            {
+                simd_mask stop = simd_or( lo, hi );
+
+                simd_sincos( theta, &s, &c );
+                dtheta = simd_blend( stop, simd_add( dtheta, simd_div( simd_mul( simd_mul( p.ml, c ), dx ), p.inertia ) ), dtheta );
+                x = simd_blend( lo, zero, simd_blend( hi, track, x ) );
+                dx = simd_blend( stop, zero, dx );
+            }
+        }
+
+        simd_store( &b->x[ i ], x );
+        simd_store( &b->theta[ i ], theta );
+        simd_store( &b->dx[ i ], dx );
+        simd_store( &b->dtheta[ i ], dtheta );
+        simd_store( &b->current[ i ], current );
+    }
+}
+
+const char *sim_batch_simd_name( void )
+{
+    return SIMD_NAME;
+}
+
+uint32_t sim_batch_simd_width( void )
+{
+    return SIMD_WIDTH;
+}
@@ -0,0 +1,21 @@
+/*
+ * Description: SIL stand-in for LIP/source/com_driver.c
+ *
+ * UART3 output goes to stdout when the sim runs with -v, otherwise it is
+ * dropped.
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "com_driver.h"
+#include "sim.h"
+
+void com_send( char* message, uint8_t len )
+{
+    if( sim_verbose )
+    {
+        fwrite( message, 1, len, stdout );
+    }
+}
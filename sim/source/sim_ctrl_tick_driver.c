@@ -0,0 +1,23 @@
+/*
+ * Description: SIL stand-in for LIP/source/ctrl_tick_driver.c
+ *
+ * TIM7 period is handed to the sim, which calls ctrl_tick_isr() at every
+ * control tick in virtual time (see sim_tick_isr() in sim_main.c). The cycle
+ * counter is virtual time at core clock, so task execution takes no time and
+ * the measured latency is zero, jitter comes only from the timer period.
+ *
+ */
+
+#include "main_LIP.h"
+#include "ctrl_tick_driver.h"
+#include "sim.h"
+
+void ctrl_tick_timer_start( void )
+{
+    sim_ctrl_tick_period_us = CTRL_TICK_TIMER_HZ / CTRL_TICK_HZ;
+}
+
+uint32_t ctrl_tick_cycles( void )
+{
+    return ( uint32_t ) ( sim_time_us * ( CTRL_TICK_CPU_HZ / 1000000UL ) );
+}
@@ -0,0 +1,118 @@
+/*
+ * Description: SIL stand-in for LIP/source/dcm_encoder_driver.c
+ *
+ * TIM4 in encoder mode is emulated from the plant cart position. The counter
+ * starts from zero at enc_init() and wraps around at ARR (7000), like the
+ * hardware counter does when the cart is moved left of the zero position.
+ * The extended count (unwrapped from successive counter reads on the target)
+ * is the plant count since zeroing.
+ *
+ * CC1 capture interrupt on enc_A rising edges is raised from the plant after
+ * every substep, edge time is interpolated within the substep.
+ *
+ */
+
+#include <math.h>
+
+#include "dcm_encoder_driver.h"
+#include "cart_vel.h"
+#include "ctrl_tick_driver.h"
+#include "sim.h"
+
+/* TIM4 ARR + 1. */
+#define SIM_ENC_PERIOD 7001
+
+/* Plant encoder count that corresponds to timer count zero. */
+static int32_t enc_zero_reference = 0;
+
+void enc_init( void )
+{
+    enc_zero_reference = sim_plant_cart_counts( &sim_rig );
+}
+
+uint16_t enc_get_count( void )
+{
+    int32_t cnt = ( sim_plant_cart_counts( &sim_rig ) - enc_zero_reference ) % SIM_ENC_PERIOD;
+
+    if( cnt < 0 )
+    {
+        cnt += SIM_ENC_PERIOD;
+    }
+    return ( uint16_t ) cnt;
+}
+
+void dcm_enc_zero_counter( void )
+{
+    enc_zero_reference = sim_plant_cart_counts( &sim_rig );
+}
+
+/* Captured counter value for plant encoder count cnt. */
+static uint16_t sim_enc_capture( int32_t cnt )
+{
+    cnt = ( cnt - enc_zero_reference ) % SIM_ENC_PERIOD;
+    if( cnt < 0 )
+    {
+        cnt += SIM_ENC_PERIOD;
+    }
+    return ( uint16_t ) cnt;
+}
+
+void sim_dcm_enc_substep( double x_prev, uint64_t t_prev_us )
+{
+    double c0 = x_prev / sim_rig.p.track_length * SIM_CART_ENC_COUNTS;
+    double c1 = sim_rig.x / sim_rig.p.track_length * SIM_CART_ENC_COUNTS;
+    double h_us = ( double ) ( sim_time_us - t_prev_us );
+    double edge = ( double ) CART_VEL_EDGE_COUNTS;
+    double half = edge / 2;
+    double b;
+    double t_us;
+
+    /* enc_A is high for counts 4k and 4k + 1, it rises at count 4k moving
+    right and at count 4k + 2 moving left. */
+    if( c1 > c0 )
+    {
+        for( b = ceil( c0 / edge ) * edge; b <= c1; b += edge )
+        {
+            if( b <= c0 )
+            {
+                continue;
+            }
+            t_us = ( double ) t_prev_us + ( b - c0 ) / ( c1 - c0 ) * h_us;
+            cart_vel_edge( sim_enc_capture( ( int32_t ) b ),
+                           ( uint32_t ) ( uint64_t ) ( t_us * ( CTRL_TICK_CPU_HZ / 1000000UL ) ) );
+        }
+    }
+    else if( c1 < c0 )
+    {
+        for( b = floor( ( c0 - half ) / edge ) * edge + half; b > c1; b -= edge )
+        {
+            if( b > c0 )
+            {
+                continue;
+            }
+            t_us = ( double ) t_prev_us + ( c0 - b ) / ( c0 - c1 ) * h_us;
+            cart_vel_edge( sim_enc_capture( ( int32_t ) b - 1 ),
+                           ( uint32_t ) ( uint64_t ) ( t_us * ( CTRL_TICK_CPU_HZ / 1000000UL ) ) );
+        }
+    }
+}
+
+void dcm_enc_get_snapshot( dcm_enc_snapshot *out )
+{
+    out->counts      = sim_plant_cart_counts( &sim_rig ) - enc_zero_reference;
+    out->position_cm = ( float ) out->counts * ENCODER_MULTIPLIER;
+    out->cycles      = ctrl_tick_cycles();
+}
+
+int32_t dcm_enc_get_counts( void )
+{
+    return sim_plant_cart_counts( &sim_rig ) - enc_zero_reference;
+}
+
+float dcm_enc_get_cart_position_cm( void )
+{
+    dcm_enc_snapshot snapshot;
+
+    dcm_enc_get_snapshot( &snapshot );
+    return snapshot.position_cm;
+}
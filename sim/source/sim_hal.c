@@ -0,0 +1,66 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Host stand-ins for the HAL, CMSIS and CubeMX symbols used by LIP/source,
+ * SIL build only. Also provides FreeRTOS application hooks that live in
+ * main_LIP.c on the target.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main_LIP.h"
+#include "sim.h"
+
+uint32_t SystemCoreClock = 168000000;
+
+GPIO_TypeDef sim_gpio_ports[ 8 ] = { { 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 }, { 6 }, { 7 } };
+
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim4;
+TIM_HandleTypeDef htim7;
+
+/* Only the limit switches are wired to the plant, all other inputs read low. */
+GPIO_PinState HAL_GPIO_ReadPin( GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin )
+{
+    if( GPIOx == limitSW_left_GPIO_Port && GPIO_Pin == limitSW_left_Pin )
+    {
+        return sim_plant_limit_left( &sim_rig ) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    }
+    if( GPIOx == limitSW_right_GPIO_Port && GPIO_Pin == limitSW_right_Pin )
+    {
+        return sim_plant_limit_right( &sim_rig ) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+    }
+    return GPIO_PIN_RESET;
+}
+
+/* "reset" cli command ends the simulation. */
+void NVIC_SystemReset( void )
+{
+    printf( "sim: NVIC_SystemReset() at %.3f s\n", ( double ) sim_time_ms * 0.001 );
+    exit( EXIT_SUCCESS );
+}
+
+void Error_Handler( void )
+{
+    printf( "sim: Error_Handler() at %.3f s\n", ( double ) sim_time_ms * 0.001 );
+    abort();
+}
+
+void vAssertCalled( const char *pcFile, unsigned long ulLine )
+{
+    printf( "sim: assert failed %s:%lu at %.3f s\n", pcFile, ulLine, ( double ) sim_time_ms * 0.001 );
+    abort();
+}
+
+/* Needed for freeeros objects static allocation, same as in main_LIP.c. */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer,
+                                    StackType_t **ppxIdleTaskStackBuffer,
+                                    uint32_t *pulIdleTaskStackSize )
+{
+    static StaticTask_t xIdleTaskTCB;
+    static StackType_t uxIdleTaskStack[ configMINIMAL_STACK_SIZE ];
+
+    *ppxIdleTaskTCBBuffer = &xIdleTaskTCB;
+    *ppxIdleTaskStackBuffer = uxIdleTaskStack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
@@ -0,0 +1,548 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Host software-in-the-loop (SIL) runner.
+ *
+ * Runs the unmodified LIP app tasks on the host against the simulated plant
+ * in sim_plant.c. Time is virtual: whenever all app tasks are blocked, time
+ * jumps to the next interrupt, a control tick (TIM7) or a FreeRTOS tick (1 ms),
+ * so a run takes as long as the app and plant computations do, not as long as
+ * the experiment.
+ *
+ * Usage: lip_sim [-d seconds] [-s scenario.txt] [-t trace.csv] [-v]
+ *     -d  end time in seconds, overrides "!end" from the scenario
+ *     -s  scenario file, default is the built-in UPC balance scenario
+ *     -t  write plant and app state every 10 ms as csv
+ *     -v  echo console and communication task output to stdout
+ *
+ * Scenario file, one event per line, "#" starts a comment:
+ *     <time_s> <cli text>           type text followed by enter into the console
+ *     <time_s> !pend <rad>          move the arm by hand to angle (0 is up) over
+ *                                   0.5 s and hold it there
+ *     <time_s> !release [rad/s]     let go of the arm, optionally giving it a push
+ *     <time_s> !push <N> <ms>       push the cart with external force
+ *     <time_s> !pot <cm>            set the setpoint potentiometer
+ *     <time_s> !end                 end of the run
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main_LIP.h"
+#include "sim.h"
+
+/* Plant integration step, us. Steps are shortened to end exactly at interrupts. */
+#define SIM_SUBSTEP_US      100
+/* Time it takes to lift the pendulum arm by hand, ms. */
+#define SIM_HAND_MOVE_MS    500
+/* Trace period, ms. */
+#define SIM_TRACE_PERIOD    10
+
+#define SIM_MAX_EVENTS      256
+#define SIM_MAX_EVENT_TEXT  64
+#define SIM_RX_QUEUE_LEN    1024
+
+/* Defined in LIP_tasks_common.c */
+extern uint8_t cRxedChar;
+extern int32_t pend_init_count_sum;
+extern float pend_angle[ 2 ];
+extern float pend_speed[ 2 ];
+extern float cart_position[ 2 ];
+extern float cart_speed[ 2 ];
+extern float *cart_position_setpoint_cm;
+extern enum lip_app_states app_current_state;
+
+sim_plant_t sim_rig;
+uint32_t sim_time_ms = 0;
+uint64_t sim_time_us = 0;
+uint32_t sim_ctrl_tick_period_us = 0;
+uint32_t sim_pend_enc_transfer_us = 0;
+uint8_t sim_verbose = 0;
+
+/* Time of the next control tick, 0 until the timer is started. */
+static uint64_t next_ctrl_tick_us = 0;
+
+/* End of the next AS5600 transfer, 0 until sampling is started. */
+static uint64_t next_pend_enc_us = 0;
+
+/* Limit switch states after the last substep, for EXTI rising edges. */
+static uint8_t limit_left_prev = 0;
+static uint8_t limit_right_prev = 0;
+
+typedef struct
+{
+    uint32_t t_ms;
+    char text[ SIM_MAX_EVENT_TEXT ];
+} sim_event_t;
+
+static sim_event_t events[ SIM_MAX_EVENTS ];
+static uint32_t n_events = 0;
+static uint32_t next_event = 0;
+static uint32_t end_time_ms = 0;
+static uint8_t finished = 0;
+
+/* Characters waiting to be "received" by uart3. */
+static char rx_queue[ SIM_RX_QUEUE_LEN ];
+static uint32_t rx_head = 0;
+static uint32_t rx_tail = 0;
+
+/* Pendulum arm moved or held by hand. */
+static uint8_t hand_active = 0;
+static double hand_theta;
+static double hand_rate;
+static double hand_target;
+
+/* External push on the cart. */
+static uint32_t push_end_ms = 0;
+
+static FILE *trace = NULL;
+
+/* Statistics collected while the app is in UPC state. */
+static struct
+{
+    uint32_t upc_ms;
+    double theta_err_max;
+    double theta_err_sq;
+    double x_min;
+    double x_max;
+    double v_sq;
+} stats = { 0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+
+static const char *default_scenario[] =
+{
+    "# Home the cart, lift the pendulum by hand and balance for 60 s.",
+    "1.2 home",
+    "7.0 !pend 0.0",
+    "8.0 upc on",
+    "9.0 !release 0.1",
+    "69.0 !end",
+    NULL
+};
+
+static const char *state_name( enum lip_app_states state )
+{
+    switch( state )
+    {
+        case UNINITIALIZED: return "UNINITIALIZED";
+        case DEFAULT:       return "DEFAULT";
+        case DPC:           return "DPC";
+        case UPC:           return "UPC";
+        case SWINGUP:       return "SWINGUP";
+        case TEST:          return "TEST";
+    }
+    return "?";
+}
+
+/* Pendulum angle wrapped to [-pi, pi], 0 is up. */
+static double theta_wrapped( void )
+{
+    return sim_rig.theta - 2.0 * M_PI * floor( ( sim_rig.theta + M_PI ) / ( 2.0 * M_PI ) );
+}
+
+static void add_event( const char *line, const char *source, uint32_t lineno )
+{
+    char *end;
+    double t_s;
+
+    while( *line == ' ' || *line == '\t' )
+    {
+        line++;
+    }
+    if( *line == '#' || *line == '\0' || *line == '\n' || *line == '\r' )
+    {
+        return;
+    }
+
+    t_s = strtod( line, &end );
+    if( end == line || n_events >= SIM_MAX_EVENTS )
+    {
+        fprintf( stderr, "sim: %s:%u: bad or too many events\n", source, lineno );
+        exit( EXIT_FAILURE );
+    }
+    while( *end == ' ' || *end == '\t' )
+    {
+        end++;
+    }
+
+    events[ n_events ].t_ms = ( uint32_t ) lround( t_s * 1000.0 );
+    snprintf( events[ n_events ].text, SIM_MAX_EVENT_TEXT, "%s", end );
+    events[ n_events ].text[ strcspn( events[ n_events ].text, "\r\n" ) ] = '\0';
+
+    if( strcmp( events[ n_events ].text, "!end" ) == 0 && end_time_ms == 0 )
+    {
+        end_time_ms = events[ n_events ].t_ms;
+    }
+    if( n_events > 0 && events[ n_events ].t_ms < events[ n_events - 1 ].t_ms )
+    {
+        fprintf( stderr, "sim: %s:%u: events have to be in time order\n", source, lineno );
+        exit( EXIT_FAILURE );
+    }
+    n_events++;
+}
+
+static void load_scenario( const char *path )
+{
+    char line[ 128 ];
+    uint32_t lineno = 0;
+    FILE *f;
+
+    if( path == NULL )
+    {
+        for( uint32_t i = 0; default_scenario[ i ] != NULL; i++ )
+        {
+            add_event( default_scenario[ i ], "built-in", i + 1 );
+        }
+        return;
+    }
+
+    f = fopen( path, "r" );
+    if( f == NULL )
+    {
+        perror( path );
+        exit( EXIT_FAILURE );
+    }
+    while( fgets( line, sizeof( line ), f ) != NULL )
+    {
+        add_event( line, path, ++lineno );
+    }
+    fclose( f );
+}
+
+static void type_text( const char *text )
+{
+    for( ; *text != '\0'; text++ )
+    {
+        rx_queue[ rx_head++ % SIM_RX_QUEUE_LEN ] = *text;
+    }
+    rx_queue[ rx_head++ % SIM_RX_QUEUE_LEN ] = '\r';
+}
+
+static void run_event( const sim_event_t *ev )
+{
+    double a = 0.0;
+    double b = 0.0;
+
+    if( ev->text[ 0 ] != '!' )
+    {
+        type_text( ev->text );
+    }
+    else if( sscanf( ev->text, "!pend %lf", &a ) == 1 )
+    {
+        /* Go the short way around from the current angle. */
+        hand_theta = sim_rig.theta;
+        hand_target = sim_rig.theta + ( a - theta_wrapped() );
+        hand_rate = ( hand_target - sim_rig.theta ) / ( SIM_HAND_MOVE_MS * 0.001 );
+        hand_active = 1;
+    }
+    else if( strncmp( ev->text, "!release", 8 ) == 0 )
+    {
+        sscanf( ev->text, "!release %lf", &a );
+        sim_rig.dtheta = a;
+        hand_active = 0;
+    }
+    else if( sscanf( ev->text, "!push %lf %lf", &a, &b ) == 2 )
+    {
+        sim_rig.force_ext = a;
+        push_end_ms = sim_time_ms + ( uint32_t ) b;
+    }
+    else if( sscanf( ev->text, "!pot %lf", &a ) == 1 )
+    {
+        sim_pot_counts = ( float ) ( a / ( double ) TRACK_LEN_MAX_CM * 4095.0 );
+    }
+    else if( strcmp( ev->text, "!end" ) == 0 )
+    {
+        finished = 1;
+    }
+    else
+    {
+        fprintf( stderr, "sim: unknown directive \"%s\"\n", ev->text );
+        exit( EXIT_FAILURE );
+    }
+}
+
+static void collect_stats( void )
+{
+    double err;
+
+    if( app_current_state != UPC )
+    {
+        return;
+    }
+    err = fabs( theta_wrapped() );
+    stats.upc_ms++;
+    stats.theta_err_sq += err * err;
+    stats.v_sq += sim_rig.voltage * sim_rig.voltage;
+    if( err > stats.theta_err_max )
+    {
+        stats.theta_err_max = err;
+    }
+    if( sim_rig.x < stats.x_min )
+    {
+        stats.x_min = sim_rig.x;
+    }
+    if( sim_rig.x > stats.x_max )
+    {
+        stats.x_max = sim_rig.x;
+    }
+}
+
+/* Integrate the plant up to t_us with the motor voltage set by the PWM
+compare registers now. */
+static void advance_plant( uint64_t t_us )
+{
+    uint64_t h;
+    uint64_t t_prev_us;
+    double x_prev;
+
+    sim_rig.voltage = sim_motor_pwm_voltage();
+    while( sim_time_us < t_us )
+    {
+        h = SIM_SUBSTEP_US - sim_time_us % SIM_SUBSTEP_US;
+        if( h > t_us - sim_time_us )
+        {
+            h = t_us - sim_time_us;
+        }
+        x_prev = sim_rig.x;
+        t_prev_us = sim_time_us;
+        sim_plant_step( &sim_rig, ( double ) h * 1e-6 );
+        sim_time_us += h;
+
+        /* TIM4 CC1 capture interrupts for encoder edges within the substep. */
+        sim_dcm_enc_substep( x_prev, t_prev_us );
+
+        /* EXTI15_10 rising edge on a limit switch, the ISR zeroes the voltage
+        before the next substep. */
+        if( sim_plant_limit_left( &sim_rig ) && !limit_left_prev )
+        {
+            limit_switch_isr( limitSW_left_Pin );
+        }
+        if( sim_plant_limit_right( &sim_rig ) && !limit_right_prev )
+        {
+            limit_switch_isr( limitSW_right_Pin );
+        }
+        limit_left_prev = sim_plant_limit_left( &sim_rig );
+        limit_right_prev = sim_plant_limit_right( &sim_rig );
+        sim_rig.voltage = sim_motor_pwm_voltage();
+    }
+}
+
+/* Scenario, hand, uart and trace, once per ms at SysTick. */
+static void systick_peripherals( void )
+{
+    sim_time_ms++;
+
+    /* External push ends before the next ms is simulated. */
+    if( push_end_ms != 0 && sim_time_ms + 1 >= push_end_ms )
+    {
+        sim_rig.force_ext = 0.0;
+        push_end_ms = 0;
+    }
+    if( hand_active )
+    {
+        hand_theta += hand_rate * 0.001;
+        if( ( hand_rate >= 0.0 && hand_theta >= hand_target ) ||
+            ( hand_rate < 0.0 && hand_theta <= hand_target ) )
+        {
+            hand_theta = hand_target;
+            hand_rate = 0.0;
+        }
+        sim_rig.theta = hand_theta;
+        sim_rig.dtheta = hand_rate;
+    }
+
+    /* Scenario. */
+    while( next_event < n_events && events[ next_event ].t_ms <= sim_time_ms )
+    {
+        run_event( &events[ next_event++ ] );
+    }
+    if( end_time_ms != 0 && sim_time_ms >= end_time_ms )
+    {
+        finished = 1;
+    }
+
+    /* Uart3 receive interrupt, console task reads one char per poll. */
+    if( cRxedChar == 0x00 && rx_tail != rx_head )
+    {
+        cRxedChar = ( uint8_t ) rx_queue[ rx_tail++ % SIM_RX_QUEUE_LEN ];
+    }
+
+    collect_stats();
+
+    if( trace != NULL && sim_time_ms % SIM_TRACE_PERIOD == 0 )
+    {
+        fprintf( trace, "%.3f,%.4f,%.5f,%.4f,%.5f,%.3f,%.3f,%.5f,%.3f,%.4f,%.3f,%d\n",
+                 ( double ) sim_time_ms * 0.001,
+                 sim_rig.x * 100.0, sim_rig.theta, sim_rig.dx * 100.0, sim_rig.dtheta, sim_rig.voltage,
+                 ( double ) cart_position[ 0 ], ( double ) pend_angle[ 0 ],
+                 ( double ) cart_speed[ 0 ], ( double ) pend_speed[ 0 ],
+                 ( double ) *cart_position_setpoint_cm, ( int ) app_current_state );
+    }
+}
+
+int sim_tick_isr( void )
+{
+    uint64_t systick_us = ( uint64_t ) ( sim_time_ms + 1 ) * 1000;
+    uint64_t t_us = systick_us;
+
+    if( sim_ctrl_tick_period_us != 0 )
+    {
+        if( next_ctrl_tick_us == 0 )
+        {
+            next_ctrl_tick_us = sim_time_us + sim_ctrl_tick_period_us;
+        }
+        if( next_ctrl_tick_us < t_us )
+        {
+            t_us = next_ctrl_tick_us;
+        }
+    }
+
+    if( sim_pend_enc_transfer_us != 0 )
+    {
+        if( next_pend_enc_us == 0 )
+        {
+            next_pend_enc_us = sim_time_us + sim_pend_enc_transfer_us;
+        }
+        if( next_pend_enc_us < t_us )
+        {
+            t_us = next_pend_enc_us;
+        }
+    }
+
+    advance_plant( t_us );
+
+    /* I2C1 transfer complete interrupt, next transfer starts right away. */
+    if( t_us == next_pend_enc_us )
+    {
+        next_pend_enc_us += sim_pend_enc_transfer_us;
+        sim_pend_enc_transfer_done();
+    }
+
+    /* TIM7 update interrupt. */
+    if( t_us == next_ctrl_tick_us )
+    {
+        next_ctrl_tick_us += sim_ctrl_tick_period_us;
+        ctrl_tick_isr();
+    }
+
+    if( t_us == systick_us )
+    {
+        systick_peripherals();
+        return 1;
+    }
+    return 0;
+}
+
+void vApplicationIdleHook( void )
+{
+    if( finished )
+    {
+        vTaskEndScheduler();
+    }
+    else
+    {
+        vPortSimTick();
+    }
+}
+
+static double wall_clock_s( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+static void usage( const char *prog )
+{
+    fprintf( stderr, "usage: %s [-d seconds] [-s scenario.txt] [-t trace.csv] [-v]\n", prog );
+    exit( EXIT_FAILURE );
+}
+
+int main( int argc, char **argv )
+{
+    const char *scenario_path = NULL;
+    const char *trace_path = NULL;
+    double duration_s = 0.0;
+    double wall_start, wall;
+    sim_plant_params_t params;
+    int opt;
+
+    while( ( opt = getopt( argc, argv, "d:s:t:vh" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'd': duration_s = atof( optarg ); break;
+            case 's': scenario_path = optarg; break;
+            case 't': trace_path = optarg; break;
+            case 'v': sim_verbose = 1; break;
+            default:  usage( argv[ 0 ] );
+        }
+    }
+
+    load_scenario( scenario_path );
+    if( duration_s > 0.0 )
+    {
+        end_time_ms = ( uint32_t ) lround( duration_s * 1000.0 );
+    }
+    if( end_time_ms == 0 )
+    {
+        fprintf( stderr, "sim: no end time, use \"!end\" or -d\n" );
+        return EXIT_FAILURE;
+    }
+
+    if( trace_path != NULL )
+    {
+        trace = fopen( trace_path, "w" );
+        if( trace == NULL )
+        {
+            perror( trace_path );
+            return EXIT_FAILURE;
+        }
+        fprintf( trace, "t,x_cm,theta,dx_cm,dtheta,voltage,"
+                        "cart_position,pend_angle,cart_speed,pend_speed,setpoint,state\n" );
+    }
+
+    /* Pendulum hangs down, cart somewhere in the middle of the track. */
+    sim_plant_default_params( &params );
+    sim_plant_init( &sim_rig, &params, 0.15, M_PI );
+    sim_pot_counts = 2048.0f;
+
+    /* Same as main_LIP_init(). */
+    pot_adc_init();
+    dcm_init();
+    enc_init();
+    pend_enc_init();
+    pend_init_count_sum = ( pend_enc_get_cumulative_count() - PEND_ENC_COUNTS_PER_REV / 2 ) * PEND_ENC_AVG_LEN;
+
+    wall_start = wall_clock_s();
+    LIP_create_Tasks();
+    ctrl_tick_start();
+    pend_enc_sampling_start();
+    vTaskStartScheduler();
+    wall = wall_clock_s() - wall_start;
+
+    if( sim_verbose )
+    {
+        printf( "\n" );
+    }
+    printf( "sim time:        %.3f s\n", ( double ) sim_time_ms * 0.001 );
+    printf( "wall time:       %.3f s (%.0fx real time)\n", wall, ( double ) sim_time_ms * 0.001 / wall );
+    printf( "final state:     %s\n", state_name( app_current_state ) );
+    printf( "cart, pendulum:  %.2f cm, %.4f rad\n", sim_rig.x * 100.0, theta_wrapped() );
+    printf( "time in UPC:     %.3f s\n", ( double ) stats.upc_ms * 0.001 );
+    if( stats.upc_ms > 0 )
+    {
+        printf( "UPC angle error: max %.4f rad, rms %.4f rad\n",
+                stats.theta_err_max, sqrt( stats.theta_err_sq / stats.upc_ms ) );
+        printf( "UPC cart range:  %.2f - %.2f cm\n", stats.x_min * 100.0, stats.x_max * 100.0 );
+        printf( "UPC voltage rms: %.3f V\n", sqrt( stats.v_sq / stats.upc_ms ) );
+    }
+
+    if( trace != NULL )
+    {
+        fclose( trace );
+    }
+    return EXIT_SUCCESS;
+}
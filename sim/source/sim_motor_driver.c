@@ -0,0 +1,88 @@
+/*
+ * Description: SIL stand-in for LIP/source/motor_driver.c
+ *
+ * Public behaviour is the same as on the target, including dutycycle
+ * quantization to the [0, 1000] range of TIM3 compare registers.
+ * Compare registers are plain variables here, motor terminal voltage
+ * is read by the sim from sim_motor_pwm_voltage() on every tick.
+ *
+ */
+
+#include "motor_driver.h"
+#include "sim.h"
+
+float dutycycle; // PWM dutycycle of currently active PWM timer channel
+
+float voltage_sign = 1.0f; // 1 for positive, -1 for negative output voltage
+
+/* TIM3 CCR1 & CCR2. */
+static volatile uint16_t ccr1 = 0;
+static volatile uint16_t ccr2 = 0;
+
+void dcm_init( void )
+{
+    dcm_set_ch1_dutycycle( 0 );
+    dcm_set_ch2_dutycycle( 0 );
+}
+
+void dcm_zero_output_voltage( void )
+{
+    dcm_set_ch1_dutycycle( 0 );
+    dcm_set_ch2_dutycycle( 0 );
+}
+
+/* Compare registers are applied right away in the sim, no update event needed. */
+void dcm_stop_from_isr( void )
+{
+    dcm_set_ch1_dutycycle( 0 );
+    dcm_set_ch2_dutycycle( 0 );
+    dutycycle = 0.0f;
+}
+
+void dcm_set_output_volatage( float inV )
+{
+    if ( inV >= 0 ) // ch1>0V, ch2=0V
+    {
+        if ( inV > MAX_INPUT_VOLTAGE_POSITIVE )
+        {
+            inV = MAX_INPUT_VOLTAGE_POSITIVE;
+        }
+        dutycycle = inV / MAX_INPUT_VOLTAGE_POSITIVE;
+        dutycycle = dutycycle * 1000.0f;
+        dcm_set_ch2_dutycycle( 0 );
+        dcm_set_ch1_dutycycle( ( uint16_t ) dutycycle );
+        voltage_sign = 1.0f;
+    }
+    else if ( inV < 0 ) // ch1=0V, ch2>0V
+    {
+        if ( inV < MAX_INPUT_VOLTAGE_NEGATIVE )
+        {
+            inV = MAX_INPUT_VOLTAGE_NEGATIVE;
+        }
+        dutycycle = inV / MAX_INPUT_VOLTAGE_NEGATIVE;
+        dutycycle = dutycycle * 1000.0f;
+        dcm_set_ch1_dutycycle( 0 );
+        dcm_set_ch2_dutycycle( ( uint16_t ) dutycycle );
+        voltage_sign = -1.0f;
+    }
+}
+
+float dcm_get_output_voltage( void )
+{
+    return ( dutycycle / 1000.0f * MAX_INPUT_VOLTAGE_POSITIVE * voltage_sign );
+}
+
+void dcm_set_ch1_dutycycle( uint16_t dtc )
+{
+    ccr1 = dtc;
+}
+
+void dcm_set_ch2_dutycycle( uint16_t dtc )
+{
+    ccr2 = dtc;
+}
+
+float sim_motor_pwm_voltage( void )
+{
+    return ( ( float ) ccr1 - ( float ) ccr2 ) / 1000.0f * MAX_INPUT_VOLTAGE_POSITIVE;
+}
@@ -0,0 +1,127 @@
+/*
+ * Description: SIL stand-in for LIP/source/pend_enc_driver.c
+ *
+ * AS5600 raw angle register is read from the plant, the revolution
+ * unwrapping and averaging is done by pend_enc_sampler.c, same as on the target.
+ *
+ * Background i2c sampling: pend_enc_sampling_start() hands the transfer time
+ * to the sim, which pushes a plant sample to pend_enc_sampler.h at the end of
+ * every transfer in virtual time (see sim_tick_isr() in sim_main.c). The
+ * transfer chain never stops, pend_enc_sampling_check() has nothing to do.
+ *
+ */
+
+#include "pend_enc_driver.h"
+#include "pend_enc_sampler.h"
+#include "sim.h"
+
+/* One 2 byte register read at 400kHz with HAL interrupt overhead. */
+#define SIM_AS5600_TRANSFER_US  120
+
+static uint16_t angle_raw = 0;
+
+static void sim_as5600_get_raw_angle( uint16_t *raw )
+{
+    *raw = sim_plant_pend_raw( &sim_rig );
+}
+
+uint8_t pend_enc_init( void )
+{
+    /* First sample is read before background sampling is started. */
+    pend_enc_sampler_init();
+    sim_as5600_get_raw_angle( &angle_raw );
+    pend_enc_sampler_push( angle_raw );
+
+    return 0;
+}
+
+void pend_enc_sampling_start( void )
+{
+    sim_pend_enc_transfer_us = SIM_AS5600_TRANSFER_US;
+}
+
+void pend_enc_sampling_check( void )
+{
+}
+
+void sim_pend_enc_transfer_done( void )
+{
+    uint16_t raw;
+
+    sim_as5600_get_raw_angle( &raw );
+    pend_enc_sampler_push( raw );
+}
+
+uint8_t pend_enc_read_angle_deg( float *angle )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    *angle = ( float ) sample.raw * ( 360.0f / 4096.0f );
+
+    return 0;
+}
+
+uint8_t pend_enc_read_angle_rad( float *angle )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    *angle = ( float ) sample.raw * 0.001533980788f; // 0.001533980788 = 1 / 4096.0f * PI2;
+
+    return 0;
+}
+
+uint8_t pend_enc_deinit( void )
+{
+    return 0;
+}
+
+/* Unwrapped count of the newest sample, unwrapping runs at sample rate
+in pend_enc_sampler_push(). */
+int32_t pend_enc_get_cumulative_count( void )
+{
+    pend_enc_sample sample;
+
+    /* Newest sample from background transfer, no bus access here. */
+    pend_enc_sampler_read( &sample );
+
+    return sample.count;
+}
+
+/* Mean unwrapped count of the last PEND_ENC_AVG_LEN samples. */
+float pend_enc_get_cumulative_count_avg( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+
+    return pend_enc_sample_avg_count( &sample );
+}
+
+/* Sum of unwrapped counts of the last PEND_ENC_AVG_LEN samples. */
+int32_t pend_enc_get_cumulative_count_sum( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+
+    return pend_enc_sample_sum_count( &sample );
+}
+
+int32_t pend_enc_get_base_count( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    return sample.raw;
+}
+
+/* Get number of full pendulum revolutions, negative number indicates negative revolution. */
+int32_t get_num_of_revolutions( void )
+{
+    pend_enc_sample sample;
+
+    pend_enc_sampler_read( &sample );
+    return sample.revolutions;
+}
@@ -0,0 +1,230 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Nonlinear cart - pendulum - DC motor plant model, see sim_plant.h.
+ *
+ * Equations of motion, M is cart mass with reflected motor inertia Jm / r^2:
+ *     (M + m) ddx + m l cos(theta) ddtheta - m l sin(theta) dtheta^2 = F
+ *     m l cos(theta) ddx + J ddtheta - m g l sin(theta) = -b dtheta
+ * with cart force
+ *     F = Kt i / r - (bx + bm / r^2) dx - Fc tanh( dx / vc ) + F_ext
+ * and motor armature
+ *     L di/dt = V_eff - R i - Ke dx / r
+ * where V_eff is the terminal voltage after the deadzone.
+ *
+ * End stops are inelastic. When the cart hits one, its speed drops to zero and
+ * the pendulum keeps its angular momentum about the (now stopped) pivot.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+
+#include "sim_plant.h"
+
+#define SIM_G 9.81
+
+/* Number of state variables integrated by RK4. */
+#define SIM_N_STATES 5
+
+void sim_plant_default_params( sim_plant_params_t *p )
+{
+    p->cart_mass          = 0.45;
+    p->pend_mass          = 0.1;
+    p->pend_com           = 0.15;
+    p->pend_inertia       = 4.0 / 3.0 * 0.1 * 0.15 * 0.15;
+    p->pend_viscous       = 0.0005;
+
+    p->cart_viscous       = 0.8;
+    p->cart_coulomb       = 0.2;
+    p->coulomb_speed      = 0.005;
+
+    p->motor_resistance   = 2.5;
+    p->motor_inductance   = 0.001;
+    p->motor_kt           = 0.1;
+    p->motor_ke           = 0.1;
+    p->motor_inertia      = 1.125e-5;
+    p->motor_viscous      = 4.5e-5;
+    p->pulley_radius      = 0.015;
+
+    p->voltage_deadzone   = 1.0;
+
+    p->track_length       = 0.407;
+    p->switch_travel      = 0.001;
+
+    p->pend_enc_mount     = 1.0;
+    /* Reading at up position is off by -0.0706 rad relative to the down position,
+    this is what PENDULUM_ANGLE_UP_SETPOINT_BASE in util task compensates for. */
+    p->pend_enc_eccentric = -0.0353;
+}
+
+void sim_plant_init( sim_plant_t *plant, const sim_plant_params_t *p, double x, double theta )
+{
+    plant->p = *p;
+    plant->x = x;
+    plant->theta = theta;
+    plant->dx = 0.0;
+    plant->dtheta = 0.0;
+    plant->current = 0.0;
+    plant->voltage = 0.0;
+    plant->force_ext = 0.0;
+}
+
+/* State derivative. s = { x, theta, dx, dtheta, current }. */
+static void sim_plant_deriv( const sim_plant_params_t *p, double v_eff, double force_ext,
+                             const double *s, double *ds )
+{
+    double r = p->pulley_radius;
+    double mass = p->cart_mass + p->motor_inertia / ( r * r ) + p->pend_mass;
+    double ml = p->pend_mass * p->pend_com;
+    double c = cos( s[ 1 ] );
+    double sn = sin( s[ 1 ] );
+    double force, a12, b1, b2, det;
+
+    force = p->motor_kt * s[ 4 ] / r
+          - ( p->cart_viscous + p->motor_viscous / ( r * r ) ) * s[ 2 ]
+          - p->cart_coulomb * tanh( s[ 2 ] / p->coulomb_speed )
+          + force_ext;
+
+    a12 = ml * c;
+    b1 = force + ml * sn * s[ 3 ] * s[ 3 ];
+    b2 = ml * SIM_G * sn - p->pend_viscous * s[ 3 ];
+    det = mass * p->pend_inertia - a12 * a12;
+
+    ds[ 0 ] = s[ 2 ];
+    ds[ 1 ] = s[ 3 ];
+    ds[ 2 ] = ( b1 * p->pend_inertia - a12 * b2 ) / det;
+    ds[ 3 ] = ( mass * b2 - a12 * b1 ) / det;
+    ds[ 4 ] = ( v_eff - p->motor_resistance * s[ 4 ] - p->motor_ke * s[ 2 ] / r ) / p->motor_inductance;
+}
+
+static double sim_plant_deadzone( const sim_plant_params_t *p, double v )
+{
+    if( v > p->voltage_deadzone )
+    {
+        return v - p->voltage_deadzone;
+    }
+    if( v < -p->voltage_deadzone )
+    {
+        return v + p->voltage_deadzone;
+    }
+    return 0.0;
+}
+
+/* Inelastic end stop. Integrating the second equation of motion over the
+impact gives J dtheta+ = J dtheta- + m l cos(theta) dx-. */
+static void sim_plant_end_stop( sim_plant_t *plant, double x_stop )
+{
+    const sim_plant_params_t *p = &plant->p;
+
+    plant->dtheta += p->pend_mass * p->pend_com * cos( plant->theta ) * plant->dx / p->pend_inertia;
+    plant->x = x_stop;
+    plant->dx = 0.0;
+}
+
+void sim_plant_step( sim_plant_t *plant, double h )
+{
+    const sim_plant_params_t *p = &plant->p;
+    double v_eff = sim_plant_deadzone( p, plant->voltage );
+    double s[ SIM_N_STATES ] = { plant->x, plant->theta, plant->dx, plant->dtheta, plant->current };
+    double k1[ SIM_N_STATES ], k2[ SIM_N_STATES ], k3[ SIM_N_STATES ], k4[ SIM_N_STATES ];
+    double tmp[ SIM_N_STATES ];
+    int i;
+
+    sim_plant_deriv( p, v_eff, plant->force_ext, s, k1 );
+    for( i = 0; i < SIM_N_STATES; i++ )
+    {
+        tmp[ i ] = s[ i ] + 0.5 * h * k1[ i ];
+    }
+    sim_plant_deriv( p, v_eff, plant->force_ext, tmp, k2 );
+    for( i = 0; i < SIM_N_STATES; i++ )
+    {
+        tmp[ i ] = s[ i ] + 0.5 * h * k2[ i ];
+    }
+    sim_plant_deriv( p, v_eff, plant->force_ext, tmp, k3 );
+    for( i = 0; i < SIM_N_STATES; i++ )
+    {
+        tmp[ i ] = s[ i ] + h * k3[ i ];
+    }
+    sim_plant_deriv( p, v_eff, plant->force_ext, tmp, k4 );
+    for( i = 0; i < SIM_N_STATES; i++ )
+    {
+        s[ i ] += h / 6.0 * ( k1[ i ] + 2.0 * k2[ i ] + 2.0 * k3[ i ] + k4[ i ] );
+    }
+
+    plant->x       = s[ 0 ];
+    plant->theta   = s[ 1 ];
+    plant->dx      = s[ 2 ];
+    plant->dtheta  = s[ 3 ];
+    plant->current = s[ 4 ];
+
+    if( plant->x < 0.0 )
+    {
+        sim_plant_end_stop( plant, 0.0 );
+    }
+    else if( plant->x > p->track_length )
+    {
+        sim_plant_end_stop( plant, p->track_length );
+    }
+}
+
+void sim_plant_advance( sim_plant_t *plant, double h, uint32_t n )
+{
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        sim_plant_step( plant, h );
+    }
+}
+
+double sim_plant_set_voltage( sim_plant_t *plant, double volts )
+{
+    double duty;
+
+    if( volts > SIM_SUPPLY_VOLTAGE )
+    {
+        volts = SIM_SUPPLY_VOLTAGE;
+    }
+    else if( volts < -SIM_SUPPLY_VOLTAGE )
+    {
+        volts = -SIM_SUPPLY_VOLTAGE;
+    }
+
+    /* Dutycycle is truncated to integer compare value, like the (uint16_t) cast in motor_driver.c. */
+    duty = floor( fabs( volts ) / SIM_SUPPLY_VOLTAGE * SIM_PWM_STEPS );
+    plant->voltage = copysign( duty / SIM_PWM_STEPS * SIM_SUPPLY_VOLTAGE, volts );
+
+    return plant->voltage;
+}
+
+double sim_plant_energy( const sim_plant_t *plant )
+{
+    const sim_plant_params_t *p = &plant->p;
+    double r = p->pulley_radius;
+    double mass = p->cart_mass + p->motor_inertia / ( r * r ) + p->pend_mass;
+    double ml = p->pend_mass * p->pend_com;
+
+    return 0.5 * mass * plant->dx * plant->dx
+         + ml * cos( plant->theta ) * plant->dx * plant->dtheta
+         + 0.5 * p->pend_inertia * plant->dtheta * plant->dtheta
+         + ml * SIM_G * ( 1.0 + cos( plant->theta ) );
+}
+
+uint16_t sim_plant_pend_raw( const sim_plant_t *plant )
+{
+    const sim_plant_params_t *p = &plant->p;
+    double reading = plant->theta + p->pend_enc_mount + p->pend_enc_eccentric * cos( plant->theta );
+    double counts = floor( reading / ( 2.0 * M_PI ) * SIM_PEND_ENC_COUNTS );
+
+    return ( uint16_t ) ( ( int64_t ) counts & ( SIM_PEND_ENC_COUNTS - 1 ) );
+}
+
+int32_t sim_plant_cart_counts( const sim_plant_t *plant )
+{
+    return ( int32_t ) floor( plant->x / plant->p.track_length * SIM_CART_ENC_COUNTS );
+}
+
+uint8_t sim_plant_limit_left( const sim_plant_t *plant )
+{
+    return plant->x < plant->p.switch_travel;
+}
+
+uint8_t sim_plant_limit_right( const sim_plant_t *plant )
+{
+    return plant->x > plant->p.track_length - plant->p.switch_travel;
+}
@@ -0,0 +1,176 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Work-stealing thread pool, see sim_pool.h.
+ *
+ * Jobs are coarse (a batch of simulated episodes each), so every range is
+ * protected by a plain mutex instead of a lock free deque.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sim_pool.h"
+
+/* Job range of one worker, padded so that workers don't share cache lines. */
+typedef struct
+{
+    pthread_mutex_t lock;
+    uint32_t begin;
+    uint32_t end;
+} __attribute__( ( aligned( 64 ) ) ) sim_pool_range_t;
+
+typedef struct
+{
+    sim_pool_range_t *ranges;
+    uint32_t n_threads;
+    sim_pool_job_t fn;
+    void *ctx;
+} sim_pool_t;
+
+typedef struct
+{
+    sim_pool_t *pool;
+    uint32_t worker;
+} sim_pool_worker_t;
+
+/* Take the next job of own range. Returns 0 if it is empty. */
+static int sim_pool_pop( sim_pool_range_t *r, uint32_t *job )
+{
+    int ok = 0;
+
+    pthread_mutex_lock( &r->lock );
+    if( r->begin < r->end )
+    {
+        *job = r->begin++;
+        ok = 1;
+    }
+    pthread_mutex_unlock( &r->lock );
+    return ok;
+}
+
+/* Move the back half of the largest other range to own range. Returns 0 if
+there is nothing left to steal. */
+static int sim_pool_steal( sim_pool_t *pool, uint32_t worker )
+{
+    sim_pool_range_t *own = &pool->ranges[ worker ];
+
+    for( ;; )
+    {
+        uint32_t victim = worker, most = 0;
+
+        /* Sizes are read without locks, they are only a hint. */
+        for( uint32_t i = 0; i < pool->n_threads; i++ )
+        {
+            uint32_t size = __atomic_load_n( &pool->ranges[ i ].end, __ATOMIC_RELAXED )
+                          - __atomic_load_n( &pool->ranges[ i ].begin, __ATOMIC_RELAXED );
+
+            if( i != worker && ( int32_t ) size > ( int32_t ) most )
+            {
+                most = size;
+                victim = i;
+            }
+        }
+        if( victim == worker )
+        {
+            return 0;
+        }
+
+        sim_pool_range_t *r = &pool->ranges[ victim ];
+        uint32_t begin = 0, end = 0;
+
+        pthread_mutex_lock( &r->lock );
+        if( r->begin < r->end )
+        {
+            end = r->end;
+            begin = r->end - ( r->end - r->begin + 1 ) / 2;
+            r->end = begin;
+        }
+        pthread_mutex_unlock( &r->lock );
+
+        if( begin < end )
+        {
+            pthread_mutex_lock( &own->lock );
+            own->begin = begin;
+            own->end = end;
+            pthread_mutex_unlock( &own->lock );
+            return 1;
+        }
+        /* Victim ran dry meanwhile, look again. */
+    }
+}
+
+static void *sim_pool_worker( void *arg )
+{
+    sim_pool_worker_t *w = arg;
+    sim_pool_t *pool = w->pool;
+    uint32_t job;
+
+    do
+    {
+        while( sim_pool_pop( &pool->ranges[ w->worker ], &job ) )
+        {
+            pool->fn( pool->ctx, w->worker, job );
+        }
+    } while( sim_pool_steal( pool, w->worker ) );
+
+    return NULL;
+}
+
+int sim_pool_run( uint32_t n_threads, uint32_t n_jobs, sim_pool_job_t fn, void *ctx )
+{
+    sim_pool_t pool = { NULL, n_threads == 0 ? 1 : n_threads, fn, ctx };
+    sim_pool_worker_t *workers;
+    pthread_t *threads;
+    uint32_t started = 1;
+    int ret = 0;
+
+    pool.ranges = aligned_alloc( 64, pool.n_threads * sizeof( sim_pool_range_t ) );
+    workers = calloc( pool.n_threads, sizeof( sim_pool_worker_t ) );
+    threads = calloc( pool.n_threads, sizeof( pthread_t ) );
+    if( pool.ranges == NULL || workers == NULL || threads == NULL )
+    {
+        ret = 1;
+        goto out;
+    }
+
+    for( uint32_t i = 0; i < pool.n_threads; i++ )
+    {
+        pthread_mutex_init( &pool.ranges[ i ].lock, NULL );
+        pool.ranges[ i ].begin = ( uint32_t ) ( ( uint64_t ) n_jobs * i / pool.n_threads );
+        pool.ranges[ i ].end = ( uint32_t ) ( ( uint64_t ) n_jobs * ( i + 1 ) / pool.n_threads );
+        workers[ i ].pool = &pool;
+        workers[ i ].worker = i;
+    }
+
+    for( ; started < pool.n_threads; started++ )
+    {
+        if( pthread_create( &threads[ started ], NULL, sim_pool_worker, &workers[ started ] ) != 0 )
+        {
+            /* Jobs of the missing workers get stolen by the running ones. */
+            break;
+        }
+    }
+    sim_pool_worker( &workers[ 0 ] );
+    for( uint32_t i = 1; i < started; i++ )
+    {
+        pthread_join( threads[ i ], NULL );
+    }
+
+    for( uint32_t i = 0; i < pool.n_threads; i++ )
+    {
+        pthread_mutex_destroy( &pool.ranges[ i ].lock );
+    }
+
+out:
+    free( pool.ranges );
+    free( workers );
+    free( threads );
+    return ret;
+}
+
+uint32_t sim_pool_cpus( void )
+{
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+
+    return n > 0 ? ( uint32_t ) n : 1;
+}
@@ -0,0 +1,74 @@
+/*
+ * Description: SIL stand-in for LIP/source/pot_adc_driver.c
+ *
+ * Potentiometer voltage is sim_pot_counts (set by "!pot" scenario events)
+ * plus white conversion noise of SIM_POT_NOISE_LSB rms, from a fixed seed so
+ * runs are repeatable. Every pot_adc_tick() latches the burst converted after
+ * the previous tick and converts the next one, same one tick delay as the
+ * DMA burst on the target.
+ *
+ */
+
+#include <math.h>
+
+#include "pend_enc_driver.h"
+#include "pot_adc_driver.h"
+#include "sim.h"
+
+/* Conversion noise, counts rms. */
+#define SIM_POT_NOISE_LSB   3.0f
+
+float sim_pot_counts = 2048.0f;
+
+static uint16_t burst[ POT_ADC_OVERSAMPLE ];
+static uint32_t burst_sum = 0;
+static uint32_t rng_state = 0x2545F491u;
+
+/* xorshift32, uniform in ( 0, 1 ). */
+static float sim_pot_uniform( void )
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return ( ( float ) ( rng_state >> 8 ) + 0.5f ) * ( 1.0f / 16777216.0f );
+}
+
+static void sim_pot_convert( void )
+{
+    for( uint32_t i = 0; i < POT_ADC_OVERSAMPLE; i++ )
+    {
+        /* Box-Muller, one normal sample per conversion. */
+        float n = sqrtf( -2.0f * logf( sim_pot_uniform() ) ) * cosf( PI2 * sim_pot_uniform() );
+        float v = floorf( sim_pot_counts + SIM_POT_NOISE_LSB * n + 0.5f );
+
+        burst[ i ] = ( uint16_t ) ( v < 0.0f ? 0.0f : v > ( float ) ( POT_ADC_COUNTS - 1 ) ? ( float ) ( POT_ADC_COUNTS - 1 ) : v );
+    }
+}
+
+void pot_adc_init( void )
+{
+    sim_pot_convert();
+}
+
+void pot_adc_tick( void )
+{
+    uint32_t sum = 0;
+
+    for( uint32_t i = 0; i < POT_ADC_OVERSAMPLE; i++ )
+    {
+        sum += burst[ i ];
+    }
+    burst_sum = sum;
+
+    sim_pot_convert();
+}
+
+uint32_t pot_adc_get_sum( void )
+{
+    return burst_sum;
+}
+
+float pot_adc_get_counts( void )
+{
+    return ( float ) burst_sum * ( 1.0f / POT_ADC_OVERSAMPLE );
+}
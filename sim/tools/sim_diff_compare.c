@@ -0,0 +1,244 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Offline comparison of speed estimators on a lip_sim trace.
+ *
+ * Usage: sim_diff_compare trace.csv [t_start]
+ *
+ * Reads the firmware position measurements (cart_position, pend_angle
+ * columns) of a trace written by lip_sim -t, runs every differentiator on
+ * them once per row (the trace period is the control period) and compares
+ * the estimates to the true plant speeds (dx_cm, dtheta columns). Rows before
+ * t_start are used to settle the filters only.
+ *
+ * For every estimator and both speeds:
+ *     rms    - rms error against the true speed
+ *     lag    - delay (ms) that minimizes the rms error, true speed is shifted
+ *              with linear interpolation in 1 ms steps
+ *     noise  - rms error at that lag, what is left is noise and model error
+ *
+ * Trace rows hold the truth at the trace time and the firmware values from
+ * the last control tick, the same offset is included in every lag.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "LP_filter.h"
+#include "poly_diff.h"
+
+#define COMPARE_MAX_ROWS    200000
+#define COMPARE_DT          0.01f       /* trace period, ms in sim_main.c SIM_TRACE_PERIOD */
+#define COMPARE_MAX_LAG_MS  100
+
+/* Same as util task. */
+#define COMPARE_LP_T        0.025f
+#define COMPARE_DEAD_ZONE   0.2f
+
+typedef enum
+{
+    EST_FIRMWARE,       /* cart_speed / pend_speed columns, what the app used */
+    EST_TUSTIN_LP,      /* util task "estimator lp", with the pendulum dead zone */
+    EST_TUSTIN_LP_NODZ, /* same without the dead zone */
+    EST_POLY_DIFF
+} est_kind;
+
+typedef struct
+{
+    const char *name;
+    est_kind kind;
+    uint32_t window;
+    uint32_t order;
+    float delay;
+} estimator;
+
+static const estimator estimators[] =
+{
+    { "firmware (trace columns)",          EST_FIRMWARE,       0, 0, 0.0f },
+    { "Tustin + LP 25 ms + dead zone",     EST_TUSTIN_LP,      0, 0, 0.0f },
+    { "Tustin + LP 25 ms",                 EST_TUSTIN_LP_NODZ, 0, 0, 0.0f },
+    { "poly fit N=4, order 1, newest",     EST_POLY_DIFF,      4, 1, 0.0f },
+    { "poly fit N=6, order 2, newest",     EST_POLY_DIFF,      6, 2, 0.0f },
+    { "poly fit N=8, order 2, newest",     EST_POLY_DIFF,      8, 2, 0.0f },
+    { "poly fit N=12, order 2, newest",    EST_POLY_DIFF,     12, 2, 0.0f },
+    { "Savitzky-Golay N=5, centre",        EST_POLY_DIFF,      5, 2, 2.0f },
+    { "Savitzky-Golay N=9, centre",        EST_POLY_DIFF,      9, 2, 4.0f },
+};
+
+#define N_ESTIMATORS ( sizeof( estimators ) / sizeof( estimators[ 0 ] ) )
+
+typedef struct
+{
+    float t;
+    float true_speed[ 2 ];      /* cart cm/s, pendulum rad/s */
+    float position[ 2 ];        /* firmware cart cm, pendulum rad */
+    float firmware_speed[ 2 ];
+} row;
+
+static row rows[ COMPARE_MAX_ROWS ];
+static float estimate[ N_ESTIMATORS ][ 2 ][ COMPARE_MAX_ROWS ];
+
+static uint32_t read_trace( const char *path )
+{
+    FILE *f = fopen( path, "r" );
+    char line[ 512 ];
+    uint32_t n = 0;
+
+    if( f == NULL )
+    {
+        perror( path );
+        exit( EXIT_FAILURE );
+    }
+
+    /* Header. */
+    if( fgets( line, sizeof( line ), f ) == NULL )
+    {
+        fclose( f );
+        return 0;
+    }
+
+    while( n < COMPARE_MAX_ROWS && fgets( line, sizeof( line ), f ) != NULL )
+    {
+        float t, x, th, dx, dth, v, cp, pa, cs, ps;
+
+        if( sscanf( line, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &t, &x, &th, &dx, &dth, &v, &cp, &pa, &cs, &ps ) != 10 )
+        {
+            continue;
+        }
+        rows[ n ].t = t;
+        rows[ n ].true_speed[ 0 ] = dx;
+        rows[ n ].true_speed[ 1 ] = dth;
+        rows[ n ].position[ 0 ] = cp;
+        rows[ n ].position[ 1 ] = pa;
+        rows[ n ].firmware_speed[ 0 ] = cs;
+        rows[ n ].firmware_speed[ 1 ] = ps;
+        n++;
+    }
+
+    fclose( f );
+    return n;
+}
+
+static void run_estimator( const estimator *e, float *out[ 2 ], uint32_t n )
+{
+    for( uint32_t s = 0; s < 2; s++ )
+    {
+        LP_filter lp;
+        poly_diff pd;
+        float tustin = 0.0f;
+
+        LP_init( &lp, COMPARE_LP_T, COMPARE_DT );
+        poly_diff_init( &pd, e->window, e->order, e->delay, COMPARE_DT );
+
+        for( uint32_t i = 0; i < n; i++ )
+        {
+            float prev = i > 0 ? rows[ i - 1 ].position[ s ] : rows[ i ].position[ s ];
+            float y;
+
+            switch( e->kind )
+            {
+                case EST_FIRMWARE:
+                    y = rows[ i ].firmware_speed[ s ];
+                    break;
+                case EST_TUSTIN_LP:
+                case EST_TUSTIN_LP_NODZ:
+                    tustin = ( rows[ i ].position[ s ] - prev ) * 2.0f / COMPARE_DT - tustin;
+                    y = LP_update( &lp, tustin );
+                    if( e->kind == EST_TUSTIN_LP && s == 1 && y < COMPARE_DEAD_ZONE && y > -COMPARE_DEAD_ZONE )
+                    {
+                        y = 0.0f;
+                    }
+                    break;
+                default:
+                    y = poly_diff_update( &pd, rows[ i ].position[ s ] );
+                    break;
+            }
+            out[ s ][ i ] = y;
+        }
+    }
+}
+
+/* True speed lag_ms before row i, linear interpolation between rows. */
+static float true_speed_at( uint32_t i, uint32_t s, uint32_t lag_ms )
+{
+    float back = ( float ) lag_ms / ( COMPARE_DT * 1000.0f );
+    uint32_t whole = ( uint32_t ) back;
+    float frac = back - ( float ) whole;
+    uint32_t i0 = i >= whole ? i - whole : 0;
+    uint32_t i1 = i0 > 0 ? i0 - 1 : 0;
+
+    return ( 1.0f - frac ) * rows[ i0 ].true_speed[ s ] + frac * rows[ i1 ].true_speed[ s ];
+}
+
+static double rms_error( const float *est, uint32_t s, uint32_t first, uint32_t n, uint32_t lag_ms )
+{
+    double sq = 0.0;
+
+    for( uint32_t i = first; i < n; i++ )
+    {
+        double e = ( double ) est[ i ] - ( double ) true_speed_at( i, s, lag_ms );
+        sq += e * e;
+    }
+    return sqrt( sq / ( double ) ( n - first ) );
+}
+
+int main( int argc, char **argv )
+{
+    static const char *speed_names[ 2 ] = { "cart speed, cm/s", "pendulum speed, rad/s" };
+    float t_start = argc > 2 ? strtof( argv[ 2 ], NULL ) : 0.0f;
+    uint32_t first = 0;
+    uint32_t n;
+
+    if( argc < 2 )
+    {
+        fprintf( stderr, "usage: %s trace.csv [t_start]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+
+    n = read_trace( argv[ 1 ] );
+    while( first < n && rows[ first ].t < t_start )
+    {
+        first++;
+    }
+    /* Room for the largest lag. */
+    if( first < COMPARE_MAX_LAG_MS / 10 + 1 )
+    {
+        first = COMPARE_MAX_LAG_MS / 10 + 1;
+    }
+    if( n <= first + 1 )
+    {
+        fprintf( stderr, "not enough rows after t = %.2f s\n", ( double ) t_start );
+        return EXIT_FAILURE;
+    }
+
+    for( uint32_t k = 0; k < N_ESTIMATORS; k++ )
+    {
+        float *out[ 2 ] = { estimate[ k ][ 0 ], estimate[ k ][ 1 ] };
+        run_estimator( &estimators[ k ], out, n );
+    }
+
+    printf( "%u rows from t = %.2f s\n", ( unsigned ) ( n - first ), ( double ) rows[ first ].t );
+    for( uint32_t s = 0; s < 2; s++ )
+    {
+        printf( "\n%-34s %10s %8s %10s\n", speed_names[ s ], "rms", "lag ms", "noise" );
+        for( uint32_t k = 0; k < N_ESTIMATORS; k++ )
+        {
+            uint32_t best_lag = 0;
+            double best = INFINITY;
+
+            for( uint32_t lag = 0; lag <= COMPARE_MAX_LAG_MS; lag++ )
+            {
+                double r = rms_error( estimate[ k ][ s ], s, first, n, lag );
+                if( r < best )
+                {
+                    best = r;
+                    best_lag = lag;
+                }
+            }
+            printf( "%-34s %10.4f %8u %10.4f\n", estimators[ k ].name,
+                    rms_error( estimate[ k ][ s ], s, first, n, 0 ), ( unsigned ) best_lag, best );
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
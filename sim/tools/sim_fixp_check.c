@@ -0,0 +1,415 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Bit exactness check of the fixed point filters (LIP/source/fixp_filter.c)
+ * and of the Q15 FIR engine kernel (LIP/source/FIR_engine.c).
+ *
+ * Usage: sim_fixp_check [samples] [seed]
+ *
+ * Every filter runs on the firmware code (built with the firmware flags) and
+ * on a reference model written here from the arithmetic spelled out in
+ * fixp_filter.h: exact products in 128 bits, round half up as
+ * floor( ( acc + 2^( s - 1 ) ) / 2^s ), saturation to the output format.
+ * Signals are pseudo random full scale noise, full scale square waves and
+ * steps, so rounding ties and all saturation branches are hit. Low pass and
+ * IIR set up by their init functions can't saturate (DC gain 1, the output is
+ * a weighted mean of inputs and outputs), their saturation branches are hit
+ * by a second instance with coefficients set by hand to a gain above 1.
+ * Prints the number of mismatching samples per filter and the largest
+ * deviation from the float filter for the non saturating noise, exits with
+ * failure on any mismatch.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fixp_filter.h"
+#include "FIR_engine.h"
+#include "LP_filter.h"
+
+#define CHECK_DEFAULT_SAMPLES   200000UL
+#define CHECK_DEFAULT_SEED      1UL
+
+#define CHECK_DT                0.01f
+#define CHECK_ENGINE_TAPS       61
+
+__extension__ typedef __int128 wide;
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Reference arithmetic.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static wide ref_floor_div( wide v, unsigned shift )
+{
+    wide d = ( wide ) 1 << shift;
+    wide q = v / d;
+
+    if( v % d != 0 && v < 0 )
+    {
+        q--;
+    }
+    return q;
+}
+
+static wide ref_round( wide v, unsigned shift )
+{
+    return ref_floor_div( v + ( ( wide ) 1 << ( shift - 1 ) ), shift );
+}
+
+static wide ref_sat( wide v, wide lo, wide hi )
+{
+    return v < lo ? lo : ( v > hi ? hi : v );
+}
+
+#define REF_SAT_Q15( v ) ( ( int16_t ) ref_sat( ( v ), INT16_MIN, INT16_MAX ) )
+#define REF_SAT_Q31( v ) ( ( int32_t ) ref_sat( ( v ), INT32_MIN, INT32_MAX ) )
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Test signal, one sample per call, Q31. Segments of noise, square waves and
+ * steps at full scale.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+static unsigned long long rng_state;
+
+static uint32_t rng_next( void )
+{
+    rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return ( uint32_t ) ( rng_state >> 32 );
+}
+
+static int32_t signal_sample( unsigned long n )
+{
+    unsigned long segment = ( n / 1000 ) % 4;
+
+    switch( segment )
+    {
+        case 0:     /* noise at half scale */
+            return ( int32_t ) rng_next() / 2;
+        case 1:     /* full scale noise */
+            return ( int32_t ) rng_next();
+        case 2:     /* full scale square wave, period 20 samples */
+            return ( n / 10 ) % 2 ? INT32_MAX : INT32_MIN;
+        default:    /* steps with random levels */
+            return ( n % 50 ) == 0 ? ( int32_t ) rng_next() : ( int32_t ) ( rng_state >> 32 );
+    }
+}
+
+static int segment_is_nominal( unsigned long n )
+{
+    return ( ( n / 1000 ) % 4 ) == 0;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Checks.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+typedef struct
+{
+    const char *name;
+    unsigned long mismatches;
+    unsigned long saturated;
+    double max_float_error;     /* LSB of the output format, nominal noise only */
+} check_result;
+
+static void report( const check_result *r )
+{
+    printf( "%-30s mismatches %8lu, saturated %8lu", r->name, r->mismatches, r->saturated );
+    if( r->max_float_error >= 0.0 )
+    {
+        printf( ", max error against float %8.2f LSB", r->max_float_error );
+    }
+    printf( "\n" );
+}
+
+static check_result check_lp( unsigned long samples )
+{
+    check_result r15 = { "LP_filter Q15", 0, 0, 0.0 };
+    check_result r31 = { "LP_filter Q31", 0, 0, -1.0 };
+    LP_filter_q15 lp15;
+    LP_filter_q31 lp31;
+    LP_filter lpf;
+    int16_t in15_prev = 0, out15 = 0;
+    int32_t in31_prev = 0, out31 = 0;
+
+    LP_q15_init( &lp15, 0.05f, CHECK_DT );
+    LP_q31_init( &lp31, 0.05f, CHECK_DT );
+    LP_init( &lpf, 0.05f, CHECK_DT );
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        int32_t x = signal_sample( n );
+        int16_t x15 = ( int16_t ) ( x >> 16 );
+        int16_t y15 = LP_q15_update( &lp15, x15 );
+        int32_t y31 = LP_q31_update( &lp31, x );
+        float yf = LP_update( &lpf, ( float ) x15 );
+        wide acc;
+
+        acc = ( wide ) lp15.c1 * ( ( wide ) x15 + in15_prev ) + ( wide ) lp15.c2 * out15;
+        in15_prev = x15;
+        out15 = REF_SAT_Q15( ref_round( acc, 15 ) );
+        r15.mismatches += out15 != y15;
+        r15.saturated += ref_round( acc, 15 ) != out15;
+
+        acc = ( wide ) lp31.c1 * ( ( wide ) x + in31_prev ) + ( wide ) lp31.c2 * out31;
+        in31_prev = x;
+        out31 = REF_SAT_Q31( ref_round( acc, 31 ) );
+        r31.mismatches += out31 != y31;
+        r31.saturated += ref_round( acc, 31 ) != out31;
+
+        if( segment_is_nominal( n ) && n % 1000 > 100 )
+        {
+            double e = fabs( ( double ) yf - ( double ) y15 );
+            r15.max_float_error = e > r15.max_float_error ? e : r15.max_float_error;
+        }
+        else
+        {
+            /* Float filter follows the test signal, restart it on each segment. */
+            lpf.in[ 0 ] = ( float ) x15;
+            lpf.out[ 0 ] = ( float ) y15;
+        }
+    }
+
+    report( &r15 );
+    report( &r31 );
+    r15.mismatches += r31.mismatches;
+    return r15;
+}
+
+static check_result check_lp_overdriven( unsigned long samples )
+{
+    check_result r15 = { "LP_filter Q15 gain 1.5", 0, 0, -1.0 };
+    check_result r31 = { "LP_filter Q31 gain 1.5", 0, 0, -1.0 };
+    LP_filter_q15 lp15;
+    LP_filter_q31 lp31;
+    int16_t in15_prev = 0, out15 = 0;
+    int32_t in31_prev = 0, out31 = 0;
+
+    /* Input coefficient 1.5 times the designed one, DC gain above 1, so the
+    outputs saturate on the full scale signals. Short time constant, the
+    output follows the square waves and steps. Accumulator stays below
+    1.5 * 2^30 in Q15. */
+    LP_q15_init( &lp15, 0.01f, CHECK_DT );
+    LP_q31_init( &lp31, 0.01f, CHECK_DT );
+    lp15.c1 = ( int16_t ) ( lp15.c1 * 3 / 2 );
+    lp31.c1 = ( int32_t ) ( ( int64_t ) lp31.c1 * 3 / 2 );
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        int32_t x = signal_sample( n );
+        int16_t x15 = ( int16_t ) ( x >> 16 );
+        wide acc;
+
+        acc = ( wide ) lp15.c1 * ( ( wide ) x15 + in15_prev ) + ( wide ) lp15.c2 * out15;
+        in15_prev = x15;
+        out15 = REF_SAT_Q15( ref_round( acc, 15 ) );
+        r15.mismatches += LP_q15_update( &lp15, x15 ) != out15;
+        r15.saturated += ref_round( acc, 15 ) != out15;
+
+        acc = ( wide ) lp31.c1 * ( ( wide ) x + in31_prev ) + ( wide ) lp31.c2 * out31;
+        in31_prev = x;
+        out31 = REF_SAT_Q31( ref_round( acc, 31 ) );
+        r31.mismatches += LP_q31_update( &lp31, x ) != out31;
+        r31.saturated += ref_round( acc, 31 ) != out31;
+    }
+
+    report( &r15 );
+    report( &r31 );
+    r15.mismatches += r31.mismatches;
+    return r15;
+}
+
+static check_result check_fir( unsigned long samples )
+{
+    check_result r15 = { "FIR_filter Q15", 0, 0, -1.0 };
+    check_result r31 = { "FIR_filter Q31", 0, 0, -1.0 };
+    float coeffs[ FIR_BUFF_LEN ];
+    int16_t hist15[ FIR_BUFF_LEN ] = { 0 };
+    int32_t hist31[ FIR_BUFF_LEN ] = { 0 };
+    FIR_filter_q15 fir15;
+    FIR_filter_q31 fir31;
+
+    /* Gain above 1, so the outputs saturate on the full scale signals. */
+    FIR_design_lowpass( coeffs, FIR_BUFF_LEN, 0.2f );
+    for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+    {
+        coeffs[ i ] *= 1.5f;
+    }
+    FIR_q15_init( &fir15, coeffs );
+    FIR_q31_init( &fir31, coeffs );
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        int32_t x = signal_sample( n );
+        int16_t y15 = FIR_q15_update( &fir15, ( int16_t ) ( x >> 16 ) );
+        int32_t y31 = FIR_q31_update( &fir31, x );
+        wide acc15 = 0, acc31 = 0;
+
+        for( uint32_t i = FIR_BUFF_LEN - 1; i > 0; i-- )
+        {
+            hist15[ i ] = hist15[ i - 1 ];
+            hist31[ i ] = hist31[ i - 1 ];
+        }
+        hist15[ 0 ] = ( int16_t ) ( x >> 16 );
+        hist31[ 0 ] = x;
+
+        for( uint32_t i = 0; i < FIR_BUFF_LEN; i++ )
+        {
+            acc15 += ( wide ) fir15.coeffs[ i ] * hist15[ i ];
+            acc31 += ref_floor_div( ( wide ) fir31.coeffs[ i ] * hist31[ i ], FIR_Q31_GUARD_BITS );
+        }
+        r15.mismatches += REF_SAT_Q15( ref_round( acc15, 15 ) ) != y15;
+        r15.saturated  += REF_SAT_Q15( ref_round( acc15, 15 ) ) != ref_round( acc15, 15 );
+        r31.mismatches += REF_SAT_Q31( ref_round( acc31, 31 - FIR_Q31_GUARD_BITS ) ) != y31;
+        r31.saturated  += REF_SAT_Q31( ref_round( acc31, 31 - FIR_Q31_GUARD_BITS ) ) != ref_round( acc31, 31 - FIR_Q31_GUARD_BITS );
+    }
+
+    report( &r15 );
+    report( &r31 );
+    r15.mismatches += r31.mismatches;
+    return r15;
+}
+
+static check_result check_fir_engine( unsigned long samples )
+{
+    check_result r = { "FIR engine Q15, 61 taps", 0, 0, -1.0 };
+    float coeffs[ CHECK_ENGINE_TAPS ];
+    int16_t coeffs15[ CHECK_ENGINE_TAPS ];
+    int16_t state[ FIR_ENGINE_STATE_LEN( CHECK_ENGINE_TAPS ) ];
+    int16_t hist[ CHECK_ENGINE_TAPS ] = { 0 };
+    FIR_engine_q15 fir;
+
+    FIR_design_lowpass( coeffs, CHECK_ENGINE_TAPS, 0.1f );
+    for( uint32_t i = 0; i < CHECK_ENGINE_TAPS; i++ )
+    {
+        coeffs[ i ] *= 1.5f;
+    }
+    FIR_coeffs_to_q15( coeffs, coeffs15, CHECK_ENGINE_TAPS );
+    FIR_engine_q15_init( &fir, coeffs15, state, CHECK_ENGINE_TAPS );
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        int16_t x = ( int16_t ) ( signal_sample( n ) >> 16 );
+        int16_t y = FIR_engine_q15_update( &fir, x );
+        wide acc = 0;
+
+        for( uint32_t i = CHECK_ENGINE_TAPS - 1; i > 0; i-- )
+        {
+            hist[ i ] = hist[ i - 1 ];
+        }
+        hist[ 0 ] = x;
+        for( uint32_t i = 0; i < CHECK_ENGINE_TAPS; i++ )
+        {
+            acc += ( wide ) coeffs15[ i ] * hist[ i ];
+        }
+        r.mismatches += REF_SAT_Q15( ref_round( acc, 15 ) ) != y;
+        r.saturated  += REF_SAT_Q15( ref_round( acc, 15 ) ) != ref_round( acc, 15 );
+    }
+
+    report( &r );
+    return r;
+}
+
+static check_result check_iir( unsigned long samples, int overdriven )
+{
+    check_result r15 = { overdriven ? "IIR_filter Q15 gain 1.25" : "IIR_filter Q15", 0, 0, -1.0 };
+    check_result r31 = { overdriven ? "IIR_filter Q31 gain 1.25" : "IIR_filter Q31", 0, 0, -1.0 };
+    IIR_filter_q15 iir15;
+    IIR_filter_q31 iir31;
+    int16_t out15 = 0;
+    int32_t out31 = 0;
+
+    IIR_q15_init_fo( &iir15, 0.9f );
+    IIR_q31_init_fo( &iir31, 0.9f );
+    if( overdriven )
+    {
+        /* alpha -0.25, outside what init accepts, input weight 1.25 so the
+        outputs saturate on the full scale signals. Accumulator stays below
+        1.5 * 2^30 in Q15. */
+        iir15.alpha = -8192;
+        iir31.alpha = -( 1LL << 29 );
+    }
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        int32_t x = signal_sample( n );
+        int16_t x15 = ( int16_t ) ( x >> 16 );
+        wide acc;
+
+        acc = ( wide ) ( 32768 - iir15.alpha ) * x15 + ( wide ) iir15.alpha * out15;
+        out15 = REF_SAT_Q15( ref_round( acc, 15 ) );
+        r15.mismatches += IIR_q15_update_fo( &iir15, x15 ) != out15;
+        r15.saturated += ref_round( acc, 15 ) != out15;
+
+        acc = ( ( ( wide ) 1 << 31 ) - iir31.alpha ) * x + ( wide ) iir31.alpha * out31;
+        out31 = REF_SAT_Q31( ref_round( acc, 31 ) );
+        r31.mismatches += IIR_q31_update_fo( &iir31, x ) != out31;
+        r31.saturated += ref_round( acc, 31 ) != out31;
+    }
+
+    report( &r15 );
+    report( &r31 );
+    r15.mismatches += r31.mismatches;
+    return r15;
+}
+
+static check_result check_deriv( unsigned long samples )
+{
+    check_result r15 = { "Tustin derivative Q15", 0, 0, -1.0 };
+    check_result r31 = { "Tustin derivative Q31", 0, 0, -1.0 };
+    deriv_q15 d15;
+    deriv_q31 d31;
+    int16_t in15 = 0, out15 = 0;
+    int32_t in31 = 0, out31 = 0;
+
+    /* Output LSB of 1/16 input LSB per second, saturates on most steps. */
+    deriv_q15_init( &d15, CHECK_DT, 1.0f / 16.0f );
+    deriv_q31_init( &d31, CHECK_DT, 1.0f / 16.0f );
+
+    for( unsigned long n = 0; n < samples; n++ )
+    {
+        /* Slow ramps make the nominal segment, derivative stays in range. */
+        int32_t x = segment_is_nominal( n ) ? ( int32_t ) ( ( n % 1000 ) * 1000 ) : signal_sample( n );
+        int16_t x15 = ( int16_t ) ( x >> 16 );
+        wide v;
+
+        v = ref_round( ( wide ) d15.gain * ( ( wide ) x15 - in15 ), 16 ) - out15;
+        in15 = x15;
+        out15 = REF_SAT_Q15( v );
+        r15.mismatches += deriv_q15_update( &d15, x15 ) != out15;
+        r15.saturated += v != out15;
+
+        v = ref_round( ( wide ) d31.gain * ref_sat( ( wide ) x - in31, INT32_MIN, INT32_MAX ), 16 ) - out31;
+        in31 = x;
+        out31 = REF_SAT_Q31( v );
+        r31.mismatches += deriv_q31_update( &d31, x ) != out31;
+        r31.saturated += v != out31;
+    }
+
+    report( &r15 );
+    report( &r31 );
+    r15.mismatches += r31.mismatches;
+    return r15;
+}
+
+int main( int argc, char **argv )
+{
+    unsigned long samples = argc > 1 ? strtoul( argv[ 1 ], NULL, 10 ) : CHECK_DEFAULT_SAMPLES;
+    unsigned long seed = argc > 2 ? strtoul( argv[ 2 ], NULL, 10 ) : CHECK_DEFAULT_SEED;
+    unsigned long mismatches = 0;
+
+    printf( "samples: %lu, seed %lu\n", samples, seed );
+
+    rng_state = seed;
+    mismatches += check_lp( samples ).mismatches;
+    rng_state = seed;
+    mismatches += check_lp_overdriven( samples ).mismatches;
+    rng_state = seed;
+    mismatches += check_fir( samples ).mismatches;
+    rng_state = seed;
+    mismatches += check_fir_engine( samples ).mismatches;
+    rng_state = seed;
+    mismatches += check_iir( samples, 0 ).mismatches;
+    rng_state = seed;
+    mismatches += check_iir( samples, 1 ).mismatches;
+    rng_state = seed;
+    mismatches += check_deriv( samples ).mismatches;
+
+    printf( "%s\n", mismatches == 0 ? "bit exact" : "MISMATCH" );
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
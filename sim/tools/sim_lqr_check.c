@@ -0,0 +1,284 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Check of the on-target LQR solver (LIP/source/lqr.c).
+ *
+ * Usage: sim_lqr_check [upc|dpc] [q_x q_th q_dx q_dth r] [hz]
+ *
+ * Builds the rig model (default plant parameters) for the up or down
+ * position, discretizes it at the control rate (100 Hz, CTRL_TICK_HZ, by default) and
+ * solves the DARE with the firmware code (float, built with the firmware
+ * flags). The same problem is solved in double precision on the host, by
+ * discretizing with a long Taylor series and iterating the Riccati recursion
+ * until it settles. Prints both gains in gain set units (V/m, V/rad, Vs/m,
+ * Vs/rad), the relative difference, doubling steps, host solve time and the
+ * spectral radius of the discrete closed loop. Exits with failure if the
+ * float solver fails or is more than 1e-3 off.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lqr.h"
+
+#define CHECK_DEFAULT_HZ        100.0       /* CTRL_TICK_HZ in main_LIP.h */
+#define CHECK_TAYLOR_TERMS      40
+#define CHECK_RICCATI_MAX       10000000UL
+#define CHECK_REPEAT            10000UL
+
+/* Double precision reference. */
+static void ref_discretize( const float Ac[ LQR_N ][ LQR_N ], const float Bc[ LQR_N ], double dt,
+                            double A[ LQR_N ][ LQR_N ], double B[ LQR_N ] )
+{
+    double M[ LQR_N + 1 ][ LQR_N + 1 ] = { { 0.0 } };
+    double T[ LQR_N + 1 ][ LQR_N + 1 ];
+    double X[ LQR_N + 1 ][ LQR_N + 1 ];
+    double E[ LQR_N + 1 ][ LQR_N + 1 ];
+
+    for( int i = 0; i < LQR_N; i++ )
+    {
+        for( int j = 0; j < LQR_N; j++ )
+        {
+            M[ i ][ j ] = ( double ) Ac[ i ][ j ] * dt;
+        }
+        M[ i ][ LQR_N ] = ( double ) Bc[ i ] * dt;
+    }
+    for( int i = 0; i <= LQR_N; i++ )
+    {
+        for( int j = 0; j <= LQR_N; j++ )
+        {
+            T[ i ][ j ] = E[ i ][ j ] = ( i == j ) ? 1.0 : 0.0;
+        }
+    }
+    for( int k = 1; k <= CHECK_TAYLOR_TERMS; k++ )
+    {
+        for( int i = 0; i <= LQR_N; i++ )
+        {
+            for( int j = 0; j <= LQR_N; j++ )
+            {
+                double sum = 0.0;
+
+                for( int l = 0; l <= LQR_N; l++ )
+                {
+                    sum += T[ i ][ l ] * M[ l ][ j ];
+                }
+                X[ i ][ j ] = sum / k;
+            }
+        }
+        memcpy( T, X, sizeof( T ) );
+        for( int i = 0; i <= LQR_N; i++ )
+        {
+            for( int j = 0; j <= LQR_N; j++ )
+            {
+                E[ i ][ j ] += T[ i ][ j ];
+            }
+        }
+    }
+    for( int i = 0; i < LQR_N; i++ )
+    {
+        for( int j = 0; j < LQR_N; j++ )
+        {
+            A[ i ][ j ] = E[ i ][ j ];
+        }
+        B[ i ] = E[ i ][ LQR_N ];
+    }
+}
+
+/* K of one Riccati step, P_next = Q + A' P ( A - B K ). */
+static unsigned long ref_riccati( const double A[ LQR_N ][ LQR_N ], const double B[ LQR_N ],
+                                  const double Q[ LQR_N ], double R, double K[ LQR_N ] )
+{
+    double P[ LQR_N ][ LQR_N ] = { { 0.0 } };
+    double Pn[ LQR_N ][ LQR_N ];
+    double PB[ LQR_N ], Acl[ LQR_N ][ LQR_N ];
+    unsigned long it;
+
+    for( int i = 0; i < LQR_N; i++ )
+    {
+        P[ i ][ i ] = Q[ i ];
+    }
+    for( it = 1; it <= CHECK_RICCATI_MAX; it++ )
+    {
+        double den = R, change = 0.0, size = 0.0;
+
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            PB[ i ] = 0.0;
+            for( int l = 0; l < LQR_N; l++ )
+            {
+                PB[ i ] += P[ i ][ l ] * B[ l ];
+            }
+            den += B[ i ] * PB[ i ];
+        }
+        for( int j = 0; j < LQR_N; j++ )
+        {
+            K[ j ] = 0.0;
+            for( int l = 0; l < LQR_N; l++ )
+            {
+                K[ j ] += PB[ l ] * A[ l ][ j ];
+            }
+            K[ j ] /= den;
+        }
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            for( int j = 0; j < LQR_N; j++ )
+            {
+                Acl[ i ][ j ] = A[ i ][ j ] - B[ i ] * K[ j ];
+            }
+        }
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            for( int j = 0; j < LQR_N; j++ )
+            {
+                double sum = ( i == j ) ? Q[ i ] : 0.0;
+
+                for( int l = 0; l < LQR_N; l++ )
+                {
+                    for( int m = 0; m < LQR_N; m++ )
+                    {
+                        sum += A[ l ][ i ] * P[ l ][ m ] * Acl[ m ][ j ];
+                    }
+                }
+                Pn[ i ][ j ] = sum;
+            }
+        }
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            for( int j = 0; j < LQR_N; j++ )
+            {
+                double sym = 0.5 * ( Pn[ i ][ j ] + Pn[ j ][ i ] );
+
+                change = fmax( change, fabs( sym - P[ i ][ j ] ) );
+                size = fmax( size, fabs( sym ) );
+                P[ i ][ j ] = sym;
+            }
+        }
+        if( change <= 1e-15 * size )
+        {
+            break;
+        }
+    }
+    return it;
+}
+
+/* Spectral radius of the closed loop, from the growth of a power iteration. */
+static double ref_spectral_radius( const double A[ LQR_N ][ LQR_N ], const double B[ LQR_N ], const double K[ LQR_N ] )
+{
+    double x[ LQR_N ] = { 1.0, 0.7, -0.3, 0.2 };
+    double y[ LQR_N ];
+    double log_growth = 0.0;
+    int n = 4000;
+
+    for( int k = 0; k < n; k++ )
+    {
+        double u = 0.0, norm = 0.0;
+
+        for( int j = 0; j < LQR_N; j++ )
+        {
+            u -= K[ j ] * x[ j ];
+        }
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            y[ i ] = B[ i ] * u;
+            for( int j = 0; j < LQR_N; j++ )
+            {
+                y[ i ] += A[ i ][ j ] * x[ j ];
+            }
+            norm += y[ i ] * y[ i ];
+        }
+        norm = sqrt( norm );
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            x[ i ] = y[ i ] / norm;
+        }
+        if( k >= n / 2 )
+        {
+            log_growth += log( norm );
+        }
+    }
+    return exp( log_growth / ( n / 2 ) );
+}
+
+int main( int argc, char **argv )
+{
+    lqr_plant_params plant = LQR_PLANT_DEFAULT;
+    uint8_t down = 0;
+    float Q[ LQR_N ] = { 2000.0f, 100.0f, 0.0f, 0.0f };
+    float R = 1.0f;
+    double hz = CHECK_DEFAULT_HZ;
+    float Ac[ LQR_N ][ LQR_N ], Bc[ LQR_N ];
+    float A[ LQR_N ][ LQR_N ], B[ LQR_N ];
+    double Ad[ LQR_N ][ LQR_N ], Bd[ LQR_N ], Qd[ LQR_N ];
+    double K_ref[ LQR_N ];
+    float K[ LQR_N ];
+    static lqr_solver s;
+    unsigned long ref_it;
+    double err = 0.0, kmax = 0.0, seconds;
+    clock_t start;
+
+    if( argc > 1 )
+    {
+        if( !strcmp( argv[ 1 ], "dpc" ) )
+        {
+            down = 1;
+        }
+        else if( strcmp( argv[ 1 ], "upc" ) )
+        {
+            fprintf( stderr, "usage: sim_lqr_check [upc|dpc] [q_x q_th q_dx q_dth r] [hz]\n" );
+            return EXIT_FAILURE;
+        }
+    }
+    if( argc > 6 )
+    {
+        for( int i = 0; i < LQR_N; i++ )
+        {
+            Q[ i ] = strtof( argv[ 2 + i ], NULL );
+        }
+        R = strtof( argv[ 6 ], NULL );
+    }
+    if( argc > 7 )
+    {
+        hz = strtod( argv[ 7 ], NULL );
+    }
+
+    /* Firmware solver. */
+    start = clock();
+    for( unsigned long r = 0; r < CHECK_REPEAT; r++ )
+    {
+        lqr_cart_pendulum_model( &plant, down, Ac, Bc );
+        lqr_discretize( ( const float ( * )[ LQR_N ] ) Ac, Bc, ( float ) ( 1.0 / hz ), A, B );
+        lqr_init( &s, ( const float ( * )[ LQR_N ] ) A, B, Q, R );
+        while( !lqr_step( &s ) )
+        {
+        }
+        lqr_gain( &s, K );
+    }
+    seconds = ( double ) ( clock() - start ) / CLOCKS_PER_SEC / CHECK_REPEAT;
+
+    /* Reference. */
+    ref_discretize( ( const float ( * )[ LQR_N ] ) Ac, Bc, 1.0 / hz, Ad, Bd );
+    for( int i = 0; i < LQR_N; i++ )
+    {
+        Qd[ i ] = Q[ i ];
+    }
+    ref_it = ref_riccati( ( const double ( * )[ LQR_N ] ) Ad, Bd, Qd, R, K_ref );
+
+    for( int i = 0; i < LQR_N; i++ )
+    {
+        err = fmax( err, fabs( ( double ) K[ i ] - K_ref[ i ] ) );
+        kmax = fmax( kmax, fabs( K_ref[ i ] ) );
+    }
+
+    printf( "%s, %.0f Hz, Q = diag( %g %g %g %g ), R = %g\n", down ? "dpc" : "upc", hz,
+            ( double ) Q[ 0 ], ( double ) Q[ 1 ], ( double ) Q[ 2 ], ( double ) Q[ 3 ], ( double ) R );
+    printf( "float doubling:   K = %10.4f %10.4f %10.4f %10.4f  steps %lu%s, %.1f us on host\n",
+            ( double ) K[ 0 ], ( double ) K[ 1 ], ( double ) K[ 2 ], ( double ) K[ 3 ],
+            ( unsigned long ) s.steps, s.failed ? " FAILED" : "", seconds * 1e6 );
+    printf( "double Riccati:   K = %10.4f %10.4f %10.4f %10.4f  iterations %lu\n",
+            K_ref[ 0 ], K_ref[ 1 ], K_ref[ 2 ], K_ref[ 3 ], ref_it );
+    printf( "relative error:   %.2e\n", err / kmax );
+    printf( "closed loop:      spectral radius %.6f\n", ref_spectral_radius( ( const double ( * )[ LQR_N ] ) Ad, Bd, K_ref ) );
+
+    return ( s.failed || !( err <= 1e-3 * kmax ) ) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
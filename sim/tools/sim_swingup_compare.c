@@ -0,0 +1,499 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Monte Carlo comparison of the swingup modes.
+ *
+ * Usage: sim_swingup_compare [-n episodes] [-s seed] [-T seconds] [-p scale] [-F] [-f]
+ *
+ *     -n  number of episodes per mode, default 500
+ *     -s  seed, default 1
+ *     -T  swingup timeout in seconds, default 15
+ *     -p  scale of all perturbations, default 1.0 (0 runs the nominal plant)
+ *     -F  perturb only the friction (cart viscous and coulomb, pendulum
+ *         viscous), the other parameters and initial conditions are nominal
+ *     -f  catch with the default FSF gain set instead of the LQR gain
+ *
+ * All modes run on the same perturbed plants (sim_plant.h, same spreads as
+ * sim_upc_sweep) with encoder quantization and backward difference speeds at
+ * the 10 ms control period:
+ *     table  - swingup_control_2 voltage table (swingup_input_voltage_lookup_table.c)
+ *              from rest at SWINGUP_START_POSITION, where DPC leaves the cart,
+ *              hand-off at 0 < angle error < 126 deg
+ *     energy - energy shaping law (swingup_energy.c, firmware code and flags)
+ *              from rest anywhere in the middle of the track, hand-off inside
+ *              SWINGUP_ENERGY_CATCH_RAD when swingup_energy_catch_ok() with
+ *              the UPC gain predicts the cart stops 2 cm inside the zones
+ *     nominal - nominal voltage of the TVLQR table (swingup_tvlqr_table.c)
+ *              open loop, from rest at SWINGUP_TVLQR_START_CM, hand-off inside
+ *              SWINGUP_TVLQR_CATCH_RAD
+ *     tvlqr  - the same trajectory tracked with the TVLQR gains of the table
+ *              (swingup_tvlqr.c, firmware code and flags), same hand-off
+ * Hand-off is tested every 25 ms as in watchdog task. Speeds are plain
+ * backward differences, not the filtered estimates of util task, lip_sim
+ * with sim/scenarios/swingup_energy.txt runs the whole firmware path.
+ * After the hand-off the UPC law (ctrl_5 with the LQR_UPC_Q / LQR_UPC_R gain of
+ * the 'lqr' command, or the default gain set with -f, deadzone compensation,
+ * +-35 deg window) has to hold the pendulum for SWINGUP_HOLD_S. The default
+ * gain set leaves too little robustness margin on the perturbed plants, most
+ * of its failures are the UPC oscillating after a clean hand-off. An episode
+ * fails if the cart enters a freezing zone (counted apart for the swingup
+ * and for UPC after the hand-off), if there is no hand-off before the
+ * timeout or if the pendulum leaves the UPC window.
+ * Time to upright is the time from start to hand-off of the successful
+ * episodes; table and TVLQR times don't include the 3 s DPC pre-positioning.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lqr.h"
+#include "sim_plant.h"
+#include "swingup_energy.h"
+#include "swingup_tvlqr.h"
+
+#define SWINGUP_DEFAULT_EPISODES    500UL
+#define SWINGUP_DEFAULT_SECONDS     15.0
+
+/* Plant step and control period. */
+#define SWINGUP_H                   1e-4
+#define SWINGUP_SUBSTEPS            100
+#define SWINGUP_DT                  ( SWINGUP_H * SWINGUP_SUBSTEPS )
+#define SWINGUP_WATCHDOG_TICKS      ( 25.0 / 10.0 )
+
+/* LIP_task_swingup.c, swingup_input_voltage_lookup_table.c. */
+#define SWINGUP_START_POSITION_CM   11.0
+#define SWINGUP_TABLE_SAMPLES       220
+extern float swingup_control_2[ 220 ];
+
+/* Cart centre of the energy swingup and UPC setpoint after it. */
+#define SWINGUP_CENTRE_CM           20.0
+
+/* Watchdog freezing zones and hand-off tests, LIP_task_watchdog.c. */
+#define SWINGUP_FREEZE_LEFT_CM      3.0
+#define SWINGUP_FREEZE_RIGHT_CM     37.07
+#define SWINGUP_TABLE_CATCH_RAD     ( 126.0 * M_PI / 180.0 )
+
+/* SWINGUP_ENERGY_CATCH_MARGIN_CM of LIP_tasks_common.h. */
+#define SWINGUP_ENERGY_CATCH_MARGIN_CM  2.0
+
+/* UPC law, LIP_task_ctrl_upposition.c and gain_sets.c default set. Gains are
+F of u = F ( sp - x ), the LQR gain replaces them unless -f. */
+#define SWINGUP_UP_BASE             -0.070563
+#define SWINGUP_WINDOW_RAD          ( 35.0 * M_PI / 180.0 )
+#define SWINGUP_HOLD_S              3.0
+#define SWINGUP_U_MAX               12.0
+static double swingup_upc_gains[ 4 ] = { -74.5, -76.0, -51.5, -9.0 };
+static const double swingup_upc_deadzone    = 1.0;
+
+/* Encoder resolution in app units. */
+#define SWINGUP_RAD_PER_COUNT       ( 2.0 * M_PI / SIM_PEND_ENC_COUNTS )
+#define SWINGUP_M_PER_COUNT         ( 0.407 / SIM_CART_ENC_COUNTS )
+
+/* Perturbations, uniform relative spread at scale 1, as sim_upc_sweep. */
+static const double swingup_spread_cart_mass    = 0.3;
+static const double swingup_spread_pend_mass    = 0.2;
+static const double swingup_spread_pend_com     = 0.1;
+static const double swingup_spread_friction     = 0.5;
+static const double swingup_spread_motor        = 0.1;
+static const double swingup_spread_deadzone     = 0.3;
+static const double swingup_spread_eccentric    = 0.1;
+
+/* Initial condition spread at scale 1: energy mode start position around the
+centre, pendulum swing and the table start position. */
+static const double swingup_init_x              = 0.08;     /* m */
+static const double swingup_init_theta          = 0.1;      /* rad */
+static const double swingup_init_x_table        = 0.005;    /* m */
+
+/* -F, only the friction is perturbed. */
+static uint8_t swingup_friction_only = 0;
+
+typedef enum
+{
+    SWINGUP_MODE_TABLE = 0,
+    SWINGUP_MODE_ENERGY,
+    SWINGUP_MODE_NOMINAL,
+    SWINGUP_MODE_TVLQR,
+    SWINGUP_N_MODES
+} swingup_mode_t;
+
+static const char *swingup_mode_names[ SWINGUP_N_MODES ] = { "table", "energy", "nominal", "tvlqr" };
+
+typedef enum
+{
+    SWINGUP_OK = 0,
+    SWINGUP_FAIL_ZONE,
+    SWINGUP_FAIL_ZONE_UPC,
+    SWINGUP_FAIL_TIMEOUT,
+    SWINGUP_FAIL_FELL,
+    SWINGUP_N_OUTCOMES
+} swingup_outcome_t;
+
+static const char *swingup_outcome_names[ SWINGUP_N_OUTCOMES ] =
+{
+    "ok", "freezing zone", "freezing zone in UPC", "no hand-off", "left UPC window"
+};
+
+typedef struct
+{
+    uint8_t outcome;
+    double upright_s;       /* start to hand-off */
+    double margin_cm;       /* min distance to a freezing zone */
+} swingup_result_t;
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Random numbers, splitmix64 per episode.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static uint64_t rng_next( uint64_t *s )
+{
+    uint64_t z = ( *s += 0x9e3779b97f4a7c15ULL );
+
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+    return z ^ ( z >> 31 );
+}
+
+/* Uniform in [-1, 1). */
+static double rng_symmetric( uint64_t *s )
+{
+    return 2.0 * ( double ) ( rng_next( s ) >> 11 ) * 0x1.0p-53 - 1.0;
+}
+
+static double swingup_perturb( uint64_t *rng, double nominal, double spread, double scale )
+{
+    return nominal * ( 1.0 + spread * scale * rng_symmetric( rng ) );
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Episodes.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static void swingup_episode_params( uint64_t *rng, double s, sim_plant_params_t *p )
+{
+    double s_other = swingup_friction_only ? 0.0 : s;
+
+    sim_plant_default_params( p );
+    p->cart_mass          = swingup_perturb( rng, p->cart_mass, swingup_spread_cart_mass, s_other );
+    p->pend_mass          = swingup_perturb( rng, p->pend_mass, swingup_spread_pend_mass, s_other );
+    p->pend_com           = swingup_perturb( rng, p->pend_com, swingup_spread_pend_com, s_other );
+    p->pend_inertia       = 4.0 / 3.0 * p->pend_mass * p->pend_com * p->pend_com;
+    p->pend_viscous       = swingup_perturb( rng, p->pend_viscous, swingup_spread_friction, s );
+    p->cart_viscous       = swingup_perturb( rng, p->cart_viscous, swingup_spread_friction, s );
+    p->cart_coulomb       = swingup_perturb( rng, p->cart_coulomb, swingup_spread_friction, s );
+    p->motor_resistance   = swingup_perturb( rng, p->motor_resistance, swingup_spread_motor, s_other );
+    p->motor_kt           = swingup_perturb( rng, p->motor_kt, swingup_spread_motor, s_other );
+    p->motor_ke           = p->motor_kt;
+    p->voltage_deadzone   = swingup_perturb( rng, p->voltage_deadzone, swingup_spread_deadzone, s_other );
+    p->pend_enc_eccentric = swingup_perturb( rng, p->pend_enc_eccentric, swingup_spread_eccentric, s_other );
+}
+
+/* Firmware view of the plant: angle from the up position as the util task
+gets it (pendulum_angle_in_base_range_upc - PENDULUM_ANGLE_UP_SETPOINT_BASE),
+cart position in m, quantized. */
+static void swingup_sense( const sim_plant_t *plant, double *x, double *th )
+{
+    const sim_plant_params_t *p = &plant->p;
+    double reading = plant->theta + p->pend_enc_eccentric * ( cos( plant->theta ) + 1.0 );
+    double angle = floor( reading / SWINGUP_RAD_PER_COUNT ) * SWINGUP_RAD_PER_COUNT;
+
+    angle = angle - 2.0 * M_PI * floor( ( angle + M_PI ) / ( 2.0 * M_PI ) );
+    *th = angle - SWINGUP_UP_BASE;
+    *x = floor( plant->x / SWINGUP_M_PER_COUNT ) * SWINGUP_M_PER_COUNT;
+}
+
+/* LQR gain of the 'lqr' command at the control period, F = K. */
+static void swingup_lqr_gains( void )
+{
+    const lqr_plant_params model = LQR_PLANT_DEFAULT;
+    const float Q[ LQR_N ] = LQR_UPC_Q;
+    static lqr_solver s;
+    float Ac[ LQR_N ][ LQR_N ], Bc[ LQR_N ], A[ LQR_N ][ LQR_N ], B[ LQR_N ], K[ LQR_N ];
+
+    lqr_cart_pendulum_model( &model, 0, Ac, Bc );
+    lqr_discretize( ( const float ( * )[ LQR_N ] ) Ac, Bc, ( float ) SWINGUP_DT, A, B );
+    lqr_init( &s, ( const float ( * )[ LQR_N ] ) A, B, Q, LQR_UPC_R );
+    while( !lqr_step( &s ) )
+    {
+    }
+    lqr_gain( &s, K );
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        swingup_upc_gains[ i ] = K[ i ];
+    }
+}
+
+static double swingup_upc( const double x[ 4 ], double setpoint )
+{
+    double error = setpoint - x[ 0 ];
+    double u;
+
+    if( fabs( x[ 1 ] ) > SWINGUP_WINDOW_RAD )
+    {
+        return 0.0;
+    }
+    u = -swingup_upc_gains[ 0 ] * x[ 0 ] + swingup_upc_gains[ 0 ] * setpoint
+        - swingup_upc_gains[ 1 ] * x[ 1 ] - swingup_upc_gains[ 2 ] * x[ 2 ] - swingup_upc_gains[ 3 ] * x[ 3 ];
+    u += ( error > 0.0 ? swingup_upc_deadzone : -swingup_upc_deadzone );
+    return fmax( -SWINGUP_U_MAX, fmin( SWINGUP_U_MAX, u ) );
+}
+
+static void swingup_episode( swingup_mode_t mode, uint64_t seed, double scale, double seconds,
+                             swingup_result_t *res )
+{
+    static const swingup_energy_params energy_params = SWINGUP_ENERGY_DEFAULT;
+    static const lqr_plant_params model = LQR_PLANT_DEFAULT;
+    sim_plant_params_t p;
+    sim_plant_t plant;
+    uint64_t rng = seed;
+    double x_start, th_start, setpoint;
+    double x[ 4 ], x_prev, th_prev;
+    double t = 0.0, t_handoff = -1.0;
+    double s_init = swingup_friction_only ? 0.0 : scale;
+    uint32_t tick = 0;
+
+    /* Same plant for all modes, start from the same random numbers. */
+    swingup_episode_params( &rng, scale, &p );
+    if( mode == SWINGUP_MODE_TABLE )
+    {
+        x_start  = SWINGUP_START_POSITION_CM * 0.01 + swingup_init_x_table * s_init * rng_symmetric( &rng );
+        setpoint = SWINGUP_START_POSITION_CM * 0.01;
+    }
+    else if( mode == SWINGUP_MODE_ENERGY )
+    {
+        x_start  = SWINGUP_CENTRE_CM * 0.01 + swingup_init_x * s_init * rng_symmetric( &rng );
+        setpoint = SWINGUP_CENTRE_CM * 0.01;
+    }
+    else
+    {
+        x_start  = ( double ) SWINGUP_TVLQR_START_CM * 0.01 + swingup_init_x_table * s_init * rng_symmetric( &rng );
+        setpoint = ( double ) SWINGUP_TVLQR_START_CM * 0.01;
+    }
+    th_start = M_PI + swingup_init_theta * s_init * rng_symmetric( &rng );
+
+    sim_plant_init( &plant, &p, x_start, th_start );
+    swingup_sense( &plant, &x_prev, &th_prev );
+
+    res->outcome   = SWINGUP_FAIL_TIMEOUT;
+    res->upright_s = 0.0;
+    res->margin_cm = INFINITY;
+
+    for( ;; )
+    {
+        double u, dth;
+
+        /* Control tick, backward difference speeds. */
+        swingup_sense( &plant, &x[ 0 ], &x[ 1 ] );
+        dth = x[ 1 ] - th_prev;
+        dth -= 2.0 * M_PI * floor( ( dth + M_PI ) / ( 2.0 * M_PI ) );
+        x[ 2 ] = ( x[ 0 ] - x_prev ) / SWINGUP_DT;
+        x[ 3 ] = dth / SWINGUP_DT;
+        x_prev = x[ 0 ];
+        th_prev = x[ 1 ];
+
+        res->margin_cm = fmin( res->margin_cm, fmin( plant.x * 100.0 - SWINGUP_FREEZE_LEFT_CM,
+                                                     SWINGUP_FREEZE_RIGHT_CM - plant.x * 100.0 ) );
+        if( res->margin_cm < 0.0 )
+        {
+            res->outcome = t_handoff < 0.0 ? SWINGUP_FAIL_ZONE : SWINGUP_FAIL_ZONE_UPC;
+            return;
+        }
+
+        if( t_handoff < 0.0 && fmod( tick, SWINGUP_WATCHDOG_TICKS ) < 1.0 )
+        {
+            /* Hand-off tests of the watchdog. */
+            uint8_t caught;
+
+            if( mode == SWINGUP_MODE_TABLE )
+            {
+                caught = -x[ 1 ] > 0.0 && -x[ 1 ] < SWINGUP_TABLE_CATCH_RAD;
+            }
+            else if( mode == SWINGUP_MODE_ENERGY )
+            {
+                float K[ LQR_N ], xf[ LQR_N ];
+
+                for( uint32_t i = 0; i < LQR_N; i++ )
+                {
+                    K[ i ] = ( float ) swingup_upc_gains[ i ];
+                }
+                xf[ 0 ] = ( float ) ( x[ 0 ] - setpoint );
+                xf[ 1 ] = ( float ) x[ 1 ];
+                xf[ 2 ] = ( float ) x[ 2 ];
+                xf[ 3 ] = ( float ) x[ 3 ];
+                caught = fabs( x[ 1 ] ) < ( double ) SWINGUP_ENERGY_CATCH_RAD
+                         && swingup_energy_catch_ok( &model, K, xf,
+                                ( float ) ( ( SWINGUP_FREEZE_LEFT_CM + SWINGUP_ENERGY_CATCH_MARGIN_CM ) * 0.01 - setpoint ),
+                                ( float ) ( ( SWINGUP_FREEZE_RIGHT_CM - SWINGUP_ENERGY_CATCH_MARGIN_CM ) * 0.01 - setpoint ),
+                                ( float ) ( SWINGUP_U_MAX - swingup_upc_deadzone ) );
+            }
+            else
+            {
+                caught = fabs( x[ 1 ] ) < ( double ) SWINGUP_TVLQR_CATCH_RAD;
+            }
+            if( caught )
+            {
+                t_handoff = t;
+            }
+        }
+        if( t_handoff < 0.0 && t >= seconds )
+        {
+            return;
+        }
+
+        if( t_handoff >= 0.0 )
+        {
+            if( t - t_handoff >= SWINGUP_HOLD_S )
+            {
+                res->outcome = SWINGUP_OK;
+                res->upright_s = t_handoff;
+                return;
+            }
+            /* Table hand-off happens far from the window, UPC outputs 0 V
+            until the pendulum gets there, falling back out of it fails. */
+            if( fabs( x[ 1 ] ) > SWINGUP_WINDOW_RAD && t - t_handoff > 1.0 )
+            {
+                res->outcome = SWINGUP_FAIL_FELL;
+                return;
+            }
+            u = swingup_upc( x, setpoint );
+        }
+        else if( mode == SWINGUP_MODE_TABLE )
+        {
+            u = tick < SWINGUP_TABLE_SAMPLES ? ( double ) swingup_control_2[ tick ] : 0.0;
+        }
+        else
+        {
+            float xf[ LQR_N ];
+
+            xf[ 0 ] = ( float ) ( x[ 0 ] - setpoint );
+            xf[ 1 ] = ( float ) x[ 1 ];
+            xf[ 2 ] = ( float ) x[ 2 ];
+            xf[ 3 ] = ( float ) x[ 3 ];
+            if( mode == SWINGUP_MODE_ENERGY )
+            {
+                u = swingup_energy_voltage( &energy_params, &model, xf );
+            }
+            else if( tick >= SWINGUP_TVLQR_SAMPLES )
+            {
+                u = 0.0;
+            }
+            else
+            {
+                /* Open loop is the law at the nominal state. */
+                if( mode == SWINGUP_MODE_NOMINAL )
+                {
+                    swingup_tvlqr_nominal( tick, xf );
+                }
+                u = swingup_tvlqr_voltage( tick, xf );
+            }
+        }
+
+        sim_plant_set_voltage( &plant, u );
+        sim_plant_advance( &plant, SWINGUP_H, SWINGUP_SUBSTEPS );
+        t += SWINGUP_DT;
+        tick++;
+    }
+}
+
+static int swingup_cmp_double( const void *a, const void *b )
+{
+    double x = *( const double * ) a, y = *( const double * ) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+static void swingup_report( swingup_mode_t mode, const swingup_result_t *res, uint32_t n )
+{
+    uint32_t outcomes[ SWINGUP_N_OUTCOMES ] = { 0 };
+    double *upright = malloc( n * sizeof( double ) );
+    double worst_margin = INFINITY;
+    uint32_t n_ok = 0;
+
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        outcomes[ res[ i ].outcome ]++;
+        if( res[ i ].outcome == SWINGUP_OK )
+        {
+            upright[ n_ok++ ] = res[ i ].upright_s;
+            worst_margin = fmin( worst_margin, res[ i ].margin_cm );
+        }
+    }
+
+    printf( "%-7s success rate %6.2f %% (%u / %u)", swingup_mode_names[ mode ], 100.0 * n_ok / n, n_ok, n );
+    for( uint32_t k = 1; k < SWINGUP_N_OUTCOMES; k++ )
+    {
+        printf( ", %s %u", swingup_outcome_names[ k ], outcomes[ k ] );
+    }
+    putchar( '\n' );
+    if( n_ok > 0 )
+    {
+        qsort( upright, n_ok, sizeof( double ), swingup_cmp_double );
+        printf( "        time to upright p50 %.2f s, p90 %.2f s, max %.2f s, worst zone margin %.2f cm\n",
+                upright[ n_ok / 2 ], upright[ n_ok * 9 / 10 ], upright[ n_ok - 1 ], worst_margin );
+    }
+
+    free( upright );
+}
+
+static void usage( void )
+{
+    fprintf( stderr, "usage: sim_swingup_compare [-n episodes] [-s seed] [-T seconds] [-p scale] [-F] [-f]\n" );
+    exit( EXIT_FAILURE );
+}
+
+int main( int argc, char **argv )
+{
+    uint32_t n = SWINGUP_DEFAULT_EPISODES;
+    uint64_t seed = 1;
+    double seconds = SWINGUP_DEFAULT_SECONDS, scale = 1.0;
+    swingup_result_t *res;
+    uint8_t fsf = 0;
+    int opt;
+
+    while( ( opt = getopt( argc, argv, "n:s:T:p:Ff" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'n': n = ( uint32_t ) strtoul( optarg, NULL, 10 ); break;
+            case 's': seed = strtoull( optarg, NULL, 10 ); break;
+            case 'T': seconds = strtod( optarg, NULL ); break;
+            case 'p': scale = strtod( optarg, NULL ); break;
+            case 'F': swingup_friction_only = 1; break;
+            case 'f': fsf = 1; break;
+            default: usage();
+        }
+    }
+    if( n == 0 || seconds <= 0.0 )
+    {
+        usage();
+    }
+
+    res = calloc( n, sizeof( swingup_result_t ) );
+    if( res == NULL )
+    {
+        fprintf( stderr, "sim_swingup_compare: out of memory\n" );
+        return EXIT_FAILURE;
+    }
+
+    if( !fsf )
+    {
+        swingup_lqr_gains();
+    }
+
+    printf( "episodes: %u per mode, seed %llu, perturbation scale %.2f%s, timeout %.1f s, hold %.1f s\n",
+            n, ( unsigned long long ) seed, scale, swingup_friction_only ? " (friction only)" : "", seconds,
+            SWINGUP_HOLD_S );
+    printf( "UPC gains (%s): %.1f %.1f %.1f %.2f\n", fsf ? "default set" : "lqr",
+            swingup_upc_gains[ 0 ], swingup_upc_gains[ 1 ], swingup_upc_gains[ 2 ], swingup_upc_gains[ 3 ] );
+    for( uint32_t m = 0; m < SWINGUP_N_MODES; m++ )
+    {
+        for( uint32_t i = 0; i < n; i++ )
+        {
+            swingup_episode( ( swingup_mode_t ) m, seed * 0x100000001ULL + i, scale, seconds, &res[ i ] );
+        }
+        swingup_report( ( swingup_mode_t ) m, res, n );
+    }
+
+    free( res );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,633 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Generator of the TVLQR swingup table (swingup_tvlqr.h).
+ *
+ * Usage: sim_swingup_tvlqr [-o file] [-i iterations]
+ *
+ *     -o  output C file, default stdout
+ *         (LIP/source/swingup_tvlqr_table.c in the tree)
+ *     -i  maximum number of iLQR iterations, default 200
+ *
+ * Trajectory: iterative LQR on the rig model of lqr.h (nonlinear pendulum,
+ * RK4 with 1 ms steps inside the 10 ms zero order hold sample) from rest
+ * hanging at the start position, SWINGUP_TVLQR_SAMPLES samples. Cost:
+ *     running   r u^2 + w_x ( |x| - SWINGUP_TVLQR_X_MAX )+^2
+ *                     + w_u ( |u| - SWINGUP_TVLQR_U_NOM_MAX )+^2
+ *     terminal  weighted squared error from upright at rest at the start
+ *               position (angle 0 or +-2 PI, whichever side the seed takes)
+ * The seed is the energy shaping law (swingup_energy.c, no deadzone) until
+ * SWINGUP_ENERGY_CATCH_RAD and the UPC LQR gain after it, so the optimizer
+ * starts from a swingup that already gets up.
+ *
+ * Gains: backward Riccati recursion of the trajectory linearized per sample
+ * (finite differences of the sample map) with LQR_UPC_Q / LQR_UPC_R and the
+ * DARE solution of the up position as terminal P. Feedback is
+ * u = u_nom + K ( x_nom - x ), the same sign as the F gains of the laws.
+ *
+ * Prints trajectory figures to stderr: cost, terminal error, cart and
+ * voltage range, gain range and the worst quantization error of the table.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "lqr.h"
+#include "swingup_energy.h"
+#include "swingup_tvlqr.h"
+
+#define TVLQR_N                 SWINGUP_TVLQR_SAMPLES
+#define TVLQR_DT                0.01
+#define TVLQR_SUBSTEPS          10
+#define TVLQR_DEFAULT_ITERATIONS 200
+
+/* Cost weights. */
+#define TVLQR_R                 0.01
+#define TVLQR_W_X               1.0e5
+#define TVLQR_W_U               100.0
+static const double tvlqr_qf[ LQR_N ] = { 1.0e4, 1.0e4, 1.0e3, 1.0e3 };
+
+/* Finite difference step of the linearization. */
+#define TVLQR_EPS               1.0e-6
+
+typedef struct
+{
+    double a, b, w0_sq, c, d;
+} tvlqr_model_t;
+
+static tvlqr_model_t model;
+
+/* Trajectory, x[ k ] for k = 0 .. N, u[ k ] for k = 0 .. N - 1. */
+static double traj_x[ TVLQR_N + 1 ][ LQR_N ];
+static double traj_u[ TVLQR_N ];
+static double new_x[ TVLQR_N + 1 ][ LQR_N ];
+static double new_u[ TVLQR_N ];
+
+/* Per sample linearization and gains. */
+static double lin_a[ TVLQR_N ][ LQR_N ][ LQR_N ];
+static double lin_b[ TVLQR_N ][ LQR_N ];
+static double gain_ff[ TVLQR_N ];
+static double gain_fb[ TVLQR_N ][ LQR_N ];
+static double tvlqr_k[ TVLQR_N ][ LQR_N ];
+
+static double goal[ LQR_N ];
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Model.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static void tvlqr_deriv( const double s[ LQR_N ], double u, double ds[ LQR_N ] )
+{
+    double ddx = -model.a * s[ 2 ] + model.b * u;
+
+    ds[ 0 ] = s[ 2 ];
+    ds[ 1 ] = s[ 3 ];
+    ds[ 2 ] = ddx;
+    ds[ 3 ] = model.w0_sq * sin( s[ 1 ] ) - model.c * ddx * cos( s[ 1 ] ) - model.d * s[ 3 ];
+}
+
+/* One control sample, RK4. */
+static void tvlqr_step( const double s[ LQR_N ], double u, double out[ LQR_N ] )
+{
+    const double h = TVLQR_DT / TVLQR_SUBSTEPS;
+    double k1[ LQR_N ], k2[ LQR_N ], k3[ LQR_N ], k4[ LQR_N ], t[ LQR_N ], y[ LQR_N ];
+
+    memcpy( y, s, sizeof( y ) );
+    for( uint32_t n = 0; n < TVLQR_SUBSTEPS; n++ )
+    {
+        tvlqr_deriv( y, u, k1 );
+        for( uint32_t i = 0; i < LQR_N; i++ ) t[ i ] = y[ i ] + 0.5 * h * k1[ i ];
+        tvlqr_deriv( t, u, k2 );
+        for( uint32_t i = 0; i < LQR_N; i++ ) t[ i ] = y[ i ] + 0.5 * h * k2[ i ];
+        tvlqr_deriv( t, u, k3 );
+        for( uint32_t i = 0; i < LQR_N; i++ ) t[ i ] = y[ i ] + h * k3[ i ];
+        tvlqr_deriv( t, u, k4 );
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            y[ i ] += h / 6.0 * ( k1[ i ] + 2.0 * k2[ i ] + 2.0 * k3[ i ] + k4[ i ] );
+        }
+    }
+    memcpy( out, y, sizeof( y ) );
+}
+
+/* Sample map linearized at s, u, central differences. */
+static void tvlqr_linearize( const double s[ LQR_N ], double u, double A[ LQR_N ][ LQR_N ], double B[ LQR_N ] )
+{
+    double sp[ LQR_N ], sm[ LQR_N ], yp[ LQR_N ], ym[ LQR_N ];
+
+    for( uint32_t j = 0; j < LQR_N; j++ )
+    {
+        memcpy( sp, s, sizeof( sp ) );
+        memcpy( sm, s, sizeof( sm ) );
+        sp[ j ] += TVLQR_EPS;
+        sm[ j ] -= TVLQR_EPS;
+        tvlqr_step( sp, u, yp );
+        tvlqr_step( sm, u, ym );
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            A[ i ][ j ] = ( yp[ i ] - ym[ i ] ) / ( 2.0 * TVLQR_EPS );
+        }
+    }
+    tvlqr_step( s, u + TVLQR_EPS, yp );
+    tvlqr_step( s, u - TVLQR_EPS, ym );
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        B[ i ] = ( yp[ i ] - ym[ i ] ) / ( 2.0 * TVLQR_EPS );
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Riccati recursion, one input: K = ( R + B' P B )^-1 B' P A,
+ * P = Q + A' P ( A - B K ).
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static void tvlqr_riccati_step( double P[ LQR_N ][ LQR_N ], const double A[ LQR_N ][ LQR_N ], const double B[ LQR_N ],
+                                const double Q[ LQR_N ], double R, double K[ LQR_N ] )
+{
+    double pb[ LQR_N ], pa[ LQR_N ][ LQR_N ], next[ LQR_N ][ LQR_N ];
+    double bpb = R;
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        pb[ i ] = 0.0;
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            pb[ i ] += P[ i ][ j ] * B[ j ];
+        }
+        bpb += B[ i ] * pb[ i ];
+    }
+    for( uint32_t j = 0; j < LQR_N; j++ )
+    {
+        K[ j ] = 0.0;
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            K[ j ] += pb[ i ] * A[ i ][ j ];
+        }
+        K[ j ] /= bpb;
+    }
+    /* P ( A - B K ) */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            pa[ i ][ j ] = 0.0;
+            for( uint32_t m = 0; m < LQR_N; m++ )
+            {
+                pa[ i ][ j ] += P[ i ][ m ] * ( A[ m ][ j ] - B[ m ] * K[ j ] );
+            }
+        }
+    }
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            next[ i ][ j ] = ( i == j ) ? Q[ i ] : 0.0;
+            for( uint32_t m = 0; m < LQR_N; m++ )
+            {
+                next[ i ][ j ] += A[ m ][ i ] * pa[ m ][ j ];
+            }
+        }
+    }
+    /* Keep P symmetric. */
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            P[ i ][ j ] = 0.5 * ( next[ i ][ j ] + next[ j ][ i ] );
+        }
+    }
+}
+
+/* Up position DARE by iterating the recursion, P and K. */
+static int tvlqr_dare( const double Q[ LQR_N ], double R, double P[ LQR_N ][ LQR_N ], double K[ LQR_N ] )
+{
+    const double up[ LQR_N ] = { 0.0, 0.0, 0.0, 0.0 };
+    double A[ LQR_N ][ LQR_N ], B[ LQR_N ], K_prev[ LQR_N ];
+
+    tvlqr_linearize( up, 0.0, A, B );
+    memset( P, 0, sizeof( double ) * LQR_N * LQR_N );
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        P[ i ][ i ] = Q[ i ];
+        K[ i ] = 0.0;
+    }
+    for( uint32_t n = 0; n < 100000; n++ )
+    {
+        double change = 0.0, size = 0.0;
+
+        memcpy( K_prev, K, sizeof( K_prev ) );
+        tvlqr_riccati_step( P, ( const double ( * )[ LQR_N ] ) A, B, Q, R, K );
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            change += fabs( K[ i ] - K_prev[ i ] );
+            size += fabs( K[ i ] );
+        }
+        if( n > 10 && change < 1e-12 * size )
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * iLQR.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static double tvlqr_excess( double v, double limit )
+{
+    return fabs( v ) > limit ? ( fabs( v ) - limit ) * ( v > 0.0 ? 1.0 : -1.0 ) : 0.0;
+}
+
+static double tvlqr_cost( const double x[][ LQR_N ], const double *u )
+{
+    double cost = 0.0, e;
+
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        e = tvlqr_excess( x[ k ][ 0 ], SWINGUP_TVLQR_X_MAX );
+        cost += TVLQR_W_X * e * e;
+        e = tvlqr_excess( u[ k ], SWINGUP_TVLQR_U_NOM_MAX );
+        cost += TVLQR_R * u[ k ] * u[ k ] + TVLQR_W_U * e * e;
+    }
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        e = x[ TVLQR_N ][ i ] - goal[ i ];
+        cost += tvlqr_qf[ i ] * e * e;
+    }
+    return cost;
+}
+
+/* Backward pass, Gauss-Newton, mu regularizes the input Hessian. Returns 0
+if it is not positive. */
+static int tvlqr_backward( double mu )
+{
+    double vx[ LQR_N ], vxx[ LQR_N ][ LQR_N ];
+
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        vx[ i ] = 2.0 * tvlqr_qf[ i ] * ( traj_x[ TVLQR_N ][ i ] - goal[ i ] );
+        for( uint32_t j = 0; j < LQR_N; j++ )
+        {
+            vxx[ i ][ j ] = ( i == j ) ? 2.0 * tvlqr_qf[ i ] : 0.0;
+        }
+    }
+
+    for( int32_t k = TVLQR_N - 1; k >= 0; k-- )
+    {
+        double ( *A )[ LQR_N ] = lin_a[ k ];
+        const double *B = lin_b[ k ];
+        double lx[ LQR_N ] = { 0.0 }, lxx0 = 0.0;
+        double qx[ LQR_N ], qxx[ LQR_N ][ LQR_N ], qux[ LQR_N ], vb[ LQR_N ], va[ LQR_N ][ LQR_N ];
+        double qu, quu, e;
+
+        e = tvlqr_excess( traj_x[ k ][ 0 ], SWINGUP_TVLQR_X_MAX );
+        lx[ 0 ] = 2.0 * TVLQR_W_X * e;
+        lxx0 = ( e != 0.0 ) ? 2.0 * TVLQR_W_X : 0.0;
+        e = tvlqr_excess( traj_u[ k ], SWINGUP_TVLQR_U_NOM_MAX );
+        qu = 2.0 * TVLQR_R * traj_u[ k ] + 2.0 * TVLQR_W_U * e;
+        quu = 2.0 * TVLQR_R + ( ( e != 0.0 ) ? 2.0 * TVLQR_W_U : 0.0 ) + mu;
+
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            vb[ i ] = 0.0;
+            for( uint32_t j = 0; j < LQR_N; j++ )
+            {
+                vb[ i ] += vxx[ i ][ j ] * B[ j ];
+                va[ i ][ j ] = 0.0;
+                for( uint32_t m = 0; m < LQR_N; m++ )
+                {
+                    va[ i ][ j ] += vxx[ i ][ m ] * A[ m ][ j ];
+                }
+            }
+        }
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            qu += B[ i ] * vx[ i ];
+            quu += B[ i ] * vb[ i ];
+            qx[ i ] = lx[ i ];
+            qux[ i ] = 0.0;
+            for( uint32_t m = 0; m < LQR_N; m++ )
+            {
+                qx[ i ] += A[ m ][ i ] * vx[ m ];
+                qux[ i ] += B[ m ] * va[ m ][ i ];
+            }
+            for( uint32_t j = 0; j < LQR_N; j++ )
+            {
+                qxx[ i ][ j ] = ( i == 0 && j == 0 ) ? lxx0 : 0.0;
+                for( uint32_t m = 0; m < LQR_N; m++ )
+                {
+                    qxx[ i ][ j ] += A[ m ][ i ] * va[ m ][ j ];
+                }
+            }
+        }
+        if( quu <= 0.0 )
+        {
+            return 0;
+        }
+
+        gain_ff[ k ] = -qu / quu;
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            gain_fb[ k ][ i ] = -qux[ i ] / quu;
+        }
+        /* V = Q with u = k + K dx. */
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            vx[ i ] = qx[ i ] + qux[ i ] * gain_ff[ k ];
+            for( uint32_t j = 0; j < LQR_N; j++ )
+            {
+                vxx[ i ][ j ] = qxx[ i ][ j ] - qux[ i ] * qux[ j ] / quu;
+            }
+        }
+    }
+    return 1;
+}
+
+static void tvlqr_forward( double alpha )
+{
+    memcpy( new_x[ 0 ], traj_x[ 0 ], sizeof( new_x[ 0 ] ) );
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        double u = traj_u[ k ] + alpha * gain_ff[ k ];
+
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            u += gain_fb[ k ][ i ] * ( new_x[ k ][ i ] - traj_x[ k ][ i ] );
+        }
+        new_u[ k ] = u;
+        tvlqr_step( new_x[ k ], u, new_x[ k + 1 ] );
+    }
+}
+
+static void tvlqr_linearize_trajectory( void )
+{
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        tvlqr_linearize( traj_x[ k ], traj_u[ k ], lin_a[ k ], lin_b[ k ] );
+    }
+}
+
+static double tvlqr_optimize( uint32_t iterations )
+{
+    double cost = tvlqr_cost( ( const double ( * )[ LQR_N ] ) traj_x, traj_u );
+    double mu = 1e-6;
+
+    for( uint32_t n = 0; n < iterations; n++ )
+    {
+        double alpha, best = cost;
+
+        tvlqr_linearize_trajectory();
+        if( !tvlqr_backward( mu ) )
+        {
+            mu *= 10.0;
+            continue;
+        }
+        for( alpha = 1.0; alpha > 1e-4; alpha *= 0.5 )
+        {
+            tvlqr_forward( alpha );
+            best = tvlqr_cost( ( const double ( * )[ LQR_N ] ) new_x, new_u );
+            if( best < cost )
+            {
+                break;
+            }
+        }
+        if( best >= cost )
+        {
+            mu *= 10.0;
+            if( mu > 1e6 )
+            {
+                break;
+            }
+            continue;
+        }
+        memcpy( traj_x, new_x, sizeof( traj_x ) );
+        memcpy( traj_u, new_u, sizeof( traj_u ) );
+        mu = fmax( 1e-8, mu * 0.3 );
+        if( cost - best < 1e-9 * cost )
+        {
+            cost = best;
+            break;
+        }
+        cost = best;
+    }
+    return cost;
+}
+
+/* Energy swingup on the model until the catch angle, UPC LQR after it. */
+static void tvlqr_seed( const double K[ LQR_N ] )
+{
+    swingup_energy_params energy = SWINGUP_ENERGY_DEFAULT;
+    const lqr_plant_params plant = LQR_PLANT_DEFAULT;
+    uint8_t caught = 0;
+
+    energy.deadzone = 0.0f;
+    energy.u_max = SWINGUP_TVLQR_U_NOM_MAX;
+    energy.x_min = -SWINGUP_TVLQR_X_MAX;
+    energy.x_max = SWINGUP_TVLQR_X_MAX;
+
+    memset( traj_x[ 0 ], 0, sizeof( traj_x[ 0 ] ) );
+    traj_x[ 0 ][ 1 ] = M_PI;
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        double th = traj_x[ k ][ 1 ] - 2.0 * M_PI * floor( ( traj_x[ k ][ 1 ] + M_PI ) / ( 2.0 * M_PI ) );
+        double u = 0.0;
+
+        caught = caught || fabs( th ) < ( double ) SWINGUP_ENERGY_CATCH_RAD;
+        if( caught )
+        {
+            u = -K[ 0 ] * traj_x[ k ][ 0 ] - K[ 1 ] * th - K[ 2 ] * traj_x[ k ][ 2 ] - K[ 3 ] * traj_x[ k ][ 3 ];
+        }
+        else
+        {
+            float xf[ LQR_N ] = { ( float ) traj_x[ k ][ 0 ], ( float ) th, ( float ) traj_x[ k ][ 2 ],
+                                  ( float ) traj_x[ k ][ 3 ] };
+
+            u = swingup_energy_voltage( &energy, &plant, xf );
+        }
+        traj_u[ k ] = fmax( -SWINGUP_TVLQR_U_NOM_MAX, fmin( SWINGUP_TVLQR_U_NOM_MAX, u ) );
+        tvlqr_step( traj_x[ k ], traj_u[ k ], traj_x[ k + 1 ] );
+    }
+
+    /* Upright on the side the seed went over. */
+    memset( goal, 0, sizeof( goal ) );
+    goal[ 1 ] = 2.0 * M_PI * floor( ( traj_x[ TVLQR_N ][ 1 ] + M_PI ) / ( 2.0 * M_PI ) );
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Table.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static double tvlqr_column( uint32_t k, uint32_t column )
+{
+    if( column == SWINGUP_TVLQR_COL_U )
+    {
+        return traj_u[ k ];
+    }
+    if( column < SWINGUP_TVLQR_COL_K )
+    {
+        return traj_x[ k ][ column - SWINGUP_TVLQR_COL_X ];
+    }
+    return tvlqr_k[ k ][ column - SWINGUP_TVLQR_COL_K ];
+}
+
+static void tvlqr_write_table( FILE *f, double cost )
+{
+    static const char *names[ SWINGUP_TVLQR_COLUMNS ] = { "u V", "x m", "th rad", "dx m/s", "dth rad/s",
+                                                          "K x", "K th", "K dx", "K dth" };
+    float scale[ SWINGUP_TVLQR_COLUMNS ];
+    double worst[ SWINGUP_TVLQR_COLUMNS ];
+
+    for( uint32_t c = 0; c < SWINGUP_TVLQR_COLUMNS; c++ )
+    {
+        double peak = 0.0;
+
+        for( uint32_t k = 0; k < TVLQR_N; k++ )
+        {
+            peak = fmax( peak, fabs( tvlqr_column( k, c ) ) );
+        }
+        /* Rounded up a little, so that no value quantizes past 32767. */
+        scale[ c ] = ( float ) ( peak * ( 1.0 + 1e-6 ) / 32767.0 );
+        if( scale[ c ] <= 0.0f )
+        {
+            scale[ c ] = 1.0f;
+        }
+        worst[ c ] = 0.0;
+    }
+
+    fprintf( f, "/* Swingup trajectory and TVLQR gains (swingup_tvlqr.h).\n" );
+    fprintf( f, " * Generated by sim_swingup_tvlqr (sim/tools), do not edit.\n" );
+    fprintf( f, " * Model: lqr model a %.3f b %.3f w0^2 %.3f c %.3f d %.3f\n", model.a, model.b, model.w0_sq, model.c,
+             model.d );
+    fprintf( f, " * duration : %.2f sec (%u*10ms), start : rest hanging at SWINGUP_TVLQR_START_CM\n",
+             TVLQR_N * TVLQR_DT, TVLQR_N );
+    fprintf( f, " * end : upright at rest, angle %.4f rad, cost %.4g\n", goal[ 1 ], cost );
+    fprintf( f, " * Sampling time : 10ms\n" );
+    fprintf( f, " */\n" );
+    fprintf( f, "#include \"swingup_tvlqr.h\"\n\n" );
+    fprintf( f, "#if SWINGUP_TVLQR_SAMPLES != %u || SWINGUP_TVLQR_COLUMNS != %u\n", TVLQR_N, SWINGUP_TVLQR_COLUMNS );
+    fprintf( f, "#error \"swingup_tvlqr_table.c doesn't match swingup_tvlqr.h, run sim_swingup_tvlqr\"\n" );
+    fprintf( f, "#endif\n\n" );
+    fprintf( f, "const swingup_tvlqr_table_t swingup_tvlqr_table =\n{\n" );
+    fprintf( f, "    /*" );
+    for( uint32_t c = 0; c < SWINGUP_TVLQR_COLUMNS; c++ )
+    {
+        fprintf( f, " %s%s", names[ c ], c + 1 < SWINGUP_TVLQR_COLUMNS ? "," : " */\n" );
+    }
+    fprintf( f, "    {\n       " );
+    for( uint32_t c = 0; c < SWINGUP_TVLQR_COLUMNS; c++ )
+    {
+        fprintf( f, " %.8ef%s", ( double ) scale[ c ], c + 1 < SWINGUP_TVLQR_COLUMNS ? "," : "\n" );
+    }
+    fprintf( f, "    },\n    {\n" );
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        fprintf( f, "        {" );
+        for( uint32_t c = 0; c < SWINGUP_TVLQR_COLUMNS; c++ )
+        {
+            double v = tvlqr_column( k, c );
+            long q = lround( v / ( double ) scale[ c ] );
+
+            worst[ c ] = fmax( worst[ c ], fabs( q * ( double ) scale[ c ] - v ) );
+            fprintf( f, "%7ld%s", q, c + 1 < SWINGUP_TVLQR_COLUMNS ? "," : "" );
+        }
+        fprintf( f, " }%s\n", k + 1 < TVLQR_N ? "," : "" );
+    }
+    fprintf( f, "    }\n};\n" );
+
+    fprintf( stderr, "quantization error:" );
+    for( uint32_t c = 0; c < SWINGUP_TVLQR_COLUMNS; c++ )
+    {
+        fprintf( stderr, " %.2g", worst[ c ] );
+    }
+    fprintf( stderr, "\n" );
+}
+
+static void usage( void )
+{
+    fprintf( stderr, "usage: sim_swingup_tvlqr [-o file] [-i iterations]\n" );
+    exit( EXIT_FAILURE );
+}
+
+int main( int argc, char **argv )
+{
+    const lqr_plant_params plant = LQR_PLANT_DEFAULT;
+    const float Qf[ LQR_N ] = LQR_UPC_Q;
+    double Q[ LQR_N ], P[ LQR_N ][ LQR_N ], K[ LQR_N ];
+    const char *path = NULL;
+    uint32_t iterations = TVLQR_DEFAULT_ITERATIONS;
+    double cost, x_lo = 0.0, x_hi = 0.0, u_peak = 0.0, k_lo = 0.0, k_hi = 0.0;
+    FILE *f = stdout;
+    int opt;
+
+    while( ( opt = getopt( argc, argv, "o:i:" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'o': path = optarg; break;
+            case 'i': iterations = ( uint32_t ) strtoul( optarg, NULL, 10 ); break;
+            default: usage();
+        }
+    }
+
+    model.a     = plant.cart_pole;
+    model.b     = plant.cart_gain;
+    model.w0_sq = plant.pend_w0_sq;
+    model.c     = plant.pend_coupling;
+    model.d     = plant.pend_damping;
+    for( uint32_t i = 0; i < LQR_N; i++ )
+    {
+        Q[ i ] = Qf[ i ];
+    }
+
+    if( !tvlqr_dare( Q, LQR_UPC_R, P, K ) )
+    {
+        fprintf( stderr, "sim_swingup_tvlqr: up position DARE did not converge\n" );
+        return EXIT_FAILURE;
+    }
+    fprintf( stderr, "UPC LQR gain: %.2f %.2f %.2f %.3f\n", K[ 0 ], K[ 1 ], K[ 2 ], K[ 3 ] );
+
+    tvlqr_seed( K );
+    fprintf( stderr, "seed cost %.4g\n", tvlqr_cost( ( const double ( * )[ LQR_N ] ) traj_x, traj_u ) );
+    cost = tvlqr_optimize( iterations );
+
+    /* TVLQR gains along the final trajectory. */
+    tvlqr_linearize_trajectory();
+    for( int32_t k = TVLQR_N - 1; k >= 0; k-- )
+    {
+        tvlqr_riccati_step( P, ( const double ( * )[ LQR_N ] ) lin_a[ k ], lin_b[ k ], Q, LQR_UPC_R, tvlqr_k[ k ] );
+    }
+
+    for( uint32_t k = 0; k < TVLQR_N; k++ )
+    {
+        x_lo = fmin( x_lo, traj_x[ k ][ 0 ] );
+        x_hi = fmax( x_hi, traj_x[ k ][ 0 ] );
+        u_peak = fmax( u_peak, fabs( traj_u[ k ] ) );
+        for( uint32_t i = 0; i < LQR_N; i++ )
+        {
+            k_lo = fmin( k_lo, tvlqr_k[ k ][ i ] );
+            k_hi = fmax( k_hi, tvlqr_k[ k ][ i ] );
+        }
+    }
+    fprintf( stderr, "cost %.4g, end state %.4f %.4f %.4f %.4f (goal angle %.4f)\n", cost, traj_x[ TVLQR_N ][ 0 ],
+             traj_x[ TVLQR_N ][ 1 ], traj_x[ TVLQR_N ][ 2 ], traj_x[ TVLQR_N ][ 3 ], goal[ 1 ] );
+    fprintf( stderr, "cart %.3f .. %.3f m, |u_nom| <= %.2f V, gains %.1f .. %.1f\n", x_lo, x_hi, u_peak, k_lo, k_hi );
+
+    if( path != NULL )
+    {
+        f = fopen( path, "w" );
+        if( f == NULL )
+        {
+            perror( path );
+            return EXIT_FAILURE;
+        }
+    }
+    tvlqr_write_table( f, cost );
+    if( f != stdout )
+    {
+        fclose( f );
+    }
+
+    return EXIT_SUCCESS;
+}
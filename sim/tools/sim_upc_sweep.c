@@ -0,0 +1,448 @@
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Monte Carlo robustness sweep of the up position controller gains.
+ *
+ * Usage: sim_upc_sweep [-n episodes] [-j threads] [-s seed] [-T seconds]
+ *                      [-p scale] [-g g0,g1,g2,g3]
+ *
+ *     -n  number of episodes, default 10000
+ *     -j  worker threads, default number of CPUs
+ *     -s  seed, default 1
+ *     -T  episode length in seconds, default 10
+ *     -p  scale of all perturbations, default 1.0 (0 runs the nominal plant)
+ *     -g  UPC gains as in ctrl_5_FSF_uppos_law, default -74.5,-76,-51.5,-9
+ *
+ * Every episode is one plant released near the up position at some distance
+ * from the cart setpoint, balanced by the UPC law (sim_batch.h) with perturbed
+ * plant parameters, sensor noise and initial conditions. An episode fails if
+ * the cart enters a watchdog freezing zone, if the pendulum leaves the UPC
+ * angle window (the controller output drops to 0 V there) or if it doesn't
+ * settle within a second before the end.
+ *
+ * Episodes are run in chunks of SWEEP_CHUNK plants, one chunk is one job of
+ * the work-stealing pool (sim_pool.h). Every episode draws its random numbers
+ * from its own generator seeded by the seed and the episode number, and writes
+ * its own result slot, so the report is the same for any number of threads.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim_batch.h"
+#include "sim_pool.h"
+
+#define SWEEP_CHUNK                 64
+
+#define SWEEP_DEFAULT_EPISODES      10000UL
+#define SWEEP_DEFAULT_SECONDS       10.0
+
+/* Cart setpoint and watchdog freezing zones, LIP_task_watchdog.c. */
+#define SWEEP_SETPOINT_CM           20.35
+#define SWEEP_FREEZE_LEFT_CM        3.0
+#define SWEEP_FREEZE_RIGHT_CM       37.07
+
+/* Encoder resolution in app units, pend_enc_driver.h and dcm_encoder_driver.h. */
+#define SWEEP_RAD_PER_COUNT         ( 2.0 * M_PI / SIM_PEND_ENC_COUNTS )
+#define SWEEP_CM_PER_COUNT          ( 40.7 / SIM_CART_ENC_COUNTS )
+
+/* UPC angle window, LIP_task_ctrl_upposition.c. */
+#define SWEEP_WINDOW_RAD            ( 35.0 * M_PI / 180.0 )
+
+/* Settled is within these of the up position and setpoint. The cart limit
+cycle caused by the voltage deadzone is about 1-2 cm. */
+#define SWEEP_SETTLE_RAD            0.05
+#define SWEEP_SETTLE_CM             3.0
+
+/* Settling time histogram. */
+#define SWEEP_HIST_BIN_S            0.25
+#define SWEEP_HIST_BINS             40
+#define SWEEP_HIST_WIDTH            50
+
+typedef enum
+{
+    SWEEP_OK = 0,
+    SWEEP_FAIL_ZONE,
+    SWEEP_FAIL_WINDOW,
+    SWEEP_FAIL_SETTLE,
+    SWEEP_N_OUTCOMES
+} sweep_outcome_t;
+
+static const char *sweep_outcome_names[ SWEEP_N_OUTCOMES ] =
+{
+    "ok", "freezing zone", "left UPC window", "not settled"
+};
+
+typedef struct
+{
+    uint8_t outcome;
+    double settle_s;        /* last time outside the settle band */
+    double excursion_cm;    /* max |x - setpoint| */
+    double margin_cm;       /* min distance to a freezing zone, negative inside */
+} sweep_result_t;
+
+typedef struct
+{
+    uint64_t seed;
+    double seconds;
+    double scale;
+    double gains[ 4 ];
+    uint32_t n_episodes;
+    sweep_result_t *results;
+    sim_batch_t *batches;   /* one per worker */
+} sweep_t;
+
+/* Perturbations, uniform relative spread at scale 1. The AS5600 eccentric
+error moves the true up position against PENDULUM_ANGLE_UP_SETPOINT_BASE,
+the UPC law then balances with the cart running off towards an end, so its
+spread is kept to a calibration error of about 0.4 deg. */
+static const double sweep_spread_cart_mass      = 0.3;
+static const double sweep_spread_pend_mass      = 0.2;
+static const double sweep_spread_pend_com       = 0.1;
+static const double sweep_spread_friction       = 0.5;
+static const double sweep_spread_motor          = 0.1;
+static const double sweep_spread_deadzone       = 0.3;
+static const double sweep_spread_eccentric      = 0.1;
+
+/* Initial condition spread at scale 1. */
+static const double sweep_init_x                = 0.05;     /* m */
+static const double sweep_init_theta            = 0.1;      /* rad */
+static const double sweep_init_dx               = 0.05;     /* m/s */
+static const double sweep_init_dtheta           = 0.3;      /* rad/s */
+
+/* Sensor noise std at scale 1, in encoder counts. */
+static const double sweep_noise_pend_counts     = 1.0;
+static const double sweep_noise_cart_counts     = 0.5;
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Random numbers, splitmix64 per episode.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static uint64_t rng_next( uint64_t *s )
+{
+    uint64_t z = ( *s += 0x9e3779b97f4a7c15ULL );
+
+    z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+    return z ^ ( z >> 31 );
+}
+
+/* Uniform in [0, 1). */
+static double rng_uniform( uint64_t *s )
+{
+    return ( double ) ( rng_next( s ) >> 11 ) * 0x1.0p-53;
+}
+
+/* Uniform in [-1, 1). */
+static double rng_symmetric( uint64_t *s )
+{
+    return 2.0 * rng_uniform( s ) - 1.0;
+}
+
+static double rng_gauss( uint64_t *s )
+{
+    double u = 1.0 - rng_uniform( s );
+
+    return sqrt( -2.0 * log( u ) ) * cos( 2.0 * M_PI * rng_uniform( s ) );
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Episodes.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static double sweep_perturb( uint64_t *rng, double nominal, double spread, double scale )
+{
+    return nominal * ( 1.0 + spread * scale * rng_symmetric( rng ) );
+}
+
+static void sweep_episode_init( const sweep_t *sw, sim_batch_t *b, uint32_t lane, uint64_t *rng )
+{
+    sim_plant_params_t p;
+    double s = sw->scale;
+
+    sim_plant_default_params( &p );
+    p.cart_mass          = sweep_perturb( rng, p.cart_mass, sweep_spread_cart_mass, s );
+    p.pend_mass          = sweep_perturb( rng, p.pend_mass, sweep_spread_pend_mass, s );
+    p.pend_com           = sweep_perturb( rng, p.pend_com, sweep_spread_pend_com, s );
+    p.pend_inertia       = 4.0 / 3.0 * p.pend_mass * p.pend_com * p.pend_com;
+    p.pend_viscous       = sweep_perturb( rng, p.pend_viscous, sweep_spread_friction, s );
+    p.cart_viscous       = sweep_perturb( rng, p.cart_viscous, sweep_spread_friction, s );
+    p.cart_coulomb       = sweep_perturb( rng, p.cart_coulomb, sweep_spread_friction, s );
+    p.motor_resistance   = sweep_perturb( rng, p.motor_resistance, sweep_spread_motor, s );
+    p.motor_kt           = sweep_perturb( rng, p.motor_kt, sweep_spread_motor, s );
+    p.motor_ke           = p.motor_kt;
+    p.voltage_deadzone   = sweep_perturb( rng, p.voltage_deadzone, sweep_spread_deadzone, s );
+    p.pend_enc_eccentric = sweep_perturb( rng, p.pend_enc_eccentric, sweep_spread_eccentric, s );
+    sim_batch_set_params( b, lane, &p );
+
+    b->setpoint_cm[ lane ] = SWEEP_SETPOINT_CM;
+    sim_batch_set_state( b, lane,
+                         SWEEP_SETPOINT_CM * 0.01 + sweep_init_x * s * rng_symmetric( rng ),
+                         sweep_init_theta * s * rng_symmetric( rng ),
+                         sweep_init_dx * s * rng_symmetric( rng ),
+                         sweep_init_dtheta * s * rng_symmetric( rng ) );
+}
+
+/* One chunk of episodes on one batch. */
+static void sweep_job( void *ctx, uint32_t worker, uint32_t job )
+{
+    const sweep_t *sw = ctx;
+    sim_batch_t *b = &sw->batches[ worker ];
+    uint32_t first = job * SWEEP_CHUNK;
+    uint32_t n = sw->n_episodes - first < SWEEP_CHUNK ? sw->n_episodes - first : SWEEP_CHUNK;
+    uint32_t periods = ( uint32_t ) lround( sw->seconds / SIM_BATCH_DT );
+    uint64_t rng[ SWEEP_CHUNK ];
+    sweep_result_t *res = &sw->results[ first ];
+    double pend_noise = sweep_noise_pend_counts * sw->scale;
+    double cart_noise = sweep_noise_cart_counts * sw->scale;
+
+    memcpy( b->gains, sw->gains, sizeof( b->gains ) );
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        rng[ i ] = sw->seed ^ ( ( uint64_t ) ( first + i ) * 0xd1342543de82ef95ULL );
+        rng_next( &rng[ i ] );
+        sweep_episode_init( sw, b, i, &rng[ i ] );
+        res[ i ].outcome = SWEEP_OK;
+        res[ i ].settle_s = 0.0;
+        res[ i ].excursion_cm = 0.0;
+        res[ i ].margin_cm = INFINITY;
+    }
+    /* Lanes past the last episode keep simulating whatever they held. */
+
+    for( uint32_t k = 0; k < periods; k++ )
+    {
+        double t = ( k + 1 ) * SIM_BATCH_DT;
+
+        for( uint32_t i = 0; i < n; i++ )
+        {
+            b->pend_noise[ i ] = round( rng_gauss( &rng[ i ] ) * pend_noise ) * SWEEP_RAD_PER_COUNT;
+            b->cart_noise[ i ] = round( rng_gauss( &rng[ i ] ) * cart_noise ) * SWEEP_CM_PER_COUNT;
+        }
+
+        sim_batch_step( b );
+
+        for( uint32_t i = 0; i < n; i++ )
+        {
+            double x_cm = b->x[ i ] * 100.0;
+            double theta = remainder( b->theta[ i ], 2.0 * M_PI );
+            double margin = fmin( x_cm - SWEEP_FREEZE_LEFT_CM, SWEEP_FREEZE_RIGHT_CM - x_cm );
+
+            if( res[ i ].outcome != SWEEP_OK )
+            {
+                continue;
+            }
+            res[ i ].margin_cm = fmin( res[ i ].margin_cm, margin );
+            res[ i ].excursion_cm = fmax( res[ i ].excursion_cm, fabs( x_cm - SWEEP_SETPOINT_CM ) );
+            if( margin < 0.0 )
+            {
+                res[ i ].outcome = SWEEP_FAIL_ZONE;
+            }
+            else if( fabs( theta ) > SWEEP_WINDOW_RAD )
+            {
+                res[ i ].outcome = SWEEP_FAIL_WINDOW;
+            }
+            else if( fabs( theta ) > SWEEP_SETTLE_RAD || fabs( x_cm - SWEEP_SETPOINT_CM ) > SWEEP_SETTLE_CM )
+            {
+                res[ i ].settle_s = t;
+            }
+        }
+    }
+
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        if( res[ i ].outcome == SWEEP_OK && res[ i ].settle_s > sw->seconds - 1.0 )
+        {
+            res[ i ].outcome = SWEEP_FAIL_SETTLE;
+        }
+    }
+}
+
+/* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * Report.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+static int sweep_cmp_double( const void *a, const void *b )
+{
+    double x = *( const double * ) a, y = *( const double * ) b;
+
+    return ( x > y ) - ( x < y );
+}
+
+/* FNV-1a over the results, equal digests mean equal results. */
+static uint64_t sweep_digest( const sweep_t *sw )
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for( uint32_t i = 0; i < sw->n_episodes; i++ )
+    {
+        const sweep_result_t *r = &sw->results[ i ];
+        double fields[ 4 ] = { r->outcome, r->settle_s, r->excursion_cm, r->margin_cm };
+        const uint8_t *bytes = ( const uint8_t * ) fields;
+
+        for( size_t k = 0; k < sizeof( fields ); k++ )
+        {
+            h = ( h ^ bytes[ k ] ) * 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
+
+static void sweep_report( const sweep_t *sw, uint32_t n_threads, double wall )
+{
+    uint32_t outcomes[ SWEEP_N_OUTCOMES ] = { 0 };
+    uint32_t hist[ SWEEP_HIST_BINS + 1 ] = { 0 };
+    uint32_t hist_max = 1, n_ok = 0;
+    double *settle = malloc( sw->n_episodes * sizeof( double ) );
+    double worst_margin = INFINITY, worst_excursion = 0.0, worst_margin_ok = INFINITY;
+    uint32_t worst_episode = 0;
+
+    for( uint32_t i = 0; i < sw->n_episodes; i++ )
+    {
+        const sweep_result_t *r = &sw->results[ i ];
+
+        outcomes[ r->outcome ]++;
+        if( r->margin_cm < worst_margin )
+        {
+            worst_margin = r->margin_cm;
+            worst_episode = i;
+        }
+        if( r->outcome == SWEEP_OK )
+        {
+            uint32_t bin = ( uint32_t ) ( r->settle_s / SWEEP_HIST_BIN_S );
+
+            bin = bin > SWEEP_HIST_BINS ? SWEEP_HIST_BINS : bin;
+            hist[ bin ]++;
+            settle[ n_ok++ ] = r->settle_s;
+            worst_excursion = fmax( worst_excursion, r->excursion_cm );
+            worst_margin_ok = fmin( worst_margin_ok, r->margin_cm );
+        }
+    }
+
+    printf( "episodes:           %u x %.1f s, seed %llu, perturbation scale %.2f\n",
+            sw->n_episodes, sw->seconds, ( unsigned long long ) sw->seed, sw->scale );
+    printf( "gains:              %.2f %.2f %.2f %.2f\n", sw->gains[ 0 ], sw->gains[ 1 ], sw->gains[ 2 ], sw->gains[ 3 ] );
+    printf( "threads:            %u (%s x %u lanes), %.2f s wall, %.0f episodes / s\n",
+            n_threads, sim_batch_simd_name(), sim_batch_simd_width(), wall, sw->n_episodes / wall );
+    printf( "success rate:       %.2f %% (%u / %u)\n", 100.0 * n_ok / sw->n_episodes, n_ok, sw->n_episodes );
+    for( uint32_t k = 1; k < SWEEP_N_OUTCOMES; k++ )
+    {
+        printf( "  %-18s%u\n", sweep_outcome_names[ k ], outcomes[ k ] );
+    }
+    printf( "freezing zones:     %.2f cm and %.2f cm\n", SWEEP_FREEZE_LEFT_CM, SWEEP_FREEZE_RIGHT_CM );
+    printf( "worst margin:       %.2f cm (episode %u, %s)\n",
+            worst_margin, worst_episode, sweep_outcome_names[ sw->results[ worst_episode ].outcome ] );
+    if( n_ok > 0 )
+    {
+        qsort( settle, n_ok, sizeof( double ), sweep_cmp_double );
+        printf( "worst margin ok:    %.2f cm, max excursion from setpoint %.2f cm\n", worst_margin_ok, worst_excursion );
+        printf( "settling time:      p50 %.2f s, p90 %.2f s, p99 %.2f s, max %.2f s\n",
+                settle[ n_ok / 2 ], settle[ n_ok * 9 / 10 ], settle[ n_ok * 99 / 100 ], settle[ n_ok - 1 ] );
+
+        for( uint32_t k = 0; k <= SWEEP_HIST_BINS; k++ )
+        {
+            hist_max = hist[ k ] > hist_max ? hist[ k ] : hist_max;
+        }
+        for( uint32_t k = 0; k <= SWEEP_HIST_BINS; k++ )
+        {
+            if( hist[ k ] == 0 )
+            {
+                continue;
+            }
+            printf( "  %5.2f - %5.2f s %6u |", k * SWEEP_HIST_BIN_S, ( k + 1 ) * SWEEP_HIST_BIN_S, hist[ k ] );
+            for( uint32_t c = 0; c < ( hist[ k ] * SWEEP_HIST_WIDTH + hist_max - 1 ) / hist_max; c++ )
+            {
+                putchar( '#' );
+            }
+            putchar( '\n' );
+        }
+    }
+    printf( "digest:             %016llx\n", ( unsigned long long ) sweep_digest( sw ) );
+
+    free( settle );
+}
+
+static double wall_clock_s( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return ( double ) ts.tv_sec + ( double ) ts.tv_nsec * 1e-9;
+}
+
+static void usage( void )
+{
+    fprintf( stderr, "usage: sim_upc_sweep [-n episodes] [-j threads] [-s seed] [-T seconds] [-p scale] [-g g0,g1,g2,g3]\n" );
+    exit( EXIT_FAILURE );
+}
+
+int main( int argc, char **argv )
+{
+    sweep_t sw = { 1, SWEEP_DEFAULT_SECONDS, 1.0, { -74.5, -76.0, -51.5, -9.0 }, SWEEP_DEFAULT_EPISODES, NULL, NULL };
+    uint32_t n_threads = sim_pool_cpus(), n_jobs;
+    double start, wall;
+    int opt, ret = EXIT_SUCCESS;
+
+    while( ( opt = getopt( argc, argv, "n:j:s:T:p:g:" ) ) != -1 )
+    {
+        switch( opt )
+        {
+            case 'n': sw.n_episodes = ( uint32_t ) strtoul( optarg, NULL, 10 ); break;
+            case 'j': n_threads = ( uint32_t ) strtoul( optarg, NULL, 10 ); break;
+            case 's': sw.seed = strtoull( optarg, NULL, 10 ); break;
+            case 'T': sw.seconds = strtod( optarg, NULL ); break;
+            case 'p': sw.scale = strtod( optarg, NULL ); break;
+            case 'g':
+                if( sscanf( optarg, "%lf,%lf,%lf,%lf", &sw.gains[ 0 ], &sw.gains[ 1 ], &sw.gains[ 2 ], &sw.gains[ 3 ] ) != 4 )
+                {
+                    usage();
+                }
+                break;
+            default: usage();
+        }
+    }
+    if( sw.n_episodes == 0 || n_threads == 0 || sw.seconds < 1.0 )
+    {
+        usage();
+    }
+
+    n_jobs = ( sw.n_episodes + SWEEP_CHUNK - 1 ) / SWEEP_CHUNK;
+    sw.results = calloc( sw.n_episodes, sizeof( sweep_result_t ) );
+    sw.batches = calloc( n_threads, sizeof( sim_batch_t ) );
+    if( sw.results == NULL || sw.batches == NULL )
+    {
+        fprintf( stderr, "sim_upc_sweep: out of memory\n" );
+        return EXIT_FAILURE;
+    }
+    for( uint32_t i = 0; i < n_threads; i++ )
+    {
+        if( sim_batch_create( &sw.batches[ i ], SWEEP_CHUNK ) )
+        {
+            fprintf( stderr, "sim_upc_sweep: out of memory\n" );
+            return EXIT_FAILURE;
+        }
+    }
+
+    start = wall_clock_s();
+    if( sim_pool_run( n_threads, n_jobs, sweep_job, &sw ) )
+    {
+        fprintf( stderr, "sim_upc_sweep: cannot start worker threads\n" );
+        ret = EXIT_FAILURE;
+    }
+    wall = wall_clock_s() - start;
+
+    if( ret == EXIT_SUCCESS )
+    {
+        sweep_report( &sw, n_threads, wall );
+    }
+
+    for( uint32_t i = 0; i < n_threads; i++ )
+    {
+        sim_batch_destroy( &sw.batches[ i ] );
+    }
+    free( sw.batches );
+    free( sw.results );
+
+    return ret;
+}